@@ -0,0 +1,20 @@
+# Add inputs and outputs from these tool invocations to the build variables
+C_SRCS += \
+../src/heap/heap.c
+
+OBJS += \
+./src/heap/heap.o
+
+C_DEPS += \
+./src/heap/heap.d
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/heap/%.o: ../src/heap/%.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C Compiler'
+	gcc -I../include -O0 -g3 -Wall -Wextra $(CPPFLAGS) $(CFLAGS) -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -6,8 +6,10 @@ C_SRCS += \
 ../src/siri/buffersync.c \
 ../src/siri/err.c \
 ../src/siri/evars.c \
+../src/siri/expire.c \
 ../src/siri/health.c \
 ../src/siri/heartbeat.c \
+../src/siri/metrics.c \
 ../src/siri/optimize.c \
 ../src/siri/siri.c \
 ../src/siri/version.c
@@ -19,8 +21,10 @@ OBJS += \
 ./src/siri/buffersync.o \
 ./src/siri/err.o \
 ./src/siri/evars.o \
+./src/siri/expire.o \
 ./src/siri/health.o \
 ./src/siri/heartbeat.o \
+./src/siri/metrics.o \
 ./src/siri/optimize.o \
 ./src/siri/siri.o \
 ./src/siri/version.o
@@ -32,8 +36,10 @@ C_DEPS += \
 ./src/siri/buffersync.d \
 ./src/siri/err.d \
 ./src/siri/evars.d \
+./src/siri/expire.d \
 ./src/siri/health.d \
 ./src/siri/heartbeat.d \
+./src/siri/metrics.d \
 ./src/siri/optimize.d \
 ./src/siri/siri.d \
 ./src/siri/version.d
@@ -16,6 +16,7 @@ src/cexpr \
 src/cfgparser \
 src/ctree \
 src/expr \
+src/heap \
 src/imap \
 src/iso8601 \
 src/lib \
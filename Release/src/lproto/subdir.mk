@@ -0,0 +1,20 @@
+# Add inputs and outputs from these tool invocations to the build variables
+C_SRCS += \
+../src/lproto/lproto.c
+
+OBJS += \
+./src/lproto/lproto.o
+
+C_DEPS += \
+./src/lproto/lproto.d
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/lproto/%.o: ../src/lproto/%.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C Compiler'
+	$(CC) -DNDEBUG -I../include -O3 -Wall -Wextra $(CPPFLAGS) $(CFLAGS) -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
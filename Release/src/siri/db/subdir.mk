@@ -4,7 +4,9 @@ C_SRCS += \
 ../src/siri/db/aggregate.c \
 ../src/siri/db/auth.c \
 ../src/siri/db/buffer.c \
+../src/siri/db/coalesce.c \
 ../src/siri/db/db.c \
+../src/siri/db/expire.c \
 ../src/siri/db/ffile.c \
 ../src/siri/db/fifo.c \
 ../src/siri/db/forward.c \
@@ -12,17 +14,22 @@ C_SRCS += \
 ../src/siri/db/groups.c \
 ../src/siri/db/initsync.c \
 ../src/siri/db/insert.c \
+../src/siri/db/insertjson.c \
 ../src/siri/db/listener.c \
 ../src/siri/db/lookup.c \
 ../src/siri/db/median.c \
 ../src/siri/db/misc.c \
 ../src/siri/db/nodes.c \
+../src/siri/db/partial.c \
 ../src/siri/db/pcache.c \
+../src/siri/db/plan.c \
 ../src/siri/db/points.c \
 ../src/siri/db/pool.c \
 ../src/siri/db/pools.c \
 ../src/siri/db/presuf.c \
+../src/siri/db/profile.c \
 ../src/siri/db/props.c \
+../src/siri/db/qcache.c \
 ../src/siri/db/queries.c \
 ../src/siri/db/query.c \
 ../src/siri/db/re.c \
@@ -33,6 +40,7 @@ C_SRCS += \
 ../src/siri/db/servers.c \
 ../src/siri/db/shard.c \
 ../src/siri/db/shards.c \
+../src/siri/db/sketch.c \
 ../src/siri/db/sset.c \
 ../src/siri/db/tag.c \
 ../src/siri/db/tags.c \
@@ -42,14 +50,17 @@ C_SRCS += \
 ../src/siri/db/user.c \
 ../src/siri/db/users.c \
 ../src/siri/db/variance.c \
-../src/siri/db/walker.c
+../src/siri/db/walker.c \
+../src/siri/db/zones.c
 
 OBJS += \
 ./src/siri/db/access.o \
 ./src/siri/db/aggregate.o \
 ./src/siri/db/auth.o \
 ./src/siri/db/buffer.o \
+./src/siri/db/coalesce.o \
 ./src/siri/db/db.o \
+./src/siri/db/expire.o \
 ./src/siri/db/ffile.o \
 ./src/siri/db/fifo.o \
 ./src/siri/db/forward.o \
@@ -57,17 +68,22 @@ OBJS += \
 ./src/siri/db/groups.o \
 ./src/siri/db/initsync.o \
 ./src/siri/db/insert.o \
+./src/siri/db/insertjson.o \
 ./src/siri/db/listener.o \
 ./src/siri/db/lookup.o \
 ./src/siri/db/median.o \
 ./src/siri/db/misc.o \
 ./src/siri/db/nodes.o \
+./src/siri/db/partial.o \
 ./src/siri/db/pcache.o \
+./src/siri/db/plan.o \
 ./src/siri/db/points.o \
 ./src/siri/db/pool.o \
 ./src/siri/db/pools.o \
 ./src/siri/db/presuf.o \
+./src/siri/db/profile.o \
 ./src/siri/db/props.o \
+./src/siri/db/qcache.o \
 ./src/siri/db/queries.o \
 ./src/siri/db/query.o \
 ./src/siri/db/re.o \
@@ -78,6 +94,7 @@ OBJS += \
 ./src/siri/db/servers.o \
 ./src/siri/db/shard.o \
 ./src/siri/db/shards.o \
+./src/siri/db/sketch.o \
 ./src/siri/db/sset.o \
 ./src/siri/db/tag.o \
 ./src/siri/db/tags.o \
@@ -87,14 +104,17 @@ OBJS += \
 ./src/siri/db/user.o \
 ./src/siri/db/users.o \
 ./src/siri/db/variance.o \
-./src/siri/db/walker.o
+./src/siri/db/walker.o \
+./src/siri/db/zones.o
 
 C_DEPS += \
 ./src/siri/db/access.d \
 ./src/siri/db/aggregate.d \
 ./src/siri/db/auth.d \
 ./src/siri/db/buffer.d \
+./src/siri/db/coalesce.d \
 ./src/siri/db/db.d \
+./src/siri/db/expire.d \
 ./src/siri/db/ffile.d \
 ./src/siri/db/fifo.d \
 ./src/siri/db/forward.d \
@@ -102,17 +122,22 @@ C_DEPS += \
 ./src/siri/db/groups.d \
 ./src/siri/db/initsync.d \
 ./src/siri/db/insert.d \
+./src/siri/db/insertjson.d \
 ./src/siri/db/listener.d \
 ./src/siri/db/lookup.d \
 ./src/siri/db/median.d \
 ./src/siri/db/misc.d \
 ./src/siri/db/nodes.d \
+./src/siri/db/partial.d \
 ./src/siri/db/pcache.d \
+./src/siri/db/plan.d \
 ./src/siri/db/points.d \
 ./src/siri/db/pool.d \
 ./src/siri/db/pools.d \
 ./src/siri/db/presuf.d \
+./src/siri/db/profile.d \
 ./src/siri/db/props.d \
+./src/siri/db/qcache.d \
 ./src/siri/db/queries.d \
 ./src/siri/db/query.d \
 ./src/siri/db/re.d \
@@ -123,6 +148,7 @@ C_DEPS += \
 ./src/siri/db/servers.d \
 ./src/siri/db/shard.d \
 ./src/siri/db/shards.d \
+./src/siri/db/sketch.d \
 ./src/siri/db/sset.d \
 ./src/siri/db/tag.d \
 ./src/siri/db/tags.d \
@@ -132,7 +158,8 @@ C_DEPS += \
 ./src/siri/db/user.d \
 ./src/siri/db/users.d \
 ./src/siri/db/variance.d \
-./src/siri/db/walker.d
+./src/siri/db/walker.d \
+./src/siri/db/zones.d
 
 
 # Each subdirectory must supply rules for building sources it contributes
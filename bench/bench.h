@@ -0,0 +1,131 @@
+#ifndef SIRIDB_BENCH_H_
+#define SIRIDB_BENCH_H_
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Each benchmark runs once to warm up and then BENCH_RUNS times (can be
+ * changed with the BENCH_RUNS environment variable). The fastest and the
+ * median run are reported, one line for each benchmark, as CSV or as a JSON
+ * object when BENCH_FORMAT=json.
+ */
+#define BENCH_RUNS 5
+#define BENCH_MAX_RUNS 100
+#define BENCH_SEED 0x5eed5171db
+
+typedef void (*bench_cb)(void * arg);
+
+static const char * bench_suite;
+static int bench_json;
+static int bench_runs = BENCH_RUNS;
+static uint64_t bench_paused;
+static uint64_t bench_pause_start;
+static uint64_t bench_state = BENCH_SEED;
+
+/* results are written to this sink so the compiler cannot skip the work */
+static volatile uint64_t bench_sink;
+
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Deterministic pseudo random numbers (xorshift64*) so each run uses the
+ * same data set.
+ */
+static inline uint64_t bench_rand(void)
+{
+    bench_state ^= bench_state >> 12;
+    bench_state ^= bench_state << 25;
+    bench_state ^= bench_state >> 27;
+    return bench_state * 0x2545f4914f6cdd1dULL;
+}
+
+static void bench_init(const char * suite)
+{
+    const char * env = getenv("BENCH_FORMAT");
+    bench_suite = suite;
+    bench_json = env != NULL && strcmp(env, "json") == 0;
+
+    env = getenv("BENCH_RUNS");
+    if (env != NULL)
+    {
+        bench_runs = atoi(env);
+        if (bench_runs < 1 || bench_runs > BENCH_MAX_RUNS)
+        {
+            bench_runs = BENCH_RUNS;
+        }
+    }
+}
+
+/*
+ * Work between bench_pause() and bench_resume() is not measured, this can be
+ * used to restore the input for the next run.
+ */
+static inline void bench_pause(void)
+{
+    bench_pause_start = bench_now();
+}
+
+static inline void bench_resume(void)
+{
+    bench_paused += bench_now() - bench_pause_start;
+}
+
+static int bench_cmp(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Run a benchmark. The ops argument is the number of operations done by a
+ * single call to cb and is used to calculate the time per operation.
+ */
+static void bench_run(const char * name, size_t ops, bench_cb cb, void * arg)
+{
+    uint64_t times[BENCH_MAX_RUNS];
+    uint64_t start;
+    double ns_op, mops;
+    int i;
+
+    cb(arg);
+
+    for (i = 0; i < bench_runs; i++)
+    {
+        bench_paused = 0;
+        start = bench_now();
+        cb(arg);
+        times[i] = bench_now() - start - bench_paused;
+    }
+
+    qsort(times, bench_runs, sizeof(uint64_t), bench_cmp);
+
+    ns_op = (double) times[0] / ops;
+    mops = ns_op > 0.0 ? 1000.0 / ns_op : 0.0;
+
+    printf(bench_json ?
+            "{\"suite\": \"%s\", \"name\": \"%s\", \"ops\": %zu, "
+            "\"runs\": %d, \"best_ns\": %" PRIu64 ", "
+            "\"median_ns\": %" PRIu64 ", \"ns_per_op\": %.3f, "
+            "\"mops\": %.3f}\n" :
+            "%s,%s,%zu,%d,%" PRIu64 ",%" PRIu64 ",%.3f,%.3f\n",
+            bench_suite,
+            name,
+            ops,
+            bench_runs,
+            times[0],
+            times[bench_runs / 2],
+            ns_op,
+            mops);
+    fflush(stdout);
+}
+
+#endif  /* SIRIDB_BENCH_H_ */
@@ -0,0 +1,72 @@
+#!/bin/bash
+#
+# Run all benchmarks, or only the given one:
+#
+#   ./bench.sh [name]
+#
+# Environment:
+#   BENCH_FORMAT    csv (default) or json
+#   BENCH_RUNS      number of measured runs for each benchmark (default 5)
+#   BENCH_OUT       result file (default results.csv or results.json)
+#   BENCH_BASELINE  compare with the results from a previous run and fail
+#                   when a benchmark is slower than BENCH_THRESHOLD percent
+#   BENCH_THRESHOLD allowed slow down in percent (default 10)
+#
+RET=0
+
+if [[ "$OSTYPE" == "darwin" ]]; then
+    LCRYPT=
+else
+    LCRYPT=-lcrypt
+fi
+
+BENCH_FORMAT=${BENCH_FORMAT:-csv}
+BENCH_OUT=${BENCH_OUT:-results.$BENCH_FORMAT}
+export BENCH_FORMAT
+
+run () {
+    if [ ! -f $1/sources ]; then
+       return;
+    fi
+    C_SRC=$(cat $1/sources)
+
+    SOURCE=$1/$1.c
+    OUT=$1.out
+    rm "$OUT" 2> /dev/null
+
+    gcc -I"../include" -O2 -DNDEBUG -Wall -Wextra -std=gnu99 $SOURCE $C_SRC -lm -lpcre2-8 -lcleri -luuid -luv -lyajl $LCRYPT -o "$OUT"
+    ./$OUT >> "$BENCH_OUT.tmp"
+    rc=$?; if [[ $rc != 0 ]]; then RET=$((RET+1)); fi
+    rm "$OUT" 2> /dev/null
+    rm -r "$OUT.dSYM" 2> /dev/null
+}
+
+rm "$BENCH_OUT.tmp" 2> /dev/null
+
+if [ $# -eq 0 ]; then
+    for d in bench_*/ ; do
+        run "${d%?}"
+    done
+else
+    name=`echo $1 | sed 's/\(bench_\)\?\(.*\?\)$/\2/g' | sed 's/\(.*\)\/$/\1/g'`
+    run "bench_$name"
+fi
+
+if [[ "$BENCH_FORMAT" == "json" ]]; then
+    { echo "["; sed '$!s/$/,/' "$BENCH_OUT.tmp"; echo "]"; } > "$BENCH_OUT"
+else
+    { echo "suite,name,ops,runs,best_ns,median_ns,ns_per_op,mops"; \
+      cat "$BENCH_OUT.tmp"; } > "$BENCH_OUT"
+fi
+rm "$BENCH_OUT.tmp"
+
+if ! hash python3 2>/dev/null; then
+    cat "$BENCH_OUT"
+elif [ -n "$BENCH_BASELINE" ]; then
+    python3 compare.py "$BENCH_OUT" "$BENCH_BASELINE" \
+        --threshold ${BENCH_THRESHOLD:-10} || RET=$((RET+1))
+else
+    python3 compare.py "$BENCH_OUT"
+fi
+
+exit $RET
@@ -0,0 +1,80 @@
+#include "../bench.h"
+#include <siri/db/points.h>
+#include <siri/db/aggregate.h>
+
+
+#define SIRIDB_MAX_SIZE_ERR_MSG 1024
+#define NPOINTS 1000000
+#define INTERVAL 10
+#define GROUP_BY 3600
+
+typedef struct
+{
+    const char * name;
+    uint32_t gid;
+    uint64_t group_by;
+    double percentile;
+} bench_aggr_t;
+
+static siridb_points_t * points;
+static char err_msg[SIRIDB_MAX_SIZE_ERR_MSG];
+
+static void bench_aggregate(void * arg)
+{
+    siridb_aggr_t * aggr = arg;
+    siridb_points_t * aggrp = siridb_aggregate_run(points, aggr, err_msg);
+
+    if (aggrp != NULL)
+    {
+        bench_sink += aggrp->len;
+        if (aggrp != points)
+        {
+            siridb_points_free(aggrp);
+        }
+    }
+}
+
+int main()
+{
+    bench_aggr_t aggrs[] = {
+        {"count", CLERI_GID_F_COUNT, GROUP_BY, 0.0},
+        {"sum", CLERI_GID_F_SUM, GROUP_BY, 0.0},
+        {"mean", CLERI_GID_F_MEAN, GROUP_BY, 0.0},
+        {"max", CLERI_GID_F_MAX, GROUP_BY, 0.0},
+        {"median", CLERI_GID_F_MEDIAN, GROUP_BY, 0.0},
+        {"stddev", CLERI_GID_F_STDDEV, GROUP_BY, 0.0},
+        {"percentile", CLERI_GID_F_PERCENTILE, GROUP_BY, 99.0},
+        {"distinct", CLERI_GID_F_DISTINCT, GROUP_BY, 0.0},
+        {"difference", CLERI_GID_F_DIFFERENCE, 0, 0.0},
+        {"derivative", CLERI_GID_F_DERIVATIVE, 0, 0.0},
+    };
+    siridb_aggr_t aggr = {0};
+    uint64_t ts = 1579521270;
+    qp_via_t val;
+    size_t i;
+
+    bench_init("aggr");
+    siridb_init_aggregates();
+
+    points = siridb_points_new(NPOINTS, TP_INT);
+    val.int64 = 5000;
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        ts += INTERVAL;
+        val.int64 += (int64_t) (bench_rand() % 101) - 50;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    for (i = 0; i < sizeof(aggrs) / sizeof(bench_aggr_t); i++)
+    {
+        aggr.gid = aggrs[i].gid;
+        aggr.group_by = aggrs[i].group_by;
+        aggr.percentile = aggrs[i].percentile;
+        aggr.timespan = 1.0;
+        bench_run(aggrs[i].name, NPOINTS, bench_aggregate, &aggr);
+    }
+
+    siridb_points_free(points);
+    return 0;
+}
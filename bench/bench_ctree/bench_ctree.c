@@ -0,0 +1,99 @@
+#include "../bench.h"
+#include <ctree/ctree.h>
+
+
+#define NKEYS 200000
+#define KEY_SZ 48
+
+static char keys[NKEYS][KEY_SZ];
+static char misses[NKEYS][KEY_SZ];
+
+/* series names share long prefixes, like they usually do */
+static void make_key(char * key, size_t i)
+{
+    static const char * hosts[] = {"web", "db", "cache", "queue"};
+    static const char * metrics[] = {"cpu", "mem", "disk", "net", "load"};
+    uint64_t r = bench_rand();
+
+    snprintf(key, KEY_SZ, "%s%02u.example.net|%s|%zu",
+            hosts[r % 4],
+            (unsigned) (r >> 8) % 100,
+            metrics[(r >> 16) % 5],
+            i);
+}
+
+static void bench_add(void * arg __attribute__((unused)))
+{
+    ct_t * ct = ct_new();
+    size_t i;
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        ct_add(ct, keys[i], keys[i]);
+    }
+
+    bench_pause();
+    ct_free(ct, NULL);
+    bench_resume();
+}
+
+static void bench_get(void * arg)
+{
+    ct_t * ct = arg;
+    size_t i;
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        bench_sink += ct_get(ct, keys[i]) != NULL;
+    }
+}
+
+static void bench_get_miss(void * arg)
+{
+    ct_t * ct = arg;
+    size_t i;
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        bench_sink += ct_get(ct, misses[i]) != NULL;
+    }
+}
+
+static int bench_items_cb(
+        const char * key __attribute__((unused)),
+        size_t len,
+        void * data __attribute__((unused)),
+        void * arg __attribute__((unused)))
+{
+    bench_sink += len;
+    return 0;
+}
+
+static void bench_items(void * arg)
+{
+    ct_items(arg, (ct_item_cb) bench_items_cb, NULL);
+}
+
+int main()
+{
+    ct_t * ct = ct_new();
+    size_t i;
+
+    bench_init("ctree");
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        make_key(keys[i], i);
+        make_key(misses[i], i);
+        misses[i][0] = 'x';
+        ct_add(ct, keys[i], keys[i]);
+    }
+
+    bench_run("add", NKEYS, bench_add, NULL);
+    bench_run("get", NKEYS, bench_get, ct);
+    bench_run("get_miss", NKEYS, bench_get_miss, ct);
+    bench_run("items", NKEYS, bench_items, ct);
+
+    ct_free(ct, NULL);
+    return 0;
+}
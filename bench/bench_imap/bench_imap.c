@@ -0,0 +1,168 @@
+#include "../bench.h"
+#include <imap/imap.h>
+
+
+#define NIDS 500000
+#define NSET 100000
+
+/*
+ * Like series, objects in a map start with a reference counter. The set
+ * operations decrement it for objects which are in both maps so the
+ * counter starts high enough to never reach zero.
+ */
+typedef struct
+{
+    uint32_t ref;
+    uint64_t id;
+} bench_obj_t;
+
+/* ids in SiriDB are handed out in order, so most maps are dense */
+static uint64_t ids[NIDS];
+static bench_obj_t objs[NIDS + 1];
+static imap_t * set_a;
+static imap_t * set_b;
+static imap_t * dest;
+
+static void bench_decref(void * data __attribute__((unused)))
+{
+}
+
+static void bench_add(void * arg __attribute__((unused)))
+{
+    imap_t * imap = imap_new();
+    size_t i;
+
+    for (i = 0; i < NIDS; i++)
+    {
+        imap_add(imap, ids[i], &objs[ids[i]]);
+    }
+
+    bench_pause();
+    imap_free(imap, NULL);
+    bench_resume();
+}
+
+static void bench_get(void * arg)
+{
+    size_t i;
+
+    for (i = 0; i < NIDS; i++)
+    {
+        bench_sink += imap_get(arg, ids[i]) != NULL;
+    }
+}
+
+static void bench_set(
+        void (*op)(imap_t *, imap_t *, imap_free_cb),
+        imap_t * imap)
+{
+    imap_t * copy;
+    vec_t * vec;
+    size_t i;
+
+    /* the _ref functions change both maps so start with copies */
+    bench_pause();
+    imap_free(dest, NULL);
+    dest = imap_new();
+    copy = imap_new();
+    vec = imap_vec(set_a);
+    for (i = 0; i < vec->len; i++)
+    {
+        imap_add(dest, ((bench_obj_t *) vec->data[i])->id, vec->data[i]);
+    }
+    vec = imap_vec(imap);
+    for (i = 0; i < vec->len; i++)
+    {
+        imap_add(copy, ((bench_obj_t *) vec->data[i])->id, vec->data[i]);
+    }
+    bench_resume();
+
+    (*op)(dest, copy, bench_decref);
+}
+
+static void bench_union(void * arg)
+{
+    bench_set(imap_union_ref, arg);
+}
+
+static void bench_intersection(void * arg)
+{
+    bench_set(imap_intersection_ref, arg);
+}
+
+static void bench_difference(void * arg)
+{
+    bench_set(imap_difference_ref, arg);
+}
+
+static void bench_symmetric_difference(void * arg)
+{
+    bench_set(imap_symmetric_difference_ref, arg);
+}
+
+int main()
+{
+    imap_t * imap = imap_new();
+    size_t i;
+
+    bench_init("imap");
+
+    for (i = 0; i < NIDS; i++)
+    {
+        ids[i] = i + 1;
+        objs[i + 1].ref = UINT32_MAX / 2;
+        objs[i + 1].id = i + 1;
+    }
+
+    /* shuffle so the ids are added in a random order */
+    for (i = NIDS - 1; i > 0; i--)
+    {
+        size_t j = bench_rand() % (i + 1);
+        uint64_t tmp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = tmp;
+    }
+
+    set_a = imap_new();
+    set_b = imap_new();
+    dest = imap_new();
+
+    for (i = 0; i < NIDS; i++)
+    {
+        imap_add(imap, ids[i], &objs[ids[i]]);
+
+        /* two sets which overlap for about half of their ids */
+        if (ids[i] <= NSET)
+        {
+            imap_add(set_a, ids[i], &objs[ids[i]]);
+        }
+        else if (ids[i] > NSET / 2 && ids[i] <= NSET + NSET / 2)
+        {
+            imap_add(set_b, ids[i], &objs[ids[i]]);
+        }
+    }
+    for (i = 0; i < NIDS; i++)
+    {
+        if (ids[i] > NSET / 2 && ids[i] <= NSET)
+        {
+            imap_add(set_b, ids[i], &objs[ids[i]]);
+        }
+    }
+
+    bench_run("add", NIDS, bench_add, NULL);
+    bench_run("get", NIDS, bench_get, imap);
+    bench_run("union", NSET, bench_union, set_b);
+    bench_run("intersection", NSET, bench_intersection, set_b);
+    bench_run("difference", NSET, bench_difference, set_b);
+    bench_run(
+            "symmetric_difference",
+            NSET,
+            bench_symmetric_difference,
+            set_b);
+
+    imap_free(imap, NULL);
+    imap_free(set_a, NULL);
+    imap_free(set_b, NULL);
+    imap_free(dest, NULL);
+    return 0;
+}
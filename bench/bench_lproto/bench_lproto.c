@@ -0,0 +1,94 @@
+#include "../bench.h"
+#include <lproto/lproto.h>
+
+
+#define NLINES 100000
+
+/*
+ * The parser un-escapes and sorts keys in place so each run starts with a
+ * fresh copy of the source data.
+ */
+static const char line_sorted[] =
+    "cpu,host=server01,region=eu usage_idle=93.25,usage_user=4i "
+    "1700000000000000000\n";
+static const char line_unsorted[] =
+    "cpu,region=eu,host=server01 usage_idle=93.25,usage_user=4i "
+    "1700000000000000000\n";
+
+typedef struct
+{
+    size_t n;
+    char * src;
+    char * data;
+} bench_lines_t;
+
+static void bench_lines_init(bench_lines_t * lines, const char * line)
+{
+    size_t i;
+
+    lines->n = strlen(line);
+    lines->src = malloc(lines->n * NLINES);
+    lines->data = malloc(lines->n * NLINES);
+
+    if (lines->src == NULL || lines->data == NULL)
+    {
+        abort();
+    }
+
+    for (i = 0; i < NLINES; i++)
+    {
+        memcpy(lines->src + i * lines->n, line, lines->n);
+    }
+}
+
+static void bench_lines_destroy(bench_lines_t * lines)
+{
+    free(lines->src);
+    free(lines->data);
+}
+
+static void bench_parse(void * arg)
+{
+    bench_lines_t * lines = arg;
+    size_t nlines = 0, nfields = 0;
+    lproto_t lp;
+    lproto_field_t field;
+
+    bench_pause();
+    memcpy(lines->data, lines->src, lines->n * NLINES);
+    bench_resume();
+
+    lproto_init(&lp, lines->data, lines->n * NLINES);
+    while (lproto_next_line(&lp) == LPROTO_OK)
+    {
+        ++nlines;
+        while (lproto_next_field(&lp, &field) == LPROTO_OK)
+        {
+            ++nfields;
+        }
+    }
+
+    if (nlines != NLINES || nfields != NLINES * 2)
+    {
+        abort();
+    }
+
+    bench_sink += nfields;
+}
+
+int main()
+{
+    bench_lines_t sorted, unsorted;
+
+    bench_init("lproto");
+
+    bench_lines_init(&sorted, line_sorted);
+    bench_lines_init(&unsorted, line_unsorted);
+
+    bench_run("parse", NLINES, bench_parse, &sorted);
+    bench_run("parse_unsorted_tags", NLINES, bench_parse, &unsorted);
+
+    bench_lines_destroy(&sorted);
+    bench_lines_destroy(&unsorted);
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include <math.h>
+#include "../bench.h"
+#include <siri/db/db.h>
+#include <siri/db/points.h>
+
+
+#define NCHUNKS 200
+#define CHUNK_SZ 800    /* about the number of points in a shard chunk */
+#define NPOINTS (NCHUNKS * CHUNK_SZ)
+
+typedef unsigned char * (*zip_cb)(
+        siridb_points_t *,
+        uint_fast32_t,
+        uint_fast32_t,
+        uint16_t *,
+        size_t *);
+
+typedef struct
+{
+    siridb_points_t * points;
+    zip_cb zip;
+    unsigned char * bits[NCHUNKS];
+    uint16_t cinfo[NCHUNKS];
+    siridb_points_t * unzipped;
+} bench_codec_t;
+
+static siridb_points_t * prepare_gauge(void)
+{
+    siridb_points_t * points = siridb_points_new(NPOINTS, TP_INT);
+    uint64_t ts = 1579521271;
+    qp_via_t val;
+    size_t i;
+
+    val.int64 = 500;
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        ts += 60 + bench_rand() % 3;
+        val.int64 += (int64_t) (bench_rand() % 21) - 10;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static siridb_points_t * prepare_counter(void)
+{
+    siridb_points_t * points = siridb_points_new(NPOINTS, TP_INT);
+    uint64_t ts = 1579521271000;
+    qp_via_t val;
+    size_t i;
+
+    val.int64 = 1000000;
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        ts += 10000 + bench_rand() % 5;
+        val.int64 += bench_rand() % 200;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static siridb_points_t * prepare_doubles(void)
+{
+    siridb_points_t * points = siridb_points_new(NPOINTS, TP_DOUBLE);
+    uint64_t ts = 1579521271;
+    qp_via_t val;
+    size_t i;
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        ts += 300;
+        val.real = 20.0 + sin((double) i / 100.0) * 5.0 +
+                (double) (bench_rand() % 100) / 100.0;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static siridb_points_t * prepare_log(void)
+{
+    siridb_points_t * points = siridb_points_new(NPOINTS, TP_STRING);
+    const char * levels[] = {"info", "warning", "error"};
+    char buf[128];
+    uint64_t ts = 1579521271;
+    size_t i;
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        ts += 1 + bench_rand() % 60;
+        snprintf(buf, sizeof(buf),
+                "[%s] connection from 10.0.0.%u closed after %u ms",
+                levels[bench_rand() % 3],
+                (unsigned) (bench_rand() % 255),
+                (unsigned) (bench_rand() % 10000));
+        points->data[i].ts = ts;
+        points->data[i].val.str = strdup(buf);
+        points->len++;
+    }
+
+    return points;
+}
+
+static void bench_zip(void * arg)
+{
+    bench_codec_t * codec = arg;
+    unsigned char * bits;
+    uint16_t cinfo;
+    size_t i, size;
+
+    for (i = 0; i < NCHUNKS; i++)
+    {
+        bits = (*codec->zip)(
+                codec->points,
+                i * CHUNK_SZ,
+                (i + 1) * CHUNK_SZ,
+                &cinfo,
+                &size);
+        bench_sink += size;
+        free(bits);
+    }
+}
+
+static void bench_unzip(void * arg)
+{
+    bench_codec_t * codec = arg;
+    siridb_points_t * points = codec->unzipped;
+    size_t i, j;
+
+    for (i = 0; i < NCHUNKS; i++)
+    {
+        if (points->tp == TP_STRING)
+        {
+            bench_pause();
+            for (j = 0; j < points->len; j++)
+            {
+                free(points->data[j].val.str);
+            }
+            points->len = 0;
+            bench_resume();
+
+            siridb_points_unzip_string(
+                    points, codec->bits[i], CHUNK_SZ, NULL, NULL, 0);
+        }
+        else
+        {
+            points->len = 0;
+            (points->tp == TP_INT ?
+                    siridb_points_unzip_int : siridb_points_unzip_double)(
+                        points,
+                        codec->bits[i],
+                        CHUNK_SZ,
+                        codec->cinfo[i],
+                        NULL,
+                        NULL,
+                        0);
+        }
+        bench_sink += points->len;
+    }
+}
+
+static void bench_codec(
+        const char * name,
+        siridb_points_t * points,
+        zip_cb zip)
+{
+    bench_codec_t codec;
+    char buf[64];
+    size_t i, size, total = 0;
+
+    codec.points = points;
+    codec.zip = zip;
+    codec.unzipped = siridb_points_new(CHUNK_SZ, points->tp);
+
+    for (i = 0; i < NCHUNKS; i++)
+    {
+        codec.bits[i] = (*zip)(
+                points,
+                i * CHUNK_SZ,
+                (i + 1) * CHUNK_SZ,
+                &codec.cinfo[i],
+                &size);
+        total += size;
+    }
+
+    snprintf(buf, sizeof(buf), "zip_%s", name);
+    bench_run(buf, NPOINTS, bench_zip, &codec);
+
+    snprintf(buf, sizeof(buf), "unzip_%s", name);
+    bench_run(buf, NPOINTS, bench_unzip, &codec);
+
+    fprintf(stderr, "    %-16s %.2f bytes/point\n",
+            name, (double) total / NPOINTS);
+
+    for (i = 0; i < NCHUNKS; i++)
+    {
+        free(codec.bits[i]);
+    }
+    siridb_points_free(codec.unzipped);
+}
+
+int main()
+{
+    siridb_points_t * gauge = prepare_gauge();
+    siridb_points_t * counter = prepare_counter();
+    siridb_points_t * doubles = prepare_doubles();
+    siridb_points_t * log = prepare_log();
+
+    bench_init("points");
+
+    bench_codec("int", gauge, siridb_points_zip_int);
+    bench_codec("int_bits", counter, siridb_points_zip_int_bits);
+    bench_codec("double", doubles, siridb_points_zip_double);
+    bench_codec("double_bits", doubles, siridb_points_zip_double_bits);
+    bench_codec("string", log, siridb_points_zip_string);
+
+    siridb_points_free(gauge);
+    siridb_points_free(counter);
+    siridb_points_free(doubles);
+    siridb_points_free(log);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "../bench.h"
+#include <qpack/qpack.h>
+
+
+#define NSERIES 1000
+#define NPOINTS 1000
+#define NOBJ (NSERIES * (1 + 1 + NPOINTS * 3))
+
+/*
+ * The data set looks like a select response: a map with for each series an
+ * array of [timestamp, value] points.
+ */
+static void bench_pack(void * arg)
+{
+    qp_packer_t * packer = arg;
+    char name[32];
+    uint64_t ts;
+    size_t i, j;
+
+    packer->len = 0;
+    qp_add_type(packer, QP_MAP_OPEN);
+
+    for (i = 0; i < NSERIES; i++)
+    {
+        snprintf(name, sizeof(name), "series-%03zu", i);
+        qp_add_string(packer, name);
+        qp_add_type(packer, QP_ARRAY_OPEN);
+
+        for (j = 0, ts = 1579521270; j < NPOINTS; j++, ts += 10)
+        {
+            qp_add_type(packer, QP_ARRAY2);
+            qp_add_int64(packer, (int64_t) ts);
+            if (i % 2)
+            {
+                qp_add_int64(packer, (int64_t) (i * j));
+            }
+            else
+            {
+                qp_add_double(packer, (double) (i * j) / 7.0);
+            }
+        }
+        qp_add_type(packer, QP_ARRAY_CLOSE);
+    }
+
+    qp_add_type(packer, QP_MAP_CLOSE);
+    bench_sink += packer->len;
+}
+
+static void bench_next(void * arg)
+{
+    qp_packer_t * packer = arg;
+    qp_unpacker_t unpacker;
+    qp_obj_t qp_obj;
+    qp_types_t tp;
+
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+
+    while ((tp = qp_next(&unpacker, &qp_obj)) != QP_END)
+    {
+        bench_sink += tp;
+    }
+}
+
+int main()
+{
+    qp_packer_t * packer = qp_packer_new(QP_SUGGESTED_SIZE);
+
+    bench_init("qpack");
+
+    bench_run("pack", NOBJ, bench_pack, packer);
+    bench_run("next", NOBJ, bench_next, packer);
+
+    qp_packer_free(packer);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/python3
+'''Show benchmark results and compare them with a baseline.
+
+Usage:
+
+    python3 compare.py results.csv [baseline.csv] [--threshold 10]
+
+Results can be CSV or JSON, as written by bench.sh. When a baseline is given
+the exit code is 1 if at least one benchmark is more than `threshold`
+percent slower than in the baseline.
+'''
+import argparse
+import csv
+import json
+import sys
+
+
+def read_results(fn):
+    with open(fn, 'r') as f:
+        if fn.endswith('.json'):
+            rows = json.load(f)
+        else:
+            rows = list(csv.DictReader(f))
+    return {
+        '{}/{}'.format(row['suite'], row['name']): float(row['ns_per_op'])
+        for row in rows}
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('results')
+    parser.add_argument('baseline', nargs='?')
+    parser.add_argument(
+        '--threshold',
+        type=float,
+        default=10.0,
+        help='allowed slow down in percent (default: 10)')
+    args = parser.parse_args()
+
+    results = read_results(args.results)
+    baseline = read_results(args.baseline) if args.baseline else {}
+    regressions = 0
+
+    for name, ns_op in results.items():
+        if name not in baseline:
+            print('{:<40} {:>12.3f} ns/op'.format(name, ns_op))
+            continue
+
+        diff = (ns_op / baseline[name] - 1.0) * 100.0 \
+            if baseline[name] else 0.0
+        regression = diff > args.threshold
+        regressions += regression
+
+        print('{:<40} {:>12.3f} ns/op {:>+8.1f}%{}'.format(
+            name,
+            ns_op,
+            diff,
+            '  REGRESSION' if regression else ''))
+
+    if regressions:
+        print('{} benchmark(s) are more than {}% slower than the baseline'
+              .format(regressions, args.threshold))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
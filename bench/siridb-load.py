@@ -0,0 +1,313 @@
+#!/usr/bin/python3
+'''Load generator for a running SiriDB server.
+
+Runs a fixed mix of inserts and selects with a number of parallel workers
+and reports the throughput and latency percentiles for each kind of
+request. The data set only depends on --seed so runs can be compared.
+
+Example:
+
+    python3 siridb-load.py -s localhost:9000 --duration 30 --parallel 8
+'''
+import argparse
+import asyncio
+import csv
+import json
+import random
+import sys
+import time
+from siridb.connector import SiriDBClient
+
+
+PERCENTILES = (('p50', 50.0), ('p90', 90.0), ('p99', 99.0), ('p999', 99.9))
+
+SELECTS = {
+    # select the last points written to a single series
+    'select_points':
+        'select * from "{series}" between {start} and {end}',
+    # aggregate a single series
+    'select_mean':
+        'select mean({group}) from "{series}" between {start} and {end}',
+    # aggregate many series and merge them into one result
+    'select_merge':
+        'select max({group}) from /bench-{prefix}.*/ '
+        'between {start} and {end} merge as "max" using max(1)',
+}
+
+
+class Stats:
+
+    def __init__(self, name):
+        self.name = name
+        self.latencies = []
+        self.points = 0
+        self.errors = 0
+
+    def percentile(self, p):
+        if not self.latencies:
+            return 0.0
+        values = sorted(self.latencies)
+        return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+    def row(self, duration):
+        n = len(self.latencies)
+        row = {
+            'name': self.name,
+            'requests': n,
+            'errors': self.errors,
+            'requests_per_sec': round(n / duration, 3),
+            'points_per_sec': round(self.points / duration, 3),
+        }
+        for name, p in PERCENTILES:
+            row[name + '_ms'] = round(self.percentile(p) * 1e3, 3)
+        row['max_ms'] = round(max(self.latencies, default=0.0) * 1e3, 3)
+        return row
+
+
+class Load:
+
+    def __init__(self, args, ts_factor):
+        self.args = args
+        self.ts_factor = ts_factor
+        self.names = [
+            'bench-{:03d}-{:06d}'.format(i % 100, i)
+            for i in range(args.num_series)]
+        # all series start at the same time-stamp and share one clock
+        self.ts = args.start_ts
+        self.stats = {'insert': Stats('insert')}
+        self.stats.update({name: Stats(name) for name in args.selects})
+
+    def get_insert(self, r):
+        args = self.args
+        series = r.sample(self.names, args.series_per_insert)
+        data = {}
+        for name in series:
+            ts = self.ts
+            points = []
+            for _ in range(args.points_per_series):
+                ts += args.interval
+                points.append([ts * self.ts_factor, r.randint(0, 1000)])
+            data[name] = points
+        self.ts += args.interval * args.points_per_series
+        return data
+
+    def get_select(self, r, name):
+        end = self.ts
+        start = max(self.args.start_ts, end - self.args.select_window)
+        return SELECTS[name].format(
+            series=r.choice(self.names),
+            prefix='{:02d}'.format(r.randrange(10)),
+            group='{}s'.format(self.args.interval * 10),
+            start=start * self.ts_factor,
+            end=end * self.ts_factor)
+
+    async def request(self, stats, coro, points=0):
+        start = time.perf_counter()
+        try:
+            await coro
+        except Exception:
+            stats.errors += 1
+        else:
+            stats.latencies.append(time.perf_counter() - start)
+            stats.points += points
+
+    async def worker(self, siri, n, until):
+        args = self.args
+        r = random.Random(args.seed + n)
+        while time.perf_counter() < until:
+            if not args.selects or r.random() >= args.select_ratio:
+                data = self.get_insert(r)
+                await self.request(
+                    self.stats['insert'],
+                    siri.insert(data),
+                    sum(len(p) for p in data.values()))
+            else:
+                name = r.choice(args.selects)
+                await self.request(
+                    self.stats[name],
+                    siri.query(self.get_select(r, name)))
+
+
+async def get_ts_factor(siri):
+    res = await siri.query('show time_precision')
+    return 10**(['s', 'ms', 'us', 'ns'].index(res['data'][0]['value'])*3)
+
+
+async def run(siri, args):
+    await siri.connect()
+    try:
+        load = Load(args, await get_ts_factor(siri))
+
+        # make sure all series exist before measuring
+        if args.warmup:
+            for i in range(0, args.num_series, args.series_per_insert):
+                await siri.insert({
+                    name: [[load.ts * load.ts_factor, 0]]
+                    for name in load.names[i:i + args.series_per_insert]})
+            load.ts += args.interval
+
+        start = time.perf_counter()
+        until = start + args.duration
+        await asyncio.gather(*(
+            load.worker(siri, n, until) for n in range(args.parallel)))
+        duration = time.perf_counter() - start
+    finally:
+        siri.close()
+
+    return [stats.row(duration) for stats in load.stats.values()]
+
+
+def write_rows(rows, fmt, f):
+    if fmt == 'json':
+        json.dump(rows, f, indent=2)
+        f.write('\n')
+    elif fmt == 'csv':
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+    else:
+        for row in rows:
+            f.write(
+                '{name:<16} {requests_per_sec:>10.1f} req/s '
+                '{points_per_sec:>12.1f} points/s '
+                'p50 {p50_ms:>8.3f} ms  p99 {p99_ms:>8.3f} ms  '
+                'p99.9 {p999_ms:>8.3f} ms  errors {errors}\n'
+                .format_map(row))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+
+    parser.add_argument(
+        '-u', '--user',
+        type=str,
+        default='iris',
+        help='database user')
+
+    parser.add_argument(
+        '-p', '--password',
+        type=str,
+        default='siri',
+        help='password')
+
+    parser.add_argument(
+        '-d', '--dbname',
+        type=str,
+        default='dbtest',
+        help='database name')
+
+    parser.add_argument(
+        '-s', '--servers',
+        type=str,
+        default='localhost:9000',
+        help='siridb server(s)')
+
+    parser.add_argument(
+        '--seed',
+        type=int,
+        default=0,
+        help='seed for generating data (default: 0)')
+
+    parser.add_argument(
+        '--duration',
+        type=float,
+        default=10.0,
+        help='number of seconds to generate load (default: 10)')
+
+    parser.add_argument(
+        '--parallel',
+        type=int,
+        default=4,
+        help='number of parallel requests (default: 4)')
+
+    parser.add_argument(
+        '--num-series',
+        type=int,
+        default=1000,
+        help='number of series (default: 1000)')
+
+    parser.add_argument(
+        '--series-per-insert',
+        type=int,
+        default=100,
+        help='number of series in each insert request (default: 100)')
+
+    parser.add_argument(
+        '--points-per-series',
+        type=int,
+        default=10,
+        help='number of points for each series in an insert (default: 10)')
+
+    parser.add_argument(
+        '--interval',
+        type=int,
+        default=10,
+        help='seconds between points (default: 10)')
+
+    parser.add_argument(
+        '--start-ts',
+        type=int,
+        default=1577836800,
+        help='time-stamp in seconds for the first point '
+             '(default: 2020-01-01)')
+
+    parser.add_argument(
+        '--select-ratio',
+        type=float,
+        default=0.2,
+        help='part of the requests which are selects (default: 0.2)')
+
+    parser.add_argument(
+        '--select-window',
+        type=int,
+        default=3600,
+        help='number of seconds selected by queries (default: 3600)')
+
+    parser.add_argument(
+        '--selects',
+        nargs='*',
+        default=sorted(SELECTS),
+        choices=sorted(SELECTS),
+        help='select queries to run (default: all)')
+
+    parser.add_argument(
+        '--no-warmup',
+        dest='warmup',
+        action='store_false',
+        help='do not create all series before generating load')
+
+    parser.add_argument(
+        '-f', '--format',
+        default='text',
+        choices=['text', 'csv', 'json'],
+        help='output format (default: text)')
+
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        help='write the results to a file instead of stdout')
+
+    args = parser.parse_args()
+
+    if args.num_series < args.series_per_insert:
+        exit('num-series must be equal or greater than series-per-insert')
+
+    if args.parallel < 1:
+        exit('parallel must be > 0')
+
+    siri = SiriDBClient(
+        username=args.user,
+        password=args.password,
+        dbname=args.dbname,
+        hostlist=[
+            [s.strip() for s in server.split(':')]
+            for server in args.servers.split(',')])
+
+    loop = asyncio.new_event_loop()
+    rows = loop.run_until_complete(run(siri, args))
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            write_rows(rows, args.format, f)
+    else:
+        write_rows(rows, args.format, sys.stdout)
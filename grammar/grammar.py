@@ -59,6 +59,7 @@ class SiriGrammar(Grammar):
     k_between = Keyword('between')
     k_buffer_path = Keyword('buffer_path')
     k_buffer_size = Keyword('buffer_size')
+    k_codec = Keyword('codec')
     k_count = Keyword('count')
     k_create = Keyword('create')
     k_critical = Keyword('critical')
@@ -68,6 +69,7 @@ class SiriGrammar(Grammar):
     k_debug = Keyword('debug')
     k_derivative = Keyword('derivative')
     k_difference = Keyword('difference')
+    k_distinct = Keyword('distinct')
     k_drop = Keyword('drop')
     k_drop_threshold = Keyword('drop_threshold')
     k_duration_log = Keyword('duration_log')
@@ -121,6 +123,7 @@ class SiriGrammar(Grammar):
     k_merge = Keyword('merge')
     k_min = Keyword('min')
     k_modify = Keyword('modify')
+    k_moved = Keyword('moved')
     k_name = Keyword('name')
     k_nan = Keyword('nan')
     k_ninf = Sequence('-', k_inf)
@@ -131,12 +134,17 @@ class SiriGrammar(Grammar):
     k_open_files = Keyword('open_files')
     k_or = Keyword('or')
     k_password = Keyword('password')
+    k_percentile = Keyword('percentile')
+    k_placement = Keyword('placement')
     k_points = Keyword('points')
     k_pool = Keyword('pool')
     k_pools = Keyword('pools')
     k_port = Keyword('port')
     k_prefix = Keyword('prefix')
+    k_profile = Keyword('profile')
     k_pvariance = Keyword('pvariance')
+    k_query_cache_hit_rate = Keyword('query_cache_hit_rate')
+    k_query_cache_time_saved = Keyword('query_cache_time_saved')
     k_read = Keyword('read')
     k_received_points = Keyword('received_points')
     k_reindex_progress = Keyword('reindex_progress')
@@ -153,6 +161,7 @@ class SiriGrammar(Grammar):
     k_show = Keyword('show')
     k_sid = Keyword('sid')
     k_size = Keyword('size')
+    k_slots = Keyword('slots')
     k_start = Keyword('start')
     k_startup_time = Keyword('startup_time')
     k_status = Keyword('status')
@@ -169,6 +178,7 @@ class SiriGrammar(Grammar):
     k_tags = Keyword('tags')
     k_tail = Keyword('tail')
     k_tee = Keyword('tee')
+    k_tee_lag = Keyword('tee_lag')
     k_time_precision = Keyword('time_precision')
     k_timeit = Keyword('timeit')
     k_timeval = Keyword('timeval')
@@ -313,6 +323,8 @@ class SiriGrammar(Grammar):
         k_pool,
         k_servers,
         k_series,
+        k_slots,
+        k_moved,
         most_greedy=False)
     pool_columns = List(pool_props, ',', 1)
 
@@ -528,6 +540,12 @@ class SiriGrammar(Grammar):
     f_last = Sequence(
         k_last,
         '(', Optional(time_expr), ')')
+    f_percentile = Sequence(
+        k_percentile,
+        '(', r_float, Optional(Sequence(',', time_expr)), ')')
+    f_distinct = Sequence(
+        k_distinct,
+        '(', Optional(time_expr), ')')
     f_offset = Sequence(
         k_offset,
         '(', time_expr, ')')
@@ -583,6 +601,8 @@ class SiriGrammar(Grammar):
         f_median,
         f_median_low,
         f_median_high,
+        f_percentile,
+        f_distinct,
         f_min,
         f_max,
         f_count,
@@ -618,6 +638,7 @@ class SiriGrammar(Grammar):
         string,
         most_greedy=False))
     set_backup_mode = Sequence(k_set, k_backup_mode, _boolean)
+    set_codec = Sequence(k_set, k_codec, string)
     set_drop_threshold = Sequence(k_set, k_drop_threshold, r_float)
     set_expression = Sequence(k_set, k_expression, r_regex)
     set_ignore_threshold = Sequence(k_set, k_ignore_threshold, _boolean)
@@ -643,6 +664,7 @@ class SiriGrammar(Grammar):
         Optional(set_ignore_threshold))
 
     alter_database = Sequence(k_database, Choice(
+        set_codec,
         set_drop_threshold,
         set_list_limit,
         set_select_points_limit,
@@ -835,6 +857,7 @@ class SiriGrammar(Grammar):
         k_active_tasks,
         k_buffer_path,
         k_buffer_size,
+        k_codec,
         k_dbname,
         k_dbpath,
         k_drop_threshold,
@@ -852,7 +875,10 @@ class SiriGrammar(Grammar):
         k_max_open_files,
         k_mem_usage,
         k_open_files,
+        k_placement,
         k_pool,
+        k_query_cache_hit_rate,
+        k_query_cache_time_saved,
         k_received_points,
         k_reindex_progress,
         k_selected_points,
@@ -862,6 +888,7 @@ class SiriGrammar(Grammar):
         k_status,
         k_sync_progress,
         k_tee,
+        k_tee_lag,
         k_time_precision,
         k_timezone,
         k_uptime,
@@ -872,10 +899,12 @@ class SiriGrammar(Grammar):
 
     timeit_stmt = Repeat(k_timeit, 1, 1)
 
+    profile_stmt = Repeat(k_profile, 1, 1)
+
     help_stmt = Ref()
 
     START = Sequence(
-        Optional(timeit_stmt),
+        Optional(Choice(timeit_stmt, profile_stmt)),
         Optional(Choice(
             select_stmt,
             list_stmt,
@@ -0,0 +1,48 @@
+/*
+ * heap.h - Binary min-heap with 64bit keys.
+ *
+ * The node with the smallest key is always at the top. Nodes with equal keys
+ * are returned in no particular order.
+ */
+#ifndef HEAP_H_
+#define HEAP_H_
+
+#define HEAP_DEFAULT_SIZE 8
+
+typedef struct heap_s heap_t;
+typedef struct heap_node_s heap_node_t;
+typedef void (*heap_destroy_cb)(void *);
+
+#include <inttypes.h>
+#include <stddef.h>
+
+heap_t * heap_new(size_t size);
+void heap_destroy(heap_t * heap, heap_destroy_cb cb);
+int heap_push(heap_t ** heap, uint64_t key, void * data);
+void * heap_pop(heap_t * heap);
+
+/*
+ * Returns the node with the smallest key or NULL when the heap is empty.
+ * The node is only valid until the heap is changed.
+ */
+#define heap_peek(heap) ((heap)->len ? (heap)->nodes : NULL)
+
+/*
+ * Destroy the heap.
+ */
+#define heap_free(heap) free(heap)
+
+struct heap_node_s
+{
+    uint64_t key;
+    void * data;
+};
+
+struct heap_s
+{
+    size_t size;
+    size_t len;
+    heap_node_t nodes[];
+};
+
+#endif  /* HEAP_H_ */
@@ -1,9 +1,18 @@
 /*
  * logger.h - Logging module.
+ *
+ * Until logger_start() is called, log lines are written directly by the
+ * calling thread. Once started, each thread formats its log lines into its
+ * own ring buffer and a single writer thread writes them to the stream, so
+ * logging never waits for the stream. Lines from one thread keep their order
+ * but lines from different threads may be written in a slightly different
+ * order. A line is dropped when the ring of a thread is full, in which case
+ * Logger.dropped is incremented. Critical lines are always written directly.
  */
 #ifndef LOGGER_H_
 #define LOGGER_H_
 
+#include <inttypes.h>
 #include <stdio.h>
 #ifdef __APPLE__
 typedef struct __sFILE LOGGER_IO_FILE;
@@ -21,11 +30,18 @@ typedef struct _IO_FILE LOGGER_IO_FILE;
 
 #define LOGGER_FLAG_COLORED 1
 
+#define LOGGER_RING_SZ 256      /* log lines per thread, must be 2^n      */
+#define LOGGER_LINE_SZ 512      /* longer lines are truncated             */
+#define LOGGER_POLL_MS 10       /* writer thread sleep time when idle     */
+
 typedef struct logger_s logger_t;
 
 void logger_init(LOGGER_IO_FILE * ostream, int log_level);
 void logger_set_level(int log_level);
 const char * logger_level_name(int log_level);
+int logger_start(void);
+void logger_stop(void);
+uint64_t logger_dropped(void);
 
 void log__debug(const char * fmt, ...);
 void log__info(const char * fmt, ...);
@@ -56,8 +72,7 @@ extern logger_t Logger;
         log__critical(fmt, ##__VA_ARGS__)   \
 
 #define LOGC(fmt, ...) \
-    fprintf(Logger.ostream, "%s:%d ", __FILE__, __LINE__); \
-    log_critical(fmt, ##__VA_ARGS__)
+    log_critical("%s:%d " fmt, __FILE__, __LINE__, ##__VA_ARGS__)
 
 struct logger_s
 {
@@ -65,6 +80,7 @@ struct logger_s
     int level;
     const char * level_name;
     int flags;
+    uint64_t dropped;       /* lines dropped because a ring was full    */
 };
 
 #endif  /* LOGGER_H_ */
@@ -0,0 +1,66 @@
+/*
+ * lproto.h - Zero-copy parser for the line protocol.
+ *
+ * Each line has the format:
+ *
+ *  measurement[,tag=value...] field=value[,field=value...] [timestamp]
+ *
+ * Keys, field names and string values are returned as pointers into the
+ * source data and are un-escaped in place so the source data must be
+ * writable. The tags of a key are sorted by tag key so the same measurement
+ * with the same tags always results in the same key.
+ */
+#ifndef LPROTO_H_
+#define LPROTO_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+
+typedef enum
+{
+    LPROTO_INT64,
+    LPROTO_DOUBLE,
+    LPROTO_STRING,
+} lproto_tp_t;
+
+enum
+{
+    LPROTO_ERR=-1,
+    LPROTO_END,
+    LPROTO_OK,
+};
+
+typedef struct lproto_s lproto_t;
+typedef struct lproto_field_s lproto_field_t;
+
+void lproto_init(lproto_t * lp, char * data, size_t n);
+int lproto_next_line(lproto_t * lp);
+int lproto_next_field(lproto_t * lp, lproto_field_t * field);
+
+struct lproto_s
+{
+    char * pt;              /* start of the next line */
+    char * end;
+    char * key;             /* measurement with tags for the current line */
+    size_t key_n;
+    char * fields;          /* next field for the current line */
+    char * fields_end;
+    int64_t ts;
+    int has_ts;
+};
+
+struct lproto_field_s
+{
+    const char * name;
+    size_t name_n;
+    lproto_tp_t tp;
+    size_t len;             /* string length, only used by LPROTO_STRING */
+    union
+    {
+        int64_t int64;
+        double real;
+        char * str;
+    } via;
+};
+
+#endif  /* LPROTO_H_ */
@@ -112,6 +112,7 @@ struct qp_packer_s
 qp_packer_t * qp_packer_new(size_t alloc_size);
 void qp_packer_free(qp_packer_t * packer);
 int qp_packer_extend(qp_packer_t * packer, qp_packer_t * source);
+int qp_packer_reserve(qp_packer_t * packer, size_t n);
 int qp_packer_extend_fu(qp_packer_t * packer, qp_unpacker_t * unpacker);
 
 /* unpacker: create and destroy functions */
@@ -173,6 +174,7 @@ static inline int qp_is_raw_term(qp_obj_t * qp_obj)
 
 /* Add to packer functions */
 int qp_add_raw(qp_packer_t * packer, const unsigned char * raw, size_t len);
+int qp_add_raw_alloc(qp_packer_t * packer, unsigned char ** raw, size_t len);
 int qp_add_string(qp_packer_t * packer, const char * str);
 int qp_add_string_term(qp_packer_t * packer, const char * str);
 int qp_add_string_term_n(qp_packer_t * packer, const char * str, size_t n);
@@ -6,6 +6,7 @@
 
 #include <lib/http_parser.h>
 #include <siri/db/db.h>
+#include <siri/db/insertjson.h>
 #include <siri/service/request.h>
 #include <stdbool.h>
 #include <uv.h>
@@ -23,6 +24,7 @@ typedef enum
     SIRI_API_RT_QUERY,
     SIRI_API_RT_INSERT,
     SIRI_APT_RT_SERVICE,
+    SIRI_API_RT_INSERT_LINE,
 } siri_api_req_t;
 
 typedef enum
@@ -33,6 +35,7 @@ typedef enum
     E403_FORBIDDEN,
     E404_NOT_FOUND,
     E405_METHOD_NOT_ALLOWED,
+    E413_PAYLOAD_TOO_LARGE,
     E415_UNSUPPORTED_MEDIA_TYPE,
     E422_UNPROCESSABLE_ENTITY,
     E500_INTERNAL_SERVER_ERROR,
@@ -49,6 +52,7 @@ int siri_api_send(
         siri_api_header_t ht,
         unsigned char * src,
         size_t n);
+void siri_api_free_request(siri_api_request_t * ar);
 
 struct siri_api_request_s
 {
@@ -61,6 +65,8 @@ struct siri_api_request_s
     size_t len;
     size_t size;
     uv_stream_t * stream;
+    siridb_insertjson_t * insertjson;   /* used for streaming JSON inserts */
+    siridb_timep_t precision;           /* line protocol time precision */
     siri_api_content_t content_type;
     siri_api_req_t request_type;
     service_request_t service_type;
@@ -31,6 +31,8 @@ struct siri_cfg_s
     uint16_t listen_client_port;
     uint16_t listen_backend_port;
     uint16_t heartbeat_interval;
+    uint16_t server_connections;
+    uint16_t insert_coalesce_window;
     uint16_t max_open_files;
 
     uint16_t http_status_port;
@@ -38,6 +40,7 @@ struct siri_cfg_s
     uint8_t pipe_support;
     uint8_t ip_support;
     uint8_t shard_compression;
+    uint8_t select_compression;
     uint8_t shard_auto_duration;
 
     char * bind_client_addr;
@@ -20,6 +20,8 @@ siridb_points_t * siridb_aggregate_run(
 void siridb_init_aggregates(void);
 vec_t * siridb_aggregate_list(cleri_children_t * children, char * err_msg);
 void siridb_aggregate_list_free(vec_t * alist);
+int siridb_aggregate_list_pack(vec_t * alist, qp_packer_t * packer);
+vec_t * siridb_aggregate_list_unpack(qp_unpacker_t * unpacker);
 int siridb_aggregate_can_skip(cleri_children_t * children);
 
 struct siridb_aggr_s
@@ -31,6 +33,7 @@ struct siridb_aggr_s
     uint64_t limit;
     uint64_t offset;
     double timespan;  /* used for derivative        */
+    double percentile;  /* used for percentile  */
     pcre2_code * regex;             \
     pcre2_match_data * match_data;
     qp_via_t filter_via;
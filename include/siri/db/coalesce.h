@@ -0,0 +1,52 @@
+/*
+ * coalesce.h - Combine forwarded inserts for the same pool.
+ *
+ * Clients sending many small inserts would cause one package and promise for
+ * each pool for each insert. Within a short time window, which is set with
+ * insert_coalesce_window, the points for a pool from different inserts are
+ * combined into one package.
+ * The response for the combined package is used as the response of the pool
+ * for each of the inserts, so each client still gets its own response.
+ */
+#ifndef SIRIDB_COALESCE_H_
+#define SIRIDB_COALESCE_H_
+
+#define SIRIDB_COALESCE_MAX_SIZE 1048576    /* send a batch at this size */
+
+typedef struct siridb_coalesce_s siridb_coalesce_t;
+typedef struct siridb_coalesce_batch_s siridb_coalesce_batch_t;
+
+#include <inttypes.h>
+#include <qpack/qpack.h>
+#include <siri/db/db.h>
+#include <siri/net/promises.h>
+#include <uv.h>
+#include <vec/vec.h>
+
+siridb_coalesce_t * siridb_coalesce_new(siridb_t * siridb);
+void siridb_coalesce_free(siridb_coalesce_t * coalesce);
+int siridb_coalesce_add(
+        siridb_coalesce_t * coalesce,
+        uint16_t pool,
+        uint8_t tp,
+        qp_packer_t * packer,
+        sirinet_promises_t * promises);
+
+struct siridb_coalesce_batch_s
+{
+    uint8_t tp;                 /* BPROTO_INSERT_POOL or _TEST_POOL     */
+    qp_packer_t * packer;       /* NULL when the batch is empty         */
+    vec_t * promises;           /* sirinet_promises_t for each insert   */
+};
+
+struct siridb_coalesce_s
+{
+    siridb_t * siridb;
+    uv_timer_t * timer;         /* NULL when no batch is waiting        */
+    uint16_t n;                 /* number of batches                    */
+    uint64_t inserts;           /* number of combined inserts           */
+    uint64_t packages;          /* number of sent packages              */
+    siridb_coalesce_batch_t * batches;  /* one batch for each pool      */
+};
+
+#endif  /* SIRIDB_COALESCE_H_ */
@@ -8,7 +8,7 @@ typedef struct siridb_s siridb_t;
 
 #define SIRIDB_MAX_SIZE_ERR_MSG 1024
 #define SIRIDB_MAX_DBNAME_LEN 256  /*    255 + NULL     */
-#define SIRIDB_SCHEMA 7
+#define SIRIDB_SCHEMA 9
 #define SIRIDB_FLAG_REINDEXING 1
 #define SIRIDB_FLAG_DROPPED 2
 
@@ -16,6 +16,14 @@ typedef struct siridb_s siridb_t;
 #define DEF_SELECT_POINTS_LIMIT 1000000     /* one million  */
 #define DEF_LIST_LIMIT 10000                /* ten thousand */
 
+enum
+{
+    SIRIDB_CODEC_DEFAULT,       /* byte codec for all types             */
+    SIRIDB_CODEC_GORILLA,       /* bit-packed codec for float series    */
+    SIRIDB_CODEC_BITPACK,       /* bit-packed codec for float and int   */
+    SIRIDB_CODEC_END
+};
+
 #include <string.h>
 #include <uv.h>
 #include <qpack/qpack.h>
@@ -29,6 +37,9 @@ typedef struct siridb_s siridb_t;
 #include <siri/db/user.h>
 #include <siri/db/server.h>
 #include <siri/db/pools.h>
+#include <siri/db/qcache.h>
+#include <siri/db/coalesce.h>
+#include <siri/db/expire.h>
 #include <siri/db/fifo.h>
 #include <siri/db/replicate.h>
 #include <siri/db/reindex.h>
@@ -38,6 +49,7 @@ typedef struct siridb_s siridb_t;
 #include <siri/db/buffer.h>
 #include <siri/db/tee.h>
 #include <siri/db/tags.h>
+#include <siri/db/zones.h>
 
 
 int32_t siridb_get_uptime(siridb_t * siridb);
@@ -54,6 +66,8 @@ int siridb_save(siridb_t * siridb);
 void siridb__free(siridb_t * siridb);
 void siridb_drop(siridb_t * siridb);
 void siridb_update_shard_expiration(siridb_t * siridb);
+int siridb_codec_by_name(const char * name, size_t n);
+const char * siridb_codec_name(uint8_t codec);
 
 #define siridb_incref(siridb__) __atomic_add_fetch(&(siridb__)->ref, 1, __ATOMIC_SEQ_CST)
 #define siridb_decref(siridb__) \
@@ -64,7 +78,8 @@ struct siridb_s
 {
     uint16_t ref;
     uint8_t flags;
-    uint8_t pad0;
+    uint8_t codec;
+    uint8_t placement;              /* see siridb_placement_t           */
     uint32_t max_series_id;
     uint16_t insert_tasks;
     uint16_t shard_mask_num;
@@ -94,6 +109,7 @@ struct siridb_s
     siridb_pools_t * pools;
     ct_t * series;
     imap_t * series_map;
+    uint32_t * series_slots;        /* local series for each lookup slot */
     uv_mutex_t series_mutex;
     uv_mutex_t shards_mutex;
     uv_mutex_t values_mutex;
@@ -107,6 +123,10 @@ struct siridb_s
     siridb_tags_t * tags;
     siridb_buffer_t * buffer;
     siridb_tee_t * tee;
+    siridb_qcache_t * qcache;
+    siridb_coalesce_t * coalesce;
+    siridb_expire_t * expire;       /* heap with shards to expire       */
+    siridb_zones_t * zones;         /* NULL until needed                */
     siridb_tasks_t tasks;
 };
 
@@ -0,0 +1,41 @@
+/*
+ * expire.h - Shard expiration for a SiriDB database.
+ *
+ * Shards are kept in a min-heap ordered by the time the shard ends, one heap
+ * for number and one for log shards. The heap is ordered by the end of a
+ * shard and not by the expiration time so changing the expiration of a
+ * database does not require the heap to be rebuilt.
+ *
+ * A heap node does not hold a reference to the shard. When the node is
+ * popped, the shard is looked up by id and duration and when it is not found
+ * the shard is already dropped and the node is simply ignored.
+ */
+#ifndef SIRIDB_EXPIRE_H_
+#define SIRIDB_EXPIRE_H_
+
+#define SIRIDB_EXPIRE_NEVER UINT64_MAX
+
+typedef struct siridb_expire_s siridb_expire_t;
+
+#include <heap/heap.h>
+#include <inttypes.h>
+#include <siri/db/db.h>
+#include <uv.h>
+
+siridb_expire_t * siridb_expire_new(void);
+void siridb_expire_free(siridb_expire_t * expire);
+int siridb_expire_add(
+        siridb_expire_t * expire,
+        uint64_t id,
+        uint64_t duration,
+        uint8_t tp);
+uint64_t siridb_expire_next(siridb_t * siridb);
+size_t siridb_expire_drop(siridb_t * siridb);
+
+struct siridb_expire_s
+{
+    uv_mutex_t mutex;
+    heap_t * heap[2];       /* one for each shard type (number and log) */
+};
+
+#endif  /* SIRIDB_EXPIRE_H_ */
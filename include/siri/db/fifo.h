@@ -13,6 +13,7 @@ typedef struct siridb_fifo_s siridb_fifo_t;
 
 
 siridb_fifo_t * siridb_fifo_new(siridb_t * siridb);
+siridb_fifo_t * siridb_fifo_new_path(const char * path);
 void siridb_fifo_free(siridb_fifo_t * fifo);
 size_t siridb_fifo_size(siridb_fifo_t * fifo);
 int siridb_fifo_append(siridb_fifo_t * fifo, sirinet_pkg_t * pkg);
@@ -9,9 +9,15 @@
 #define INSERT_FLAG_POOL 4
 #define INSERT_FLAG_INIT_REPL 8
 
+#define INSERT_TIMEOUT 300000  /* 5 minutes */
+
 typedef enum
 {
-    ERR_EXPECTING_ARRAY=-10,
+    ERR_INSERT_TOO_LARGE=-14,
+    ERR_INVALID_LINE,
+    ERR_INVALID_JSON,
+    ERR_POOLS_CHANGED,
+    ERR_EXPECTING_ARRAY,
     ERR_EXPECTING_SERIES_NAME,
     ERR_EXPECTING_MAP_OR_ARRAY,
     ERR_EXPECTING_INTEGER_TS,
@@ -38,12 +44,21 @@ typedef struct siridb_insert_local_s siridb_insert_local_t;
 #include <siri/db/forward.h>
 #include <uv.h>
 #include <siri/db/pcache.h>
+#include <siri/db/time.h>
 
 ssize_t siridb_insert_assign_pools(
         siridb_t * siridb,
         qp_unpacker_t * unpacker,
         qp_packer_t * packer[]);
+ssize_t siridb_insert_assign_lines(
+        siridb_t * siridb,
+        char * data,
+        size_t n,
+        siridb_timep_t precision,
+        qp_packer_t * packer[],
+        size_t * pos);
 const char * siridb_insert_err_msg(siridb_insert_err_t err);
+uint16_t siridb_insert_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name);
 siridb_insert_t * siridb_insert_new(
         siridb_t * siridb,
         uint16_t pid,
@@ -65,6 +80,7 @@ struct siridb_insert_s
     uint16_t packer_size; /* number of packers (one for each pool) */
     sirinet_stream_t * client;
     size_t npoints;        /* number of points */
+    uint64_t start;        /* time received, see siri_metrics_now() */
     qp_packer_t * packer[];
 };
 
@@ -0,0 +1,41 @@
+/*
+ * insertjson.h - Streaming JSON parser for inserts using the HTTP API.
+ */
+#ifndef SIRIDB_INSERTJSON_H_
+#define SIRIDB_INSERTJSON_H_
+
+typedef struct siridb_insertjson_s siridb_insertjson_t;
+
+#include <qpack/qpack.h>
+#include <siri/db/db.h>
+#include <siri/db/insert.h>
+#include <siri/net/stream.h>
+#include <yajl/yajl_parse.h>
+
+siridb_insertjson_t * siridb_insertjson_new(
+        siridb_t * siridb,
+        sirinet_stream_t * client);
+void siridb_insertjson_free(siridb_insertjson_t * ijson);
+void siridb_insertjson_feed(
+        siridb_insertjson_t * ijson,
+        const char * data,
+        size_t n);
+ssize_t siridb_insertjson_done(siridb_insertjson_t * ijson);
+siridb_insert_t * siridb_insertjson_take(siridb_insertjson_t * ijson);
+
+struct siridb_insertjson_s
+{
+    uint8_t state;
+    uint8_t flags;
+    uint16_t pool;          /* pool for the current series */
+    int err;                /* 0 or a siridb_insert_err_t value */
+    ssize_t count;          /* number of points processed */
+    size_t pos;             /* number of bytes fed to the parser */
+    siridb_t * siridb;
+    siridb_insert_t * insert;
+    qp_packer_t * packer;   /* packer which receives the current points */
+    qp_packer_t * tmp_packer;
+    yajl_handle handle;
+};
+
+#endif  /* SIRIDB_INSERTJSON_H_ */
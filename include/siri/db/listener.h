@@ -8,6 +8,7 @@
 #include <siri/grammar/grammar.h>
 
 void siridb_init_listener(void);
+void siridb_listener_run_plan(uv_async_t * handle);
 
 uv_async_cb siridb_node_get_enter(enum cleri_grammar_ids gid);
 uv_async_cb siridb_node_get_exit(enum cleri_grammar_ids gid);
@@ -1,22 +1,51 @@
 /*
  * lookup.h - Find and assign to which pool series belong.
+ *
+ * A series name is mapped to one of SIRIDB_LOOKUP_SZ slots and each slot is
+ * assigned to a pool. When a pool is added, only the slots which are moved to
+ * the new pool change, so about 1/(n+1) of the series will move.
+ *
+ * The 'sum' placement uses the sum of the name bytes for finding a slot. This
+ * is the original placement and is kept for existing databases. Similar names
+ * often share the same sum so the 'xxhash' placement is available for new
+ * databases and uses a 64-bit xxHash of the name instead.
  */
 #ifndef SIRIDB_LOOKUP_H_
 #define SIRIDB_LOOKUP_H_
 
-#include <inttypes.h>
-#include <stddef.h>
-
 #define SIRIDB_LOOKUP_SZ 8192
 
-typedef uint_fast16_t siridb_lookup_t[SIRIDB_LOOKUP_SZ];
+typedef enum
+{
+    SIRIDB_PLACEMENT_SUM,       /* sum of the name bytes (default)      */
+    SIRIDB_PLACEMENT_XXHASH,    /* xxHash64 of the name                 */
+    SIRIDB_PLACEMENT_END
+} siridb_placement_t;
+
+typedef struct siridb_lookup_s siridb_lookup_t;
+
+#include <inttypes.h>
+#include <stddef.h>
 
 uint16_t siridb_lookup_sn(siridb_lookup_t * lookup, const char * sn);
+uint16_t siridb_lookup_slot(uint8_t placement, const char * sn, size_t len);
 uint16_t siridb_lookup_sn_raw(
         siridb_lookup_t * lookup,
         const char * sn,
         size_t len);
-siridb_lookup_t * siridb_lookup_new(uint_fast16_t num_pools);
+siridb_lookup_t * siridb_lookup_new(
+        uint_fast16_t num_pools,
+        uint8_t placement);
 void siridb_lookup_free(siridb_lookup_t * lookup);
+size_t siridb_lookup_slots(siridb_lookup_t * lookup, uint16_t pool);
+uint64_t siridb_lookup_xxhash(const char * sn, size_t len);
+int siridb_placement_by_name(const char * name, size_t n);
+const char * siridb_placement_name(uint8_t placement);
+
+struct siridb_lookup_s
+{
+    uint8_t placement;
+    uint_fast16_t pools[SIRIDB_LOOKUP_SZ];
+};
 
 #endif  /* SIRIDB_LOOKUP_H_ */
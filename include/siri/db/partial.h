@@ -0,0 +1,70 @@
+/*
+ * partial.h - Partial aggregation states for merged series.
+ *
+ * When series are merged using an aggregate function, each pool can reduce
+ * its own points to one state per group. The states from all pools are then
+ * combined on the master server which is much cheaper than sending all the
+ * raw points across the cluster. States are only used when the combined
+ * result is equal to the result of the raw points.
+ *
+ * Functions like percentile() and distinct() use a sketch as state. These
+ * sketches are kept next to the states and are packed after the states.
+ */
+#ifndef SIRIDB_PARTIAL_H_
+#define SIRIDB_PARTIAL_H_
+
+/*
+ * Partial states are packed like raw points but with this value added to
+ * the type so the receiver can tell them apart.
+ */
+#define SIRIDB_PARTIAL_TP 0x10
+
+typedef struct siridb_pstate_s siridb_pstate_t;
+typedef struct siridb_partial_s siridb_partial_t;
+
+#include <inttypes.h>
+#include <qpack/qpack.h>
+#include <siri/db/aggregate.h>
+#include <siri/db/points.h>
+#include <siri/db/sketch.h>
+#include <vec/vec.h>
+
+int siridb_partial_is_supported(siridb_aggr_t * aggr);
+int siridb_partial_is_exact(vec_t * plist, siridb_aggr_t * aggr);
+siridb_partial_t * siridb_partial_new(size_t size, points_tp tp);
+void siridb_partial_free(siridb_partial_t * partial);
+void siridb_partial_list_free(vec_t * partials);
+siridb_partial_t * siridb_partial_merge(
+        vec_t * plist,
+        vec_t * partials,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+siridb_points_t * siridb_partial_finalize(
+        siridb_partial_t * partial,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+int siridb_partial_raw_pack(siridb_partial_t * partial, qp_packer_t * packer);
+siridb_partial_t * siridb_partial_raw_unpack(
+        int64_t tp,
+        int64_t len,
+        qp_obj_t * qp_raw,
+        siridb_aggr_t * aggr);
+
+struct siridb_pstate_s
+{
+    uint64_t ts;
+    uint64_t n;
+    qp_via_t sum;       /* only used by sum()                       */
+    qp_via_t min;       /* only used by min()                       */
+    qp_via_t max;       /* only used by max()                       */
+};
+
+struct siridb_partial_s
+{
+    size_t len;
+    points_tp tp;
+    siridb_pstate_t * data;
+    siridb_sketch_t ** sketches;    /* NULL or a sketch for each state  */
+};
+
+#endif  /* SIRIDB_PARTIAL_H_ */
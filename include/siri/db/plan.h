@@ -0,0 +1,64 @@
+/*
+ * plan.h - Binary plan for forwarding select queries to pools.
+ *
+ * The master server has already parsed and walked a select query, so instead
+ * of letting each pool parse the query text again we send a compact plan with
+ * the resolved time range, series names and aggregation methods. The query
+ * text is still sent as well so older servers and queries which cannot be
+ * expressed by a plan keep using the text.
+ */
+#ifndef SIRIDB_PLAN_H_
+#define SIRIDB_PLAN_H_
+
+#define SIRIDB_PLAN_FLAG_SKIP_GET_POINTS 1
+#define SIRIDB_PLAN_FLAG_START_TS 2
+#define SIRIDB_PLAN_FLAG_END_TS 4
+
+typedef struct siridb_plan_s siridb_plan_t;
+typedef struct siridb_plan_method_s siridb_plan_method_t;
+
+#include <inttypes.h>
+#include <qpack/qpack.h>
+#include <siri/db/presuf.h>
+#include <sys/types.h>
+#include <vec/vec.h>
+
+siridb_plan_t * siridb_plan_new(void);
+void siridb_plan_free(siridb_plan_t * plan);
+int siridb_plan_add_series(siridb_plan_t * plan, const char * name);
+int siridb_plan_add_method(
+        siridb_plan_t * plan,
+        siridb_presuf_t * presuf,
+        vec_t * alist);
+qp_packer_t * siridb_plan_pack(
+        siridb_plan_t * plan,
+        int flags,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        ssize_t headtail,
+        const char * merge_as,
+        vec_t * mlist);
+siridb_plan_t * siridb_plan_unpack(unsigned char * data, size_t len);
+
+struct siridb_plan_method_s
+{
+    char * prefix;
+    char * suffix;
+    vec_t * alist;
+};
+
+struct siridb_plan_s
+{
+    int flags;
+    ssize_t headtail;
+    uint64_t start_ts;
+    uint64_t end_ts;
+    char * merge_as;
+    vec_t * mlist;
+    vec_t * series;         /* series names                                 */
+    vec_t * methods;        /* siridb_plan_method_t (only when unpacked)    */
+    qp_packer_t * packer;   /* packed methods (only on the master)          */
+    size_t n;               /* number of packed methods                     */
+};
+
+#endif  /* SIRIDB_PLAN_H_ */
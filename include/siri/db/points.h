@@ -6,6 +6,27 @@
 
 #define POINTS_ZIP_THRESHOLD 5
 
+/*
+ * Estimated size of a packed point, used for allocating a result at once.
+ * (a point packed as columns uses exactly this size)
+ */
+#define POINTS_PACK_SZ 16
+
+/*
+ * Chunks compressed with a bit-packed codec use 0xf for the lower four bits
+ * of cinfo, a value which is never used by the byte codec. The other twelve
+ * bits contain the size of the compressed data.
+ */
+#define POINTS_CINFO_BITPACK 0xf
+
+/*
+ * Points sent between servers using siridb_points_zip_pack() have their
+ * type increased with POINTS_ZIP_TP and are compressed in chunks of at most
+ * POINTS_ZIP_CHUNK points. (must be smaller than SIRIDB_PARTIAL_TP)
+ */
+#define POINTS_ZIP_TP 0x08
+#define POINTS_ZIP_CHUNK 1024
+
 typedef enum
 {
     TP_INT,
@@ -21,7 +42,6 @@ typedef struct siridb_points_s siridb_points_t;
 #include <qpack/qpack.h>
 #include <vec/vec.h>
 
-void siridb_points_init(void);
 siridb_points_t * siridb_points_new(size_t size, points_tp tp);
 void siridb_points_free(siridb_points_t * points);
 int siridb_points_resize(siridb_points_t * points, size_t n);
@@ -33,8 +53,18 @@ void siridb_points_add_point(
         qp_via_t * val);
 siridb_points_t * siridb_points_copy(siridb_points_t * points);
 int siridb_points_pack(siridb_points_t * points, qp_packer_t * packer);
+int siridb_points_pack_columns(siridb_points_t * points, qp_packer_t * packer);
 void siridb_points_ts_correction(siridb_points_t * points, double factor);
 int siridb_points_raw_pack(siridb_points_t * points, qp_packer_t * packer);
+int siridb_points_zip_pack(
+        siridb_points_t * points,
+        qp_packer_t * packer,
+        uint8_t codec);
+siridb_points_t * siridb_points_raw_unpack(
+        int64_t tp,
+        int64_t len,
+        unsigned char * data,
+        size_t size);
 siridb_points_t * siridb_points_merge(vec_t * plist, char * err_msg);
 unsigned char * siridb_points_zip_double(
         siridb_points_t * points,
@@ -42,12 +72,24 @@ unsigned char * siridb_points_zip_double(
         uint_fast32_t end,
         uint16_t * cinfo,
         size_t * size);
+unsigned char * siridb_points_zip_double_bits(
+        siridb_points_t * points,
+        uint_fast32_t start,
+        uint_fast32_t end,
+        uint16_t * cinfo,
+        size_t * size);
 unsigned char * siridb_points_zip_int(
         siridb_points_t * points,
         uint_fast32_t start,
         uint_fast32_t end,
         uint16_t * cinfo,
         size_t * size);
+unsigned char * siridb_points_zip_int_bits(
+        siridb_points_t * points,
+        uint_fast32_t start,
+        uint_fast32_t end,
+        uint16_t * cinfo,
+        size_t * size);
 unsigned char * siridb_points_zip_string(
         siridb_points_t * points,
         uint_fast32_t start,
@@ -110,6 +152,12 @@ struct siridb_points_s
     siridb_point_t * data;
 };
 
+static inline int siridb_points_is_bitpack(uint16_t cinfo, uint16_t len)
+{
+    return len >= POINTS_ZIP_THRESHOLD &&
+            (cinfo & 0xf) == POINTS_CINFO_BITPACK;
+}
+
 static inline size_t siridb_points_get_size_log(size_t cinfo)
 {
     return cinfo & 0x8000 ? (cinfo ^ 0x8000) << 10 : cinfo;
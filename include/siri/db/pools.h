@@ -13,6 +13,7 @@ typedef struct siridb_pools_s siridb_pools_t;
 #include <siri/net/pkg.h>
 #include <siri/net/promise.h>
 #include <siri/net/promises.h>
+#include <sys/types.h>
 #include <vec/vec.h>
 #include <siri/db/lookup.h>
 
@@ -25,6 +26,7 @@ siridb_lookup_t * siridb_pools_gen_lookup(uint_fast16_t num_pools);
 int siridb_pools_online(siridb_t * siridb);
 int siridb_pools_available(siridb_t * siridb);
 int siridb_pools_accessible(siridb_t * siridb);
+ssize_t siridb_pools_moved(siridb_t * siridb);
 void siridb_pools_send_pkg(
         siridb_t * siridb,
         sirinet_pkg_t * pkg,
@@ -12,6 +12,10 @@ void siridb_presuf_free(siridb_presuf_t * presuf);
 siridb_presuf_t * siridb_presuf_add(
         siridb_presuf_t ** presuf,
         cleri_node_t * node);
+siridb_presuf_t * siridb_presuf_add_str(
+        siridb_presuf_t ** presuf,
+        const char * prefix,
+        const char * suffix);
 int siridb_presuf_is_unique(siridb_presuf_t * presuf);
 void siridb_presuf_cleanup(void);
 const char * siridb_presuf_name(
@@ -0,0 +1,86 @@
+/*
+ * profile.h - Execution profile for queries starting with `profile`.
+ *
+ * A profile records wall and CPU time for each stage of a query together
+ * with the shard chunks which are read. Pools return their profile with the
+ * query response, the server which has received the query adds them as
+ * children, together with the round-trip time of the request, and returns
+ * the tree with a total for all servers.
+ */
+#ifndef SIRIDB_PROFILE_H_
+#define SIRIDB_PROFILE_H_
+
+typedef enum
+{
+    SIRIDB_PROFILE_REGEX,       /* match series names with a regular expr.  */
+    SIRIDB_PROFILE_FILTER,      /* where statements on series               */
+    SIRIDB_PROFILE_READ,        /* read points, includes decompress         */
+    SIRIDB_PROFILE_DECOMPRESS,  /* decode compressed shard chunks           */
+    SIRIDB_PROFILE_AGGREGATE,   /* run aggregate functions on series        */
+    SIRIDB_PROFILE_MERGE,       /* unpack and merge responses from pools    */
+    SIRIDB_PROFILE_PACK,        /* pack the select result                   */
+    SIRIDB_PROFILE_END
+} siridb_profile_stage_t;
+
+typedef struct siridb_profile_s siridb_profile_t;
+typedef struct siridb_profile_clock_s siridb_profile_clock_t;
+typedef struct siridb_profile_timer_s siridb_profile_timer_t;
+
+#include <inttypes.h>
+#include <qpack/qpack.h>
+#include <vec/vec.h>
+
+siridb_profile_t * siridb_profile_new(void);
+void siridb_profile_free(siridb_profile_t * profile);
+void siridb_profile_start(
+        siridb_profile_t * profile,
+        siridb_profile_clock_t * clock);
+void siridb_profile_stop(
+        siridb_profile_t * profile,
+        siridb_profile_stage_t stage,
+        siridb_profile_clock_t * clock);
+int siridb_profile_from_unpacker(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker,
+        uint64_t network);
+int siridb_profile_pack(
+        siridb_profile_t * profile,
+        qp_packer_t * packer,
+        const char * server,
+        double time);
+
+/*
+ * The profile for the query which is running on this thread. Shard reads do
+ * not know the query they are reading for so the caller sets this profile
+ * while reading points.
+ */
+extern __thread siridb_profile_t * siridb_profile_local;
+
+struct siridb_profile_clock_s
+{
+    uint64_t wall;          /* microseconds, see siri_metrics_now()         */
+    uint64_t cpu;           /* thread CPU time in microseconds              */
+};
+
+struct siridb_profile_timer_s
+{
+    uint64_t wall;
+    uint64_t cpu;
+    uint64_t count;         /* number of times the stage is timed           */
+};
+
+struct siridb_profile_s
+{
+    char * server;          /* NULL for the local server                    */
+    double time;            /* total query time reported by a pool          */
+    uint64_t network;       /* round-trip time to a pool in microseconds    */
+    siridb_profile_timer_t stages[SIRIDB_PROFILE_END];
+    uint64_t chunks;        /* shard chunks read                            */
+    uint64_t bytes;         /* bytes read from shards                       */
+    uint64_t points;        /* points decoded from the chunks               */
+    uint64_t cache_hits;    /* chunk reads which found the shard file open  */
+    uint64_t cache_misses;  /* chunk reads which had to open the shard file */
+    vec_t * pools;          /* profiles received from pools, can be NULL    */
+};
+
+#endif  /* SIRIDB_PROFILE_H_ */
@@ -0,0 +1,57 @@
+/*
+ * qcache.h - LRU cache for parsed queries.
+ *
+ * Dashboards send the same query text over and over again. A parse result
+ * only depends on the query text since time expressions like 'now' are
+ * evaluated while walking the parse tree, so a cached tree is simply walked
+ * again for each query.
+ */
+#ifndef SIRIDB_QCACHE_H_
+#define SIRIDB_QCACHE_H_
+
+#define SIRIDB_QCACHE_SIZE 256
+#define SIRIDB_QCACHE_MAX_QUERY_LEN 4096  /* longer queries are not cached */
+
+typedef struct siridb_qcache_s siridb_qcache_t;
+typedef struct siridb_qcache_entry_s siridb_qcache_entry_t;
+
+#include <cleri/cleri.h>
+#include <ctree/ctree.h>
+#include <inttypes.h>
+
+siridb_qcache_t * siridb_qcache_new(void);
+void siridb_qcache_free(siridb_qcache_t * qcache);
+siridb_qcache_entry_t * siridb_qcache_get(
+        siridb_qcache_t * qcache,
+        const char * q);
+siridb_qcache_entry_t * siridb_qcache_add(
+        siridb_qcache_t * qcache,
+        char * q,
+        cleri_parse_t * pr,
+        uint64_t parse_time);
+void siridb_qcache_release(siridb_qcache_entry_t * entry);
+double siridb_qcache_hit_rate(siridb_qcache_t * qcache);
+
+struct siridb_qcache_entry_s
+{
+    char * q;               /* the parse result points into this text   */
+    cleri_parse_t * pr;
+    uint64_t parse_time;    /* time it took to parse in nanoseconds     */
+    uint8_t in_use;
+    uint8_t evicted;        /* free when no longer in use               */
+    siridb_qcache_entry_t * prev;
+    siridb_qcache_entry_t * next;
+};
+
+struct siridb_qcache_s
+{
+    ct_t * entries;
+    siridb_qcache_entry_t * head;   /* most recently used               */
+    siridb_qcache_entry_t * tail;   /* least recently used              */
+    size_t n;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t time_saved;            /* parse time saved in nanoseconds  */
+};
+
+#endif  /* SIRIDB_QCACHE_H_ */
@@ -12,6 +12,7 @@
 #include <cleri/cleri.h>
 #include <ctree/ctree.h>
 #include <siri/db/group.h>
+#include <siri/db/plan.h>
 #include <siri/db/presuf.h>
 #include <siri/db/series.h>
 #include <siri/db/tag.h>
@@ -138,6 +139,9 @@ struct query_select_s
     imap_t * points_map;    /* points_map for caching                       */
     vec_t * alist;        /* aggregation list (can be used multiple times)*/
     vec_t * mlist;        /* merge aggregation list                       */
+    ct_t * partials;      /* partial states for merge (only on master)    */
+    siridb_plan_t * plan; /* plan to forward (master) or to run (pool)    */
+    uint64_t lookup_start;  /* reset to 0 once the series are selected    */
 };
 
 #endif  /* SIRIDB_QUERIES_H_ */
@@ -8,6 +8,10 @@
 #define SIRIDB_QUERY_FLAG_REBUILD 2
 #define SIRIDB_QUERY_FLAG_UPDATE_REPLICA 4
 #define SIRIDB_QUERY_FLAG_ERR 8
+#define SIRIDB_QUERY_FLAG_PARTIAL 16   /* master accepts partial states   */
+#define SIRIDB_QUERY_FLAG_FRAMES 32    /* master accepts framed responses */
+#define SIRIDB_QUERY_FLAG_COLUMNS 64   /* client accepts points as columns */
+#define SIRIDB_QUERY_FLAG_ZIP 128      /* master accepts compressed points */
 
 /*
  * Note(*) : servers must be 'accessible' unless FLAG_ONLY_CHECK_ONLINE is used
@@ -41,6 +45,9 @@ typedef struct siridb_query_s siridb_query_t;
 #include <qpack/qpack.h>
 #include <siri/db/time.h>
 #include <siri/db/nodes.h>
+#include <siri/db/plan.h>
+#include <siri/db/profile.h>
+#include <siri/db/qcache.h>
 #include <siri/db/series.h>
 #include <siri/db/db.h>
 #include <siri/net/protocol.h>
@@ -57,6 +64,13 @@ void siridb_query_run(
         size_t q_len,
         float factor,
         int flags);
+void siridb_query_run_plan(
+        uint16_t pid,
+        sirinet_stream_t * client,
+        const char * q,
+        size_t q_len,
+        int flags,
+        siridb_plan_t * plan);
 void siridb_query_free(uv_handle_t * handle);
 void siridb_send_query_result(uv_async_t * handle);
 void siridb_query_send_error(
@@ -86,7 +100,9 @@ struct siridb_query_s
     char err_msg[SIRIDB_MAX_SIZE_ERR_MSG];
     qp_packer_t * packer;
     qp_packer_t * timeit;
+    siridb_profile_t * profile;         /* only set for profile queries */
     cleri_parse_t * pr;
+    siridb_qcache_entry_t * cached;     /* owns pr when not NULL */
     siridb_nodes_t * nodes;
     struct timespec start;
 #if SIRIDB_EXPR_ALLOC
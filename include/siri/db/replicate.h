@@ -41,6 +41,7 @@ struct siridb_replicate_s
     siridb_replicate_status_t status;
     uv_timer_t * timer;
     siridb_initsync_t * initsync;
+    uint64_t pending;   /* packages added but not yet committed             */
 };
 
 #endif  /* SIRIDB_REPLICATE_H_ */
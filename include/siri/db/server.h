@@ -7,6 +7,9 @@
 #define FLAG_KEEP_PKG 1
 #define FLAG_ONLY_CHECK_ONLINE 2
 
+/* maximum value for server_connections in the configuration file */
+#define SIRIDB_SERVER_MAX_CONNECTIONS 8
+
 #define SERVER_FLAG_RUNNING 1
 #define SERVER_FLAG_SYNCHRONIZING 2
 #define SERVER_FLAG_REINDEXING 4
@@ -84,6 +87,7 @@ typedef struct siridb_server_async_s siridb_server_async_t;
 #include <cexpr/cexpr.h>
 #include <uv.h>
 #include <siri/net/promise.h>
+#include <siri/net/twheel.h>
 #include <siri/net/pkg.h>
 #include <siri/net/stream.h>
 
@@ -95,6 +99,10 @@ siridb_server_t * siridb_server_new(
         uint16_t pool);
 
 void siridb_server_connect(siridb_t * siridb, siridb_server_t * server);
+void siridb_server_connect_extra(siridb_t * siridb, siridb_server_t * server);
+void siridb_server_stream_closed(
+        siridb_server_t * server,
+        sirinet_stream_t * client);
 int siridb_server_send_pkg(
         siridb_server_t * server,
         sirinet_pkg_t * pkg,
@@ -102,6 +110,7 @@ int siridb_server_send_pkg(
         sirinet_promise_cb cb,
         void * data,
         int flags);
+int siridb_server_init_promises(siridb_server_t * server);
 void siridb_server_send_flags(siridb_server_t * server);
 int siridb_server_update_address(
         siridb_t * siridb,
@@ -150,7 +159,11 @@ struct siridb_server_s
     char * name; /* this is a format for address:port but we use it a lot */
     char * address;
     omap_t * promises;
-    sirinet_stream_t * client;
+    sirinet_twheel_t * twheel;  /* promise time-outs, only with promises */
+    sirinet_stream_t * client;  /* control connection */
+    sirinet_stream_t * extra[SIRIDB_SERVER_MAX_CONNECTIONS - 1];
+    uint8_t extra_auth;         /* one bit for each authenticated extra */
+    uint8_t extra_next;         /* round-robin for the query connections */
     uint16_t pid;
     /* fixed server properties */
     uint8_t ip_support;
@@ -31,12 +31,14 @@ extern const char shard_type_map[2][7];
 typedef struct siridb_shard_flags_repr_s siridb_shard_flags_repr_t;
 typedef struct siridb_shard_s siridb_shard_t;
 typedef struct siridb_shard_view_s siridb_shard_view_t;
+typedef struct siridb_shard_loader_s siridb_shard_loader_t;
 
 #include <stdio.h>
 #include <siri/db/db.h>
 #include <siri/db/points.h>
 #include <siri/db/series.h>
 #include <siri/file/handler.h>
+#include <imap/imap.h>
 #include <omap/omap.h>
 
 siridb_shard_t * siridb_shard_create(
@@ -52,6 +54,12 @@ int siridb_shard_cexpr_cb(
         cexpr_condition_t * cond);
 int siridb_shard_status(char * str, siridb_shard_t * shard);
 int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration);
+siridb_shard_loader_t * siridb_shard_read(
+        siridb_t * siridb,
+        uint64_t id,
+        uint64_t duration);
+int siridb_shard_apply(siridb_t * siridb, siridb_shard_loader_t * loader);
+void siridb_shard_loader_free(siridb_shard_loader_t * loader);
 void siridb_shard_drop(siridb_shard_t * shard, siridb_t * siridb);
 size_t siridb_shard_write_points(
         siridb_t * siridb,
@@ -109,6 +117,7 @@ int siridb_shard_migrate(
         uint64_t shard_id,
         uint64_t * duration);
 int siridb_shard_optimize(siridb_shard_t * shard, siridb_t * siridb);
+int siridb_shard_add_series(siridb_shard_t * shard, uint32_t series_id);
 void siridb__shard_free(siridb_shard_t * shard);
 void siridb__shard_decref(siridb_shard_t * shard);
 
@@ -131,6 +140,17 @@ struct siridb_shard_s
     siri_fp_t * fp;
     char * fn;
     siridb_shard_t * replacing;
+    imap_t * series;    /* ids of series with chunks, see series_mutex */
+};
+
+struct siridb_shard_loader_s
+{
+    siridb_shard_t * shard;
+    char * data;            /* index entries, not yet applied to series */
+    size_t n_idx;           /* number of entries read from the index file */
+    size_t n_tail;          /* number of entries read from the shard file */
+    unsigned int idx_sz;
+    int is_ts64;
 };
 
 struct siridb_shard_view_s
@@ -0,0 +1,76 @@
+/*
+ * sketch.h - Mergeable sketches for percentile() and distinct().
+ *
+ * A t-digest keeps a sorted list of weighted centroids which are small near
+ * the tails and larger around the median, so extreme percentiles stay
+ * accurate while the number of centroids is bounded by the compression. A
+ * HyperLogLog estimates the number of distinct values from the longest run of
+ * leading zero bits seen by each register.
+ *
+ * Both sketches use a fixed amount of memory, no matter how many values are
+ * added, and two sketches of the same type can be merged. This makes them
+ * usable as partial states when series are merged across pools.
+ */
+#ifndef SIRIDB_SKETCH_H_
+#define SIRIDB_SKETCH_H_
+
+#define SIRIDB_SKETCH_TDIGEST 1
+#define SIRIDB_SKETCH_HLL 2
+
+#define SIRIDB_TDIGEST_DELTA 100    /* compression, higher is more accurate */
+#define SIRIDB_TDIGEST_SZ (SIRIDB_TDIGEST_DELTA + 1)    /* max centroids    */
+#define SIRIDB_TDIGEST_BUF 256      /* values sorted at once while adding   */
+
+#define SIRIDB_HLL_BITS 12
+#define SIRIDB_HLL_SZ (1 << SIRIDB_HLL_BITS)    /* number of registers      */
+
+typedef struct siridb_centroid_s siridb_centroid_t;
+typedef struct siridb_sketch_s siridb_sketch_t;
+
+#include <inttypes.h>
+#include <siri/db/points.h>
+#include <stddef.h>
+
+void siridb_sketch_init(siridb_sketch_t * sketch, uint32_t tp);
+siridb_sketch_t * siridb_sketch_new(uint32_t tp);
+void siridb_sketch_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp);
+void siridb_sketch_merge(siridb_sketch_t * dst, siridb_sketch_t * src);
+double siridb_sketch_percentile(siridb_sketch_t * sketch, double percentile);
+int64_t siridb_sketch_distinct(siridb_sketch_t * sketch);
+size_t siridb_sketch_size(siridb_sketch_t * sketch);
+siridb_sketch_t * siridb_sketch_unpack(
+        const unsigned char * data,
+        size_t size,
+        size_t * consumed);
+
+#define siridb_sketch_free(sketch) free(sketch)
+
+struct siridb_centroid_s
+{
+    double mean;
+    double weight;
+};
+
+/*
+ * Only the first siridb_sketch_size() bytes are used, so a sketch can be
+ * copied to another server as raw data.
+ */
+struct siridb_sketch_s
+{
+    uint32_t tp;        /* SIRIDB_SKETCH_TDIGEST or SIRIDB_SKETCH_HLL       */
+    uint32_t len;       /* number of centroids or registers                 */
+    uint64_t n;         /* number of values added to the sketch             */
+    double min;         /* only used by the t-digest                        */
+    double max;         /* only used by the t-digest                        */
+    union
+    {
+        siridb_centroid_t centroids[SIRIDB_TDIGEST_SZ];
+        uint8_t registers[SIRIDB_HLL_SZ];
+    } via;
+};
+
+#endif  /* SIRIDB_SKETCH_H_ */
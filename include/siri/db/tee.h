@@ -10,6 +10,7 @@ typedef struct siridb_tee_s siridb_tee_t;
 
 enum
 {
+    SIRIDB_TEE_FLAG_SPOOL_INIT = 1<<0,
     SIRIDB_TEE_FLAG = 1<<31,
 };
 
@@ -24,9 +25,11 @@ enum siridb_tee_e_t
 
 #include <uv.h>
 #include <stdbool.h>
+#include <siri/db/db.h>
+#include <siri/db/fifo.h>
 #include <siri/net/pkg.h>
 
-siridb_tee_t * siridb_tee_new(void);
+siridb_tee_t * siridb_tee_new(siridb_t * siridb);
 void siridb_tee_close(siridb_tee_t * tee);
 int siridb_tee_set_address_port(
         siridb_tee_t * tee,
@@ -35,6 +38,7 @@ int siridb_tee_set_address_port(
 void siridb_tee_write(siridb_tee_t * tee, sirinet_pkg_t * pkg);
 void siridb_tee_free(siridb_tee_t * tee);
 const char * siridb_tee_str(siridb_tee_t * tee);
+double siridb_tee_lag(siridb_tee_t * tee);
 
 typedef void (*siridb_tee_cb)(uv_handle_t *);
 
@@ -47,6 +51,17 @@ struct siridb_tee_s
     char * address;
     uv_tcp_t * tcp;
     uv_mutex_t lock_;
+    siridb_t * siridb;
+    siridb_fifo_t * spool;  /* disk spool, only created when required */
+    char * buf;             /* packages waiting for the next frame */
+    size_t len;
+    size_t size;
+    size_t in_flight;       /* size of the frame which is being written */
+    uint64_t buf_since;     /* loop time of the oldest package in buf */
+    uint64_t flight_since;  /* loop time of the oldest package in flight */
+    uint64_t spool_since;   /* loop time since the spool has data */
+    uint64_t n_spooled;     /* packages written to the spool */
+    uint64_t n_dropped;     /* packages dropped because the spool was full */
 };
 
 
@@ -0,0 +1,67 @@
+/*
+ * zones.h - Min/max zone maps for filtering series on their properties.
+ *
+ * Series are grouped in zones of SIRIDB_ZONES_SZ consecutive series ids. For
+ * each zone we keep the lowest and highest start, end, length, pool and type
+ * of the series in the zone, so a where-clause which cannot be true for any
+ * value within these ranges skips the whole zone. The ranges only grow, so
+ * each change to the start, end or length of a series must widen its zone
+ * with siridb_zones_update(), also when the value shrinks. After removing
+ * points or series a zone might be wider than required, which only means
+ * some extra series are checked against the where-clause.
+ *
+ * The maps are created the first time they are needed. Creating, updating
+ * and reading the maps requires the series_mutex.
+ */
+#ifndef SIRIDB_ZONES_H_
+#define SIRIDB_ZONES_H_
+
+#define SIRIDB_ZONES_BITS 10
+#define SIRIDB_ZONES_SZ (1 << SIRIDB_ZONES_BITS)
+
+/*
+ * The maps are only used when at most 1/SIRIDB_ZONES_SCAN of the zones might
+ * contain a matching series, otherwise scanning all series is faster.
+ */
+#define SIRIDB_ZONES_SCAN 4
+
+typedef enum
+{
+    SIRIDB_ZONES_START,
+    SIRIDB_ZONES_END,
+    SIRIDB_ZONES_LENGTH,
+    SIRIDB_ZONES_POOL,
+    SIRIDB_ZONES_TYPE,
+    SIRIDB_ZONES_PROPS
+} siridb_zones_prop_t;
+
+typedef struct siridb_zone_s siridb_zone_t;
+typedef struct siridb_zones_s siridb_zones_t;
+
+#include <cexpr/cexpr.h>
+#include <imap/imap.h>
+#include <inttypes.h>
+#include <siri/db/db.h>
+#include <siri/db/series.h>
+#include <vec/vec.h>
+
+siridb_zones_t * siridb_zones_new(imap_t * series_map, uint32_t max_id);
+void siridb_zones_free(siridb_zones_t * zones);
+int siridb_zones_add(siridb_zones_t * zones, siridb_series_t * series);
+int siridb_zones_match(siridb_zone_t * zone, cexpr_t * where_expr);
+void siridb_zones_update(siridb_t * siridb, siridb_series_t * series);
+vec_t * siridb_zones_series(siridb_t * siridb, cexpr_t * where_expr);
+
+struct siridb_zone_s
+{
+    int64_t min[SIRIDB_ZONES_PROPS];
+    int64_t max[SIRIDB_ZONES_PROPS];
+};
+
+struct siridb_zones_s
+{
+    size_t len;
+    siridb_zone_t * zone;
+};
+
+#endif  /* SIRIDB_ZONES_H_ */
@@ -0,0 +1,19 @@
+/*
+ * expire.h - Shard expiration task SiriDB.
+ *
+ * One timer is used for all databases. The timer is set to fire when the
+ * first shard of any database expires, but at least every heart-beat
+ * interval so the expiration time stamps used by inserts are updated. The
+ * expired shards are dropped in a work thread.
+ */
+#ifndef SIRI_EXPIRE_H_
+#define SIRI_EXPIRE_H_
+
+#include <siri/siri.h>
+
+void siri_expire_init(siri_t * siri);
+void siri_expire_stop(siri_t * siri);
+void siri_expire_schedule(void);
+int siri_expire_is_running(void);
+
+#endif  /* SIRI_EXPIRE_H_ */
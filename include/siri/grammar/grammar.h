@@ -59,6 +59,7 @@ enum cleri_grammar_ids {
     CLERI_GID_F_COUNT,
     CLERI_GID_F_DERIVATIVE,
     CLERI_GID_F_DIFFERENCE,
+    CLERI_GID_F_DISTINCT,
     CLERI_GID_F_FILTER,
     CLERI_GID_F_FIRST,
     CLERI_GID_F_INTERVAL,
@@ -71,6 +72,7 @@ enum cleri_grammar_ids {
     CLERI_GID_F_MEDIAN_LOW,
     CLERI_GID_F_MIN,
     CLERI_GID_F_OFFSET,
+    CLERI_GID_F_PERCENTILE,
     CLERI_GID_F_POINTS,
     CLERI_GID_F_PVARIANCE,
     CLERI_GID_F_STDDEV,
@@ -116,6 +118,7 @@ enum cleri_grammar_ids {
     CLERI_GID_HELP_LIST_SHARDS,
     CLERI_GID_HELP_LIST_USERS,
     CLERI_GID_HELP_NOACCESS,
+    CLERI_GID_HELP_PROFILE,
     CLERI_GID_HELP_REVOKE,
     CLERI_GID_HELP_SELECT,
     CLERI_GID_HELP_SHOW,
@@ -138,6 +141,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_BETWEEN,
     CLERI_GID_K_BUFFER_PATH,
     CLERI_GID_K_BUFFER_SIZE,
+    CLERI_GID_K_CODEC,
     CLERI_GID_K_COUNT,
     CLERI_GID_K_CREATE,
     CLERI_GID_K_CRITICAL,
@@ -147,6 +151,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_DEBUG,
     CLERI_GID_K_DERIVATIVE,
     CLERI_GID_K_DIFFERENCE,
+    CLERI_GID_K_DISTINCT,
     CLERI_GID_K_DROP,
     CLERI_GID_K_DROP_THRESHOLD,
     CLERI_GID_K_DURATION_LOG,
@@ -197,6 +202,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_MERGE,
     CLERI_GID_K_MIN,
     CLERI_GID_K_MODIFY,
+    CLERI_GID_K_MOVED,
     CLERI_GID_K_NAME,
     CLERI_GID_K_NAN,
     CLERI_GID_K_NINF,
@@ -207,12 +213,17 @@ enum cleri_grammar_ids {
     CLERI_GID_K_OPEN_FILES,
     CLERI_GID_K_OR,
     CLERI_GID_K_PASSWORD,
+    CLERI_GID_K_PERCENTILE,
+    CLERI_GID_K_PLACEMENT,
     CLERI_GID_K_POINTS,
     CLERI_GID_K_POOL,
     CLERI_GID_K_POOLS,
     CLERI_GID_K_PORT,
     CLERI_GID_K_PREFIX,
+    CLERI_GID_K_PROFILE,
     CLERI_GID_K_PVARIANCE,
+    CLERI_GID_K_QUERY_CACHE_HIT_RATE,
+    CLERI_GID_K_QUERY_CACHE_TIME_SAVED,
     CLERI_GID_K_READ,
     CLERI_GID_K_RECEIVED_POINTS,
     CLERI_GID_K_REINDEX_PROGRESS,
@@ -229,6 +240,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_SHOW,
     CLERI_GID_K_SID,
     CLERI_GID_K_SIZE,
+    CLERI_GID_K_SLOTS,
     CLERI_GID_K_START,
     CLERI_GID_K_STARTUP_TIME,
     CLERI_GID_K_STATUS,
@@ -242,6 +254,7 @@ enum cleri_grammar_ids {
     CLERI_GID_K_TAGS,
     CLERI_GID_K_TAIL,
     CLERI_GID_K_TEE,
+    CLERI_GID_K_TEE_LAG,
     CLERI_GID_K_TIMEIT,
     CLERI_GID_K_TIMEVAL,
     CLERI_GID_K_TIMEZONE,
@@ -276,6 +289,7 @@ enum cleri_grammar_ids {
     CLERI_GID_POOL_COLUMNS,
     CLERI_GID_POOL_PROPS,
     CLERI_GID_PREFIX_EXPR,
+    CLERI_GID_PROFILE_STMT,
     CLERI_GID_REVOKE_STMT,
     CLERI_GID_REVOKE_USER,
     CLERI_GID_R_COMMENT,
@@ -301,6 +315,7 @@ enum cleri_grammar_ids {
     CLERI_GID_SERVER_COLUMNS,
     CLERI_GID_SET_ADDRESS,
     CLERI_GID_SET_BACKUP_MODE,
+    CLERI_GID_SET_CODEC,
     CLERI_GID_SET_DROP_THRESHOLD,
     CLERI_GID_SET_EXPIRATION_LOG,
     CLERI_GID_SET_EXPIRATION_NUM,
@@ -0,0 +1,74 @@
+/*
+ * metrics.h - Counters and latency histograms for hot paths.
+ *
+ * Each thread updates its own block of counters so updates never contend.
+ * The blocks are only summed when the metrics are read, which happens when
+ * the HTTP status server is asked for `/metrics`.
+ *
+ * Histograms are log-linear (like HDR histograms): every power of two is
+ * split in SIRI_METRICS_SUB buckets, so a recorded value is accurate within
+ * 1/SIRI_METRICS_SUB of its magnitude while the number of buckets stays
+ * small. Values are recorded in microseconds.
+ */
+#ifndef SIRI_METRICS_H_
+#define SIRI_METRICS_H_
+
+#define SIRI_METRICS_SUB_BITS 2
+#define SIRI_METRICS_SUB (1 << SIRI_METRICS_SUB_BITS)
+#define SIRI_METRICS_MAX_BITS 40    /* about 12 days in microseconds    */
+#define SIRI_METRICS_HIST_SZ \
+    ((SIRI_METRICS_MAX_BITS - SIRI_METRICS_SUB_BITS + 1) * SIRI_METRICS_SUB)
+
+typedef enum
+{
+    SIRI_METRICS_SHARD_READ_BYTES,
+    SIRI_METRICS_FCACHE_HITS,
+    SIRI_METRICS_FCACHE_MISSES,
+    SIRI_METRICS_COUNTER_END
+} siri_metrics_counter_t;
+
+typedef enum
+{
+    SIRI_METRICS_INSERT,
+    SIRI_METRICS_SELECT_LOOKUP,
+    SIRI_METRICS_SELECT_READ,
+    SIRI_METRICS_SELECT_DECOMPRESS,
+    SIRI_METRICS_SELECT_AGGREGATE,
+    SIRI_METRICS_SELECT_PACK,
+    SIRI_METRICS_OPTIMIZE,
+    SIRI_METRICS_TIMER_END
+} siri_metrics_timer_t;
+
+typedef struct siri_metrics_hist_s siri_metrics_hist_t;
+typedef struct siri_metrics_buf_s siri_metrics_buf_t;
+
+#include <inttypes.h>
+#include <stddef.h>
+
+uint64_t siri_metrics_now(void);
+void siri_metrics_incr(siri_metrics_counter_t counter, uint64_t n);
+void siri_metrics_observe(siri_metrics_timer_t timer, uint64_t usec);
+uint64_t siri_metrics_counter(siri_metrics_counter_t counter);
+void siri_metrics_hist(siri_metrics_timer_t timer, siri_metrics_hist_t * hist);
+uint64_t siri_metrics_percentile(siri_metrics_hist_t * hist, double p);
+int siri_metrics_printf(siri_metrics_buf_t * buf, const char * fmt, ...);
+int siri_metrics_write(siri_metrics_buf_t * buf);
+
+#define siri_metrics_since(timer__, start__) \
+    siri_metrics_observe(timer__, siri_metrics_now() - (start__))
+
+struct siri_metrics_hist_s
+{
+    uint64_t count;
+    uint64_t sum;           /* sum of all values in microseconds            */
+    uint64_t buckets[SIRI_METRICS_HIST_SZ];
+};
+
+struct siri_metrics_buf_s
+{
+    size_t len;
+    size_t size;
+    char * data;            /* must be freed, also in case of an error      */
+};
+
+#endif  /* SIRI_METRICS_H_ */
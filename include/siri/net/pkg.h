@@ -4,6 +4,12 @@
 #ifndef SIRINET_PKG_H_
 #define SIRINET_PKG_H_
 
+/* maximum frame size, including the header of the frame */
+#define SIRINET_PKG_FRAME_SIZE 65536
+
+/* maximum size of a package, also used to limit HTTP inserts */
+#define MAX_ALLOWED_PKG_SIZE 41943040      /* 40 MB  */
+
 typedef struct sirinet_pkg_s sirinet_pkg_t;
 
 #include <inttypes.h>
@@ -28,6 +34,12 @@ sirinet_pkg_t * sirinet_pkg_err(
         const char * msg);
 
 int sirinet_pkg_send(sirinet_stream_t * client, sirinet_pkg_t * pkg);
+int sirinet_pkg_send_frames(sirinet_stream_t * client, sirinet_pkg_t * pkg);
+int sirinet_pkg_frame_add(
+        sirinet_pkg_t ** pkg,
+        size_t * n,
+        sirinet_pkg_t * frame);
+int sirinet_pkg_frame_is_first(sirinet_pkg_t * frame);
 sirinet_pkg_t * sirinet_pkg_dup(sirinet_pkg_t * pkg);
 
 /* Shortcut to print an packer object */
@@ -25,23 +25,33 @@ typedef void (* sirinet_promise_cb)(
 #include <siri/net/stream.h>
 #include <siri/db/server.h>
 #include <siri/net/pkg.h>
+#include <siri/net/twheel.h>
 
+#define PROMISE_SLAB_SIZE 256  /* promises per slab allocation */
 
+sirinet_promise_t * sirinet_promise_new(void);
+void sirinet_promise_free(sirinet_promise_t * promise);
+void sirinet_promise_slab_destroy(void);
 const char * sirinet_promise_strstatus(sirinet_promise_status_t status);
 
 #define sirinet_promise_incref(p__) (p__)->ref++
-#define sirinet_promise_decref(p__) if (!--(p__)->ref) free(p__)
+#define sirinet_promise_decref(p__) \
+    if (!--(p__)->ref) sirinet_promise_free(p__)
 
 /* the callback will always be called and is responsible to free the promise */
 struct sirinet_promise_s
 {
     uint16_t pid;
     uint16_t ref;
-    uv_timer_t * timer;
+    sirinet_twheel_entry_t tentry;  /* time-out, only used for servers */
     sirinet_promise_cb cb;
     siridb_server_t * server;
     sirinet_pkg_t * pkg;
     void * data;
+    sirinet_pkg_t * frames;         /* framed response, only for servers */
+    size_t frames_n;                /* received bytes for the response   */
+    uint64_t sent;                  /* see siri_metrics_now()            */
+    uint64_t rtt;                   /* round-trip time in microseconds   */
 };
 
 #endif  /* SIRINET_PROMISE_H_ */
@@ -4,10 +4,13 @@
 #ifndef SIRINET_PROTOCOL_H_
 #define SIRINET_PROTOCOL_H_
 
+/* CPROTO_REQ_QUERY options */
+#define CPROTO_QUERY_OPT_COLUMNS 1      /* select points as columns         */
+
 typedef enum
 {
     /* Public requests */
-    CPROTO_REQ_QUERY=0,                 /* (query, time_precision)          */
+    CPROTO_REQ_QUERY=0,                 /* (query, time_precision, options) */
     CPROTO_REQ_INSERT=1,                /* series with points map/array     */
     CPROTO_REQ_AUTH=2,                  /* (user, password, dbname)         */
     CPROTO_REQ_PING=3,                  /* empty                            */
@@ -134,6 +137,7 @@ typedef enum
     BPROTO_RES_TAGS,                            /* [[name, series], ...]    */
     BPROTO_ACK_SERIES_TAGS,                     /* empty                    */
     BPROTO_ACK_EMPTY_TAGS,                      /* empty                    */
+    BPROTO_RES_FRAME,                           /* part of a response       */
 } bproto_server_t;
 
 #define sirinet_protocol_is_error(tp) (tp >= 64 && tp < 192)
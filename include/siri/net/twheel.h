@@ -0,0 +1,58 @@
+/*
+ * twheel.h - Hierarchical timer wheel for promise time-outs.
+ *
+ * Each level has SIRINET_TWHEEL_SLOTS slots. A slot on level 0 covers one
+ * tick and a slot on level N covers all the slots of level N-1. Entries are
+ * added to the lowest level which can hold their expiration tick and move to
+ * a lower level when the wheel reaches their slot. Adding and removing an
+ * entry is O(1) and the wheel is driven by a single uv timer which only runs
+ * while the wheel holds entries.
+ */
+#ifndef SIRINET_TWHEEL_H_
+#define SIRINET_TWHEEL_H_
+
+#define SIRINET_TWHEEL_TICK 100     /* tick resolution in milliseconds  */
+#define SIRINET_TWHEEL_BITS 6
+#define SIRINET_TWHEEL_SLOTS (1 << SIRINET_TWHEEL_BITS)
+#define SIRINET_TWHEEL_LEVELS 4     /* max 2^24 ticks (about 19 days)   */
+
+typedef struct sirinet_twheel_s sirinet_twheel_t;
+typedef struct sirinet_twheel_entry_s sirinet_twheel_entry_t;
+typedef void (* sirinet_twheel_cb)(sirinet_twheel_entry_t * entry);
+
+#include <inttypes.h>
+#include <uv.h>
+
+sirinet_twheel_t * sirinet_twheel_new(uv_loop_t * loop, sirinet_twheel_cb cb);
+void sirinet_twheel_free(sirinet_twheel_t * twheel);
+int sirinet_twheel_add(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry,
+        uint64_t timeout);
+void sirinet_twheel_remove(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry);
+
+#define sirinet_twheel_is_pending(entry__) ((entry__)->pprev != NULL)
+
+struct sirinet_twheel_entry_s
+{
+    sirinet_twheel_entry_t * next;
+    sirinet_twheel_entry_t ** pprev;    /* NULL when not in the wheel   */
+    uint64_t expire;                    /* expiration tick              */
+    void * data;
+};
+
+struct sirinet_twheel_s
+{
+    uv_loop_t * loop;
+    uv_timer_t * timer;     /* NULL when the wheel is empty             */
+    sirinet_twheel_cb cb;
+    uint64_t start;         /* loop time in milliseconds at tick 0      */
+    uint64_t tick;          /* last processed tick                      */
+    size_t n;               /* number of entries in the wheel           */
+    sirinet_twheel_entry_t *
+        slots[SIRINET_TWHEEL_LEVELS][SIRINET_TWHEEL_SLOTS];
+};
+
+#endif  /* SIRINET_TWHEEL_H_ */
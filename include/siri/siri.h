@@ -48,6 +48,7 @@ extern siri_t siri;
 #include <siri/optimize.h>
 #include <siri/backup.h>
 #include <siri/heartbeat.h>
+#include <siri/expire.h>
 #include <siri/cfg/cfg.h>
 #include <siri/args/args.h>
 #include <llist/llist.h>
@@ -68,6 +69,7 @@ struct siri_s
     siri_optimize_t * optimize;
     uv_timer_t * backup;
     uv_timer_t * heartbeat;
+    uv_timer_t * expire;
     uv_timer_t * buffersync;
     siri_cfg_t * cfg;
     siri_args_t * args;
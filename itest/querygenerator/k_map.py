@@ -19,6 +19,8 @@ k_map = {
         'k_reindex_progress': '"REINDEX_PROGRESS"',
         'k_sync_progress': '"SYNC_PROGRESS"',
         'k_timezone': '"NAIVE"',
+        'k_codec': '"gorilla"',
+        'k_placement': '"sum"',
         'k_ip_support': '"ALL"',
         'k_libuv': '"1.8.0"',
         'k_server': '"SERVER"',
@@ -66,6 +68,7 @@ k_map = {
     },
     'r_float': {
         'k_filter': 10.0,
+        'k_percentile': 99.0,
         'k_drop_threshold': 0.99},
     'r_time_str': {
         'aggregate_functions': '10s',
@@ -72,6 +72,77 @@ class TestHTTPAPI(TestBase):
         self.assertDictEqual(x.json(), {
             'success_msg': 'Successfully inserted 20000 point(s).'})
 
+        data = [
+            {'points': [[1579521271, 1.5]], 'name': 'my_array_float'},
+            {'name': 'my_array_str', 'points': [[1579521271, 'one']]},
+        ]
+
+        x = requests.post(
+            'http://localhost:9020/insert/dbtest',
+            json=data,
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 200)
+        self.assertDictEqual(x.json(), {
+            'success_msg': 'Successfully inserted 2 point(s).'})
+
+        x = requests.post(
+            'http://localhost:9020/insert-line/dbtest?precision=s',
+            data=(
+                'cpu,host=a usage=0.5,count=3i 1579521271\n'
+                'cpu,host=a usage=0.7 1579521272\n'),
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 200)
+        self.assertDictEqual(x.json(), {
+            'success_msg': 'Successfully inserted 3 point(s).'})
+
+        x = requests.post(
+            'http://localhost:9020/query/dbtest',
+            json={'q': 'select * from "cpu,host=a usage"'},
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 200)
+        self.assertEqual(x.json(), {
+            'cpu,host=a usage': [[1579521271, 0.5], [1579521272, 0.7]]})
+
+        x = requests.post(
+            'http://localhost:9020/insert-line/dbtest?precision=s',
+            data=(
+                'cpu,region=eu,host=b usage=1i 1579521271\n'
+                'cpu,host=b,region=eu usage=2i 1579521272\n'),
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 200)
+
+        x = requests.post(
+            'http://localhost:9020/query/dbtest',
+            json={'q': 'select * from "cpu,host=b,region=eu usage"'},
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 200)
+        self.assertEqual(x.json(), {
+            'cpu,host=b,region=eu usage': [[1579521271, 1], [1579521272, 2]]})
+
+        x = requests.post(
+            'http://localhost:9020/insert-line/dbtest',
+            data='cpu,host=a usage=\n',
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 400)
+        self.assertDictEqual(x.json(), {
+            'error_msg': 'Invalid line protocol data.'})
+
+        x = requests.post(
+            'http://localhost:9020/insert/dbtest',
+            json={'my_float': [[1579521271, 1.5], [1579521272]]},
+            auth=('iris', 'siri'))
+
+        self.assertEqual(x.status_code, 400)
+        self.assertDictEqual(x.json(), {
+            'error_msg': 'Unsupported value received. (only integer, float '
+                         'and string values are supported).'})
+
         data = {
             'dbname': 'dbtest',
             'host': 'localhost',
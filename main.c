@@ -45,6 +45,13 @@ int main(int argc, char * argv[])
     /* setup logger, this must be done before logging the first line */
     siri_setup_logger();
 
+    /* write log lines from a separate thread, pending lines are written at
+     * exit */
+    if (logger_start() == 0)
+    {
+        atexit(logger_stop);
+    }
+
     /* initialize random */
     seed = 0;
     fd = open("/dev/urandom", O_RDONLY);
@@ -57,9 +64,6 @@ int main(int argc, char * argv[])
     (void) close(fd);
     srand(seed);
 
-    /* initialize points dictionary */
-    siridb_points_init();
-
     /* start server */
     log_info("Starting SiriDB Server (version: %s)", SIRIDB_VERSION);
 
@@ -82,6 +86,7 @@ int main(int argc, char * argv[])
     set_max_open_files_limit();
 
     log_debug("Shard compression: %s", siri.cfg->shard_compression ? "enabled" : "disabled");
+    log_debug("Select compression: %s", siri.cfg->select_compression ? "enabled" : "disabled");
     log_debug("Shard auto duration: %s", siri.cfg->shard_auto_duration ? "enabled" : "disabled");
     log_debug("Pipe support: %s", siri.cfg->pipe_support ? "enabled" : "disabled");
     log_debug("IP support: %s", sirinet_tcp_ip_support_str(siri.cfg->ip_support));
@@ -0,0 +1,126 @@
+/*
+ * heap.c - Binary min-heap with 64bit keys.
+ */
+#include <heap/heap.h>
+#include <stdlib.h>
+
+#define HEAP_MAX_SZ 512
+
+/*
+ * Returns NULL in case an error has occurred.
+ */
+heap_t * heap_new(size_t size)
+{
+    heap_t * heap = malloc(sizeof(heap_t) + sizeof(heap_node_t) * size);
+
+    if (heap == NULL)
+    {
+        return NULL;
+    }
+    heap->size = size;
+    heap->len = 0;
+    return heap;
+}
+
+/*
+ * Destroy the heap and call 'cb' for each data object. The call-back can be
+ * NULL when the data does not need to be destroyed.
+ */
+void heap_destroy(heap_t * heap, heap_destroy_cb cb)
+{
+    if (cb != NULL)
+    {
+        size_t i;
+        for (i = 0; i < heap->len; i++)
+        {
+            (*cb)(heap->nodes[i].data);
+        }
+    }
+    free(heap);
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an error.
+ * (in case of an error the heap is unchanged)
+ */
+int heap_push(heap_t ** heap, uint64_t key, void * data)
+{
+    heap_node_t * nodes;
+    size_t i, parent;
+
+    if ((*heap)->len == (*heap)->size)
+    {
+        heap_t * tmp;
+        size_t sz = (*heap)->size;
+
+        /* like vec_append_safe(), double the size until HEAP_MAX_SZ */
+        sz = (sz >= HEAP_DEFAULT_SIZE) ?
+                (sz <= HEAP_MAX_SZ) ?
+                        sz * 2 : sz + HEAP_MAX_SZ : HEAP_DEFAULT_SIZE;
+
+        tmp = realloc(*heap, sizeof(heap_t) + sizeof(heap_node_t) * sz);
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+
+        tmp->size = sz;
+        *heap = tmp;
+    }
+
+    nodes = (*heap)->nodes;
+
+    /* move parents down until the place for the new node is found */
+    for (i = (*heap)->len++; i; i = parent)
+    {
+        parent = (i - 1) / 2;
+        if (nodes[parent].key <= key)
+        {
+            break;
+        }
+        nodes[i] = nodes[parent];
+    }
+
+    nodes[i].key = key;
+    nodes[i].data = data;
+
+    return 0;
+}
+
+/*
+ * Remove the node with the smallest key and return its data. Returns NULL
+ * when the heap is empty.
+ */
+void * heap_pop(heap_t * heap)
+{
+    heap_node_t * nodes = heap->nodes;
+    heap_node_t last;
+    void * data;
+    size_t i, child;
+
+    if (heap->len == 0)
+    {
+        return NULL;
+    }
+
+    data = nodes[0].data;
+    last = nodes[--heap->len];
+
+    /* move the smallest child up until the place for 'last' is found */
+    for (i = 0; (child = i * 2 + 1) < heap->len; i = child)
+    {
+        if (child + 1 < heap->len && nodes[child + 1].key < nodes[child].key)
+        {
+            child++;
+        }
+        if (last.key <= nodes[child].key)
+        {
+            break;
+        }
+        nodes[i] = nodes[child];
+    }
+
+    nodes[i] = last;
+
+    return data;
+}
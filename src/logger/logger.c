@@ -2,16 +2,21 @@
  * logger.h - Logging module.
  */
 #include <logger/logger.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <uv.h>
 
 logger_t Logger = {
         .level=2,
         .level_name=NULL,
         .ostream=NULL,
-        .flags=0
+        .flags=0,
+        .dropped=0
 };
 
 #define LOGGER_CHR_MAP "DIWECU"
@@ -33,43 +38,63 @@ const char * LOGGER_COLOR_MAP[LOGGER_NUM_LEVELS] =
 
 #define LOGGER_LOG_STUFF(LEVEL)                                 \
 {                                                               \
-    time_t t = time(NULL);                                      \
-    struct tm tm = *localtime(&t);                              \
-    if (Logger.flags & LOGGER_FLAG_COLORED)                     \
-    {                                                           \
-        fprintf(Logger.ostream,                                 \
-            "%s[%c %d-%0*d-%0*d %0*d:%0*d:%0*d]" KNRM " ",      \
-            LOGGER_COLOR_MAP[LEVEL],                            \
-            LOGGER_CHR_MAP[LEVEL],                              \
-            tm.tm_year + 1900,                                  \
-            2, tm.tm_mon + 1,                                   \
-            2, tm.tm_mday,                                      \
-            2, tm.tm_hour,                                      \
-            2, tm.tm_min,                                       \
-            2, tm.tm_sec);                                      \
-    }                                                           \
-    else                                                        \
-    {                                                           \
-        fprintf(Logger.ostream,                                 \
-        "[%c %d-%0*d-%0*d %0*d:%0*d:%0*d] ",                    \
-            LOGGER_CHR_MAP[LEVEL],                              \
-            tm.tm_year + 1900,                                  \
-            2, tm.tm_mon + 1,                                   \
-            2, tm.tm_mday,                                      \
-            2, tm.tm_hour,                                      \
-            2, tm.tm_min,                                       \
-            2, tm.tm_sec);                                      \
-    }                                                           \
-    /* print the actual log line */                             \
     va_list args;                                               \
     va_start(args, fmt);                                        \
-    vfprintf(Logger.ostream, fmt, args);                        \
+    LOGGER_log(LEVEL, fmt, args);                               \
     va_end(args);                                               \
-    /* write end of line and flush the stream */                \
-    fputc('\n', Logger.ostream);                                \
-    fflush(Logger.ostream);                                     \
 }
 
+#define LOGGER_RING_MASK (LOGGER_RING_SZ - 1)
+
+typedef struct logger_line_s logger_line_t;
+typedef struct logger_ring_s logger_ring_t;
+typedef struct logger_tcache_s logger_tcache_t;
+
+struct logger_line_s
+{
+    time_t ts;
+    int level;
+    char msg[LOGGER_LINE_SZ];
+};
+
+/*
+ * Single producer, single consumer ring. Only the owning thread writes head
+ * and only the writer thread writes tail. Rings are never destroyed but are
+ * released when a thread exits so they can be used by a new thread.
+ */
+struct logger_ring_s
+{
+    logger_ring_t * next;
+    int in_use;
+    uint32_t head;
+    uint32_t tail;
+    logger_line_t lines[LOGGER_RING_SZ];
+};
+
+/* formatted local time, only updated when the second changes */
+struct logger_tcache_s
+{
+    time_t ts;
+    char str[32];
+};
+
+static __thread logger_ring_t * LOGGER_ring = NULL;
+static logger_ring_t * LOGGER_rings = NULL;
+static pthread_key_t LOGGER_key;
+static uv_thread_t LOGGER_thread;
+static int LOGGER_running = 0;
+
+static void LOGGER_log(int level, const char * fmt, va_list args);
+static logger_ring_t * LOGGER_get_ring(void);
+static void LOGGER_release_ring(void * arg);
+static void LOGGER_write(
+        logger_tcache_t * tcache,
+        int level,
+        time_t ts,
+        const char * msg);
+static size_t LOGGER_drain(logger_tcache_t * tcache);
+static void LOGGER_work(void * arg);
+
 /*
  * Initialize the Logger.
  */
@@ -96,6 +121,58 @@ const char * logger_level_name(int log_level)
     return LOGGER_LEVEL_NAMES[log_level];
 }
 
+/*
+ * Start the writer thread. Lines which are logged from this point on are
+ * written asynchronous until logger_stop() is called.
+ *
+ * Returns 0 if successful or -1 when the writer cannot be started, in which
+ * case lines are still written directly.
+ */
+int logger_start(void)
+{
+    if (LOGGER_running)
+    {
+        return 0;
+    }
+
+    if (pthread_key_create(&LOGGER_key, LOGGER_release_ring))
+    {
+        return -1;
+    }
+
+    __atomic_store_n(&LOGGER_running, 1, __ATOMIC_RELEASE);
+
+    if (uv_thread_create(&LOGGER_thread, LOGGER_work, NULL))
+    {
+        __atomic_store_n(&LOGGER_running, 0, __ATOMIC_RELEASE);
+        (void) pthread_key_delete(LOGGER_key);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Stop the writer thread after all pending lines are written. Lines which
+ * are logged after this call are written directly again.
+ */
+void logger_stop(void)
+{
+    if (!__atomic_exchange_n(&LOGGER_running, 0, __ATOMIC_ACQ_REL))
+    {
+        return;
+    }
+    (void) uv_thread_join(&LOGGER_thread);
+}
+
+/*
+ * Returns the number of lines which are dropped because a ring was full.
+ */
+uint64_t logger_dropped(void)
+{
+    return __atomic_load_n(&Logger.dropped, __ATOMIC_RELAXED);
+}
+
 void log__debug(const char * fmt, ...)
     LOGGER_LOG_STUFF(LOGGER_DEBUG)
 
@@ -111,3 +188,221 @@ void log__error(const char * fmt, ...)
 void log__critical(const char * fmt, ...)
     LOGGER_LOG_STUFF(LOGGER_CRITICAL)
 
+static void LOGGER_log(int level, const char * fmt, va_list args)
+{
+    logger_ring_t * ring;
+    logger_line_t * line;
+    uint32_t head;
+    int n;
+
+    if (level == LOGGER_CRITICAL ||
+        !__atomic_load_n(&LOGGER_running, __ATOMIC_ACQUIRE) ||
+        (ring = LOGGER_get_ring()) == NULL)
+    {
+        /* lines which are written directly are never truncated */
+        char buf[LOGGER_LINE_SZ];
+        char * msg = buf;
+        logger_tcache_t tcache = {.ts = -1};
+        va_list cp;
+
+        va_copy(cp, args);
+        n = vsnprintf(buf, LOGGER_LINE_SZ, fmt, args);
+        if (n >= LOGGER_LINE_SZ && (msg = malloc(n + 1)) != NULL)
+        {
+            (void) vsnprintf(msg, n + 1, fmt, cp);
+        }
+        va_end(cp);
+
+        LOGGER_write(&tcache, level, time(NULL), msg == NULL ? buf : msg);
+        fflush(Logger.ostream);
+
+        if (msg != buf)
+        {
+            free(msg);
+        }
+        return;
+    }
+
+    head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) ==
+            LOGGER_RING_SZ)
+    {
+        __atomic_add_fetch(&Logger.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    line = &ring->lines[head & LOGGER_RING_MASK];
+    line->ts = time(NULL);
+    line->level = level;
+
+    n = vsnprintf(line->msg, LOGGER_LINE_SZ, fmt, args);
+    if (n >= LOGGER_LINE_SZ)
+    {
+        memcpy(line->msg + LOGGER_LINE_SZ - 4, "...", 4);
+    }
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Returns the ring for the current thread or NULL in case of an allocation
+ * error. A released ring is used when available, otherwise a new ring is
+ * added to the list.
+ */
+static logger_ring_t * LOGGER_get_ring(void)
+{
+    logger_ring_t * ring = LOGGER_ring;
+    int expected;
+
+    if (ring != NULL)
+    {
+        return ring;
+    }
+
+    for (ring = __atomic_load_n(&LOGGER_rings, __ATOMIC_ACQUIRE);
+         ring != NULL;
+         ring = ring->next)
+    {
+        expected = 0;
+        if (__atomic_compare_exchange_n(
+                &ring->in_use, &expected, 1, 0,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+    }
+
+    if (ring == NULL)
+    {
+        ring = calloc(1, sizeof(logger_ring_t));
+        if (ring == NULL)
+        {
+            return NULL;
+        }
+
+        ring->in_use = 1;
+        ring->next = __atomic_load_n(&LOGGER_rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(
+                &LOGGER_rings, &ring->next, ring, 1,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    /* the key releases the ring when the thread exits */
+    (void) pthread_setspecific(LOGGER_key, ring);
+    LOGGER_ring = ring;
+    return ring;
+}
+
+static void LOGGER_release_ring(void * arg)
+{
+    logger_ring_t * ring = arg;
+    __atomic_store_n(&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Write a single line. The formatted time is cached by the caller so the
+ * time zone is only checked once a second.
+ */
+static void LOGGER_write(
+        logger_tcache_t * tcache,
+        int level,
+        time_t ts,
+        const char * msg)
+{
+    if (ts != tcache->ts)
+    {
+        struct tm tm;
+        (void) localtime_r(&ts, &tm);
+        (void) strftime(
+                tcache->str,
+                sizeof(tcache->str),
+                "%Y-%m-%d %H:%M:%S",
+                &tm);
+        tcache->ts = ts;
+    }
+
+    if (Logger.flags & LOGGER_FLAG_COLORED)
+    {
+        fprintf(Logger.ostream,
+                "%s[%c %s]" KNRM " %s\n",
+                LOGGER_COLOR_MAP[level],
+                LOGGER_CHR_MAP[level],
+                tcache->str,
+                msg);
+    }
+    else
+    {
+        fprintf(Logger.ostream,
+                "[%c %s] %s\n",
+                LOGGER_CHR_MAP[level],
+                tcache->str,
+                msg);
+    }
+}
+
+/*
+ * Write all pending lines from all rings.
+ *
+ * Returns the number of lines written.
+ */
+static size_t LOGGER_drain(logger_tcache_t * tcache)
+{
+    logger_ring_t * ring;
+    logger_line_t * line;
+    uint32_t tail, head;
+    size_t n = 0;
+
+    for (ring = __atomic_load_n(&LOGGER_rings, __ATOMIC_ACQUIRE);
+         ring != NULL;
+         ring = ring->next)
+    {
+        tail = ring->tail;
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        for (; tail != head; tail++, n++)
+        {
+            line = &ring->lines[tail & LOGGER_RING_MASK];
+            LOGGER_write(tcache, line->level, line->ts, line->msg);
+        }
+
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return n;
+}
+
+static void LOGGER_work(void * arg __attribute__((unused)))
+{
+    logger_tcache_t tcache = {.ts = -1};
+    uint64_t dropped = logger_dropped();
+    uint64_t tmp;
+    int running;
+    size_t n;
+
+    do
+    {
+        running = __atomic_load_n(&LOGGER_running, __ATOMIC_ACQUIRE);
+        n = LOGGER_drain(&tcache);
+
+        tmp = logger_dropped();
+        if (tmp != dropped)
+        {
+            char msg[64];
+            snprintf(msg, sizeof(msg),
+                    "%" PRIu64 " log line(s) dropped", tmp - dropped);
+            LOGGER_write(&tcache, LOGGER_WARNING, time(NULL), msg);
+            dropped = tmp;
+            n++;
+        }
+
+        if (n)
+        {
+            fflush(Logger.ostream);
+        }
+        else if (running)
+        {
+            usleep(LOGGER_POLL_MS * 1000);
+        }
+    }
+    while (running);
+}
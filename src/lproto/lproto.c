@@ -0,0 +1,385 @@
+/*
+ * lproto.c - Zero-copy parser for the line protocol.
+ */
+#include <lproto/lproto.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LPROTO_MAX_NUMBER_SZ 64
+#define LPROTO_MAX_TAGS 64
+
+typedef struct
+{
+    size_t off;             /* offset of the leading comma in the key */
+    size_t len;             /* length including the leading comma */
+    size_t key_n;           /* length of the tag key */
+} lproto__tag_t;
+
+static inline int lproto__is_escape(char c)
+{
+    return c == ',' || c == '=' || c == ' ' || c == '\\';
+}
+
+static int lproto__int(const char * s, size_t n, int64_t * i)
+{
+    uint64_t u = 0;
+    int neg = 0;
+
+    if (n && (*s == '-' || *s == '+'))
+    {
+        neg = *s == '-';
+        ++s;
+        --n;
+    }
+
+    if (!n)
+        return -1;
+
+    for (; n; --n, ++s)
+    {
+        if (*s < '0' || *s > '9' || u > (UINT64_MAX - 9) / 10)
+            return -1;
+        u = u * 10 + (*s - '0');
+    }
+
+    if (u > (uint64_t) INT64_MAX + neg)
+        return -1;
+
+    *i = neg ? (int64_t) (0 - u) : (int64_t) u;
+    return 0;
+}
+
+static int lproto__bool(const char * s, size_t n, int64_t * i)
+{
+    switch (n)
+    {
+    case 1:
+        *i = (*s == 't' || *s == 'T');
+        return (*i || *s == 'f' || *s == 'F') ? 0 : -1;
+    case 4:
+        *i = 1;
+        return (
+            memcmp(s, "true", 4) == 0 ||
+            memcmp(s, "True", 4) == 0 ||
+            memcmp(s, "TRUE", 4) == 0) ? 0 : -1;
+    case 5:
+        *i = 0;
+        return (
+            memcmp(s, "false", 5) == 0 ||
+            memcmp(s, "False", 5) == 0 ||
+            memcmp(s, "FALSE", 5) == 0) ? 0 : -1;
+    }
+    return -1;
+}
+
+static int lproto__value(lproto_field_t * field, const char * s, size_t n)
+{
+    char buf[LPROTO_MAX_NUMBER_SZ];
+    char * end;
+
+    if (!n)
+        return -1;
+
+    switch (s[n - 1])
+    {
+    case 'i':
+        field->tp = LPROTO_INT64;
+        return lproto__int(s, n - 1, &field->via.int64);
+    case 'u':
+        field->tp = LPROTO_INT64;
+        return (*s == '-' || *s == '+')
+                ? -1
+                : lproto__int(s, n - 1, &field->via.int64);
+    case 'e':
+    case 'E':
+    case 't':
+    case 'T':
+        field->tp = LPROTO_INT64;
+        return lproto__bool(s, n, &field->via.int64);
+    }
+
+    /* the source is not terminated so we need a copy for strtod() */
+    if (n >= LPROTO_MAX_NUMBER_SZ)
+        return -1;
+
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+
+    field->tp = LPROTO_DOUBLE;
+    field->via.real = strtod(buf, &end);
+
+    return (end == buf + n) ? 0 : -1;
+}
+
+static void lproto__reverse(char * s, size_t n)
+{
+    char * e = s + n - 1;
+    char c;
+
+    for (; s < e; ++s, --e)
+    {
+        c = *s;
+        *s = *e;
+        *e = c;
+    }
+}
+
+static int lproto__tag_cmp(
+        const char * key,
+        lproto__tag_t * a,
+        lproto__tag_t * b)
+{
+    size_t n = a->key_n < b->key_n ? a->key_n : b->key_n;
+    int rc = memcmp(key + a->off + 1, key + b->off + 1, n);
+    return rc ? rc : (a->key_n > b->key_n) - (a->key_n < b->key_n);
+}
+
+/*
+ * Un-escape the key in place and sort the tags by tag key. Each tag must
+ * have the format `key=value` and at most LPROTO_MAX_TAGS are allowed.
+ *
+ * Returns 0 if successful or -1 in case the key is invalid.
+ */
+static int lproto__key(lproto_t * lp, char * end)
+{
+    lproto__tag_t tags[LPROTO_MAX_TAGS], tmp;
+    size_t i, ntags = 0;
+    char * src = lp->key;
+    char * dst = lp->key;
+    char c;
+
+    while (src < end)
+    {
+        if (*src == '\\' && src + 1 < end && lproto__is_escape(src[1]))
+        {
+            *dst++ = src[1];
+            src += 2;
+            continue;
+        }
+
+        c = *src++;
+        if (c == ',')
+        {
+            if (ntags == LPROTO_MAX_TAGS)
+                return -1;
+            tags[ntags].off = dst - lp->key;
+            tags[ntags].key_n = 0;
+            ++ntags;
+        }
+        else if (c == '=' && ntags && !tags[ntags - 1].key_n)
+            tags[ntags - 1].key_n = dst - lp->key - tags[ntags - 1].off - 1;
+        *dst++ = c;
+    }
+
+    lp->key_n = dst - lp->key;
+
+    for (i = 0; i < ntags; ++i)
+    {
+        if (!tags[i].key_n)
+            return -1;
+        tags[i].len = ((i + 1 < ntags) ? tags[i + 1].off : lp->key_n) -
+                tags[i].off;
+    }
+
+    /* insertion sort, adjacent tags are swapped by rotating them in place */
+    for (i = 1; i < ntags; ++i)
+    {
+        size_t j = i;
+        for (; j && lproto__tag_cmp(lp->key, &tags[j - 1], &tags[j]) > 0; --j)
+        {
+            char * s = lp->key + tags[j - 1].off;
+
+            lproto__reverse(s, tags[j - 1].len);
+            lproto__reverse(s + tags[j - 1].len, tags[j].len);
+            lproto__reverse(s, tags[j - 1].len + tags[j].len);
+
+            tmp = tags[j];
+            tmp.off = tags[j - 1].off;
+            tags[j - 1].off += tmp.len;
+            tags[j] = tags[j - 1];
+            tags[j - 1] = tmp;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Initialize a line protocol parser. The data must stay available while
+ * parsing since all the results point to the source data.
+ */
+void lproto_init(lproto_t * lp, char * data, size_t n)
+{
+    lp->pt = data;
+    lp->end = data + n;
+    lp->key = NULL;
+    lp->key_n = 0;
+    lp->fields = NULL;
+    lp->fields_end = NULL;
+    lp->ts = 0;
+    lp->has_ts = 0;
+}
+
+/*
+ * Read the next line.
+ *
+ * Returns LPROTO_OK when a line is read, LPROTO_END when no more lines are
+ * available or LPROTO_ERR in case the line is invalid. Use lp->pt for the
+ * position of the error.
+ */
+int lproto_next_line(lproto_t * lp)
+{
+    char * pt = lp->pt;
+    char * end = lp->end;
+    int in_str = 0;
+
+    /* skip empty lines and comments */
+    while (pt < end)
+    {
+        if (*pt == '#')
+        {
+            pt = memchr(pt, '\n', end - pt);
+            if (pt == NULL)
+                pt = end;
+            continue;
+        }
+        if (*pt != '\n' && *pt != '\r' && *pt != ' ' && *pt != '\t')
+            break;
+        ++pt;
+    }
+
+    lp->pt = pt;
+
+    if (pt == end)
+        return LPROTO_END;
+
+    /* measurement with optional tags */
+    lp->key = pt;
+    while (pt < end && *pt != ' ')
+    {
+        if (*pt == '\n')
+            return LPROTO_ERR;
+
+        pt += (*pt == '\\') ? 2 : 1;
+    }
+
+    if (pt >= end || *lp->key == ',' || lproto__key(lp, pt))
+        return LPROTO_ERR;
+
+    /* fields, spaces are allowed within string values */
+    lp->fields = ++pt;
+    while (pt < end)
+    {
+        if (*pt == '\\')
+        {
+            pt += 2;
+            continue;
+        }
+        if (*pt == '"')
+            in_str = !in_str;
+        else if (!in_str && (*pt == ' ' || *pt == '\n' || *pt == '\r'))
+            break;
+        ++pt;
+    }
+
+    if (in_str || pt > end || pt == lp->fields)
+        return LPROTO_ERR;
+
+    lp->fields_end = pt;
+
+    while (pt < end && (*pt == ' ' || *pt == '\t'))
+        ++pt;
+
+    /* optional time-stamp */
+    lp->has_ts = 0;
+    if (pt < end && *pt != '\n' && *pt != '\r')
+    {
+        char * ts = pt;
+        while (pt < end && *pt != ' ' && *pt != '\n' && *pt != '\r')
+            ++pt;
+
+        if (lproto__int(ts, pt - ts, &lp->ts))
+            return LPROTO_ERR;
+
+        lp->has_ts = 1;
+
+        while (pt < end && (*pt == ' ' || *pt == '\t' || *pt == '\r'))
+            ++pt;
+    }
+
+    if (pt < end)
+    {
+        if (*pt == '\r')
+            ++pt;
+        if (pt < end && *pt++ != '\n')
+            return LPROTO_ERR;
+    }
+
+    lp->pt = pt;
+    return LPROTO_OK;
+}
+
+/*
+ * Read the next field for the current line.
+ *
+ * Returns LPROTO_OK when a field is read, LPROTO_END when no more fields are
+ * available for the current line or LPROTO_ERR in case of an invalid field.
+ */
+int lproto_next_field(lproto_t * lp, lproto_field_t * field)
+{
+    char * pt = lp->fields;
+    char * end = lp->fields_end;
+    char * name;
+
+    if (pt == end)
+        return LPROTO_END;
+
+    field->name = name = pt;
+    while (pt < end && *pt != '=')
+    {
+        if (*pt == '\\' && pt + 1 < end && lproto__is_escape(pt[1]))
+            ++pt;
+        *name++ = *pt++;
+    }
+
+    if (pt >= end - 1 || pt == field->name)
+        return LPROTO_ERR;
+
+    field->name_n = name - field->name;
+
+    if (*(++pt) == '"')
+    {
+        char * dst = ++pt;
+
+        field->tp = LPROTO_STRING;
+        field->via.str = dst;
+
+        while (pt < end && *pt != '"')
+        {
+            if (*pt == '\\' && pt + 1 < end && (pt[1] == '"' || pt[1] == '\\'))
+                ++pt;
+            *dst++ = *pt++;
+        }
+
+        if (pt == end)
+            return LPROTO_ERR;
+
+        field->len = dst - field->via.str;
+        ++pt;
+    }
+    else
+    {
+        char * val = pt;
+        while (pt < end && *pt != ',')
+            ++pt;
+
+        if (lproto__value(field, val, pt - val))
+            return LPROTO_ERR;
+    }
+
+    if (pt < end && (*pt++ != ',' || pt == end))
+        return LPROTO_ERR;
+
+    lp->fields = pt;
+    return LPROTO_OK;
+}
@@ -18,21 +18,19 @@
 
 #define QPACK_MAX_FMT_SIZE 1024
 
+static int QP_grow(qp_packer_t * packer, size_t n);
+
+/*
+ * The buffer size is doubled until it reaches QP_GROW_MAX, after which it
+ * grows with steps of QP_GROW_MAX. This keeps the number of re-allocations
+ * low for large results without doubling the memory usage for huge ones.
+ */
+#define QP_GROW_MAX 67108864    /* 64 MB */
+
 #define QP_RESIZE(LEN)                                                  \
-if (packer->len + LEN > packer->buffer_size)                            \
+if (packer->len + LEN > packer->buffer_size && QP_grow(packer, LEN))    \
 {                                                                       \
-    packer->buffer_size =                                               \
-            ((packer->len + LEN) / packer->alloc_size + 1)              \
-            * packer->alloc_size;                                       \
-    unsigned char * tmp = (unsigned char *) realloc(                    \
-            packer->buffer, packer->buffer_size);                       \
-    if (tmp == NULL)                                                    \
-    {                                                                   \
-        ERR_ALLOC                                                       \
-        packer->buffer_size = packer->len;                              \
-        return -1;                                                      \
-    }                                                                   \
-    packer->buffer = tmp;                                               \
+    return -1;                                                          \
 }
 
 #define QP_PLAIN_OBJ(QP_TYPE)                       \
@@ -231,6 +229,35 @@ qp_packer_t * qp_packer_new(size_t alloc_size)
     return packer;
 }
 
+/*
+ * Make sure the packer has room for at least 'n' more bytes. This can be
+ * used to allocate the buffer at once when the size of the result can be
+ * estimated.
+ *
+ * Returns 0 if successful; -1 and a SIGNAL is raised in case an error occurred.
+ */
+int qp_packer_reserve(qp_packer_t * packer, size_t n)
+{
+    size_t size;
+    unsigned char * tmp;
+
+    if (packer->len + n <= packer->buffer_size)
+    {
+        return 0;
+    }
+
+    size = packer->len + n;
+    tmp = (unsigned char *) realloc(packer->buffer, size);
+    if (tmp == NULL)
+    {
+        ERR_ALLOC
+        return -1;
+    }
+    packer->buffer = tmp;
+    packer->buffer_size = size;
+    return 0;
+}
+
 /*
  * Destroy packer object. (parsing NULL is not allowed)
  */
@@ -409,6 +436,21 @@ int qp_add_raw(qp_packer_t * packer, const unsigned char * raw, size_t len)
     return 0;
 }
 
+/*
+ * Adds a raw string header to the packer and reserves 'len' bytes. The
+ * reserved space is returned by 'raw' and must be filled by the caller before
+ * something else is added to the packer.
+ *
+ * Returns 0 if successful; -1 and a SIGNAL is raised in case an error occurred.
+ */
+int qp_add_raw_alloc(qp_packer_t * packer, unsigned char ** raw, size_t len)
+{
+    QP_PREPARE_RAW
+    *raw = packer->buffer + packer->len;
+    packer->len += len;
+    return 0;
+}
+
 /* shortcuts for qp_add_raw() */
 int qp_add_string(qp_packer_t * packer, const char * str)
 {
@@ -1303,3 +1345,35 @@ static qp_types_t QP_print_unpacker(
     }
     return qp_next(unpacker, qp_obj);
 }
+
+/*
+ * Grow the packer buffer so at least 'n' more bytes fit.
+ *
+ * Returns 0 if successful; -1 and a SIGNAL is raised in case an error occurred.
+ */
+static int QP_grow(qp_packer_t * packer, size_t n)
+{
+    size_t need = packer->len + n;
+    size_t size = (packer->buffer_size < QP_GROW_MAX)
+            ? packer->buffer_size * 2
+            : packer->buffer_size + QP_GROW_MAX;
+    unsigned char * tmp;
+
+    if (size < need)
+    {
+        size = need;
+    }
+
+    /* keep the size a multiple of the allocation size */
+    size = (size / packer->alloc_size + 1) * packer->alloc_size;
+
+    tmp = (unsigned char *) realloc(packer->buffer, size);
+    if (tmp == NULL)
+    {
+        ERR_ALLOC
+        return -1;
+    }
+    packer->buffer = tmp;
+    packer->buffer_size = size;
+    return 0;
+}
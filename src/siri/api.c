@@ -38,26 +38,28 @@ static const char api__content_type[3][20] = {
         "application/qpack",
 };
 
-static const char api__html_header[10][32] = {
+static const char api__html_header[11][32] = {
         "200 OK",
         "400 Bad Request",
         "401 Unauthorized",
         "403 Forbidden",
         "404 Not Found",
         "405 Method Not Allowed",
+        "413 Payload Too Large",
         "415 Unsupported Media Type",
         "422 Unprocessable Entity",
         "500 Internal Server Error",
         "503 Service Unavailable",
 };
 
-static const char api__default_body[10][30] = {
+static const char api__default_body[11][30] = {
         "OK\r\n",
         "BAD REQUEST\r\n",
         "UNAUTHORIZED\r\n",
         "FORBIDDEN\r\n",
         "NOT FOUND\r\n",
         "METHOD NOT ALLOWED\r\n",
+        "PAYLOAD TOO LARGE\r\n",
         "UNSUPPORTED MEDIA TYPE\r\n",
         "UNPROCESSABLE ENTITY\r\n",
         "INTERNAL SERVER ERROR\r\n",
@@ -127,6 +129,12 @@ static void api__reset(siri_api_request_t * ar)
     /* Reset buffer in case multiple HTTP requests are used */
     free (ar->buf);
 
+    if (ar->insertjson)
+    {
+        siridb_insertjson_free(ar->insertjson);
+        ar->insertjson = NULL;
+    }
+
     if (ar->siridb)
     {
         siridb_decref(ar->siridb);
@@ -146,6 +154,7 @@ static void api__reset(siri_api_request_t * ar)
     ar->service_authenticated = 0;
     ar->request_type = SIRI_API_RT_NONE;
     ar->content_type = SIRI_API_CT_TEXT;
+    ar->precision = SIRIDB_TIME_NANOSECONDS;
 }
 
 static void api__data_cb(
@@ -190,14 +199,85 @@ done:
      free(buf->base);
 }
 
+static siri_api_header_t api__insert_check(
+        siri_api_request_t * ar,
+        http_parser * parser)
+{
+    if (parser->method != HTTP_POST)
+        return E405_METHOD_NOT_ALLOWED;
+
+    if (!ar->siridb)
+        return E404_NOT_FOUND;
+
+    if (!ar->origin)
+        return E401_UNAUTHORIZED;
+
+    if (!(((siridb_user_t *) ar->origin)->access_bit & SIRIDB_ACCESS_INSERT))
+        return E403_FORBIDDEN;
+
+    if ((
+            ar->siridb->server->flags != SERVER_FLAG_RUNNING &&
+            ar->siridb->server->flags != SERVER_FLAG_RUNNING + SERVER_FLAG_REINDEXING
+        ) ||
+        !siridb_pools_accessible(ar->siridb))
+        return E503_SERVICE_UNAVAILABLE;
+
+    return E200_OK;
+}
+
+/*
+ * Returns E413_PAYLOAD_TOO_LARGE when the body of an insert request was too
+ * large to be buffered.
+ */
+static siri_api_header_t api__insert_size_check(siri_api_request_t * ar)
+{
+    if (ar->size <= MAX_ALLOWED_PKG_SIZE)
+        return E200_OK;
+
+    log_warning(
+            "insert data of %zu bytes exceeds %d bytes",
+            ar->size,
+            MAX_ALLOWED_PKG_SIZE);
+    return E413_PAYLOAD_TOO_LARGE;
+}
+
 static int api__headers_complete_cb(http_parser * parser)
 {
     siri_api_request_t * ar = parser->data;
 
     assert (!ar->buf);
+    assert (!ar->insertjson);
+
+    /*
+     * JSON inserts are parsed while the body is received so the body does
+     * not need to be buffered. In case the insert is not allowed, the body
+     * is buffered as usual and the error is returned once the message is
+     * complete.
+     */
+    if (ar->request_type == SIRI_API_RT_INSERT &&
+        ar->content_type == SIRI_API_CT_JSON &&
+        api__insert_check(ar, parser) == E200_OK)
+    {
+        ar->insertjson = siridb_insertjson_new(
+                ar->siridb,
+                (sirinet_stream_t *) ar);
+        return ar->insertjson ? 0 : -1;  /* signal is raised */
+    }
 
     if (parser->content_length != ULLONG_MAX)
     {
+        ar->size = parser->content_length;
+
+        /*
+         * Other insert data is limited to the same size as streamed JSON
+         * inserts. A larger body is not buffered and is refused once the
+         * message is complete, see api__insert_size_check().
+         */
+        if ((ar->request_type == SIRI_API_RT_INSERT ||
+             ar->request_type == SIRI_API_RT_INSERT_LINE) &&
+            ar->size > MAX_ALLOWED_PKG_SIZE)
+            return 0;
+
         ar->buf = malloc(parser->content_length);
         if (ar->buf)
         {
@@ -226,6 +306,42 @@ static void api__get_siridb(siri_api_request_t * ar, const char * at, size_t n)
     }
 }
 
+/*
+ * Read the optional time precision for line protocol inserts, for example:
+ *
+ *   /insert-line/dbname?precision=ms
+ */
+static int api__get_precision(siri_api_request_t * ar, const char * at, size_t n)
+{
+    int i;
+
+    while (n && *at != '?')
+    {
+        ++at;
+        --n;
+    }
+
+    if (!n)
+        return 0;
+
+    ++at;
+    --n;
+
+    if (!api__starts_with(&at, &n, "precision=", strlen("precision=")))
+        return -1;
+
+    for (i = SIRIDB_TIME_SECONDS; i < SIRIDB_TIME_END; ++i)
+    {
+        if (API__CMP_WITH(at, n, siridb_time_short_map(i)))
+        {
+            ar->precision = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
 static int api__url_cb(http_parser * parser, const char * at, size_t n)
 {
     siri_api_request_t * ar = parser->data;
@@ -240,6 +356,18 @@ static int api__url_cb(http_parser * parser, const char * at, size_t n)
         ar->request_type = SIRI_API_RT_INSERT;
         api__get_siridb(ar, at, n);
     }
+    else if (api__starts_with(
+            &at, &n, "/insert-line/", strlen("/insert-line/")))
+    {
+        ar->request_type = SIRI_API_RT_INSERT_LINE;
+        ar->precision = SIRIDB_TIME_NANOSECONDS;
+        api__get_siridb(ar, at, n);
+        if (api__get_precision(ar, at, n))
+        {
+            /* invalid query string, the request will return 400 */
+            ar->request_type = SIRI_API_RT_NONE;
+        }
+    }
     else if (API__CMP_WITH(at, n, "/new-account"))
     {
         ar->request_type = SIRI_APT_RT_SERVICE;
@@ -424,6 +552,12 @@ static int api__body_cb(http_parser * parser, const char * at, size_t n)
     size_t offset;
     siri_api_request_t * ar = parser->data;
 
+    if (ar->insertjson)
+    {
+        siridb_insertjson_feed(ar->insertjson, at, n);
+        return 0;
+    }
+
     if (!n || !ar->len)
         return 0;
 
@@ -572,6 +706,47 @@ static int api__query_from_qp(api__query_t * q, siri_api_request_t * ar)
             : api__query(ar, q);
 }
 
+static void api__insert_err(
+        siri_api_request_t * ar,
+        siridb_insert_err_t err,
+        size_t pos)
+{
+    /* something went wrong, get correct err message */
+    const char * err_msg = siridb_insert_err_msg(err);
+
+    log_error("Insert error: '%s' at position %lu", err_msg, pos);
+
+    /* create and send package */
+    sirinet_pkg_t * package = sirinet_pkg_err(
+            0,
+            strlen(err_msg),
+            CPROTO_ERR_INSERT,
+            err_msg);
+
+    if (package != NULL)
+    {
+        /* ignore result code, signal can be raised */
+        sirinet_pkg_send((sirinet_stream_t *) ar, package);
+    }
+}
+
+static int api__insert_points(
+        siri_api_request_t * ar,
+        siridb_insert_t * insert,
+        size_t npoints)
+{
+    if (siridb_insert_points_to_pools(insert, npoints))
+    {
+        siridb_insert_free(insert);  /* signal is raised */
+    }
+    else
+    {
+        /* extra increment for the insert task */
+        sirinet_stream_incref(ar);
+    }
+    return 0;
+}
+
 static int api__insert_from_qp(siri_api_request_t * ar)
 {
     qp_unpacker_t unpacker;
@@ -592,81 +767,69 @@ static int api__insert_from_qp(siri_api_request_t * ar)
             &unpacker,
             insert->packer);
 
-    switch ((siridb_insert_err_t) rc)
-    {
-    case ERR_EXPECTING_ARRAY:
-    case ERR_EXPECTING_SERIES_NAME:
-    case ERR_EXPECTING_MAP_OR_ARRAY:
-    case ERR_EXPECTING_INTEGER_TS:
-    case ERR_TIMESTAMP_OUT_OF_RANGE:
-    case ERR_UNSUPPORTED_VALUE:
-    case ERR_EXPECTING_AT_LEAST_ONE_POINT:
-    case ERR_EXPECTING_NAME_AND_POINTS:
-    case ERR_INCOMPATIBLE_SERVER_VERSION:
-    case ERR_MEM_ALLOC:
-        {
-            /* something went wrong, get correct err message */
-            const char * err_msg = siridb_insert_err_msg(rc);
+    if (rc < 0)
+    {
+        api__insert_err(
+                ar,
+                (siridb_insert_err_t) rc,
+                unpacker.pt -  (unsigned char *) ar->buf);
 
-            log_error("Insert error: '%s' at position %lu",
-                    err_msg, unpacker.pt -  (unsigned char *) ar->buf);
+        /* error, free insert */
+        siridb_insert_free(insert);
+        return 0;
+    }
 
-            /* create and send package */
-            sirinet_pkg_t * package = sirinet_pkg_err(
-                    0,
-                    strlen(err_msg),
-                    CPROTO_ERR_INSERT,
-                    err_msg);
+    return api__insert_points(ar, insert, (size_t) rc);
+}
 
-            if (package != NULL)
-            {
-                /* ignore result code, signal can be raised */
-                sirinet_pkg_send((sirinet_stream_t *) ar, package);
-            }
-        }
+static int api__insert_from_json(siri_api_request_t * ar)
+{
+    siridb_insert_t * insert;
+    ssize_t rc = siridb_insertjson_done(ar->insertjson);
 
-        /* error, free insert */
-        siridb_insert_free(insert);
-        break;
+    if (rc == ERR_INVALID_JSON)
+    {
+        log_debug(
+                "invalid JSON insert data at position %zu",
+                ar->insertjson->pos);
+        return api__plain_response(ar, E400_BAD_REQUEST);
+    }
 
-    default:
-        if (siridb_insert_points_to_pools(insert, (size_t) rc))
-        {
-            siridb_insert_free(insert);  /* signal is raised */
-        }
-        else
-        {
-            /* extra increment for the insert task */
-            sirinet_stream_incref(ar);
-        }
-        break;
+    if (rc == ERR_INSERT_TOO_LARGE)
+    {
+        log_warning(
+                "JSON insert data exceeds %d bytes at position %zu",
+                MAX_ALLOWED_PKG_SIZE,
+                ar->insertjson->pos);
+        return api__plain_response(ar, E413_PAYLOAD_TOO_LARGE);
     }
-    return 0;
+
+    if (rc < 0)
+    {
+        api__insert_err(
+                ar,
+                (siridb_insert_err_t) rc,
+                ar->insertjson->pos);
+        return 0;
+    }
+
+    insert = siridb_insertjson_take(ar->insertjson);
+    return api__insert_points(ar, insert, (size_t) rc);
 }
 
 static int api__insert_cb(http_parser * parser)
 {
     siri_api_request_t * ar = parser->data;
+    siri_api_header_t ht = api__insert_check(ar, parser);
 
-    if (parser->method != HTTP_POST)
-        return api__plain_response(ar, E405_METHOD_NOT_ALLOWED);
-
-    if (!ar->siridb)
-        return api__plain_response(ar, E404_NOT_FOUND);
-
-    if (!ar->origin)
-        return api__plain_response(ar, E401_UNAUTHORIZED);
+    if (ht == E200_OK && !ar->insertjson)
+        ht = api__insert_size_check(ar);
 
+    if (ht != E200_OK)
+        return api__plain_response(ar, ht);
 
-    if (!(((siridb_user_t *) ar->origin)->access_bit & SIRIDB_ACCESS_INSERT))
-        return api__plain_response(ar, E403_FORBIDDEN);
-
-    if ((
-            ar->siridb->server->flags != SERVER_FLAG_RUNNING &&
-            ar->siridb->server->flags != SERVER_FLAG_RUNNING + SERVER_FLAG_REINDEXING
-        ) ||
-        !siridb_pools_accessible(ar->siridb))
-        return api__plain_response(ar, E503_SERVICE_UNAVAILABLE);
+    if (ar->insertjson)
+        return api__insert_from_json(ar);
 
     switch (ar->content_type)
     {
@@ -691,6 +854,47 @@ static int api__insert_cb(http_parser * parser)
     return api__plain_response(ar, E415_UNSUPPORTED_MEDIA_TYPE);
 }
 
+static int api__insert_line_cb(http_parser * parser)
+{
+    size_t pos;
+    ssize_t rc;
+    siridb_insert_t * insert;
+    siri_api_request_t * ar = parser->data;
+    siri_api_header_t ht = api__insert_check(ar, parser);
+
+    /* line protocol requests are answered using JSON */
+    ar->content_type = SIRI_API_CT_JSON;
+
+    if (ht == E200_OK)
+        ht = api__insert_size_check(ar);
+
+    if (ht != E200_OK)
+        return api__plain_response(ar, ht);
+
+    insert = siridb_insert_new(ar->siridb, 0, (sirinet_stream_t *) ar);
+    if (insert == NULL)
+        return api__plain_response(ar, E500_INTERNAL_SERVER_ERROR);
+
+    rc = siridb_insert_assign_lines(
+            ar->siridb,
+            ar->buf,
+            ar->len,
+            ar->precision,
+            insert->packer,
+            &pos);
+
+    if (rc < 0)
+    {
+        api__insert_err(ar, (siridb_insert_err_t) rc, pos);
+
+        /* error, free insert */
+        siridb_insert_free(insert);
+        return 0;
+    }
+
+    return api__insert_points(ar, insert, (size_t) rc);
+}
+
 static int api__query_cb(http_parser * parser)
 {
     api__query_t q;
@@ -835,6 +1039,8 @@ static int api__message_complete_cb(http_parser * parser)
         return api__insert_cb(parser);
     case SIRI_APT_RT_SERVICE:
         return api__service_cb(parser);
+    case SIRI_API_RT_INSERT_LINE:
+        return api__insert_line_cb(parser);
     }
 
     return api__plain_response(ar, E500_INTERNAL_SERVER_ERROR);
@@ -869,6 +1075,19 @@ static int api__close_resp(
     return 0;
 }
 
+/*
+ * Free resources which are bound to a HTTP API request. This function is
+ * called when the API client stream is destroyed.
+ */
+void siri_api_free_request(siri_api_request_t * ar)
+{
+    if (ar->insertjson)
+    {
+        siridb_insertjson_free(ar->insertjson);
+        ar->insertjson = NULL;
+    }
+}
+
 int siri_api_init(void)
 {
     int rc;
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <logger/logger.h>
 #include <siri/backup.h>
+#include <siri/expire.h>
 #include <siri/db/replicate.h>
 #include <siri/db/server.h>
 #include <siri/db/servers.h>
@@ -198,7 +199,8 @@ static int BACKUP_walk(siridb_t * siridb, void * args __attribute__((unused)))
         }
     }
 
-    if (SIRI_OPTIMZE_IS_PAUSED)
+    /* wait for optimize to pause and for dropping expired shards to stop */
+    if (SIRI_OPTIMZE_IS_PAUSED && !siri_expire_is_running())
     {
         size_t i;
         siridb_shard_t * shard;
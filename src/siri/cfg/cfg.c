@@ -6,6 +6,7 @@
 #include <limits.h>
 #include <logger/logger.h>
 #include <siri/cfg/cfg.h>
+#include <siri/db/server.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <xstr/xstr.h>
@@ -22,10 +23,13 @@ static siri_cfg_t siri_cfg = {
         .bind_client_addr=NULL,
         .bind_backend_addr=NULL,
         .heartbeat_interval=30,
+        .server_connections=1,
+        .insert_coalesce_window=0,
         .max_open_files=DEFAULT_OPEN_FILES_LIMIT,
         .optimize_interval=3600,
         .ip_support=IP_SUPPORT_ALL,
         .shard_compression=0,
+        .select_compression=0,
         .shard_auto_duration=0,
         .server_address="localhost",
         .db_path="",
@@ -55,6 +59,7 @@ static void SIRI_CFG_read_db_path(cfgparser_t * cfgparser);
 static void SIRI_CFG_read_max_open_files(cfgparser_t * cfgparser);
 static void SIRI_CFG_read_ip_support(cfgparser_t * cfgparser);
 static void SIRI_CFG_read_shard_compression(cfgparser_t * cfgparser);
+static void SIRI_CFG_read_select_compression(cfgparser_t * cfgparser);
 static void SIRI_CFG_read_shard_auto_duration(cfgparser_t * cfgparser);
 static void SIRI_CFG_read_pipe_support(cfgparser_t * cfgparser);
 static void SIRI_CFG_ignore_broken_data(cfgparser_t * cfgparser);
@@ -112,6 +117,24 @@ void siri_cfg_init(siri_t * siri)
             &tmp);
     siri_cfg.heartbeat_interval = (uint16_t) tmp;
 
+    tmp = siri_cfg.server_connections;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "server_connections",
+            1,
+            SIRIDB_SERVER_MAX_CONNECTIONS,
+            &tmp);
+    siri_cfg.server_connections = (uint16_t) tmp;
+
+    tmp = siri_cfg.insert_coalesce_window;
+    SIRI_CFG_read_uint(
+            cfgparser,
+            "insert_coalesce_window",
+            0,
+            50,
+            &tmp);
+    siri_cfg.insert_coalesce_window = (uint16_t) tmp;
+
     tmp = siri_cfg.http_status_port;
     SIRI_CFG_read_uint(
             cfgparser,
@@ -134,6 +157,7 @@ void siri_cfg_init(siri_t * siri)
     SIRI_CFG_read_max_open_files(cfgparser);
     SIRI_CFG_read_ip_support(cfgparser);
     SIRI_CFG_read_shard_compression(cfgparser);
+    SIRI_CFG_read_select_compression(cfgparser);
     SIRI_CFG_read_shard_auto_duration(cfgparser);
 
     SIRI_CFG_read_addr(
@@ -300,6 +324,35 @@ static void SIRI_CFG_read_shard_compression(cfgparser_t * cfgparser)
     }
 }
 
+static void SIRI_CFG_read_select_compression(cfgparser_t * cfgparser)
+{
+    cfgparser_option_t * option;
+    cfgparser_return_t rc;
+    rc = cfgparser_get_option(
+                &option,
+                cfgparser,
+                "siridb",
+                "enable_select_compression");
+    if (rc != CFGPARSER_SUCCESS)
+    {
+        log_warning(
+                "Missing 'enable_select_compression' in '%s' (%s).",
+                siri.args->config,
+                cfgparser_errmsg(rc));
+    }
+    else if (option->tp != CFGPARSER_TP_INTEGER || option->val->integer > 1)
+    {
+        log_warning(
+                "Error reading 'enable_select_compression' in '%s': %s.",
+                siri.args->config,
+                "error: expecting 0 or 1");
+    }
+    else if (option->val->integer == 1)
+    {
+        siri_cfg.select_compression = 1;
+    }
+}
+
 static void SIRI_CFG_read_shard_auto_duration(cfgparser_t * cfgparser)
 {
     cfgparser_option_t * option;
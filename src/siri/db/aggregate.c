@@ -10,6 +10,7 @@
 #include <siri/grammar/grammar.h>
 #include <siri/grammar/gramp.h>
 #include <siri/db/re.h>
+#include <siri/db/sketch.h>
 #include <vec/vec.h>
 #include <stddef.h>
 #include <xstr/xstr.h>
@@ -99,6 +100,12 @@ static int aggr_difference(
         siridb_aggr_t * aggr,
         char * err_msg);
 
+static int aggr_distinct(
+        siridb_point_t * point,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+
 static int aggr_max(
         siridb_point_t * point,
         siridb_points_t * points,
@@ -135,6 +142,12 @@ static int aggr_min(
         siridb_aggr_t * aggr,
         char * err_msg);
 
+static int aggr_percentile(
+        siridb_point_t * point,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+
 static int aggr_pvariance(
         siridb_point_t * point,
         siridb_points_t * points,
@@ -186,12 +199,14 @@ void siridb_init_aggregates(void)
     AGGREGATES[CLERI_GID_F_COUNT - F_OFFSET] = aggr_count;
     AGGREGATES[CLERI_GID_F_DERIVATIVE - F_OFFSET] = aggr_derivative;
     AGGREGATES[CLERI_GID_F_DIFFERENCE - F_OFFSET] = aggr_difference;
+    AGGREGATES[CLERI_GID_F_DISTINCT - F_OFFSET] = aggr_distinct;
     AGGREGATES[CLERI_GID_F_MAX - F_OFFSET] = aggr_max;
     AGGREGATES[CLERI_GID_F_MEAN - F_OFFSET] = aggr_mean;
     AGGREGATES[CLERI_GID_F_MEDIAN - F_OFFSET] = aggr_median;
     AGGREGATES[CLERI_GID_F_MEDIAN_HIGH - F_OFFSET] = aggr_median_high;
     AGGREGATES[CLERI_GID_F_MEDIAN_LOW - F_OFFSET] = aggr_median_low;
     AGGREGATES[CLERI_GID_F_MIN - F_OFFSET] = aggr_min;
+    AGGREGATES[CLERI_GID_F_PERCENTILE - F_OFFSET] = aggr_percentile;
     AGGREGATES[CLERI_GID_F_PVARIANCE - F_OFFSET] = aggr_pvariance;
     AGGREGATES[CLERI_GID_F_SUM - F_OFFSET] = aggr_sum;
     AGGREGATES[CLERI_GID_F_VARIANCE - F_OFFSET] = aggr_variance;
@@ -414,7 +429,48 @@ vec_t * siridb_aggregate_list(cleri_children_t * children, char * err_msg)
 
             break;
 
+        case CLERI_GID_F_PERCENTILE:
+            AGGR_NEW
+            {
+                cleri_children_t * child = cleri_gn(cleri_gn(children)
+                        ->children)->children->next->next;
+
+                aggr->percentile = xstr_to_double(cleri_gn(child)->str);
+
+                if (!(aggr->percentile >= 0.0 && aggr->percentile <= 100.0))
+                {
+                    sprintf(err_msg,
+                            "Percentile must be a value between 0 and 100.");
+                    AGGREGATE_free(aggr);
+                    siridb_aggregate_list_free(vec);
+                    return NULL;
+                }
+
+                if (child->next->next != NULL)
+                {
+                    /* result is always positive, checked earlier */
+                    aggr->group_by = CLERI_NODE_DATA(cleri_gn(cleri_gn(
+                            cleri_gn(child->next)->children)
+                            ->children->next));
+
+                    if (!aggr->group_by)
+                    {
+                        sprintf(err_msg,
+                                "Group by time must be an integer value "
+                                "larger than zero.");
+                        AGGREGATE_free(aggr);
+                        siridb_aggregate_list_free(vec);
+                        return NULL;
+                    }
+                }
+            }
+
+            VEC_APPEND
+
+            break;
+
         case CLERI_GID_F_DIFFERENCE:
+        case CLERI_GID_F_DISTINCT:
         case CLERI_GID_F_COUNT:
         case CLERI_GID_F_MAX:
         case CLERI_GID_F_MEAN:
@@ -489,6 +545,129 @@ void siridb_aggregate_list_free(vec_t * alist)
     free(alist);
 }
 
+/*
+ * Pack an aggregation list so it can be used by another server.
+ *
+ * Returns 0 if successful, 1 when the list contains a string or regular
+ * expression filter which cannot be packed, or -1 in case of an error.
+ * (nothing is packed when the list cannot be packed)
+ */
+int siridb_aggregate_list_pack(vec_t * alist, qp_packer_t * packer)
+{
+    siridb_aggr_t * aggr;
+    size_t i;
+    int rc;
+
+    for (i = 0; i < alist->len; i++)
+    {
+        if (((siridb_aggr_t *) alist->data[i])->filter_tp == TP_STRING)
+        {
+            return 1;
+        }
+    }
+
+    rc = qp_add_type(packer, QP_ARRAY_OPEN);
+    for (i = 0; i < alist->len; i++)
+    {
+        aggr = alist->data[i];
+        rc = rc ||
+            qp_add_type(packer, QP_ARRAY_OPEN) ||
+            qp_add_int64(packer, aggr->gid) ||
+            qp_add_int64(packer, aggr->filter_opr) ||
+            qp_add_int64(packer, aggr->filter_tp) ||
+            qp_add_int64(packer, (int64_t) aggr->group_by) ||
+            qp_add_int64(packer, (int64_t) aggr->limit) ||
+            qp_add_int64(packer, (int64_t) aggr->offset) ||
+            qp_add_double(packer, aggr->timespan) ||
+            ((aggr->filter_tp == TP_DOUBLE) ?
+                qp_add_double(packer, aggr->filter_via.real) :
+                qp_add_int64(packer, aggr->filter_via.int64)) ||
+            qp_add_double(packer, aggr->percentile) ||
+            qp_add_type(packer, QP_ARRAY_CLOSE);
+    }
+    return (rc || qp_add_type(packer, QP_ARRAY_CLOSE)) ? -1 : 0;
+}
+
+/*
+ * Unpack an aggregation list which is packed with siridb_aggregate_list_pack.
+ *
+ * Returns NULL when the data is invalid or in case of an allocation error.
+ */
+vec_t * siridb_aggregate_list_unpack(qp_unpacker_t * unpacker)
+{
+    siridb_aggr_t * aggr;
+    qp_obj_t qp_val[9];
+    qp_types_t tp;
+    size_t i;
+    vec_t * vec;
+
+    if (qp_next(unpacker, NULL) != QP_ARRAY_OPEN ||
+        (vec = vec_new(VEC_DEFAULT_SIZE)) == NULL)
+    {
+        return NULL;
+    }
+
+    while ((tp = qp_next(unpacker, NULL)) == QP_ARRAY_OPEN)
+    {
+        for (i = 0; i < 9; i++)
+        {
+            if (!qp_is_int(qp_next(unpacker, &qp_val[i])) &&
+                !(qp_is_double(qp_val[i].tp) && i >= 6))
+            {
+                siridb_aggregate_list_free(vec);
+                return NULL;
+            }
+        }
+
+        if (qp_next(unpacker, NULL) != QP_ARRAY_CLOSE ||
+            qp_val[0].via.int64 < CLERI_GID_F_COUNT ||
+            qp_val[0].via.int64 > CLERI_GID_F_VARIANCE ||
+            (qp_val[2].via.int64 != TP_INT &&
+             qp_val[2].via.int64 != TP_DOUBLE) ||
+            !qp_is_double(qp_val[6].tp) ||
+            !qp_is_double(qp_val[8].tp) ||
+            (aggr = AGGREGATE_new((uint32_t) qp_val[0].via.int64)) == NULL)
+        {
+            siridb_aggregate_list_free(vec);
+            return NULL;
+        }
+
+        aggr->filter_opr = (cexpr_operator_t) qp_val[1].via.int64;
+        aggr->filter_tp = (uint8_t) qp_val[2].via.int64;
+        aggr->group_by = (uint64_t) qp_val[3].via.int64;
+        aggr->limit = (uint64_t) qp_val[4].via.int64;
+        aggr->offset = (uint64_t) qp_val[5].via.int64;
+        aggr->timespan = qp_val[6].via.real;
+        aggr->percentile = qp_val[8].via.real;
+
+        if (aggr->filter_tp == TP_DOUBLE)
+        {
+            aggr->filter_via.real = qp_is_double(qp_val[7].tp) ?
+                    qp_val[7].via.real : (double) qp_val[7].via.int64;
+        }
+        else
+        {
+            aggr->filter_via.int64 = qp_is_int(qp_val[7].tp) ?
+                    qp_val[7].via.int64 : (int64_t) qp_val[7].via.real;
+        }
+
+        if (vec_append_safe(&vec, aggr))
+        {
+            AGGREGATE_free(aggr);
+            siridb_aggregate_list_free(vec);
+            return NULL;
+        }
+    }
+
+    if (tp != QP_ARRAY_CLOSE)
+    {
+        siridb_aggregate_list_free(vec);
+        return NULL;
+    }
+
+    return vec;
+}
+
 /*
  * Returns 1 (true) if at least one aggregation requires all points to be queried.
  */
@@ -568,6 +747,7 @@ static siridb_aggr_t * AGGREGATE_new(uint32_t gid)
     aggr->limit = 0;
     aggr->offset = 0;
     aggr->timespan = 1.0;
+    aggr->percentile = 0.0;
     aggr->regex = NULL;
     aggr->match_data = NULL;
     aggr->filter_via.raw = NULL;
@@ -1079,12 +1259,14 @@ static siridb_points_t * AGGREGATE_to_one(
     {
     case CLERI_GID_F_MEAN:
     case CLERI_GID_F_MEDIAN:
+    case CLERI_GID_F_PERCENTILE:
     case CLERI_GID_F_PVARIANCE:
     case CLERI_GID_F_VARIANCE:
     case CLERI_GID_F_STDDEV:
         points = siridb_points_new(1, TP_DOUBLE);
         break;
     case CLERI_GID_F_COUNT:
+    case CLERI_GID_F_DISTINCT:
         points = siridb_points_new(1, TP_INT);
         break;
     case CLERI_GID_F_MEDIAN_HIGH:
@@ -1153,6 +1335,7 @@ static siridb_points_t * AGGREGATE_group_by(
     {
     case CLERI_GID_F_MEAN:
     case CLERI_GID_F_MEDIAN:
+    case CLERI_GID_F_PERCENTILE:
     case CLERI_GID_F_PVARIANCE:
     case CLERI_GID_F_VARIANCE:
     case CLERI_GID_F_STDDEV:
@@ -1160,6 +1343,7 @@ static siridb_points_t * AGGREGATE_group_by(
         points = siridb_points_new(max_sz, TP_DOUBLE);
         break;
     case CLERI_GID_F_COUNT:
+    case CLERI_GID_F_DISTINCT:
     case CLERI_GID_F_TIMEVAL:
     case CLERI_GID_F_INTERVAL:
         points = siridb_points_new(max_sz, TP_INT);
@@ -1358,6 +1542,27 @@ static int aggr_difference(
     return 0;
 }
 
+/*
+ * Uses a HyperLogLog so the memory used does not depend on the number of
+ * points. The result is exact for small groups and has a standard error of
+ * about 1.6% for larger groups.
+ */
+static int aggr_distinct(
+        siridb_point_t * point,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr __attribute__((unused)),
+        char * err_msg __attribute__((unused)))
+{
+    siridb_sketch_t sketch;
+
+    siridb_sketch_init(&sketch, SIRIDB_SKETCH_HLL);
+    siridb_sketch_add(&sketch, points->data, points->len, points->tp);
+
+    point->val.int64 = siridb_sketch_distinct(&sketch);
+
+    return 0;
+}
+
 static int aggr_max(
         siridb_point_t * point,
         siridb_points_t * points,
@@ -1595,6 +1800,35 @@ static int aggr_min(
     return 0;
 }
 
+/*
+ * Uses a t-digest instead of sorting the points like median(), so no memory
+ * is allocated and the same digest can be used as partial state for merged
+ * series.
+ */
+static int aggr_percentile(
+        siridb_point_t * point,
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    siridb_sketch_t sketch;
+
+    assert (points->len);
+
+    if (points->tp == TP_STRING)
+    {
+        sprintf(err_msg, "Cannot use percentile() on string type.");
+        return -1;
+    }
+
+    siridb_sketch_init(&sketch, SIRIDB_SKETCH_TDIGEST);
+    siridb_sketch_add(&sketch, points->data, points->len, points->tp);
+
+    point->val.real = siridb_sketch_percentile(&sketch, aggr->percentile);
+
+    return 0;
+}
+
 static int aggr_pvariance(
         siridb_point_t * point,
         siridb_points_t * points,
@@ -0,0 +1,302 @@
+/*
+ * coalesce.c - Combine forwarded inserts for the same pool.
+ */
+#include <assert.h>
+#include <logger/logger.h>
+#include <siri/db/coalesce.h>
+#include <siri/db/insert.h>
+#include <siri/db/pool.h>
+#include <siri/err.h>
+#include <siri/net/pkg.h>
+#include <siri/net/promise.h>
+#include <siri/net/protocol.h>
+#include <siri/siri.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int COALESCE_grow(siridb_coalesce_t * coalesce, uint16_t pool);
+static void COALESCE_send(siridb_coalesce_t * coalesce, uint16_t pool);
+static void COALESCE_fail(vec_t * promises);
+static void COALESCE_on_response(
+        sirinet_promise_t * promise,
+        sirinet_pkg_t * pkg,
+        int status);
+static void COALESCE_on_timer(uv_timer_t * timer);
+
+/*
+ * Returns NULL in case of an allocation error.
+ */
+siridb_coalesce_t * siridb_coalesce_new(siridb_t * siridb)
+{
+    siridb_coalesce_t * coalesce = calloc(1, sizeof(siridb_coalesce_t));
+    if (coalesce == NULL)
+    {
+        return NULL;
+    }
+    coalesce->siridb = siridb;
+    return coalesce;
+}
+
+/*
+ * Destroy the coalescer.
+ *
+ * Waiting inserts keep a reference to the database so usually no batch is
+ * waiting at this point, unless SiriDB is forced to stop.
+ */
+void siridb_coalesce_free(siridb_coalesce_t * coalesce)
+{
+    uint16_t pool;
+
+    /* the timer might be closed already when the loop is stopped */
+    if (    coalesce->timer != NULL &&
+            !uv_is_closing((uv_handle_t *) coalesce->timer))
+    {
+        uv_timer_stop(coalesce->timer);
+        uv_close((uv_handle_t *) coalesce->timer, (uv_close_cb) free);
+    }
+
+    for (pool = 0; pool < coalesce->n; pool++)
+    {
+        if (coalesce->batches[pool].packer != NULL)
+        {
+            qp_packer_free(coalesce->batches[pool].packer);
+        }
+        vec_free(coalesce->batches[pool].promises);
+    }
+
+    free(coalesce->batches);
+    free(coalesce);
+}
+
+/*
+ * Add the points for a pool from an insert. The packer must be created with
+ * sirinet_packer_new() and should contain an open map with series and
+ * points.
+ *
+ * On success the coalescer takes ownership of the packer and one response
+ * for the pool will be added to the promises.
+ *
+ * Returns 0 if successful or -1 in case of an error in which case the packer
+ * is not used. (a SIGNAL might be raised)
+ */
+int siridb_coalesce_add(
+        siridb_coalesce_t * coalesce,
+        uint16_t pool,
+        uint8_t tp,
+        qp_packer_t * packer,
+        sirinet_promises_t * promises)
+{
+    siridb_coalesce_batch_t * batch;
+
+    if (pool >= coalesce->n && COALESCE_grow(coalesce, pool))
+    {
+        return -1;
+    }
+
+    batch = coalesce->batches + pool;
+
+    if (batch->packer != NULL && batch->tp != tp)
+    {
+        /* the re-index status has changed, send the current batch first */
+        COALESCE_send(coalesce, pool);
+    }
+
+    if (batch->promises == NULL)
+    {
+        batch->promises = vec_new(VEC_DEFAULT_SIZE);
+        if (batch->promises == NULL)
+        {
+            ERR_ALLOC
+            return -1;
+        }
+    }
+
+    if (vec_append_safe(&batch->promises, promises))
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
+    if (batch->packer == NULL)
+    {
+        batch->packer = packer;
+        batch->tp = tp;
+    }
+    else
+    {
+        /*
+         * Skip the package header and the map open of the insert so only
+         * the series with points are added to the batch.
+         */
+        qp_packer_t points = *packer;
+        points.buffer += sizeof(sirinet_pkg_t) + 1;
+        points.len -= sizeof(sirinet_pkg_t) + 1;
+
+        if (qp_packer_extend(batch->packer, &points))
+        {
+            (void) vec_pop(batch->promises);
+            return -1;  /* signal is raised */
+        }
+        qp_packer_free(packer);
+    }
+
+    coalesce->inserts++;
+
+    if (batch->packer->len >= SIRIDB_COALESCE_MAX_SIZE)
+    {
+        COALESCE_send(coalesce, pool);
+    }
+    else if (coalesce->timer == NULL)
+    {
+        coalesce->timer = malloc(sizeof(uv_timer_t));
+        if (coalesce->timer == NULL)
+        {
+            ERR_ALLOC
+            COALESCE_send(coalesce, pool);
+            return 0;
+        }
+
+        uv_timer_init(siri.loop, coalesce->timer);
+        coalesce->timer->data = coalesce;
+        uv_timer_start(
+                coalesce->timer,
+                COALESCE_on_timer,
+                siri.cfg->insert_coalesce_window,
+                0);
+    }
+
+    return 0;
+}
+
+/*
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+static int COALESCE_grow(siridb_coalesce_t * coalesce, uint16_t pool)
+{
+    siridb_coalesce_batch_t * tmp = realloc(
+            coalesce->batches,
+            (pool + 1) * sizeof(siridb_coalesce_batch_t));
+
+    if (tmp == NULL)
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
+    memset(tmp + coalesce->n, 0,
+            (pool + 1 - coalesce->n) * sizeof(siridb_coalesce_batch_t));
+
+    coalesce->batches = tmp;
+    coalesce->n = pool + 1;
+
+    return 0;
+}
+
+static void COALESCE_send(siridb_coalesce_t * coalesce, uint16_t pool)
+{
+    siridb_coalesce_batch_t * batch = coalesce->batches + pool;
+    siridb_t * siridb = coalesce->siridb;
+    vec_t * waiting = batch->promises;
+    sirinet_pkg_t * pkg = sirinet_packer2pkg(batch->packer, 0, batch->tp);
+
+    batch->packer = NULL;
+    batch->promises = NULL;
+
+    log_debug(
+            "Send %zu combined insert(s) to pool %u",
+            waiting->len,
+            pool);
+
+    if (siridb_pool_send_pkg(
+            siridb->pools->pool + pool,
+            pkg,
+            INSERT_TIMEOUT,
+            (sirinet_promise_cb) COALESCE_on_response,
+            waiting,
+            0))
+    {
+        free(pkg);
+        log_error(
+                "Cannot send combined points to pool %u, "
+                "the pool is not available", pool);
+        COALESCE_fail(waiting);
+        vec_free(waiting);
+        return;
+    }
+
+    coalesce->packages++;
+}
+
+/*
+ * Add an error response for each insert.
+ */
+static void COALESCE_fail(vec_t * waiting)
+{
+    sirinet_promises_t * promises;
+    size_t i;
+
+    for (i = 0; i < waiting->len; i++)
+    {
+        promises = waiting->data[i];
+        vec_append(promises->promises, NULL);
+        SIRINET_PROMISES_CHECK(promises)
+    }
+}
+
+/*
+ * Call-back for a combined package. Each insert receives a promise with its
+ * own copy of the response, just like when the points were sent by the
+ * insert itself.
+ */
+static void COALESCE_on_response(
+        sirinet_promise_t * promise,
+        sirinet_pkg_t * pkg,
+        int status)
+{
+    vec_t * waiting = promise->data;
+    sirinet_promises_t * promises;
+    sirinet_promise_t * response;
+    size_t i;
+
+    for (i = 0; i < waiting->len; i++)
+    {
+        promises = waiting->data[i];
+        response = sirinet_promise_new();
+        if (response == NULL)
+        {
+            ERR_ALLOC
+            vec_append(promises->promises, NULL);
+            SIRINET_PROMISES_CHECK(promises)
+            continue;
+        }
+
+        response->pid = promise->pid;
+        response->ref = 1;
+        response->cb = NULL;
+        response->server = promise->server;
+        response->pkg = NULL;
+        response->data = promises;
+
+        sirinet_promises_on_response(response, pkg, status);
+    }
+
+    vec_free(waiting);
+    sirinet_promise_decref(promise);
+}
+
+static void COALESCE_on_timer(uv_timer_t * timer)
+{
+    siridb_coalesce_t * coalesce = timer->data;
+    uint16_t pool;
+
+    uv_close((uv_handle_t *) timer, (uv_close_cb) free);
+    coalesce->timer = NULL;
+
+    for (pool = 0; pool < coalesce->n; pool++)
+    {
+        if (coalesce->batches[pool].packer != NULL)
+        {
+            COALESCE_send(coalesce, pool);
+        }
+    }
+}
@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <uuid/uuid.h>
 #include <xpath/xpath.h>
 #include <vec/vec.h>
@@ -314,7 +315,9 @@ static int siridb__from_unpacker(
             qp_schema.via.int64 == 3 ||
             qp_schema.via.int64 == 4 ||
             qp_schema.via.int64 == 5 ||
-            qp_schema.via.int64 == 6)
+            qp_schema.via.int64 == 6 ||
+            qp_schema.via.int64 == 7 ||
+            qp_schema.via.int64 == 8)
     {
         log_info(
                 "Found an old database schema (v%d), "
@@ -529,6 +532,28 @@ static int siridb__from_unpacker(
 
         (*siridb)->tee->port = qp_obj.via.int64;
     }
+    if (qp_schema.via.int64 >= 8)
+    {
+        if (qp_next(unpacker, &qp_obj) != QP_INT64 ||
+            qp_obj.via.int64 < 0 ||
+            qp_obj.via.int64 >= SIRIDB_CODEC_END)
+        {
+            READ_DB_EXIT_WITH_ERROR("Cannot read codec.")
+        }
+
+        (*siridb)->codec = qp_obj.via.int64;
+    }
+    if (qp_schema.via.int64 >= 9)
+    {
+        if (qp_next(unpacker, &qp_obj) != QP_INT64 ||
+            qp_obj.via.int64 < 0 ||
+            qp_obj.via.int64 >= SIRIDB_PLACEMENT_END)
+        {
+            READ_DB_EXIT_WITH_ERROR("Cannot read placement.")
+        }
+
+        (*siridb)->placement = qp_obj.via.int64;
+    }
 
     if ((*siridb)->tee->address == NULL)
     {
@@ -693,6 +718,8 @@ int siridb_save(siridb_t * siridb)
                 ? qp_fadd_type(fpacker, QP_NULL)
                 : qp_fadd_string(fpacker, siridb->tee->address)) ||
             qp_fadd_int64(fpacker, siridb->tee->port) ||
+            qp_fadd_int64(fpacker, siridb->codec) ||
+            qp_fadd_int64(fpacker, siridb->placement) ||
             qp_fadd_type(fpacker, QP_ARRAY_CLOSE) ||
             qp_close(fpacker));
 }
@@ -769,6 +796,8 @@ void siridb__free(siridb_t * siridb)
         imap_free(siridb->series_map, NULL);
     }
 
+    free(siridb->series_slots);
+
     /* free c-tree lookup and series */
     if (siridb->series != NULL)
     {
@@ -802,6 +831,23 @@ void siridb__free(siridb_t * siridb)
         siridb_tee_free(siridb->tee);
     }
 
+    if (siridb->qcache != NULL)
+    {
+        siridb_qcache_free(siridb->qcache);
+    }
+
+    if (siridb->coalesce != NULL)
+    {
+        siridb_coalesce_free(siridb->coalesce);
+    }
+
+    if (siridb->expire != NULL)
+    {
+        siridb_expire_free(siridb->expire);
+    }
+
+    siridb_zones_free(siridb->zones);
+
     /* unlock the database in case no siri_err occurred */
     if (!siri_err)
     {
@@ -880,6 +926,34 @@ void siridb_update_shard_expiration(siridb_t * siridb)
     uv_mutex_unlock(&siridb->values_mutex);
 }
 
+/*
+ * Returns the codec for a given name or -1 if the name is unknown.
+ */
+int siridb_codec_by_name(const char * name, size_t n)
+{
+    int codec;
+
+    for (codec = 0; codec < SIRIDB_CODEC_END; ++codec)
+    {
+        const char * s = siridb_codec_name(codec);
+        if (strlen(s) == n && strncasecmp(s, name, n) == 0)
+        {
+            return codec;
+        }
+    }
+    return -1;
+}
+
+const char * siridb_codec_name(uint8_t codec)
+{
+    switch (codec)
+    {
+    case SIRIDB_CODEC_DEFAULT:  return "default";
+    case SIRIDB_CODEC_GORILLA:  return "gorilla";
+    case SIRIDB_CODEC_BITPACK:  return "bitpack";
+    }
+    return "unknown";
+}
 
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
@@ -908,6 +982,8 @@ static siridb_t * siridb__new(void)
     siridb->drop_threshold = DEF_DROP_THRESHOLD;
     siridb->select_points_limit = DEF_SELECT_POINTS_LIMIT;
     siridb->list_limit = DEF_LIST_LIMIT;
+    siridb->codec = SIRIDB_CODEC_DEFAULT;
+    siridb->placement = SIRIDB_PLACEMENT_SUM;
     siridb->tz = -1;
     siridb->server = NULL;
     siridb->replica = NULL;
@@ -922,6 +998,7 @@ static siridb_t * siridb__new(void)
     siridb->exp_at_num = 0;
     siridb->expiration_log = 0;
     siridb->expiration_num = 0;
+    siridb->zones = NULL;
 
     siridb->series = ct_new();
     if (siridb->series == NULL)
@@ -947,18 +1024,54 @@ static siridb_t * siridb__new(void)
     }
 
     /* allocate tee */
-    siridb->tee = siridb_tee_new();
+    siridb->tee = siridb_tee_new(siridb);
     if (siridb->tee == NULL)
     {
         goto fail4;
     }
 
+    /* allocate query cache */
+    siridb->qcache = siridb_qcache_new();
+    if (siridb->qcache == NULL)
+    {
+        goto fail5;
+    }
+
+    /* allocate insert coalescer */
+    siridb->coalesce = siridb_coalesce_new(siridb);
+    if (siridb->coalesce == NULL)
+    {
+        goto fail6;
+    }
+
+    /* allocate shard expiration heap */
+    siridb->expire = siridb_expire_new();
+    if (siridb->expire == NULL)
+    {
+        goto fail7;
+    }
+
+    /* allocate series counters for each lookup slot */
+    siridb->series_slots = calloc(SIRIDB_LOOKUP_SZ, sizeof(uint32_t));
+    if (siridb->series_slots == NULL)
+    {
+        goto fail8;
+    }
+
     uv_mutex_init(&siridb->series_mutex);
     uv_mutex_init(&siridb->shards_mutex);
     uv_mutex_init(&siridb->values_mutex);
 
     return siridb;
 
+fail8:
+    siridb_expire_free(siridb->expire);
+fail7:
+    siridb_coalesce_free(siridb->coalesce);
+fail6:
+    siridb_qcache_free(siridb->qcache);
+fail5:
+    siridb_tee_free(siridb->tee);
 fail4:
     siridb_buffer_free(siridb->buffer);
 fail3:
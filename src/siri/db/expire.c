@@ -0,0 +1,249 @@
+/*
+ * expire.c - Shard expiration for a SiriDB database.
+ */
+#include <logger/logger.h>
+#include <siri/db/expire.h>
+#include <siri/db/shard.h>
+#include <siri/db/time.h>
+#include <siri/optimize.h>
+#include <siri/siri.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct
+{
+    uint64_t id;
+    uint64_t duration;
+} expire_shard_t;
+
+static siridb_shard_t * EXPIRE_pop(siridb_t * siridb, uint8_t tp, uint64_t at);
+
+/*
+ * Returns NULL in case of an allocation error.
+ */
+siridb_expire_t * siridb_expire_new(void)
+{
+    siridb_expire_t * expire = malloc(sizeof(siridb_expire_t));
+    if (expire == NULL)
+    {
+        return NULL;
+    }
+
+    expire->heap[SIRIDB_SHARD_TP_NUMBER] = heap_new(HEAP_DEFAULT_SIZE);
+    expire->heap[SIRIDB_SHARD_TP_LOG] = heap_new(HEAP_DEFAULT_SIZE);
+
+    if (    expire->heap[SIRIDB_SHARD_TP_NUMBER] == NULL ||
+            expire->heap[SIRIDB_SHARD_TP_LOG] == NULL)
+    {
+        free(expire->heap[SIRIDB_SHARD_TP_NUMBER]);
+        free(expire->heap[SIRIDB_SHARD_TP_LOG]);
+        free(expire);
+        return NULL;
+    }
+
+    uv_mutex_init(&expire->mutex);
+
+    return expire;
+}
+
+void siridb_expire_free(siridb_expire_t * expire)
+{
+    heap_destroy(expire->heap[SIRIDB_SHARD_TP_NUMBER], free);
+    heap_destroy(expire->heap[SIRIDB_SHARD_TP_LOG], free);
+    uv_mutex_destroy(&expire->mutex);
+    free(expire);
+}
+
+/*
+ * Add a shard to the expiration heap, the end of the shard is used as key.
+ * This function is thread-safe.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_expire_add(
+        siridb_expire_t * expire,
+        uint64_t id,
+        uint64_t duration,
+        uint8_t tp)
+{
+    int rc;
+    uint64_t end = id - id % duration + duration;
+    expire_shard_t * entry = malloc(sizeof(expire_shard_t));
+    if (entry == NULL)
+    {
+        return -1;
+    }
+
+    entry->id = id;
+    entry->duration = duration;
+
+    uv_mutex_lock(&expire->mutex);
+
+    rc = heap_push(&expire->heap[tp], end, entry);
+
+    uv_mutex_unlock(&expire->mutex);
+
+    if (rc)
+    {
+        free(entry);
+    }
+    return rc;
+}
+
+/*
+ * Returns the number of milliseconds until the next shard expires, 0 if a
+ * shard is already expired or SIRIDB_EXPIRE_NEVER if no shard will expire.
+ */
+uint64_t siridb_expire_next(siridb_t * siridb)
+{
+    uint64_t expiration[2], now_ts, factor, diff, ms, next;
+    heap_node_t * node;
+    struct timespec now;
+    uint8_t tp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uv_mutex_lock(&siridb->values_mutex);
+
+    expiration[SIRIDB_SHARD_TP_NUMBER] = siridb->expiration_num;
+    expiration[SIRIDB_SHARD_TP_LOG] = siridb->expiration_log;
+
+    uv_mutex_unlock(&siridb->values_mutex);
+
+    now_ts = siridb_time_now(siridb, now);
+    factor = siridb->time->factor;
+    next = SIRIDB_EXPIRE_NEVER;
+
+    uv_mutex_lock(&siridb->expire->mutex);
+
+    for (tp = SIRIDB_SHARD_TP_NUMBER; tp <= SIRIDB_SHARD_TP_LOG; tp++)
+    {
+        if (!expiration[tp] ||
+            (node = heap_peek(siridb->expire->heap[tp])) == NULL)
+        {
+            continue;
+        }
+
+        if (node->key + expiration[tp] < now_ts)
+        {
+            next = 0;
+            break;
+        }
+
+        /* a shard is expired one time unit after `end + expiration` so we
+         * round up to be sure the shard is expired when the timer fires */
+        diff = node->key + expiration[tp] - now_ts + 1;
+        ms = diff / factor * 1000 +
+                (diff % factor * 1000 + factor - 1) / factor;
+
+        if (ms < next)
+        {
+            next = ms;
+        }
+    }
+
+    uv_mutex_unlock(&siridb->expire->mutex);
+
+    return next;
+}
+
+/*
+ * Drop all shards which are expired. This function is called from a work
+ * thread so it does not block the main loop. Dropping stops as soon as the
+ * optimize task is paused, for example by the backup mode.
+ *
+ * Returns the number of dropped shards.
+ */
+size_t siridb_expire_drop(siridb_t * siridb)
+{
+    uint64_t expiration[2], now_ts;
+    struct timespec now;
+    siridb_shard_t * shard;
+    size_t n = 0;
+    uint8_t tp;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    uv_mutex_lock(&siridb->values_mutex);
+
+    expiration[SIRIDB_SHARD_TP_NUMBER] = siridb->expiration_num;
+    expiration[SIRIDB_SHARD_TP_LOG] = siridb->expiration_log;
+
+    uv_mutex_unlock(&siridb->values_mutex);
+
+    now_ts = siridb_time_now(siridb, now);
+
+    for (tp = SIRIDB_SHARD_TP_NUMBER; tp <= SIRIDB_SHARD_TP_LOG; tp++)
+    {
+        if (!expiration[tp] || expiration[tp] >= now_ts)
+        {
+            continue;
+        }
+
+        while ((shard = EXPIRE_pop(siridb, tp, now_ts - expiration[tp])))
+        {
+            log_info(
+                    "Shard id %" PRIu64 " (%" PRIu8 ") is expired "
+                    "and will be dropped",
+                    shard->id, shard->flags);
+            siridb_shard_drop(shard, siridb);
+            siridb_shard_decref(shard);
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * Returns a shard which ends before `at` with a new reference or NULL when
+ * no more shards are expired or when the optimize task is paused. Nodes for
+ * shards which are already dropped are removed from the heap while looking
+ * for a shard.
+ */
+static siridb_shard_t * EXPIRE_pop(siridb_t * siridb, uint8_t tp, uint64_t at)
+{
+    siridb_shard_t * shard = NULL;
+    expire_shard_t * entry;
+    heap_node_t * node;
+    omap_t * shards;
+
+    while (shard == NULL)
+    {
+        uv_mutex_lock(&siridb->expire->mutex);
+
+        /* the pause is checked again before each drop */
+        node = siri.optimize->pause
+                ? NULL
+                : heap_peek(siridb->expire->heap[tp]);
+        entry = (node != NULL && node->key < at)
+                ? heap_pop(siridb->expire->heap[tp])
+                : NULL;
+
+        uv_mutex_unlock(&siridb->expire->mutex);
+
+        if (entry == NULL)
+        {
+            return NULL;
+        }
+
+        uv_mutex_lock(&siridb->shards_mutex);
+
+        shards = imap_get(siridb->shards, entry->id);
+        shard = shards == NULL ? NULL : omap_get(shards, entry->duration);
+        if (shard != NULL && (~shard->flags & SIRIDB_SHARD_IS_REMOVED))
+        {
+            siridb_shard_incref(shard);
+        }
+        else
+        {
+            shard = NULL;
+        }
+
+        uv_mutex_unlock(&siridb->shards_mutex);
+
+        free(entry);
+    }
+
+    return shard;
+}
@@ -25,6 +25,30 @@ static int FIFO_init(siridb_fifo_t * fifo);
  * Make sure siridb->replica is not NULL since this function needs its UUID.
  */
 siridb_fifo_t * siridb_fifo_new(siridb_t * siridb)
+{
+    siridb_fifo_t * fifo;
+    char * path;
+    char str_uuid[37];
+
+    uuid_unparse_lower(siridb->replica->uuid, str_uuid);
+
+    if (asprintf(&path, "%s.%s/", siridb->dbpath, str_uuid) < 0)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    fifo = siridb_fifo_new_path(path);
+    free(path);
+    return fifo;
+}
+
+/*
+ * Returns NULL and raises a SIGNAL in case an error has occurred.
+ *
+ * The path must end with a slash and will be created when it does not exist.
+ */
+siridb_fifo_t * siridb_fifo_new_path(const char * path)
 {
     siridb_fifo_t * fifo = malloc(sizeof(siridb_fifo_t));
 
@@ -45,11 +69,9 @@ siridb_fifo_t * siridb_fifo_new(siridb_t * siridb)
 
     fifo->in = NULL;
     fifo->out = NULL;
+    fifo->path = strdup(path);
 
-    char str_uuid[37];
-    uuid_unparse_lower(siridb->replica->uuid, str_uuid);
-
-    if (asprintf(&fifo->path, "%s.%s/", siridb->dbpath, str_uuid) < 0)
+    if (fifo->path == NULL)
     {
         ERR_ALLOC
         siridb_fifo_free(fifo);
@@ -274,7 +296,10 @@ void siridb_fifo_free(siridb_fifo_t * fifo)
     /* we only need to free fifo->out because fido->in is either in the
      * list or the same as fifo->out. (fifo->out is never in the list)
      */
-    siridb_ffile_free(fifo->out);
+    if (fifo->out != NULL)
+    {
+        siridb_ffile_free(fifo->out);
+    }
 
     llist_free_cb(fifo->fifos, (llist_cb) FIFO_walk_free, NULL);
     free(fifo->path);
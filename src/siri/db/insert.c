@@ -3,6 +3,7 @@
  */
 #include <assert.h>
 #include <logger/logger.h>
+#include <lproto/lproto.h>
 #include <qpack/qpack.h>
 #include <siri/async.h>
 #include <siri/db/buffer.h>
@@ -12,7 +13,9 @@
 #include <siri/db/replicate.h>
 #include <siri/db/series.h>
 #include <siri/db/servers.h>
+#include <siri/db/zones.h>
 #include <siri/err.h>
+#include <siri/metrics.h>
 #include <siri/net/promises.h>
 #include <siri/net/protocol.h>
 #include <siri/net/clserver.h>
@@ -22,7 +25,6 @@
 #include <siri/db/tasks.h>
 
 #define MAX_INSERT_MSG 236
-#define INSERT_TIMEOUT 300000  /* 5 minutes                                 */
 #define INSERT_AT_ONCE 3000    /* one point counts as 1, a series as 100    */
 #define WEIGHT_SERIES 50
 #define WEIGHT_NEW_SERIES 100
@@ -40,7 +42,6 @@ if (*ts > series->end)              \
 static void INSERT_free(uv_handle_t * handle);
 static void INSERT_points_to_pools(uv_async_t * handle);
 static void INSERT_on_response(vec_t * promises, uv_async_t * handle);
-static uint16_t INSERT_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name);
 
 static void INSERT_local_free_cb(uv_async_t * handle);
 static int8_t INSERT_local_work(
@@ -87,6 +88,23 @@ static int INSERT_read_points(
         qp_obj_t * qp_obj,
         ssize_t * count);
 
+typedef struct
+{
+    const char * key;
+    size_t key_n;
+    const char * field;
+    size_t field_n;
+} insert_line_series_t;
+
+static ssize_t INSERT_assign_lines(
+        siridb_t * siridb,
+        lproto_t * lp,
+        siridb_timep_t precision,
+        qp_packer_t * packer[],
+        insert_line_series_t * last,
+        char * name,
+        char ** err_pt);
+
 /*
  * Return an error message for an insert err.
  */
@@ -94,6 +112,15 @@ const char * siridb_insert_err_msg(siridb_insert_err_t err)
 {
     switch (err)
     {
+    case ERR_INSERT_TOO_LARGE:
+        return  "The insert data exceeds the maximum allowed size.";
+    case ERR_INVALID_LINE:
+        return  "Invalid line protocol data.";
+    case ERR_INVALID_JSON:
+        return  "Invalid JSON data.";
+    case ERR_POOLS_CHANGED:
+        return  "The number of pools has changed while receiving the insert "
+                "data, please try again.";
     case ERR_EXPECTING_ARRAY:
         return  "Expecting an array with points.";
     case ERR_EXPECTING_SERIES_NAME:
@@ -191,6 +218,68 @@ ssize_t siridb_insert_assign_pools(
     return (siri_err) ? ERR_MEM_ALLOC : rc;
 }
 
+/*
+ * Assign points from line protocol data to the pools. Each field is stored
+ * in a series named by the measurement with tags, followed by a space and
+ * the field name. For example:
+ *
+ *  cpu,host=a usage=0.5,count=3i 1700000000000000000
+ *
+ * results in the series `cpu,host=a usage` and `cpu,host=a count`. Points
+ * without a time-stamp will get the current time. The data is parsed in
+ * place and might be changed by this function.
+ *
+ * Returns a negative value in case of an error or a value equal to zero or
+ * higher representing the number of points processed. In case of an error,
+ * argument pos is set to the position in the data where the error occurred.
+ *
+ * This function can set a SIGNAL when not enough space in the packer can be
+ * allocated for the points and ERR_MEM_ALLOC will be the return value if this
+ * is the case.
+ */
+ssize_t siridb_insert_assign_lines(
+        siridb_t * siridb,
+        char * data,
+        size_t n,
+        siridb_timep_t precision,
+        qp_packer_t * packer[],
+        size_t * pos)
+{
+    ssize_t rc;
+    lproto_t lp;
+    char * err_pt = data;
+    char * name = malloc(SIRIDB_SERIES_NAME_LEN_MAX);
+    insert_line_series_t * last = calloc(
+            siridb->pools->len,
+            sizeof(insert_line_series_t));
+
+    if (name == NULL || last == NULL)
+    {
+        ERR_ALLOC
+        free(name);
+        free(last);
+        return ERR_MEM_ALLOC;
+    }
+
+    lproto_init(&lp, data, n);
+
+    rc = INSERT_assign_lines(
+            siridb,
+            &lp,
+            precision,
+            packer,
+            last,
+            name,
+            &err_pt);
+
+    *pos = err_pt - data;
+
+    free(name);
+    free(last);
+
+    return (siri_err) ? ERR_MEM_ALLOC : rc;
+}
+
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  */
@@ -220,6 +309,7 @@ siridb_insert_t * siridb_insert_new(
 
         /* n-points will be set later to the correct value */
         insert->npoints = 0;
+        insert->start = siri_metrics_now();
 
         /* save PID and client so we can respond to the client */
         insert->pid = pid;
@@ -284,7 +374,7 @@ int insert_init_backend_local(
         sirinet_pkg_t * pkg,
         uint8_t flags)
 {
-    sirinet_promise_t * promise = malloc(sizeof(sirinet_promise_t));
+    sirinet_promise_t * promise = sirinet_promise_new();
     if (promise == NULL)
     {
         ERR_ALLOC
@@ -294,7 +384,7 @@ int insert_init_backend_local(
     siridb_insert_local_t * ilocal = malloc(sizeof(siridb_insert_local_t));
     if (ilocal == NULL)
     {
-        free(promise);
+        sirinet_promise_free(promise);
         ERR_ALLOC
         return -1;
     }
@@ -302,7 +392,7 @@ int insert_init_backend_local(
     uv_async_t * handle = malloc(sizeof(uv_async_t));
     if (handle == NULL)
     {
-        free(promise);
+        sirinet_promise_free(promise);
         free(ilocal);
         ERR_ALLOC
         return -1;
@@ -320,7 +410,7 @@ int insert_init_backend_local(
     promise->pkg = sirinet_pkg_dup(pkg);
     if (promise->pkg == NULL)
     {
-        free(promise);
+        sirinet_promise_free(promise);
         free(ilocal);
         free(handle);
         ERR_ALLOC
@@ -334,7 +424,6 @@ int insert_init_backend_local(
     promise->cb = (sirinet_promise_cb) INSERT_local_promise_backend_cb;
     promise->pid = promise->pkg->pid;
     promise->ref = 1;
-    promise->timer = NULL;
     promise->server = NULL;
 
     handle->data = ilocal;
@@ -428,6 +517,7 @@ static void INSERT_on_response(vec_t * promises, uv_async_t * handle)
                         insert->npoints);
                 log_info(msg);
                 siridb->received_points += insert->npoints;
+                siri_metrics_since(SIRI_METRICS_INSERT, insert->start);
             }
 
             qp_add_raw(
@@ -645,6 +735,10 @@ static int8_t INSERT_local_work(
                 siridb_series_flush_dropped(siridb);
             }
         }
+        else
+        {
+            siridb_zones_update(siridb, series);
+        }
 
         if (tp == QP_ARRAY_CLOSE)
         {
@@ -870,6 +964,10 @@ static int INSERT_local_work_test(
                 siridb_series_flush_dropped(siridb);
             }
         }
+        else
+        {
+            siridb_zones_update(siridb, series);
+        }
 
         if (tp == QP_ARRAY_CLOSE)
         {
@@ -1022,7 +1120,7 @@ static int INSERT_init_local(
         sirinet_pkg_t * pkg,
         uint8_t flags)
 {
-    sirinet_promise_t * promise = malloc(sizeof(sirinet_promise_t));
+    sirinet_promise_t * promise = sirinet_promise_new();
     if (promise == NULL)
     {
         free(pkg);
@@ -1033,7 +1131,7 @@ static int INSERT_init_local(
     if (ilocal == NULL)
     {
         free(pkg);
-        free(promise);
+        sirinet_promise_free(promise);
         ERR_ALLOC
         return -1;
     }
@@ -1042,7 +1140,7 @@ static int INSERT_init_local(
     if (handle == NULL)
     {
         free(pkg);
-        free(promise);
+        sirinet_promise_free(promise);
         free(ilocal);
         ERR_ALLOC
         return -1;
@@ -1065,7 +1163,6 @@ static int INSERT_init_local(
     promise->cb = (sirinet_promise_cb) INSERT_local_promise_cb;
     promise->pid = 0;
     promise->ref = 1;
-    promise->timer = NULL;
 
     handle->data = ilocal;
 
@@ -1165,6 +1262,24 @@ static void INSERT_points_to_pools(uv_async_t * handle)
                 pool_count++;
             }
         }
+        else if (siri.cfg->insert_coalesce_window)
+        {
+            if (siridb_coalesce_add(
+                    siridb->coalesce,
+                    n,
+                    (insert->flags & INSERT_FLAG_TEST) ?
+                            BPROTO_INSERT_TEST_POOL : BPROTO_INSERT_POOL,
+                    insert->packer[n],
+                    promises))
+            {
+                qp_packer_free(insert->packer[n]);
+                log_error("Cannot combine points for pool %u", n);
+            }
+            else
+            {
+                pool_count++;
+            }
+        }
         else
         {
             pkg = sirinet_packer2pkg(
@@ -1202,9 +1317,9 @@ static void INSERT_points_to_pools(uv_async_t * handle)
 }
 
 /*
- * Returns the correct pool.
+ * Returns the correct pool for a series name.
  */
-static uint16_t INSERT_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name)
+uint16_t siridb_insert_get_pool(siridb_t * siridb, qp_obj_t * qp_series_name)
 {
     uint16_t pool;
 
@@ -1279,7 +1394,7 @@ static ssize_t INSERT_assign_by_map(
             qp_obj.len &&
             qp_obj.len < SIRIDB_SERIES_NAME_LEN_MAX)
     {
-        pool = INSERT_get_pool(siridb, &qp_obj);
+        pool = siridb_insert_get_pool(siridb, &qp_obj);
 
         qp_add_raw_term(packer[pool],
                 qp_obj.via.raw,
@@ -1352,7 +1467,7 @@ static ssize_t INSERT_assign_by_array(
                 return ERR_EXPECTING_NAME_AND_POINTS;
             }
 
-            pool = INSERT_get_pool(siridb, &qp_obj);
+            pool = siridb_insert_get_pool(siridb, &qp_obj);
 
             qp_add_raw_term(packer[pool],
                     qp_obj.via.raw,
@@ -1398,6 +1513,162 @@ static ssize_t INSERT_assign_by_array(
     return count;
 }
 
+/*
+ * Returns a negative value in case of an error or a value equal to zero or
+ * higher representing the number of points processed.
+ *
+ * Consecutive points for the same series are written to a single points
+ * array. Argument `last` must have room for the current series of each pool
+ * and `name` must have room for SIRIDB_SERIES_NAME_LEN_MAX characters.
+ * In case of an error, `err_pt` is set to the start of the failing line or
+ * to the failing field.
+ *
+ * This function can set a SIGNAL when not enough space in the packer can be
+ * allocated for the points and should be checked with 'siri_err'.
+ */
+static ssize_t INSERT_assign_lines(
+        siridb_t * siridb,
+        lproto_t * lp,
+        siridb_timep_t precision,
+        qp_packer_t * packer[],
+        insert_line_series_t * last,
+        char * name,
+        char ** err_pt)
+{
+    int rc;
+    uint16_t pool, n = siridb->pools->len;
+    ssize_t count = 0;
+    qp_obj_t qp_series_name;
+    lproto_field_t field;
+    char * field_pt;
+    int64_t ts, now_ts, mul = 1, div = 1;
+    struct timespec now;
+    int prec_diff = (int) siridb->time->precision - (int) precision;
+
+    for (; prec_diff > 0; --prec_diff)
+        mul *= 1000;
+
+    for (; prec_diff < 0; ++prec_diff)
+        div *= 1000;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    now_ts = (int64_t) siridb_time_now(siridb, now);
+
+    qp_series_name.tp = QP_RAW;
+    qp_series_name.via.raw = (unsigned char *) name;
+
+    while ((rc = lproto_next_line(lp)) == LPROTO_OK)
+    {
+        *err_pt = lp->key;
+
+        if (lp->has_ts)
+        {
+            if (lp->ts > INT64_MAX / mul || lp->ts < INT64_MIN / mul)
+            {
+                return ERR_TIMESTAMP_OUT_OF_RANGE;
+            }
+            ts = lp->ts * mul / div;
+        }
+        else
+        {
+            ts = now_ts;
+        }
+
+        if (!siridb_int64_valid_ts(siridb->time, ts))
+        {
+            return ERR_TIMESTAMP_OUT_OF_RANGE;
+        }
+
+        for (   field_pt = lp->fields;
+                (rc = lproto_next_field(lp, &field)) == LPROTO_OK;
+                field_pt = lp->fields)
+        {
+            *err_pt = field_pt;
+
+            qp_series_name.len = lp->key_n + 1 + field.name_n;
+            if (qp_series_name.len >= SIRIDB_SERIES_NAME_LEN_MAX)
+            {
+                return ERR_EXPECTING_SERIES_NAME;
+            }
+
+            memcpy(name, lp->key, lp->key_n);
+            name[lp->key_n] = ' ';
+            memcpy(name + lp->key_n + 1, field.name, field.name_n);
+
+            pool = siridb_insert_get_pool(siridb, &qp_series_name);
+
+            if (    last[pool].key == NULL ||
+                    last[pool].key_n != lp->key_n ||
+                    last[pool].field_n != field.name_n ||
+                    memcmp(last[pool].key, lp->key, lp->key_n) ||
+                    memcmp(last[pool].field, field.name, field.name_n))
+            {
+                if (last[pool].key != NULL)
+                {
+                    qp_add_type(packer[pool], QP_ARRAY_CLOSE);
+                }
+                qp_add_raw_term(
+                        packer[pool],
+                        qp_series_name.via.raw,
+                        qp_series_name.len);
+                qp_add_type(packer[pool], QP_ARRAY_OPEN);
+
+                last[pool].key = lp->key;
+                last[pool].key_n = lp->key_n;
+                last[pool].field = field.name;
+                last[pool].field_n = field.name_n;
+            }
+
+            qp_add_type(packer[pool], QP_ARRAY2);
+            qp_add_int64(packer[pool], ts);
+
+            switch (field.tp)
+            {
+            case LPROTO_INT64:
+                qp_add_int64(packer[pool], field.via.int64);
+                break;
+            case LPROTO_DOUBLE:
+                qp_add_double(packer[pool], field.via.real);
+                break;
+            case LPROTO_STRING:
+                if (siridb_servers_check_version(siridb, "2.0.27") > 0)
+                {
+                    return ERR_INCOMPATIBLE_SERVER_VERSION;
+                }
+                qp_add_raw(
+                        packer[pool],
+                        (const unsigned char *) field.via.str,
+                        field.len);
+                break;
+            }
+
+            count++;
+        }
+
+        if (rc == LPROTO_ERR)
+        {
+            *err_pt = lp->fields;
+            return ERR_INVALID_LINE;
+        }
+    }
+
+    if (rc == LPROTO_ERR)
+    {
+        *err_pt = lp->pt;
+        return ERR_INVALID_LINE;
+    }
+
+    for (pool = 0; pool < n; pool++)
+    {
+        if (last[pool].key != NULL)
+        {
+            qp_add_type(packer[pool], QP_ARRAY_CLOSE);
+        }
+    }
+
+    return count;
+}
+
 /*
  * Returns a negative value in case of an error or a value equal to zero or
  * higher representing the next qpack type in the unpaker.
@@ -0,0 +1,523 @@
+/*
+ * insertjson.c - Streaming JSON parser for inserts using the HTTP API.
+ *
+ * The JSON body is parsed while it is received and points are written
+ * directly to the packers for each pool. This way the full body is never
+ * buffered and the JSON data does not need to be converted to QPack first.
+ * The packed data is limited to MAX_ALLOWED_PKG_SIZE, the same limit which
+ * applies to a package received from a client.
+ *
+ * Both insert formats are supported:
+ *
+ *  {"series": [[ts, val], ...], ...}
+ *  [{"name": "series", "points": [[ts, val], ...]}, ...]
+ */
+#include <assert.h>
+#include <logger/logger.h>
+#include <siri/db/insertjson.h>
+#include <siri/db/series.h>
+#include <siri/db/servers.h>
+#include <siri/db/time.h>
+#include <siri/err.h>
+#include <siri/net/pkg.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    INSERTJSON_START,
+    INSERTJSON_MAP_SERIES,      /* expecting a series name or end of map */
+    INSERTJSON_ARRAY_SERIES,    /* expecting a series map or end of array */
+    INSERTJSON_KEY,             /* expecting "name", "points" or end of map */
+    INSERTJSON_NAME,            /* expecting a series name */
+    INSERTJSON_POINTS,          /* expecting an array with points */
+    INSERTJSON_FIRST_POINT,     /* expecting at least one point */
+    INSERTJSON_NEXT_POINT,      /* expecting a point or end of array */
+    INSERTJSON_TS,              /* expecting a time-stamp */
+    INSERTJSON_VAL,             /* expecting a value */
+    INSERTJSON_POINT_CLOSE,     /* expecting end of point */
+    INSERTJSON_END,
+};
+
+#define INSERTJSON_FLAG_ARRAY 1
+#define INSERTJSON_FLAG_NAME 2
+#define INSERTJSON_FLAG_POINTS 4
+
+#define INSERTJSON_FAIL(__ijson, __err) \
+    do { (__ijson)->err = __err; return 0; } while (0)
+
+static int INSERTJSON_set_series(
+        siridb_insertjson_t * ijson,
+        const unsigned char * name,
+        size_t n);
+static int INSERTJSON_points_done(siridb_insertjson_t * ijson);
+static size_t INSERTJSON_size(siridb_insertjson_t * ijson);
+
+static int INSERTJSON_null(void * ctx);
+static int INSERTJSON_boolean(void * ctx, int boolean);
+static int INSERTJSON_integer(void * ctx, long long i);
+static int INSERTJSON_double(void * ctx, double d);
+static int INSERTJSON_string(void * ctx, const unsigned char * s, size_t n);
+static int INSERTJSON_map_key(void * ctx, const unsigned char * s, size_t n);
+static int INSERTJSON_start_map(void * ctx);
+static int INSERTJSON_end_map(void * ctx);
+static int INSERTJSON_start_array(void * ctx);
+static int INSERTJSON_end_array(void * ctx);
+
+static yajl_callbacks insertjson__callbacks = {
+    INSERTJSON_null,
+    INSERTJSON_boolean,
+    INSERTJSON_integer,
+    INSERTJSON_double,
+    NULL,
+    INSERTJSON_string,
+    INSERTJSON_start_map,
+    INSERTJSON_map_key,
+    INSERTJSON_end_map,
+    INSERTJSON_start_array,
+    INSERTJSON_end_array
+};
+
+/*
+ * Returns NULL and raises a SIGNAL in case an error has occurred.
+ *
+ * The new object owns an insert object with a packer for each pool. Use
+ * siridb_insertjson_take() to take the insert once parsing has finished.
+ */
+siridb_insertjson_t * siridb_insertjson_new(
+        siridb_t * siridb,
+        sirinet_stream_t * client)
+{
+    siridb_insertjson_t * ijson = malloc(sizeof(siridb_insertjson_t));
+    if (ijson == NULL)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    ijson->state = INSERTJSON_START;
+    ijson->flags = 0;
+    ijson->pool = 0;
+    ijson->err = 0;
+    ijson->count = 0;
+    ijson->pos = 0;
+    ijson->siridb = siridb;
+    ijson->packer = NULL;
+    ijson->handle = NULL;
+    ijson->insert = siridb_insert_new(siridb, 0, client);
+    ijson->tmp_packer = qp_packer_new(QP_SUGGESTED_SIZE);
+
+    if (ijson->tmp_packer == NULL || ijson->insert == NULL)
+    {
+        siridb_insertjson_free(ijson);
+        return NULL;  /* a signal is raised */
+    }
+
+    ijson->handle = yajl_alloc(&insertjson__callbacks, NULL, ijson);
+    if (ijson->handle == NULL)
+    {
+        ERR_ALLOC
+        siridb_insertjson_free(ijson);
+        return NULL;
+    }
+
+    return ijson;
+}
+
+void siridb_insertjson_free(siridb_insertjson_t * ijson)
+{
+    if (ijson->handle != NULL)
+    {
+        yajl_free(ijson->handle);
+    }
+    if (ijson->insert != NULL)
+    {
+        siridb_insert_free(ijson->insert);
+    }
+    if (ijson->tmp_packer != NULL)
+    {
+        qp_packer_free(ijson->tmp_packer);
+    }
+    free(ijson);
+}
+
+/*
+ * Feed the parser with the next part of the JSON data. Once an error has
+ * occurred, all remaining data will be ignored.
+ */
+void siridb_insertjson_feed(
+        siridb_insertjson_t * ijson,
+        const char * data,
+        size_t n)
+{
+    if (ijson->err)
+        return;
+
+    if (yajl_parse(
+            ijson->handle,
+            (const unsigned char *) data,
+            n) != yajl_status_ok)
+    {
+        if (!ijson->err)
+        {
+            ijson->err = ERR_INVALID_JSON;
+        }
+        ijson->pos += yajl_get_bytes_consumed(ijson->handle);
+        return;
+    }
+
+    ijson->pos += n;
+
+    if (siri_err)
+    {
+        ijson->err = ERR_MEM_ALLOC;
+    }
+    else if (INSERTJSON_size(ijson) > MAX_ALLOWED_PKG_SIZE)
+    {
+        /* release the packed data now, the remaining body is ignored */
+        siridb_insert_free(ijson->insert);
+        qp_packer_free(ijson->tmp_packer);
+        ijson->insert = NULL;
+        ijson->tmp_packer = NULL;
+        ijson->err = ERR_INSERT_TOO_LARGE;
+    }
+}
+
+/*
+ * Returns a negative value in case of an error or a value equal to zero or
+ * higher representing the number of points processed.
+ */
+ssize_t siridb_insertjson_done(siridb_insertjson_t * ijson)
+{
+    if (    !ijson->err &&
+            (yajl_complete_parse(ijson->handle) != yajl_status_ok ||
+            ijson->state != INSERTJSON_END))
+    {
+        ijson->err = ERR_INVALID_JSON;
+    }
+
+    if (!ijson->err && ijson->siridb->pools->len != ijson->insert->packer_size)
+    {
+        ijson->err = ERR_POOLS_CHANGED;
+    }
+
+    return ijson->err ? ijson->err : ijson->count;
+}
+
+/*
+ * Returns the insert object and releases ownership.
+ */
+siridb_insert_t * siridb_insertjson_take(siridb_insertjson_t * ijson)
+{
+    siridb_insert_t * insert = ijson->insert;
+    ijson->insert = NULL;
+    return insert;
+}
+
+/*
+ * Write the series name to the packer for the correct pool. Points which
+ * are received before the name are moved from the temporary packer.
+ *
+ * Returns 0 if successful or -1 in case of an error.
+ */
+static int INSERTJSON_set_series(
+        siridb_insertjson_t * ijson,
+        const unsigned char * name,
+        size_t n)
+{
+    qp_obj_t qp_series_name;
+
+    if (ijson->siridb->pools->len != ijson->insert->packer_size)
+    {
+        ijson->err = ERR_POOLS_CHANGED;
+        return -1;
+    }
+
+    qp_series_name.tp = QP_RAW;
+    qp_series_name.len = n;
+    qp_series_name.via.raw = (unsigned char *) name;
+
+    ijson->pool = siridb_insert_get_pool(ijson->siridb, &qp_series_name);
+    ijson->packer = ijson->insert->packer[ijson->pool];
+
+    if (qp_add_raw_term(ijson->packer, name, n))
+    {
+        ijson->err = ERR_MEM_ALLOC;
+        return -1;
+    }
+
+    if (ijson->tmp_packer->len)
+    {
+        if (qp_packer_extend(ijson->packer, ijson->tmp_packer))
+        {
+            ijson->err = ERR_MEM_ALLOC;
+            return -1;
+        }
+        ijson->tmp_packer->len = 0;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns the number of bytes which are packed for this insert.
+ */
+static size_t INSERTJSON_size(siridb_insertjson_t * ijson)
+{
+    size_t i, size = ijson->tmp_packer->len;
+
+    for (i = 0; i < ijson->insert->packer_size; i++)
+    {
+        size += ijson->insert->packer[i]->len;
+    }
+    return size;
+}
+
+static int INSERTJSON_points_done(siridb_insertjson_t * ijson)
+{
+    if (qp_add_type(ijson->packer, QP_ARRAY_CLOSE))
+        INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+
+    if (~ijson->flags & INSERTJSON_FLAG_ARRAY)
+    {
+        ijson->state = INSERTJSON_MAP_SERIES;
+        return 1;
+    }
+
+    ijson->flags |= INSERTJSON_FLAG_POINTS;
+    ijson->state = INSERTJSON_KEY;
+    return 1;
+}
+
+static int INSERTJSON_err(siridb_insertjson_t * ijson)
+{
+    switch (ijson->state)
+    {
+    case INSERTJSON_START:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_MAP_OR_ARRAY);
+    case INSERTJSON_MAP_SERIES:
+    case INSERTJSON_ARRAY_SERIES:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_SERIES_NAME);
+    case INSERTJSON_KEY:
+    case INSERTJSON_NAME:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_NAME_AND_POINTS);
+    case INSERTJSON_POINTS:
+    case INSERTJSON_NEXT_POINT:
+    case INSERTJSON_POINT_CLOSE:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_ARRAY);
+    case INSERTJSON_FIRST_POINT:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_AT_LEAST_ONE_POINT);
+    case INSERTJSON_TS:
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_INTEGER_TS);
+    case INSERTJSON_VAL:
+        INSERTJSON_FAIL(ijson, ERR_UNSUPPORTED_VALUE);
+    }
+    INSERTJSON_FAIL(ijson, ERR_INVALID_JSON);
+}
+
+static int INSERTJSON_null(void * ctx)
+{
+    return INSERTJSON_err((siridb_insertjson_t *) ctx);
+}
+
+static int INSERTJSON_boolean(
+        void * ctx,
+        int boolean __attribute__((unused)))
+{
+    return INSERTJSON_err((siridb_insertjson_t *) ctx);
+}
+
+static int INSERTJSON_integer(void * ctx, long long i)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_TS:
+        if (!siridb_int64_valid_ts(ijson->siridb->time, i))
+            INSERTJSON_FAIL(ijson, ERR_TIMESTAMP_OUT_OF_RANGE);
+        ijson->state = INSERTJSON_VAL;
+        break;
+    case INSERTJSON_VAL:
+        ijson->state = INSERTJSON_POINT_CLOSE;
+        break;
+    default:
+        return INSERTJSON_err(ijson);
+    }
+
+    if (qp_add_int64(ijson->packer, i))
+        INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+
+    return 1;
+}
+
+static int INSERTJSON_double(void * ctx, double d)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    if (ijson->state != INSERTJSON_VAL)
+        return INSERTJSON_err(ijson);
+
+    if (qp_add_double(ijson->packer, d))
+        INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+
+    ijson->state = INSERTJSON_POINT_CLOSE;
+    return 1;
+}
+
+static int INSERTJSON_string(void * ctx, const unsigned char * s, size_t n)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_NAME:
+        if (!n || n >= SIRIDB_SERIES_NAME_LEN_MAX)
+            INSERTJSON_FAIL(ijson, ERR_EXPECTING_NAME_AND_POINTS);
+
+        if (INSERTJSON_set_series(ijson, s, n))
+            return 0;
+
+        ijson->flags |= INSERTJSON_FLAG_NAME;
+        ijson->state = INSERTJSON_KEY;
+        return 1;
+
+    case INSERTJSON_VAL:
+        if (siridb_servers_check_version(ijson->siridb, "2.0.27") > 0)
+            INSERTJSON_FAIL(ijson, ERR_INCOMPATIBLE_SERVER_VERSION);
+
+        if (qp_add_raw(ijson->packer, s, n))
+            INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+
+        ijson->state = INSERTJSON_POINT_CLOSE;
+        return 1;
+    }
+
+    return INSERTJSON_err(ijson);
+}
+
+static int INSERTJSON_map_key(void * ctx, const unsigned char * s, size_t n)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_MAP_SERIES:
+        if (!n || n >= SIRIDB_SERIES_NAME_LEN_MAX)
+            INSERTJSON_FAIL(ijson, ERR_EXPECTING_SERIES_NAME);
+
+        if (INSERTJSON_set_series(ijson, s, n))
+            return 0;
+
+        ijson->state = INSERTJSON_POINTS;
+        return 1;
+
+    case INSERTJSON_KEY:
+        if (n == 4 && memcmp(s, "name", 4) == 0 &&
+            (~ijson->flags & INSERTJSON_FLAG_NAME))
+        {
+            ijson->state = INSERTJSON_NAME;
+            return 1;
+        }
+        if (n == 6 && memcmp(s, "points", 6) == 0 &&
+            (~ijson->flags & INSERTJSON_FLAG_POINTS))
+        {
+            /* points without a name are written to the temporary packer */
+            if (~ijson->flags & INSERTJSON_FLAG_NAME)
+            {
+                ijson->packer = ijson->tmp_packer;
+            }
+            ijson->state = INSERTJSON_POINTS;
+            return 1;
+        }
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_NAME_AND_POINTS);
+    }
+
+    return INSERTJSON_err(ijson);
+}
+
+static int INSERTJSON_start_map(void * ctx)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_START:
+        ijson->state = INSERTJSON_MAP_SERIES;
+        return 1;
+    case INSERTJSON_ARRAY_SERIES:
+        ijson->flags = INSERTJSON_FLAG_ARRAY;
+        ijson->state = INSERTJSON_KEY;
+        return 1;
+    }
+
+    return INSERTJSON_err(ijson);
+}
+
+static int INSERTJSON_end_map(void * ctx)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_MAP_SERIES:
+        ijson->state = INSERTJSON_END;
+        return 1;
+    case INSERTJSON_KEY:
+        if ((ijson->flags & INSERTJSON_FLAG_NAME) &&
+            (ijson->flags & INSERTJSON_FLAG_POINTS))
+        {
+            ijson->state = INSERTJSON_ARRAY_SERIES;
+            return 1;
+        }
+        INSERTJSON_FAIL(ijson, ERR_EXPECTING_NAME_AND_POINTS);
+    }
+
+    return INSERTJSON_err(ijson);
+}
+
+static int INSERTJSON_start_array(void * ctx)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_START:
+        ijson->flags = INSERTJSON_FLAG_ARRAY;
+        ijson->state = INSERTJSON_ARRAY_SERIES;
+        return 1;
+    case INSERTJSON_POINTS:
+        if (qp_add_type(ijson->packer, QP_ARRAY_OPEN))
+            INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+        ijson->state = INSERTJSON_FIRST_POINT;
+        return 1;
+    case INSERTJSON_FIRST_POINT:
+    case INSERTJSON_NEXT_POINT:
+        if (qp_add_type(ijson->packer, QP_ARRAY2))
+            INSERTJSON_FAIL(ijson, ERR_MEM_ALLOC);
+        ijson->state = INSERTJSON_TS;
+        return 1;
+    }
+
+    return INSERTJSON_err(ijson);
+}
+
+static int INSERTJSON_end_array(void * ctx)
+{
+    siridb_insertjson_t * ijson = (siridb_insertjson_t *) ctx;
+
+    switch (ijson->state)
+    {
+    case INSERTJSON_ARRAY_SERIES:
+        ijson->state = INSERTJSON_END;
+        return 1;
+    case INSERTJSON_NEXT_POINT:
+        return INSERTJSON_points_done(ijson);
+    case INSERTJSON_POINT_CLOSE:
+        ijson->count++;
+        ijson->state = INSERTJSON_NEXT_POINT;
+        return 1;
+    }
+
+    return INSERTJSON_err(ijson);
+}
@@ -11,7 +11,10 @@
 #include <siri/db/group.h>
 #include <siri/db/groups.h>
 #include <siri/db/nodes.h>
+#include <siri/db/partial.h>
+#include <siri/db/plan.h>
 #include <siri/db/presuf.h>
+#include <siri/db/profile.h>
 #include <siri/db/props.h>
 #include <siri/db/props.h>
 #include <siri/db/query.h>
@@ -24,12 +27,15 @@
 #include <siri/db/tags.h>
 #include <siri/db/user.h>
 #include <siri/db/users.h>
+#include <siri/db/zones.h>
 #include <siri/db/listener.h>
 #include <siri/db/queries.h>
 #include <siri/db/sset.h>
 #include <siri/err.h>
+#include <siri/expire.h>
 #include <siri/grammar/gramp.h>
 #include <siri/help/help.h>
+#include <siri/metrics.h>
 #include <siri/net/promises.h>
 #include <siri/net/protocol.h>
 #include <siri/net/clserver.h>
@@ -193,6 +199,9 @@ if (IS_MASTER && siridb_is_reindexing(siridb))                              \
     "Successfully %s backup mode on '%s'."
 #define MSG_SUCCES_SET_TIMEZONE \
     "Successfully changed timezone from '%s' to '%s'."
+#define MSG_SUCCES_SET_CODEC \
+    "Successfully changed codec from '%s' to '%s'. (the codec is used " \
+    "for new and optimized shards when shard compression is enabled)"
 #define MSG_ERR_SERVER_ADDRESS \
     "Its only possible to change a servers address or port when the server " \
     "is not connected."
@@ -221,6 +230,7 @@ static void enter_help(uv_async_t * handle);
 static void enter_limit_expr(uv_async_t * handle);
 static void enter_list_stmt(uv_async_t * handle);
 static void enter_merge_as(uv_async_t * handle);
+static void enter_profile_stmt(uv_async_t * handle);
 static void enter_revoke_user(uv_async_t * handle);
 static void enter_select_stmt(uv_async_t * handle);
 static void enter_set_expression(uv_async_t * handle);
@@ -275,6 +285,7 @@ static void exit_list_servers(uv_async_t * handle);
 static void exit_list_shards(uv_async_t * handle);
 static void exit_list_tags(uv_async_t * handle);
 static void exit_list_users(uv_async_t * handle);
+static void exit_profile_stmt(uv_async_t * handle);
 static void exit_revoke_user(uv_async_t * handle);
 static void exit_select_aggregate(uv_async_t * handle);
 static void exit_select_stmt(uv_async_t * handle);
@@ -282,6 +293,7 @@ static void exit_series_match(uv_async_t * handle);
 static void exit_series_parentheses(uv_async_t * handle);
 static void exit_set_address(uv_async_t * handle);
 static void exit_set_backup_mode(uv_async_t * handle);
+static void exit_set_codec(uv_async_t * handle);
 static void exit_set_drop_threshold(uv_async_t * handle);
 static void exit_set_expiration_log(uv_async_t * handle);
 static void exit_set_expiration_num(uv_async_t * handle);
@@ -363,6 +375,9 @@ static void on_select_unpack_merged_points(
         qp_obj_t * qp_len,
         qp_obj_t * qp_points,
         uint32_t select_points_limit);
+static void select_aggregate(uv_async_t * handle);
+static void select_plan_aggregate(uv_async_t * handle);
+static void select_plan_discard(query_wrapper_t * q_wrapper);
 
 static int values_list_groups(siridb_group_t * group, uv_async_t * handle);
 static int values_count_groups(siridb_group_t * group, uv_async_t * handle);
@@ -469,6 +484,7 @@ void siridb_init_listener(void)
     SIRIDB_NODE_ENTER[CLERI_GID_LIST_STMT] = enter_list_stmt;
     SIRIDB_NODE_ENTER[CLERI_GID_MERGE_AS] = enter_merge_as;
     SIRIDB_NODE_ENTER[CLERI_GID_POOL_COLUMNS] = enter_xxx_columns;
+    SIRIDB_NODE_ENTER[CLERI_GID_PROFILE_STMT] = enter_profile_stmt;
     SIRIDB_NODE_ENTER[CLERI_GID_REVOKE_USER] = enter_revoke_user;
     SIRIDB_NODE_ENTER[CLERI_GID_SELECT_STMT] = enter_select_stmt;
     SIRIDB_NODE_ENTER[CLERI_GID_SET_EXPRESSION] = enter_set_expression;
@@ -533,6 +549,7 @@ void siridb_init_listener(void)
     SIRIDB_NODE_EXIT[CLERI_GID_LIST_SHARDS] = exit_list_shards;
     SIRIDB_NODE_EXIT[CLERI_GID_LIST_TAGS] = exit_list_tags;
     SIRIDB_NODE_EXIT[CLERI_GID_LIST_USERS] = exit_list_users;
+    SIRIDB_NODE_EXIT[CLERI_GID_PROFILE_STMT] = exit_profile_stmt;
     SIRIDB_NODE_EXIT[CLERI_GID_REVOKE_USER] = exit_revoke_user;
     SIRIDB_NODE_EXIT[CLERI_GID_SELECT_AGGREGATE] = exit_select_aggregate;
     SIRIDB_NODE_EXIT[CLERI_GID_SELECT_STMT] = exit_select_stmt;
@@ -540,6 +557,7 @@ void siridb_init_listener(void)
     SIRIDB_NODE_EXIT[CLERI_GID_SERIES_PARENTHESES] = exit_series_parentheses;
     SIRIDB_NODE_EXIT[CLERI_GID_SET_ADDRESS] = exit_set_address;
     SIRIDB_NODE_EXIT[CLERI_GID_SET_BACKUP_MODE] = exit_set_backup_mode;
+    SIRIDB_NODE_EXIT[CLERI_GID_SET_CODEC] = exit_set_codec;
     SIRIDB_NODE_EXIT[CLERI_GID_SET_DROP_THRESHOLD] = exit_set_drop_threshold;
     SIRIDB_NODE_EXIT[CLERI_GID_SET_EXPIRATION_LOG] = exit_set_expiration_log;
     SIRIDB_NODE_EXIT[CLERI_GID_SET_EXPIRATION_NUM] = exit_set_expiration_num;
@@ -561,6 +579,103 @@ void siridb_init_listener(void)
     }
 }
 
+/*
+ * Run a select query using a plan received from the master server.
+ *
+ * The plan replaces the parse result and the walker, so this function does
+ * the same as the enter and exit functions of a select statement would do
+ * and then runs each select method followed by 'exit_select_stmt'.
+ */
+void siridb_listener_run_plan(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    siridb_t * siridb = query->siridb;
+    siridb_plan_t * plan = query->data;
+    siridb_series_t * series;
+    siridb_nodes_t ** nodes;
+    query_select_t * q_select;
+    const char * name;
+    size_t i;
+
+    query->data = q_select = query_select_new();
+
+    if (q_select == NULL)
+    {
+        siridb_plan_free(plan);
+        MEM_ERR_RET
+    }
+
+    q_select->plan = plan;
+    query->free_cb = (uv_close_cb) query_select_free;
+    query->packer = sirinet_packer_new(QP_SUGGESTED_SIZE);
+    q_select->series_map = imap_new();
+
+    if (query->packer == NULL || q_select->series_map == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    qp_add_type(query->packer, QP_MAP_OPEN);
+
+    for (i = 0; i < plan->series->len; i++)
+    {
+        name = plan->series->data[i];
+        series = (siridb_is_reindexing(siridb) || siridb_lookup_sn(
+                siridb->pools->lookup, name) == siridb->server->pool) ?
+                        ct_get(siridb->series, name) : NULL;
+
+        if (series != NULL &&
+            imap_set(q_select->series_map, series->id, series) == 1)
+        {
+            siridb_series_incref(series);
+        }
+    }
+
+    q_select->nselects = plan->methods->len;
+    q_select->headtail = plan->headtail;
+    q_select->start_ts = (plan->flags & SIRIDB_PLAN_FLAG_START_TS) ?
+            &plan->start_ts : NULL;
+    q_select->end_ts = (plan->flags & SIRIDB_PLAN_FLAG_END_TS) ?
+            &plan->end_ts : NULL;
+
+    /* the select query takes ownership of the merge name and list */
+    q_select->merge_as = plan->merge_as;
+    q_select->mlist = plan->mlist;
+    plan->merge_as = NULL;
+    plan->mlist = NULL;
+
+    if ((plan->flags & SIRIDB_PLAN_FLAG_SKIP_GET_POINTS) &&
+            q_select->start_ts == NULL && q_select->end_ts == NULL)
+    {
+        q_select->flags |= QUERIES_SKIP_GET_POINTS;
+    }
+
+    if ((~q_select->flags & QUERIES_SKIP_GET_POINTS) &&
+            q_select->nselects > 1)
+    {
+        /* not critical, everything works if points_map is NULL */
+        q_select->points_map = imap_new();
+    }
+
+    /* one node for each select method and one to finish the statement */
+    nodes = &query->nodes;
+    for (i = 0; i <= plan->methods->len; i++)
+    {
+        *nodes = malloc(sizeof(siridb_nodes_t));
+        if (*nodes == NULL)
+        {
+            MEM_ERR_RET
+        }
+        (*nodes)->node = NULL;
+        (*nodes)->cb = (i < plan->methods->len) ?
+                select_plan_aggregate : exit_select_stmt;
+        (*nodes)->next = NULL;
+        nodes = &(*nodes)->next;
+    }
+
+    query->nodes->cb(handle);
+}
+
 /******************************************************************************
  * Enter functions
  *****************************************************************************/
@@ -1074,7 +1189,12 @@ static void enter_merge_as(uv_async_t * handle)
 
     xstr_extract_string(q_select->merge_as, node->str, node->len);
 
-    if (IS_MASTER && query->nodes->node->children->next->next->next != NULL)
+    /*
+     * A pool only needs the merge aggregation list when the master accepts
+     * partial states.
+     */
+    if ((IS_MASTER || (query->flags & SIRIDB_QUERY_FLAG_PARTIAL)) &&
+        query->nodes->node->children->next->next->next != NULL)
     {
         q_select->mlist = siridb_aggregate_list(
                 cleri_gn(cleri_gn(cleri_gn(
@@ -1087,11 +1207,31 @@ static void enter_merge_as(uv_async_t * handle)
             siridb_query_send_error(handle, CPROTO_ERR_QUERY);
             return;
         }
+
+        if (IS_MASTER &&
+            siridb_partial_is_supported(q_select->mlist->data[0]) &&
+            (q_select->partials = ct_new()) == NULL)
+        {
+            MEM_ERR_RET
+        }
     }
 
     SIRIPARSER_ASYNC_NEXT_NODE
 }
 
+static void enter_profile_stmt(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    query->profile = siridb_profile_new();
+
+    if (query->profile == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    SIRIPARSER_NEXT_NODE
+}
+
 static void enter_revoke_user(uv_async_t * handle)
 {
     siridb_query_t * query = handle->data;
@@ -1161,6 +1301,17 @@ static void enter_select_stmt(uv_async_t * handle)
             (!IS_MASTER || siridb_is_reindexing(siridb)) ?
                     NULL : imap_new();
 
+    /*
+     * Pools receive a plan together with the query so they do not need to
+     * parse the query again. (not critical, plan is allowed to be NULL)
+     */
+    if (    q_select->pmap != NULL &&
+            query->timeit == NULL &&
+            query->profile == NULL)
+    {
+        q_select->plan = siridb_plan_new();
+    }
+
     /* child is always the ',' and child->next the node */
     child = cleri_gn(query->nodes->node->children->next)->children;
     skip_get_points = siridb_aggregate_can_skip(child);
@@ -1347,12 +1498,24 @@ static void enter_series_name(uv_async_t * handle)
             }
 #endif
         }
-        else if (q_wrapper->pmap != NULL && imap_set(
-                q_wrapper->pmap,
-                pool,
-                (siridb_pool_t *) (siridb->pools->pool + pool)) < 0)
+        else if (q_wrapper->pmap != NULL)
         {
-            log_critical("Cannot add pool to pool map.");
+            if (imap_set(
+                    q_wrapper->pmap,
+                    pool,
+                    (siridb_pool_t *) (siridb->pools->pool + pool)) < 0)
+            {
+                log_critical("Cannot add pool to pool map.");
+            }
+
+            if (q_wrapper->tp == QUERIES_SELECT &&
+                ((query_select_t *) q_wrapper)->plan != NULL &&
+                siridb_plan_add_series(
+                        ((query_select_t *) q_wrapper)->plan,
+                        series_name))
+            {
+                select_plan_discard(q_wrapper);
+            }
         }
     }
 
@@ -1477,6 +1640,8 @@ static void enter_series_parentheses(uv_async_t * handle)
 
     assert (q_wrapper->series_map != NULL);
 
+    select_plan_discard(q_wrapper);
+
     if (q_wrapper->sset_vec == NULL)
     {
         if ((q_wrapper->sset_vec = vec_new(1)) == NULL)
@@ -1657,6 +1822,12 @@ static void enter_series_setopr(uv_async_t * handle)
         break;
     }
 
+    /* only a union of series names can be expressed by a plan */
+    if (q_wrapper->update_cb != &imap_union_ref)
+    {
+        select_plan_discard(q_wrapper);
+    }
+
     SIRIPARSER_NEXT_NODE
 }
 
@@ -1906,6 +2077,7 @@ static void enter_where_xxx(uv_async_t * handle)
     else
     {
         ((query_wrapper_t *) query->data)->where_expr = cexpr;
+        select_plan_discard((query_wrapper_t *) query->data);
         SIRIPARSER_ASYNC_NEXT_NODE
     }
 }
@@ -2272,9 +2444,9 @@ static void exit_count_series(uv_async_t * handle)
     {
         uv_mutex_lock(&siridb->series_mutex);
 
-        q_count->vec = imap_2vec_ref(
-                (q_count->series_map == NULL) ?
-                        siridb->series_map : q_count->series_map);
+        q_count->vec = (q_count->series_map == NULL) ?
+                siridb_zones_series(siridb, q_count->where_expr) :
+                imap_2vec_ref(q_count->series_map);
 
         uv_mutex_unlock(&siridb->series_mutex);
 
@@ -2358,9 +2530,9 @@ static void exit_count_series_length(uv_async_t * handle)
 
         uv_mutex_lock(&siridb->series_mutex);
 
-        q_count->vec = imap_2vec_ref(
-                (q_count->series_map == NULL) ?
-                        siridb->series_map : q_count->series_map);
+        q_count->vec = (q_count->series_map == NULL) ?
+                siridb_zones_series(siridb, q_count->where_expr) :
+                imap_2vec_ref(q_count->series_map);
 
         uv_mutex_unlock(&siridb->series_mutex);
 
@@ -2883,7 +3055,7 @@ static void exit_drop_series(uv_async_t * handle)
     uv_mutex_lock(&siridb->series_mutex);
 
     q_drop->vec = (q_drop->series_map == NULL) ?
-        imap_2vec_ref(siridb->series_map) :
+        siridb_zones_series(siridb, q_drop->where_expr) :
         imap_vec_pop(q_drop->series_map);
 
     uv_mutex_unlock(&siridb->series_mutex);
@@ -3378,6 +3550,7 @@ static void exit_list_pools(uv_async_t * handle)
             .pool=siridb->server->pool
     };
     uint_fast16_t prop;
+    ssize_t moved;
     cexpr_t * where_expr = q_list->where_expr;
 
     if (q_list->props == NULL)
@@ -3423,6 +3596,19 @@ static void exit_list_pools(uv_async_t * handle)
             case CLERI_GID_K_SERIES:
                 qp_add_int64(query->packer, (int64_t) wpool.series);
                 break;
+            case CLERI_GID_K_SLOTS:
+                qp_add_int64(query->packer, (int64_t) siridb_lookup_slots(
+                        siridb->pools->lookup,
+                        wpool.pool));
+                break;
+            case CLERI_GID_K_MOVED:
+                moved = siridb_pools_moved(siridb);
+                if (moved < 0)
+                {
+                    MEM_ERR_RET
+                }
+                qp_add_int64(query->packer, (int64_t) moved);
+                break;
             }
         }
 
@@ -3473,8 +3659,9 @@ static void exit_list_series(uv_async_t * handle)
 
     uv_mutex_lock(&siridb->series_mutex);
 
-    q_list->vec = imap_2vec_ref((q_list->series_map == NULL) ?
-                    siridb->series_map : q_list->series_map);
+    q_list->vec = (q_list->series_map == NULL) ?
+            siridb_zones_series(siridb, q_list->where_expr) :
+            imap_2vec_ref(q_list->series_map);
 
     uv_mutex_unlock(&siridb->series_mutex);
 
@@ -3838,6 +4025,39 @@ static void exit_list_users(uv_async_t * handle)
     SIRIPARSER_ASYNC_NEXT_NODE
 }
 
+static void exit_profile_stmt(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    siridb_t * siridb = query->siridb;
+
+    struct timespec end;
+    clock_gettime(CLOCK_REALTIME, &end);
+
+    if (query->packer == NULL)
+    {
+        query->packer = sirinet_packer_new(1024);
+
+        if (query->packer == NULL)
+        {
+            MEM_ERR_RET
+        }
+
+        qp_add_type(query->packer, QP_MAP_OPEN);
+    }
+
+    if (siridb_profile_pack(
+            query->profile,
+            query->packer,
+            siridb->server->name,
+            (double) (end.tv_sec - query->start.tv_sec) +
+            (double) (end.tv_nsec - query->start.tv_nsec) / 1000000000.0f))
+    {
+        MEM_ERR_RET
+    }
+
+    SIRIPARSER_ASYNC_NEXT_NODE
+}
+
 static void exit_revoke_user(uv_async_t * handle)
 {
     siridb_query_t * query = handle->data;
@@ -3987,81 +4207,7 @@ static void exit_select_aggregate(uv_async_t * handle)
     }
     else
     {
-        q_select->nselects--;
-
-        if (!siridb_presuf_is_unique(q_select->presuf))
-        {
-            snprintf(query->err_msg,
-                    SIRIDB_MAX_SIZE_ERR_MSG,
-                    "When using multiple select methods, add a prefix "
-                    "and/or suffix to the selection to make them unique.");
-            siridb_query_send_error(handle, CPROTO_ERR_QUERY);
-        }
-        else
-        {
-            if (q_select->merge_as != NULL)
-            {
-                vec_t * plist = vec_new(VEC_DEFAULT_SIZE);
-
-                if (plist == NULL || ct_add(
-                        q_select->result,
-                        siridb_presuf_name(
-                                q_select->presuf,
-                                q_select->merge_as,
-                                strlen(q_select->merge_as)),
-                        plist))
-                {
-                    sprintf(query->err_msg,
-                            "Error while merging points. Make sure the "
-                            "destination series name is valid.");
-                    vec_free(plist);
-                    siridb_query_send_error(handle, CPROTO_ERR_QUERY);
-                    return;
-                }
-            }
-
-            if (q_select->series_map->len)
-            {
-                q_select->alist = siridb_aggregate_list(
-                        cleri_gn(query->nodes->node->children)->children,
-                        query->err_msg);
-                if (q_select->alist == NULL)
-                {
-                    siridb_query_send_error(handle, CPROTO_ERR_QUERY);
-                    return;
-                }
-                q_select->vec = imap_2vec_ref(q_select->series_map);
-
-                if (q_select->vec == NULL)
-                {
-                    MEM_ERR_RET
-                }
-
-                uv_async_t * next = malloc(sizeof(uv_async_t));
-
-                if (next == NULL)
-                {
-                    MEM_ERR_RET
-                }
-
-                next->data = handle->data;
-
-                uv_async_init(
-                        siri.loop,
-                        next,
-                        (uv_async_cb) (
-                                (q_select->flags & QUERIES_SKIP_GET_POINTS) ?
-                                        async_no_points_aggregate :
-                                        async_select_aggregate));
-                uv_async_send(next);
-
-                uv_close((uv_handle_t *) handle, (uv_close_cb) free);
-            }
-            else
-            {
-                SIRIPARSER_ASYNC_NEXT_NODE
-            }
-        }
+        select_aggregate(handle);
     }
 }
 
@@ -4122,6 +4268,11 @@ static void exit_select_stmt(uv_async_t * handle)
     }
     else
     {
+        uint64_t start = siri_metrics_now();
+        siridb_profile_clock_t clock;
+
+        siridb_profile_start(query->profile, &clock);
+
         if (qp_add_raw(query->packer, (const unsigned char *) "select", 6) ||
             qp_add_type(query->packer, QP_MAP_OPEN) ||
             ct_items(
@@ -4137,6 +4288,8 @@ static void exit_select_stmt(uv_async_t * handle)
         }
         else
         {
+            siri_metrics_since(SIRI_METRICS_SELECT_PACK, start);
+            siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &clock);
             SIRIPARSER_ASYNC_NEXT_NODE
         }
     }
@@ -4286,6 +4439,72 @@ static void exit_set_backup_mode(uv_async_t * handle)
     }
 }
 
+static void exit_set_codec(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    cleri_node_t * node = cleri_gn(query->nodes->node->children->next->next);
+    siridb_t * siridb = query->siridb;
+    int codec;
+
+    MASTER_CHECK_ACCESSIBLE(siridb)
+    MASTER_CHECK_VERSION(siridb, "2.0.56")
+
+    char name[node->len - 1];
+    xstr_extract_string(name, node->str, node->len);
+
+    codec = siridb_codec_by_name(name, strlen(name));
+
+    if (codec < 0)
+    {
+        snprintf(query->err_msg,
+                SIRIDB_MAX_SIZE_ERR_MSG,
+                "Unknown codec: '%s'. (valid codecs are 'default', "
+                "'gorilla' and 'bitpack')",
+                name);
+        siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+    }
+    else if (siridb->codec == codec)
+    {
+        snprintf(query->err_msg,
+                SIRIDB_MAX_SIZE_ERR_MSG,
+                "Database '%s' is already using codec '%s'.",
+                siridb->dbname,
+                siridb_codec_name(codec));
+        siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+    }
+    else
+    {
+        QP_ADD_SUCCESS
+
+        qp_add_fmt_safe(
+                query->packer,
+                MSG_SUCCES_SET_CODEC,
+                siridb_codec_name(siridb->codec),
+                siridb_codec_name(codec));
+
+        siridb->codec = codec;
+
+        if (siridb_save(siridb))
+        {
+            log_critical("Could not save database changes (database: '%s')",
+                    siridb->dbname);
+        }
+
+        if (IS_MASTER)
+        {
+            siridb_query_forward(
+                    handle,
+                    SIRIDB_QUERY_FWD_UPDATE,
+                    (sirinet_promises_cb) on_update_xxx_response,
+                    0);
+        }
+        else
+        {
+            SIRIPARSER_ASYNC_NEXT_NODE
+        }
+    }
+}
+
 static void exit_set_drop_threshold(uv_async_t * handle)
 {
     siridb_query_t * query = handle->data;
@@ -4405,6 +4624,7 @@ static void exit_set_expiration_xxx(
     *expirep = expiration;
 
     siridb_update_shard_expiration(siridb);
+    siri_expire_schedule();
 
     if (siridb_save(siridb))
     {
@@ -5284,6 +5504,7 @@ static void async_filter_series(uv_async_t * handle)
     uint8_t async_more = 0;
     siridb_series_t * series;
     size_t index_end = q_wrapper->vec_index + MAX_ITERATE_COUNT;
+    siridb_profile_clock_t clock;
 
     if (index_end >= q_wrapper->vec->len)
     {
@@ -5294,6 +5515,8 @@ static void async_filter_series(uv_async_t * handle)
         async_more = 1;
     }
 
+    siridb_profile_start(query->profile, &clock);
+
     for (; q_wrapper->vec_index < index_end; q_wrapper->vec_index++)
     {
         series = (siridb_series_t *)
@@ -5316,6 +5539,8 @@ static void async_filter_series(uv_async_t * handle)
         }
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_FILTER, &clock);
+
     if (async_more)
     {
         uv_async_send(handle);
@@ -5594,6 +5819,8 @@ static void async_select_aggregate(uv_async_t * handle)
     siridb_series_t * series;
     siridb_points_t * points;
     siridb_points_t * aggr_points;
+    siridb_profile_clock_t clock;
+    uint64_t start;
 
     if (q_select->n > siridb->select_points_limit)
     {
@@ -5637,6 +5864,10 @@ static void async_select_aggregate(uv_async_t * handle)
 
     if (points == NULL)
     {
+        start = siri_metrics_now();
+        siridb_profile_start(query->profile, &clock);
+        siridb_profile_local = query->profile;
+
         uv_mutex_lock(&siridb->series_mutex);
 
         points = (series->flags & SIRIDB_SERIES_IS_DROPPED)
@@ -5656,6 +5887,10 @@ static void async_select_aggregate(uv_async_t * handle)
 
         uv_mutex_unlock(&siridb->series_mutex);
 
+        siridb_profile_local = NULL;
+        siridb_profile_stop(query->profile, SIRIDB_PROFILE_READ, &clock);
+        siri_metrics_since(SIRI_METRICS_SELECT_READ, start);
+
         /* when having a cache and points, add a copy of points to the cache */
         if (q_select->points_map != NULL && points != NULL)
         {
@@ -5673,6 +5908,9 @@ static void async_select_aggregate(uv_async_t * handle)
         const char * name;
         size_t i;
 
+        start = siri_metrics_now();
+        siridb_profile_start(query->profile, &clock);
+
         for (i = 0; points->len && i < q_select->alist->len; i++)
         {
             aggr_points = siridb_aggregate_run(
@@ -5694,6 +5932,15 @@ static void async_select_aggregate(uv_async_t * handle)
             points = aggr_points;
         }
 
+        if (i)
+        {
+            siri_metrics_since(SIRI_METRICS_SELECT_AGGREGATE, start);
+            siridb_profile_stop(
+                    query->profile,
+                    SIRIDB_PROFILE_AGGREGATE,
+                    &clock);
+        }
+
         q_select->n += points->len;
 
         if (q_select->merge_as == NULL)
@@ -5760,6 +6007,7 @@ static void async_series_re(uv_async_t * handle)
     uint8_t async_more = 0;
     siridb_series_t * series;
     size_t index_end = q_wrapper->vec_index + MAX_ITERATE_COUNT;
+    siridb_profile_clock_t clock;
 
     if (index_end >= q_wrapper->vec->len)
     {
@@ -5772,6 +6020,8 @@ static void async_series_re(uv_async_t * handle)
 
     int pcre_exec_ret;
 
+    siridb_profile_start(query->profile, &clock);
+
     for (; q_wrapper->vec_index < index_end; q_wrapper->vec_index++)
     {
         series = (siridb_series_t *)
@@ -5792,6 +6042,8 @@ static void async_series_re(uv_async_t * handle)
         }
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_REGEX, &clock);
+
     if (async_more)
     {
         uv_async_send(handle);
@@ -5923,11 +6175,18 @@ static void on_alter_xxx_response(vec_t * promises, uv_async_t * handle)
             {
                 q_alter->n += qp_count.via.int64;
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
 
@@ -5994,11 +6253,18 @@ static void on_count_xxx_response(vec_t * promises, uv_async_t * handle)
             {
                 q_count->n += qp_count.via.int64;
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
         else if (pkg != NULL &&
@@ -6064,11 +6330,18 @@ static void on_drop_series_response(vec_t * promises, uv_async_t * handle)
             {
                 q_drop->n += qp_drop.via.int64;
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
 
@@ -6120,11 +6393,18 @@ static void on_drop_shards_response(vec_t * promises, uv_async_t * handle)
             {
                 q_drop->n += qp_drop.via.int64;
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
 
@@ -6308,11 +6588,18 @@ static void on_list_xxx_response(vec_t * promises, uv_async_t * handle)
                     }
                 }
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
         else if (pkg != NULL &&
@@ -6360,8 +6647,11 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
     qp_obj_t qp_len;
     qp_obj_t qp_points;
     qp_obj_t qp_err_msg;
+    siridb_profile_clock_t clock;
     size_t i;
 
+    siridb_profile_start(query->profile, &clock);
+
     for (i = 0; i < promises->len; i++)
     {
         promise = promises->data[i];
@@ -6445,12 +6735,18 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
                                 siridb->select_points_limit);
                     }
 
-
-                    /* extract time-it info if needed */
+                    /* extract time-it or profile info if needed */
                     if (query->timeit != NULL)
                     {
                         siridb_query_timeit_from_unpacker(query, &unpacker);
                     }
+                    else if (query->profile != NULL)
+                    {
+                        siridb_profile_from_unpacker(
+                                query->profile,
+                                &unpacker,
+                                promise->rtt);
+                    }
                 }
             }
 
@@ -6460,6 +6756,8 @@ static void on_select_response(vec_t * promises, uv_async_t * handle)
         }
     }
 
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_MERGE, &clock);
+
     if (q_select->n > siridb->select_points_limit)
     {
         snprintf(query->err_msg,
@@ -6611,11 +6909,18 @@ static void on_tag_response(vec_t * promises, uv_async_t * handle)
             {
                 q_tag->n += qp_tag.via.int64;
 
-                /* extract time-it info if needed */
+                /* extract time-it or profile info if needed */
                 if (query->timeit != NULL)
                 {
                     siridb_query_timeit_from_unpacker(query, &unpacker);
                 }
+                else if (query->profile != NULL)
+                {
+                    siridb_profile_from_unpacker(
+                            query->profile,
+                            &unpacker,
+                            promise->rtt);
+                }
             }
         }
 
@@ -6647,7 +6952,25 @@ static void master_select_work(uv_work_t * work)
     query_select_t * q_select = query->data;
     siridb_t * siridb = query->siridb;
     siridb->selected_points += q_select->n;
-    int rc = ct_items(
+    uint64_t start = siri_metrics_now();
+    siridb_profile_clock_t clock;
+    int rc;
+
+    siridb_profile_start(query->profile, &clock);
+
+    /*
+     * Allocate the result at once instead of growing the packer for each
+     * series.
+     */
+    if (q_select->merge_as == NULL &&
+        qp_packer_reserve(query->packer, q_select->n * POINTS_PACK_SZ))
+    {
+        sprintf(query->err_msg, "Memory allocation error.");
+        query->flags |= SIRIDB_QUERY_FLAG_ERR;
+        return;
+    }
+
+    rc = ct_items(
             q_select->result,
             (q_select->merge_as == NULL) ?
                     (ct_item_cb) &items_select_master
@@ -6655,6 +6978,9 @@ static void master_select_work(uv_work_t * work)
                     (ct_item_cb) &items_select_master_merge,
             handle);
 
+    siri_metrics_since(SIRI_METRICS_SELECT_PACK, start);
+    siridb_profile_stop(query->profile, SIRIDB_PROFILE_PACK, &clock);
+
     /* Do not set an error message when rc==1 since in that case the message
      * is already set.
      */
@@ -6715,7 +7041,9 @@ static int items_select_master(
     }
 
     if (    qp_add_raw(query->packer, (const unsigned char *) name, len) ||
-            siridb_points_pack(points, query->packer))
+            ((query->flags & SIRIDB_QUERY_FLAG_COLUMNS)
+                ? siridb_points_pack_columns(points, query->packer)
+                : siridb_points_pack(points, query->packer)))
     {
         sprintf(query->err_msg, "Memory allocation error.");
         return -1;
@@ -6733,6 +7061,9 @@ static int items_select_master_merge(
     siridb_query_t * query = handle->data;
     query_select_t * q_select = query->data;
     siridb_points_t * points;
+    vec_t * partials = (q_select->partials == NULL) ?
+            NULL : (vec_t *) ct_get(q_select->partials, name);
+    size_t start = 0;
 
     if (qp_add_raw(query->packer, (const unsigned char *) name, len))
     {
@@ -6740,7 +7071,26 @@ static int items_select_master_merge(
         return -1;
     }
 
-    switch (plist->len)
+    if (partials != NULL && partials->len)
+    {
+        /*
+         * At least one pool has sent partial states, combine them with the
+         * raw points and finish the first aggregation.
+         */
+        siridb_aggr_t * aggr = (siridb_aggr_t *) q_select->mlist->data[0];
+        siridb_partial_t * partial = siridb_partial_merge(
+                plist,
+                partials,
+                aggr,
+                query->err_msg);
+
+        points = (partial == NULL) ?
+                NULL : siridb_partial_finalize(partial, aggr, query->err_msg);
+
+        siridb_partial_free(partial);
+        start = 1;
+    }
+    else switch (plist->len)
     {
     case 0:
         points = siridb_points_new(0, TP_INT);
@@ -6762,7 +7112,7 @@ static int items_select_master_merge(
         siridb_points_t * aggr_points;
         size_t i;
 
-        for (i = 0; points->len && i < q_select->mlist->len; i++)
+        for (i = start; points->len && i < q_select->mlist->len; i++)
         {
             aggr_points = siridb_aggregate_run(
                     points,
@@ -6797,7 +7147,9 @@ static int items_select_master_merge(
         siridb_points_ts_correction(points, (double) query->factor);
     }
 
-    if (siridb_points_pack(points, query->packer))
+    if ((query->flags & SIRIDB_QUERY_FLAG_COLUMNS)
+            ? siridb_points_pack_columns(points, query->packer)
+            : siridb_points_pack(points, query->packer))
     {
         sprintf(query->err_msg, "Memory allocation error.");
         siridb_points_free(points);
@@ -6823,7 +7175,10 @@ static int items_select_other(
 
     return -(qp_add_raw_term(
                 query->packer, (const unsigned char *) name, len) ||
-            siridb_points_raw_pack(points, query->packer));
+            ((query->flags & SIRIDB_QUERY_FLAG_ZIP)
+                ? siridb_points_zip_pack(
+                        points, query->packer, query->siridb->codec)
+                : siridb_points_raw_pack(points, query->packer)));
 }
 
 /*
@@ -6838,15 +7193,43 @@ static int items_select_other_merge(
 {
     size_t i;
     siridb_query_t * query = handle->data;
+    query_select_t * q_select = query->data;
+    siridb_partial_t * partial = NULL;
     int rc = qp_add_raw_term(
                 query->packer, (const unsigned char *) name, len) ||
             qp_add_type(query->packer, QP_ARRAY_OPEN);
 
+    if ((query->flags & SIRIDB_QUERY_FLAG_PARTIAL) &&
+        q_select->mlist != NULL &&
+        siridb_partial_is_exact(plist, q_select->mlist->data[0]))
+    {
+        /*
+         * Send partial states when possible, in case of an error we simply
+         * send the raw points so the master can report the error.
+         */
+        if ((partial = siridb_partial_merge(
+                plist,
+                NULL,
+                q_select->mlist->data[0],
+                query->err_msg)) != NULL)
+        {
+            rc = rc || (partial->len &&
+                    siridb_partial_raw_pack(partial, query->packer));
+            siridb_partial_free(partial);
+            return -(rc || qp_add_type(query->packer, QP_ARRAY_CLOSE));
+        }
+    }
+
     for (i = 0; !rc && i < plist->len; i++)
     {
-        rc = siridb_points_raw_pack(
-                (siridb_points_t * ) plist->data[i],
-                query->packer);
+        rc = (query->flags & SIRIDB_QUERY_FLAG_ZIP)
+            ? siridb_points_zip_pack(
+                    (siridb_points_t * ) plist->data[i],
+                    query->packer,
+                    query->siridb->codec)
+            : siridb_points_raw_pack(
+                    (siridb_points_t * ) plist->data[i],
+                    query->packer);
     }
 
     return -(rc || qp_add_type(query->packer, QP_ARRAY_CLOSE));
@@ -6871,33 +7254,13 @@ static void on_select_unpack_points(
             qp_is_int(qp_next(unpacker, qp_len)) &&
             qp_is_raw(qp_next(unpacker, qp_points)))
     {
-        points = siridb_points_new(qp_len->via.int64, qp_tp->via.int64);
+        points = siridb_points_raw_unpack(
+                qp_tp->via.int64,
+                qp_len->via.int64,
+                qp_points->via.raw,
+                qp_points->len);
         if (points != NULL)
         {
-            if (points->tp == TP_STRING)
-            {
-                if (qp_len->via.int64 < POINTS_ZIP_THRESHOLD)
-                {
-                    siridb_points_unzip_string_raw(
-                            points,
-                            qp_points->via.raw,
-                            qp_len->via.int64);
-                }
-                else
-                {
-                    siridb_points_unzip_string(
-                            points,
-                            qp_points->via.raw,
-                            qp_len->via.int64,
-                            NULL, NULL, 0);
-                }
-            }
-            else
-            {
-                points->len = qp_len->via.int64;
-                memcpy(points->data, qp_points->via.raw, qp_points->len);
-            }
-
             if (ct_add(q_select->result, (char *) qp_name->via.raw, points))
             {
                 siridb_points_free(points);
@@ -6922,6 +7285,7 @@ static void on_select_unpack_merged_points(
         uint32_t select_points_limit)
 {
     siridb_points_t * points;
+    siridb_partial_t * partial;
 
     while ( qp_is_raw(qp_next(unpacker, qp_name)) &&
             qp_is_raw_term(qp_name) &&
@@ -6930,6 +7294,10 @@ static void on_select_unpack_merged_points(
         vec_t ** plist = (vec_t **) ct_getaddr(
                 q_select->result,
                 (const char *) qp_name->via.raw);
+        vec_t ** partials = (q_select->partials == NULL) ?
+                NULL : (vec_t **) ct_getaddr(
+                        q_select->partials,
+                        (const char *) qp_name->via.raw);
 
         while ( q_select->n <= select_points_limit &&
                 qp_is_array(qp_next(unpacker, NULL)) &&
@@ -6937,35 +7305,38 @@ static void on_select_unpack_merged_points(
                 qp_is_int(qp_next(unpacker, qp_len)) &&
                 qp_is_raw(qp_next(unpacker, qp_points)))
         {
-
-            points = siridb_points_new(qp_len->via.int64, qp_tp->via.int64);
-
-            if (points != NULL)
+            if (qp_tp->via.int64 >= SIRIDB_PARTIAL_TP)
             {
-                if (points->tp == TP_STRING)
+                partial = (partials == NULL) ? NULL : siridb_partial_raw_unpack(
+                        qp_tp->via.int64 - SIRIDB_PARTIAL_TP,
+                        qp_len->via.int64,
+                        qp_points,
+                        q_select->mlist->data[0]);
+
+                if (partial != NULL)
                 {
-                    if (qp_len->via.int64 < POINTS_ZIP_THRESHOLD)
+                    if (vec_append_safe(partials, partial))
                     {
-                        siridb_points_unzip_string_raw(
-                                points,
-                                qp_points->via.raw,
-                                qp_len->via.int64);
+                        siridb_partial_free(partial);
                     }
                     else
                     {
-                        siridb_points_unzip_string(
-                                points,
-                                qp_points->via.raw,
-                                qp_len->via.int64,
-                                NULL, NULL, 0);
+                        q_select->n += partial->len;
                     }
                 }
-                else
-                {
-                    points->len = qp_len->via.int64;
-                    memcpy(points->data, qp_points->via.raw, qp_points->len);
-                }
 
+                qp_next(unpacker, NULL);  /* QP_ARRAY_CLOSE     */
+                continue;
+            }
+
+            points = siridb_points_raw_unpack(
+                    qp_tp->via.int64,
+                    qp_len->via.int64,
+                    qp_points->via.raw,
+                    qp_points->len);
+
+            if (points != NULL)
+            {
                 if (vec_append_safe(plist, points))
                 {
                     siridb_points_free(points);
@@ -6981,6 +7352,175 @@ static void on_select_unpack_merged_points(
     }
 }
 
+/*
+ * Run a select method after the prefix-suffix is added.
+ *
+ * The aggregation list is created from the current node unless the list is
+ * already set by a plan.
+ */
+static void select_aggregate(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    query_select_t * q_select = query->data;
+
+    q_select->nselects--;
+
+    if (q_select->lookup_start)
+    {
+        siri_metrics_since(
+                SIRI_METRICS_SELECT_LOOKUP,
+                q_select->lookup_start);
+        q_select->lookup_start = 0;
+    }
+
+    if (!siridb_presuf_is_unique(q_select->presuf))
+    {
+        snprintf(query->err_msg,
+                SIRIDB_MAX_SIZE_ERR_MSG,
+                "When using multiple select methods, add a prefix "
+                "and/or suffix to the selection to make them unique.");
+        siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+        return;
+    }
+
+    if (q_select->merge_as != NULL)
+    {
+        vec_t * plist = vec_new(VEC_DEFAULT_SIZE);
+        const char * name = siridb_presuf_name(
+                q_select->presuf,
+                q_select->merge_as,
+                strlen(q_select->merge_as));
+
+        if (plist == NULL || name == NULL ||
+            ct_add(q_select->result, name, plist))
+        {
+            sprintf(query->err_msg,
+                    "Error while merging points. Make sure the "
+                    "destination series name is valid.");
+            vec_free(plist);
+            siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+            return;
+        }
+
+        if (q_select->partials != NULL)
+        {
+            vec_t * partials = vec_new(VEC_DEFAULT_SIZE);
+
+            if (partials == NULL ||
+                ct_add(q_select->partials, name, partials))
+            {
+                vec_free(partials);
+                MEM_ERR_RET
+            }
+        }
+    }
+
+    /*
+     * The master needs the aggregation list for the plan, even when no
+     * series are selected on this server.
+     */
+    if (q_select->alist == NULL &&
+        (q_select->series_map->len || q_select->plan != NULL))
+    {
+        q_select->alist = siridb_aggregate_list(
+                cleri_gn(query->nodes->node->children)->children,
+                query->err_msg);
+        if (q_select->alist == NULL)
+        {
+            siridb_query_send_error(handle, CPROTO_ERR_QUERY);
+            return;
+        }
+
+        if (q_select->plan != NULL && siridb_plan_add_method(
+                q_select->plan,
+                q_select->presuf,
+                q_select->alist))
+        {
+            /* not critical, the pools will use the query instead */
+            select_plan_discard((query_wrapper_t *) q_select);
+        }
+    }
+
+    if (q_select->series_map->len)
+    {
+        q_select->vec = imap_2vec_ref(q_select->series_map);
+
+        if (q_select->vec == NULL)
+        {
+            MEM_ERR_RET
+        }
+
+        uv_async_t * next = malloc(sizeof(uv_async_t));
+
+        if (next == NULL)
+        {
+            MEM_ERR_RET
+        }
+
+        next->data = handle->data;
+
+        uv_async_init(
+                siri.loop,
+                next,
+                (uv_async_cb) (
+                        (q_select->flags & QUERIES_SKIP_GET_POINTS) ?
+                                async_no_points_aggregate :
+                                async_select_aggregate));
+        uv_async_send(next);
+
+        uv_close((uv_handle_t *) handle, (uv_close_cb) free);
+    }
+    else
+    {
+        if (q_select->alist != NULL)
+        {
+            siridb_aggregate_list_free(q_select->alist);
+            q_select->alist = NULL;
+        }
+        SIRIPARSER_ASYNC_NEXT_NODE
+    }
+}
+
+/*
+ * Run the next select method from a plan. (only used by pools)
+ */
+static void select_plan_aggregate(uv_async_t * handle)
+{
+    siridb_query_t * query = handle->data;
+    query_select_t * q_select = query->data;
+    siridb_plan_method_t * method = q_select->plan->methods->data[
+            q_select->plan->methods->len - q_select->nselects];
+
+    if (siridb_presuf_add_str(
+            &q_select->presuf,
+            method->prefix,
+            method->suffix) == NULL)
+    {
+        MEM_ERR_RET
+    }
+
+    /* the select query takes ownership of the aggregation list */
+    q_select->alist = method->alist;
+    method->alist = NULL;
+
+    select_aggregate(handle);
+}
+
+/*
+ * Discard the plan for a select query, the pools will parse the query text
+ * instead. This is used when the series selection cannot be expressed by a
+ * plan.
+ */
+static void select_plan_discard(query_wrapper_t * q_wrapper)
+{
+    if (q_wrapper->tp == QUERIES_SELECT)
+    {
+        query_select_t * q_select = (query_select_t *) q_wrapper;
+        siridb_plan_free(q_select->plan);
+        q_select->plan = NULL;
+    }
+}
+
 static int values_list_groups(siridb_group_t * group, uv_async_t * handle)
 {
     siridb_query_t * query = handle->data;
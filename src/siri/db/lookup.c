@@ -5,6 +5,20 @@
 #include <siri/err.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define XXH_rotl64(x__, r__) (((x__) << (r__)) | ((x__) >> (64 - (r__))))
+
+static inline uint64_t LOOKUP_read64(const unsigned char * p);
+static inline uint32_t LOOKUP_read32(const unsigned char * p);
+static inline uint64_t LOOKUP_xxh_round(uint64_t acc, uint64_t input);
+static inline uint64_t LOOKUP_xxh_merge(uint64_t acc, uint64_t val);
 
 /*
  * Returns a pool id based on a terminated string.
@@ -12,11 +26,17 @@
 uint16_t siridb_lookup_sn(siridb_lookup_t * lookup, const char * sn)
 {
     uint32_t n = 0;
+
+    if (lookup->placement == SIRIDB_PLACEMENT_XXHASH)
+    {
+        return siridb_lookup_sn_raw(lookup, sn, strlen(sn));
+    }
+
     for (; *sn; sn++)
     {
         n += *sn;
     }
-    return (*lookup)[n % SIRIDB_LOOKUP_SZ];
+    return lookup->pools[n % SIRIDB_LOOKUP_SZ];
 }
 
 /*
@@ -26,21 +46,41 @@ uint16_t siridb_lookup_sn_raw(
         siridb_lookup_t * lookup,
         const char * sn,
         size_t len)
+{
+    return lookup->pools[siridb_lookup_slot(lookup->placement, sn, len)];
+}
+
+/*
+ * Returns the slot for a raw string. The slot does not depend on the number
+ * of pools.
+ */
+uint16_t siridb_lookup_slot(uint8_t placement, const char * sn, size_t len)
 {
     uint32_t n = 0;
+
+    if (placement == SIRIDB_PLACEMENT_XXHASH)
+    {
+        return siridb_lookup_xxhash(sn, len) % SIRIDB_LOOKUP_SZ;
+    }
+
     while (len--)
     {
         n += sn[len];
     }
-    return (*lookup)[n % SIRIDB_LOOKUP_SZ];
+    return n % SIRIDB_LOOKUP_SZ;
 }
 
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  *
  * (Algorithm to create pools lookup array.)
+ *
+ * Each new pool takes every m-th slot of all existing pools, so only slots
+ * for the new pool are changed compared to a lookup with one pool less.
  */
-siridb_lookup_t * siridb_lookup_new(uint_fast16_t num_pools)
+siridb_lookup_t * siridb_lookup_new(
+        uint_fast16_t num_pools,
+        uint8_t placement)
 {
     siridb_lookup_t * lookup = calloc(1, sizeof(siridb_lookup_t));
 
@@ -51,7 +91,9 @@ siridb_lookup_t * siridb_lookup_new(uint_fast16_t num_pools)
     else
     {
         uint_fast16_t n, i, m;
-        uint_fast16_t counters[num_pools - 1];
+        uint_fast16_t counters[num_pools];
+
+        lookup->placement = placement;
 
         for (n = 1, m = 2; n < num_pools; n++, m++)
         {
@@ -62,9 +104,9 @@ siridb_lookup_t * siridb_lookup_new(uint_fast16_t num_pools)
 
             for (i = 0; i < SIRIDB_LOOKUP_SZ; i++)
             {
-                if (++counters[ (*lookup)[i] ] % m == 0)
+                if (++counters[ lookup->pools[i] ] % m == 0)
                 {
-                    (*lookup)[i] = n;
+                    lookup->pools[i] = n;
                 }
             }
         }
@@ -73,11 +115,155 @@ siridb_lookup_t * siridb_lookup_new(uint_fast16_t num_pools)
 }
 
 /*
- * Destroy lookup.
+ * Destroy lookup. (parsing NULL is allowed)
  */
 void siridb_lookup_free(siridb_lookup_t * lookup)
 {
     free(lookup);
 }
 
+/*
+ * Returns the number of slots which are assigned to a given pool.
+ */
+size_t siridb_lookup_slots(siridb_lookup_t * lookup, uint16_t pool)
+{
+    size_t i, n = 0;
+    for (i = 0; i < SIRIDB_LOOKUP_SZ; i++)
+    {
+        n += lookup->pools[i] == pool;
+    }
+    return n;
+}
+
+/*
+ * Returns the 64-bit xxHash (XXH64) with seed 0 for a raw string.
+ *
+ * The input is read as little-endian so the result, and therefore the pool
+ * for a series, does not depend on the platform.
+ */
+uint64_t siridb_lookup_xxhash(const char * sn, size_t len)
+{
+    const unsigned char * p = (const unsigned char *) sn;
+    const unsigned char * end = p + len;
+    uint64_t h;
+
+    if (len >= 32)
+    {
+        const unsigned char * limit = end - 32;
+        uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = XXH_PRIME64_2;
+        uint64_t v3 = 0;
+        uint64_t v4 = -XXH_PRIME64_1;
+
+        do
+        {
+            v1 = LOOKUP_xxh_round(v1, LOOKUP_read64(p));
+            v2 = LOOKUP_xxh_round(v2, LOOKUP_read64(p + 8));
+            v3 = LOOKUP_xxh_round(v3, LOOKUP_read64(p + 16));
+            v4 = LOOKUP_xxh_round(v4, LOOKUP_read64(p + 24));
+            p += 32;
+        }
+        while (p <= limit);
+
+        h = XXH_rotl64(v1, 1) + XXH_rotl64(v2, 7) +
+            XXH_rotl64(v3, 12) + XXH_rotl64(v4, 18);
+        h = LOOKUP_xxh_merge(h, v1);
+        h = LOOKUP_xxh_merge(h, v2);
+        h = LOOKUP_xxh_merge(h, v3);
+        h = LOOKUP_xxh_merge(h, v4);
+    }
+    else
+    {
+        h = XXH_PRIME64_5;
+    }
+
+    h += (uint64_t) len;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= LOOKUP_xxh_round(0, LOOKUP_read64(p));
+        h = XXH_rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t) LOOKUP_read32(p) * XXH_PRIME64_1;
+        h = XXH_rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+
+    for (; p < end; p++)
+    {
+        h ^= (uint64_t) *p * XXH_PRIME64_5;
+        h = XXH_rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+/*
+ * Returns the placement for a given name or -1 if the name is unknown.
+ */
+int siridb_placement_by_name(const char * name, size_t n)
+{
+    int placement;
 
+    for (placement = 0; placement < SIRIDB_PLACEMENT_END; ++placement)
+    {
+        const char * s = siridb_placement_name(placement);
+        if (strlen(s) == n && strncasecmp(s, name, n) == 0)
+        {
+            return placement;
+        }
+    }
+    return -1;
+}
+
+const char * siridb_placement_name(uint8_t placement)
+{
+    switch (placement)
+    {
+    case SIRIDB_PLACEMENT_SUM:      return "sum";
+    case SIRIDB_PLACEMENT_XXHASH:   return "xxhash";
+    }
+    return "unknown";
+}
+
+static inline uint64_t LOOKUP_read64(const unsigned char * p)
+{
+    return  (uint64_t) p[0] |
+            (uint64_t) p[1] << 8 |
+            (uint64_t) p[2] << 16 |
+            (uint64_t) p[3] << 24 |
+            (uint64_t) p[4] << 32 |
+            (uint64_t) p[5] << 40 |
+            (uint64_t) p[6] << 48 |
+            (uint64_t) p[7] << 56;
+}
+
+static inline uint32_t LOOKUP_read32(const unsigned char * p)
+{
+    return  (uint32_t) p[0] |
+            (uint32_t) p[1] << 8 |
+            (uint32_t) p[2] << 16 |
+            (uint32_t) p[3] << 24;
+}
+
+static inline uint64_t LOOKUP_xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = XXH_rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t LOOKUP_xxh_merge(uint64_t acc, uint64_t val)
+{
+    acc ^= LOOKUP_xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
@@ -0,0 +1,972 @@
+/*
+ * partial.c - Partial aggregation states for merged series.
+ */
+#include <assert.h>
+#include <limits.h>
+#include <siri/db/partial.h>
+#include <siri/grammar/grammar.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARTIAL_GROUP_TS(point) \
+    (point->ts + aggr->group_by - 1) / aggr->group_by * aggr->group_by + \
+    aggr->offset
+
+/* move state i from partial p to the next state of the combined partial */
+#define PARTIAL_MOVE(p__, i__)                          \
+{                                                       \
+    *state = (p__)->data[i__];                          \
+    if (sketch != NULL)                                 \
+    {                                                   \
+        *sketch++ = (p__)->sketches[i__];               \
+        (p__)->sketches[i__] = NULL;                    \
+    }                                                   \
+    i__++;                                              \
+}
+
+#define PARTIAL_IS_SKETCH(gid) \
+    ((gid) == CLERI_GID_F_DISTINCT || (gid) == CLERI_GID_F_PERCENTILE)
+
+#define PARTIAL_SKETCH_TP(gid) \
+    (((gid) == CLERI_GID_F_DISTINCT) ? \
+            SIRIDB_SKETCH_HLL : SIRIDB_SKETCH_TDIGEST)
+
+static siridb_partial_t * PARTIAL_from_points(
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+static siridb_partial_t * PARTIAL_combine(
+        siridb_partial_t * a,
+        siridb_partial_t * b,
+        siridb_aggr_t * aggr,
+        char * err_msg);
+static int PARTIAL_set_state(
+        siridb_pstate_t * state,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg);
+static int PARTIAL_add_state(
+        siridb_pstate_t * dst,
+        siridb_pstate_t * src,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg);
+static int PARTIAL_set_sketch(
+        siridb_partial_t * partial,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg);
+static int PARTIAL_unpack_sketches(
+        siridb_partial_t * partial,
+        size_t len,
+        const unsigned char * data,
+        size_t size,
+        uint32_t gid);
+static void PARTIAL_to_double(siridb_partial_t * partial);
+static int PARTIAL_has_double(vec_t * plist, vec_t * partials);
+
+/*
+ * Returns 1 when the given aggregate can be calculated from partial states.
+ *
+ * Only aggregates which give the same result as the raw points are
+ * supported. Functions like median() need all the points and mean() and the
+ * variance methods depend on the order in which floating point values are
+ * added, so these use the raw points. Percentile() and distinct() use a
+ * mergeable sketch.
+ */
+int siridb_partial_is_supported(siridb_aggr_t * aggr)
+{
+    if (aggr->limit)
+    {
+        return 0;
+    }
+
+    switch (aggr->gid)
+    {
+    case CLERI_GID_F_COUNT:
+    case CLERI_GID_F_DISTINCT:
+    case CLERI_GID_F_MAX:
+    case CLERI_GID_F_MIN:
+    case CLERI_GID_F_PERCENTILE:
+    case CLERI_GID_F_SUM:
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns 1 when the points in plist can be reduced to partial states
+ * without changing the result of the aggregate.
+ *
+ * Strings cannot be reduced and a sum of floating point values depends on
+ * the order of the points, so a sum on float series uses the raw points.
+ * Integer sums from one pool cannot be combined with float series from
+ * another pool either, siridb_partial_merge() refuses this case.
+ */
+int siridb_partial_is_exact(vec_t * plist, siridb_aggr_t * aggr)
+{
+    siridb_points_t * points;
+    size_t i;
+
+    if (!siridb_partial_is_supported(aggr))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < plist->len; i++)
+    {
+        points = (siridb_points_t *) plist->data[i];
+        if (points->tp == TP_STRING ||
+            (points->tp == TP_DOUBLE && aggr->gid == CLERI_GID_F_SUM))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Returns NULL in case an error has occurred.
+ */
+siridb_partial_t * siridb_partial_new(size_t size, points_tp tp)
+{
+    siridb_partial_t * partial = malloc(sizeof(siridb_partial_t));
+    if (partial == NULL)
+    {
+        return NULL;
+    }
+
+    partial->len = 0;
+    partial->tp = tp;
+    partial->sketches = NULL;
+    partial->data = (size) ? malloc(sizeof(siridb_pstate_t) * size) : NULL;
+    if (partial->data == NULL && size)
+    {
+        free(partial);
+        return NULL;
+    }
+
+    return partial;
+}
+
+void siridb_partial_free(siridb_partial_t * partial)
+{
+    if (partial != NULL)
+    {
+        if (partial->sketches != NULL)
+        {
+            size_t i;
+            for (i = 0; i < partial->len; i++)
+            {
+                siridb_sketch_free(partial->sketches[i]);
+            }
+            free(partial->sketches);
+        }
+        free(partial->data);
+        free(partial);
+    }
+}
+
+/*
+ * Destroy a list with partial states.
+ */
+void siridb_partial_list_free(vec_t * partials)
+{
+    size_t i;
+    for (i = 0; i < partials->len; i++)
+    {
+        siridb_partial_free(partials->data[i]);
+    }
+    free(partials);
+}
+
+/*
+ * Combine raw points and partial states into one partial state per group.
+ *
+ * The points in plist are left untouched but the partial states are
+ * consumed and removed from the partials list. Argument partials may be
+ * NULL in case only raw points need to be reduced.
+ *
+ * Partial sums are only sent for integer series. When they need to be
+ * combined with float series, the raw points would be added in a different
+ * order and the result would depend on the pool holding each series, so
+ * this is refused.
+ *
+ * Returns NULL in case an error has occurred. (err_msg is set)
+ */
+siridb_partial_t * siridb_partial_merge(
+        vec_t * plist,
+        vec_t * partials,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    siridb_partial_t * partial = NULL;
+    siridb_partial_t * tmp;
+    siridb_points_t * points;
+    size_t i;
+
+    if (    aggr->gid == CLERI_GID_F_SUM &&
+            partials != NULL &&
+            partials->len &&
+            PARTIAL_has_double(plist, partials))
+    {
+        sprintf(err_msg,
+                "Cannot merge integer and float series using sum() when "
+                "the series are stored in different pools.");
+        return NULL;
+    }
+
+    for (i = 0; i < plist->len; i++)
+    {
+        points = (siridb_points_t *) plist->data[i];
+        if (!points->len)
+        {
+            continue;
+        }
+
+        tmp = PARTIAL_from_points(points, aggr, err_msg);
+        if (tmp == NULL)
+        {
+            siridb_partial_free(partial);
+            return NULL;
+        }
+
+        partial = PARTIAL_combine(partial, tmp, aggr, err_msg);
+        if (partial == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    while (partials != NULL && partials->len)
+    {
+        tmp = (siridb_partial_t *) vec_pop(partials);
+
+        partial = PARTIAL_combine(partial, tmp, aggr, err_msg);
+        if (partial == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    if (partial == NULL)
+    {
+        partial = siridb_partial_new(0, TP_INT);
+        if (partial == NULL)
+        {
+            sprintf(err_msg, "Memory allocation error.");
+        }
+    }
+
+    return partial;
+}
+
+/*
+ * Returns points with the aggregated values for each partial state.
+ * The result types are equal to the types returned by the aggregate run.
+ *
+ * Returns NULL in case an error has occurred. (err_msg is set)
+ */
+siridb_points_t * siridb_partial_finalize(
+        siridb_partial_t * partial,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    siridb_points_t * points;
+    siridb_pstate_t * state;
+    siridb_point_t * point;
+    size_t i;
+
+    switch (aggr->gid)
+    {
+    case CLERI_GID_F_PERCENTILE:
+        points = siridb_points_new(partial->len, TP_DOUBLE);
+        break;
+    case CLERI_GID_F_COUNT:
+    case CLERI_GID_F_DISTINCT:
+        points = siridb_points_new(partial->len, TP_INT);
+        break;
+    case CLERI_GID_F_MAX:
+    case CLERI_GID_F_MIN:
+    case CLERI_GID_F_SUM:
+        points = siridb_points_new(partial->len, partial->tp);
+        break;
+    default:
+        assert (0);
+        points = NULL;
+    }
+
+    if (points == NULL)
+    {
+        sprintf(err_msg, "Memory allocation error.");
+        return NULL;
+    }
+
+    for (i = 0; i < partial->len; i++)
+    {
+        state = partial->data + i;
+        point = points->data + i;
+        point->ts = state->ts;
+
+        switch (aggr->gid)
+        {
+        case CLERI_GID_F_COUNT:
+            point->val.int64 = (int64_t) state->n;
+            break;
+        case CLERI_GID_F_DISTINCT:
+            point->val.int64 = siridb_sketch_distinct(partial->sketches[i]);
+            break;
+        case CLERI_GID_F_MAX:
+            point->val = state->max;
+            break;
+        case CLERI_GID_F_MIN:
+            point->val = state->min;
+            break;
+        case CLERI_GID_F_PERCENTILE:
+            point->val.real = siridb_sketch_percentile(
+                    partial->sketches[i],
+                    aggr->percentile);
+            break;
+        case CLERI_GID_F_SUM:
+            point->val = state->sum;
+            break;
+        }
+    }
+
+    points->len = partial->len;
+    return points;
+}
+
+/*
+ * The sketches, if any, are packed in the same raw data after the states.
+ *
+ * Returns 0 when successful or -1 in case of an error.
+ */
+int siridb_partial_raw_pack(siridb_partial_t * partial, qp_packer_t * packer)
+{
+    size_t size = partial->len * sizeof(siridb_pstate_t);
+    unsigned char * data;
+    size_t i, sz;
+
+    if (partial->sketches != NULL)
+    {
+        for (i = 0; i < partial->len; i++)
+        {
+            size += siridb_sketch_size(partial->sketches[i]);
+        }
+    }
+
+    if (qp_add_type(packer, QP_ARRAY_OPEN) ||
+        qp_add_int64(packer, SIRIDB_PARTIAL_TP + (int64_t) partial->tp) ||
+        qp_add_int64(packer, (int64_t) partial->len) ||
+        qp_add_raw_alloc(packer, &data, size))
+    {
+        return -1;
+    }
+
+    sz = partial->len * sizeof(siridb_pstate_t);
+    memcpy(data, partial->data, sz);
+
+    if (partial->sketches != NULL)
+    {
+        for (i = 0; i < partial->len; i++)
+        {
+            data += sz;
+            sz = siridb_sketch_size(partial->sketches[i]);
+            memcpy(data, partial->sketches[i], sz);
+        }
+    }
+
+    return qp_add_type(packer, QP_ARRAY_CLOSE) ? -1 : 0;
+}
+
+/*
+ * Argument tp should be the received type without SIRIDB_PARTIAL_TP and
+ * aggr must be the aggregate for which the partial states are packed.
+ *
+ * Returns NULL in case the data is invalid or when an error has occurred.
+ */
+siridb_partial_t * siridb_partial_raw_unpack(
+        int64_t tp,
+        int64_t len,
+        qp_obj_t * qp_raw,
+        siridb_aggr_t * aggr)
+{
+    siridb_partial_t * partial;
+    size_t size = (size_t) len * sizeof(siridb_pstate_t);
+    int has_sketches = PARTIAL_IS_SKETCH(aggr->gid);
+
+    if ((tp != TP_INT && tp != TP_DOUBLE) ||
+        len < 0 ||
+        (has_sketches ? qp_raw->len < size : qp_raw->len != size))
+    {
+        return NULL;
+    }
+
+    partial = siridb_partial_new((size_t) len, (points_tp) tp);
+    if (partial == NULL || !len)
+    {
+        return partial;
+    }
+
+    memcpy(partial->data, qp_raw->via.raw, size);
+
+    if (!has_sketches)
+    {
+        partial->len = (size_t) len;
+    }
+    else if (PARTIAL_unpack_sketches(
+            partial,
+            (size_t) len,
+            qp_raw->via.raw + size,
+            qp_raw->len - size,
+            aggr->gid))
+    {
+        siridb_partial_free(partial);
+        return NULL;
+    }
+
+    return partial;
+}
+
+/*
+ * Returns NULL in case an error has occurred. (err_msg is set)
+ */
+static siridb_partial_t * PARTIAL_from_points(
+        siridb_points_t * points,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    siridb_partial_t * partial;
+    siridb_pstate_t * state;
+    siridb_point_t * point;
+    uint64_t max_sz;
+    uint64_t group_ts;
+    size_t start, end;
+
+    assert (points->len);
+
+    if (points->tp == TP_STRING)
+    {
+        sprintf(err_msg, "Cannot merge string and number series.");
+        return NULL;
+    }
+
+    if (aggr->group_by)
+    {
+        max_sz = ((points->data + points->len - 1)->ts - points->data->ts)
+                / aggr->group_by + 2;
+
+        if (max_sz > points->len)
+        {
+            max_sz = points->len;
+        }
+    }
+    else
+    {
+        max_sz = 1;
+    }
+
+    partial = siridb_partial_new(max_sz, points->tp);
+    if (partial != NULL && PARTIAL_IS_SKETCH(aggr->gid))
+    {
+        partial->sketches = calloc(max_sz, sizeof(siridb_sketch_t *));
+    }
+
+    if (partial == NULL ||
+        (PARTIAL_IS_SKETCH(aggr->gid) && partial->sketches == NULL))
+    {
+        sprintf(err_msg, "Memory allocation error.");
+        siridb_partial_free(partial);
+        return NULL;
+    }
+
+    if (!aggr->group_by)
+    {
+        state = partial->data;
+        state->ts = (points->data + points->len - 1)->ts;
+        if (PARTIAL_set_state(
+                state,
+                points->data,
+                points->len,
+                points->tp,
+                aggr->gid,
+                err_msg) ||
+            PARTIAL_set_sketch(
+                partial,
+                points->data,
+                points->len,
+                points->tp,
+                aggr->gid,
+                err_msg))
+        {
+            siridb_partial_free(partial);
+            return NULL;
+        }
+        partial->len = 1;
+        return partial;
+    }
+
+    point = points->data;
+    group_ts = PARTIAL_GROUP_TS(point);
+
+    for (start = end = 0; end <= points->len; end++)
+    {
+        point = points->data + end;
+        if (end < points->len && point->ts <= group_ts)
+        {
+            continue;
+        }
+
+        state = partial->data + partial->len;
+        state->ts = group_ts;
+        if (PARTIAL_set_state(
+                state,
+                points->data + start,
+                end - start,
+                points->tp,
+                aggr->gid,
+                err_msg) ||
+            PARTIAL_set_sketch(
+                partial,
+                points->data + start,
+                end - start,
+                points->tp,
+                aggr->gid,
+                err_msg))
+        {
+            siridb_partial_free(partial);
+            return NULL;
+        }
+        partial->len++;
+
+        if (end < points->len)
+        {
+            start = end;
+            group_ts = PARTIAL_GROUP_TS(point);
+        }
+    }
+
+    return partial;
+}
+
+/*
+ * Combine two partials into one. Both a and b are destroyed by this
+ * function and a may be NULL.
+ *
+ * Returns NULL in case an error has occurred. (err_msg is set)
+ */
+static siridb_partial_t * PARTIAL_combine(
+        siridb_partial_t * a,
+        siridb_partial_t * b,
+        siridb_aggr_t * aggr,
+        char * err_msg)
+{
+    siridb_partial_t * partial;
+    siridb_pstate_t * state;
+    siridb_sketch_t ** sketch;
+    size_t i, j, n;
+
+    if (a == NULL || !a->len)
+    {
+        siridb_partial_free(a);
+        return b;
+    }
+
+    if (!b->len)
+    {
+        siridb_partial_free(b);
+        return a;
+    }
+
+    /*
+     * When both series from type double and type integer are merged
+     * we need to promote the integer states to double.
+     */
+    if (a->tp != b->tp)
+    {
+        PARTIAL_to_double(a);
+        PARTIAL_to_double(b);
+    }
+
+    if ((a->sketches == NULL) != (b->sketches == NULL))
+    {
+        sprintf(err_msg, "Cannot combine partial states.");
+        siridb_partial_free(a);
+        siridb_partial_free(b);
+        return NULL;
+    }
+
+    if (!aggr->group_by)
+    {
+        /* without group by both have exactly one state */
+        if (PARTIAL_add_state(a->data, b->data, a->tp, aggr->gid, err_msg))
+        {
+            siridb_partial_free(a);
+            a = NULL;
+        }
+        else if (a->sketches != NULL)
+        {
+            siridb_sketch_merge(*a->sketches, *b->sketches);
+        }
+        siridb_partial_free(b);
+        return a;
+    }
+
+    partial = siridb_partial_new(a->len + b->len, a->tp);
+    if (partial == NULL || (a->sketches != NULL && (partial->sketches =
+            malloc((a->len + b->len) * sizeof(siridb_sketch_t *))) == NULL))
+    {
+        sprintf(err_msg, "Memory allocation error.");
+        siridb_partial_free(partial);
+        siridb_partial_free(a);
+        siridb_partial_free(b);
+        return NULL;
+    }
+
+    /*
+     * Sketches are moved to the new partial, so they are replaced with NULL
+     * in both a and b.
+     */
+    state = partial->data;
+    sketch = partial->sketches;
+
+    for (i = j = 0; i < a->len && j < b->len; state++)
+    {
+        if (a->data[i].ts < b->data[j].ts)
+        {
+            PARTIAL_MOVE(a, i)
+        }
+        else if (a->data[i].ts > b->data[j].ts)
+        {
+            PARTIAL_MOVE(b, j)
+        }
+        else
+        {
+            if (PARTIAL_add_state(
+                    a->data + i,
+                    b->data + j,
+                    a->tp,
+                    aggr->gid,
+                    err_msg))
+            {
+                partial->len = state - partial->data;
+                siridb_partial_free(partial);
+                partial = NULL;
+                goto done;
+            }
+            if (sketch != NULL)
+            {
+                siridb_sketch_merge(a->sketches[i], b->sketches[j]);
+            }
+            j++;
+            PARTIAL_MOVE(a, i)
+        }
+    }
+
+    n = a->len - i;
+    memcpy(state, a->data + i, n * sizeof(siridb_pstate_t));
+    state += n;
+    if (sketch != NULL)
+    {
+        memcpy(sketch, a->sketches + i, n * sizeof(siridb_sketch_t *));
+        memset(a->sketches + i, 0, n * sizeof(siridb_sketch_t *));
+        sketch += n;
+    }
+
+    n = b->len - j;
+    memcpy(state, b->data + j, n * sizeof(siridb_pstate_t));
+    state += n;
+    if (sketch != NULL)
+    {
+        memcpy(sketch, b->sketches + j, n * sizeof(siridb_sketch_t *));
+        memset(b->sketches + j, 0, n * sizeof(siridb_sketch_t *));
+    }
+
+    partial->len = state - partial->data;
+
+done:
+    siridb_partial_free(a);
+    siridb_partial_free(b);
+    return partial;
+}
+
+/*
+ * Set the state for a group of points. Only the fields required by the
+ * aggregate function are calculated.
+ *
+ * Returns 0 when successful or -1 in case of an error. (err_msg is set)
+ */
+static int PARTIAL_set_state(
+        siridb_pstate_t * state,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg)
+{
+    size_t i;
+
+    assert (n);
+
+    state->n = n;
+    state->sum.int64 = 0;
+    state->min.int64 = 0;
+    state->max.int64 = 0;
+
+    switch (gid)
+    {
+    case CLERI_GID_F_SUM:
+        if (tp == TP_INT)
+        {
+            int64_t sum = 0;
+            int64_t tmp;
+            for (i = 0; i < n; i++)
+            {
+                tmp = data[i].val.int64;
+                if ((tmp > 0 && sum > LLONG_MAX - tmp) ||
+                        (tmp < 0 && sum < LLONG_MIN - tmp))
+                {
+                    sprintf(err_msg, "Overflow detected while using sum().");
+                    return -1;
+                }
+                sum += tmp;
+            }
+            state->sum.int64 = sum;
+        }
+        else
+        {
+            double sum = 0.0;
+            for (i = 0; i < n; i++)
+            {
+                sum += data[i].val.real;
+            }
+            state->sum.real = sum;
+        }
+        break;
+
+    case CLERI_GID_F_MIN:
+        state->min = data->val;
+        for (i = 1; i < n; i++)
+        {
+            if ((tp == TP_INT)
+                    ? data[i].val.int64 < state->min.int64
+                    : data[i].val.real < state->min.real)
+            {
+                state->min = data[i].val;
+            }
+        }
+        break;
+
+    case CLERI_GID_F_MAX:
+        state->max = data->val;
+        for (i = 1; i < n; i++)
+        {
+            if ((tp == TP_INT)
+                    ? data[i].val.int64 > state->max.int64
+                    : data[i].val.real > state->max.real)
+            {
+                state->max = data[i].val;
+            }
+        }
+        break;
+    }
+
+    return 0;
+}
+
+/*
+ * Add state src to dst.
+ *
+ * Returns 0 when successful or -1 in case of an error. (err_msg is set)
+ */
+static int PARTIAL_add_state(
+        siridb_pstate_t * dst,
+        siridb_pstate_t * src,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg)
+{
+    uint64_t n = dst->n + src->n;
+
+    switch (gid)
+    {
+    case CLERI_GID_F_SUM:
+        if (tp == TP_INT)
+        {
+            int64_t tmp = src->sum.int64;
+            if ((tmp > 0 && dst->sum.int64 > LLONG_MAX - tmp) ||
+                    (tmp < 0 && dst->sum.int64 < LLONG_MIN - tmp))
+            {
+                sprintf(err_msg, "Overflow detected while using sum().");
+                return -1;
+            }
+            dst->sum.int64 += tmp;
+        }
+        else
+        {
+            dst->sum.real += src->sum.real;
+        }
+        break;
+
+    case CLERI_GID_F_MIN:
+        if ((tp == TP_INT)
+                ? src->min.int64 < dst->min.int64
+                : src->min.real < dst->min.real)
+        {
+            dst->min = src->min;
+        }
+        break;
+
+    case CLERI_GID_F_MAX:
+        if ((tp == TP_INT)
+                ? src->max.int64 > dst->max.int64
+                : src->max.real > dst->max.real)
+        {
+            dst->max = src->max;
+        }
+        break;
+    }
+
+    if (src->ts > dst->ts)
+    {
+        dst->ts = src->ts;
+    }
+
+    dst->n = n;
+    return 0;
+}
+
+/*
+ * Set the sketch for the next state in case the partial uses sketches.
+ *
+ * Returns 0 when successful or -1 in case of an error. (err_msg is set)
+ */
+static int PARTIAL_set_sketch(
+        siridb_partial_t * partial,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp,
+        uint32_t gid,
+        char * err_msg)
+{
+    siridb_sketch_t * sketch;
+
+    if (partial->sketches == NULL)
+    {
+        return 0;
+    }
+
+    sketch = siridb_sketch_new(PARTIAL_SKETCH_TP(gid));
+    if (sketch == NULL)
+    {
+        sprintf(err_msg, "Memory allocation error.");
+        return -1;
+    }
+
+    siridb_sketch_add(sketch, data, n, tp);
+    partial->sketches[partial->len] = sketch;
+
+    return 0;
+}
+
+/*
+ * Read one sketch for each state. All data must be used and the sketches
+ * must have the type which is used by the aggregate.
+ *
+ * Returns 0 when successful or -1 when the data is invalid or in case of an
+ * allocation error.
+ */
+static int PARTIAL_unpack_sketches(
+        siridb_partial_t * partial,
+        size_t len,
+        const unsigned char * data,
+        size_t size,
+        uint32_t gid)
+{
+    siridb_sketch_t * sketch;
+    size_t consumed;
+
+    partial->sketches = malloc(len * sizeof(siridb_sketch_t *));
+    if (partial->sketches == NULL)
+    {
+        return -1;
+    }
+
+    for (; partial->len < len; partial->len++)
+    {
+        sketch = siridb_sketch_unpack(data, size, &consumed);
+        if (sketch == NULL)
+        {
+            return -1;
+        }
+
+        partial->sketches[partial->len] = sketch;
+
+        if (sketch->tp != PARTIAL_SKETCH_TP(gid))
+        {
+            partial->len++;
+            return -1;
+        }
+
+        data += consumed;
+        size -= consumed;
+    }
+
+    return size ? -1 : 0;
+}
+
+static void PARTIAL_to_double(siridb_partial_t * partial)
+{
+    size_t i;
+    siridb_pstate_t * state;
+
+    if (partial->tp != TP_INT)
+    {
+        return;
+    }
+
+    for (i = 0; i < partial->len; i++)
+    {
+        state = partial->data + i;
+        state->sum.real = (double) state->sum.int64;
+        state->min.real = (double) state->min.int64;
+        state->max.real = (double) state->max.int64;
+    }
+
+    partial->tp = TP_DOUBLE;
+}
+
+/*
+ * Returns 1 when at least one of the raw points or partial states has
+ * floating point values.
+ */
+static int PARTIAL_has_double(vec_t * plist, vec_t * partials)
+{
+    size_t i;
+
+    for (i = 0; i < plist->len; i++)
+    {
+        siridb_points_t * points = (siridb_points_t *) plist->data[i];
+        if (points->len && points->tp == TP_DOUBLE)
+        {
+            return 1;
+        }
+    }
+
+    for (i = 0; i < partials->len; i++)
+    {
+        if (((siridb_partial_t *) partials->data[i])->tp == TP_DOUBLE)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
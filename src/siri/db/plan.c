@@ -0,0 +1,351 @@
+/*
+ * plan.c - Binary plan for forwarding select queries to pools.
+ */
+#include <logger/logger.h>
+#include <siri/db/aggregate.h>
+#include <siri/db/plan.h>
+#include <siri/err.h>
+#include <siri/version.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLAN_PACKER_SIZE 256
+
+static void PLAN_method_free(siridb_plan_method_t * method);
+static siridb_plan_method_t * PLAN_method_unpack(qp_unpacker_t * unpacker);
+static char * PLAN_strndup(qp_obj_t * qp_obj);
+
+/*
+ * Returns a new plan or NULL in case of an allocation error.
+ *
+ * A new plan is used by the master server to collect the series names and
+ * methods while walking a select query.
+ */
+siridb_plan_t * siridb_plan_new(void)
+{
+    siridb_plan_t * plan = calloc(1, sizeof(siridb_plan_t));
+    if (plan == NULL)
+    {
+        return NULL;
+    }
+
+    plan->series = vec_new(VEC_DEFAULT_SIZE);
+    plan->packer = qp_packer_new(PLAN_PACKER_SIZE);
+
+    if (plan->series == NULL ||
+        plan->packer == NULL ||
+        qp_add_type(plan->packer, QP_ARRAY_OPEN))
+    {
+        siridb_plan_free(plan);
+        return NULL;
+    }
+
+    return plan;
+}
+
+/*
+ * Destroy a plan. (parsing NULL is allowed)
+ */
+void siridb_plan_free(siridb_plan_t * plan)
+{
+    if (plan == NULL)
+    {
+        return;
+    }
+    vec_destroy(plan->series, free);
+    vec_destroy(plan->methods, (vec_destroy_cb) PLAN_method_free);
+    if (plan->mlist != NULL)
+    {
+        siridb_aggregate_list_free(plan->mlist);
+    }
+    if (plan->packer != NULL)
+    {
+        qp_packer_free(plan->packer);
+    }
+    free(plan->merge_as);
+    free(plan);
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_plan_add_series(siridb_plan_t * plan, const char * name)
+{
+    char * s = strdup(name);
+    if (s == NULL || vec_append_safe(&plan->series, s))
+    {
+        free(s);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Add a select method with the last prefix-suffix and the aggregation list.
+ *
+ * Returns 0 if successful, 1 when the method cannot be packed in which case
+ * the plan should not be used, or -1 in case of an allocation error.
+ */
+int siridb_plan_add_method(
+        siridb_plan_t * plan,
+        siridb_presuf_t * presuf,
+        vec_t * alist)
+{
+    size_t len = plan->packer->len;
+    int rc;
+
+    if (qp_add_type(plan->packer, QP_ARRAY3) ||
+        (presuf->prefix == NULL ?
+            qp_add_null(plan->packer) :
+            qp_add_string(plan->packer, presuf->prefix)) ||
+        (presuf->suffix == NULL ?
+            qp_add_null(plan->packer) :
+            qp_add_string(plan->packer, presuf->suffix)))
+    {
+        return -1;
+    }
+
+    rc = siridb_aggregate_list_pack(alist, plan->packer);
+    if (rc)
+    {
+        /* restore the packer so the method is not included */
+        plan->packer->len = len;
+        return rc;
+    }
+
+    plan->n++;
+    return 0;
+}
+
+/*
+ * Returns a packer with the plan which can be added to the forwarded query
+ * as raw data, or NULL when the plan cannot be packed. In the latter case
+ * the pools simply use the query text.
+ */
+qp_packer_t * siridb_plan_pack(
+        siridb_plan_t * plan,
+        int flags,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        ssize_t headtail,
+        const char * merge_as,
+        vec_t * mlist)
+{
+    qp_packer_t * packer;
+    size_t i;
+    int rc;
+
+    if (plan->packer == NULL || !plan->n)
+    {
+        return NULL;
+    }
+
+    packer = qp_packer_new(plan->packer->len + PLAN_PACKER_SIZE);
+    if (packer == NULL)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    if (start_ts != NULL)
+    {
+        flags |= SIRIDB_PLAN_FLAG_START_TS;
+    }
+
+    if (end_ts != NULL)
+    {
+        flags |= SIRIDB_PLAN_FLAG_END_TS;
+    }
+
+    rc = (
+        qp_add_type(packer, QP_ARRAY_OPEN) ||
+        qp_add_string(packer, SIRIDB_VERSION) ||
+        qp_add_int64(packer, flags) ||
+        qp_add_int64(packer, (start_ts == NULL) ? 0 : (int64_t) *start_ts) ||
+        qp_add_int64(packer, (end_ts == NULL) ? 0 : (int64_t) *end_ts) ||
+        qp_add_int64(packer, headtail) ||
+        ((merge_as == NULL) ?
+            qp_add_null(packer) : qp_add_string(packer, merge_as)));
+
+    if (!rc)
+    {
+        rc = (mlist == NULL) ?
+                qp_add_null(packer) : siridb_aggregate_list_pack(mlist, packer);
+    }
+
+    if (!rc)
+    {
+        rc = qp_add_type(packer, QP_ARRAY_OPEN);
+        for (i = 0; !rc && i < plan->series->len; i++)
+        {
+            rc = qp_add_string(packer, plan->series->data[i]);
+        }
+        rc = rc ||
+            qp_add_type(packer, QP_ARRAY_CLOSE) ||
+            qp_packer_extend(packer, plan->packer) ||
+            qp_add_type(packer, QP_ARRAY_CLOSE) ||
+            qp_add_type(packer, QP_ARRAY_CLOSE);
+    }
+
+    if (rc)
+    {
+        if (rc < 0)
+        {
+            log_error("Error while packing the select plan");
+        }
+        qp_packer_free(packer);
+        return NULL;
+    }
+
+    return packer;
+}
+
+/*
+ * Returns a plan from raw data or NULL when the data is not valid or when
+ * the plan is created by a server running another version. (a different
+ * version may use other grammar identifiers for the aggregation methods)
+ */
+siridb_plan_t * siridb_plan_unpack(unsigned char * data, size_t len)
+{
+    siridb_plan_t * plan;
+    siridb_plan_method_t * method;
+    qp_unpacker_t unpacker;
+    qp_obj_t qp_version, qp_flags, qp_start, qp_end, qp_headtail, qp_obj;
+    qp_types_t tp;
+    char * name;
+
+    qp_unpacker_init(&unpacker, data, len);
+
+    if (qp_next(&unpacker, NULL) != QP_ARRAY_OPEN ||
+        qp_next(&unpacker, &qp_version) != QP_RAW ||
+        qp_version.len != strlen(SIRIDB_VERSION) ||
+        memcmp(qp_version.via.raw, SIRIDB_VERSION, qp_version.len) ||
+        !qp_is_int(qp_next(&unpacker, &qp_flags)) ||
+        !qp_is_int(qp_next(&unpacker, &qp_start)) ||
+        !qp_is_int(qp_next(&unpacker, &qp_end)) ||
+        !qp_is_int(qp_next(&unpacker, &qp_headtail)) ||
+        (plan = calloc(1, sizeof(siridb_plan_t))) == NULL)
+    {
+        return NULL;
+    }
+
+    plan->flags = (int) qp_flags.via.int64;
+    plan->start_ts = (uint64_t) qp_start.via.int64;
+    plan->end_ts = (uint64_t) qp_end.via.int64;
+    plan->headtail = (ssize_t) qp_headtail.via.int64;
+
+    tp = qp_next(&unpacker, &qp_obj);
+    if (tp == QP_RAW)
+    {
+        if ((plan->merge_as = PLAN_strndup(&qp_obj)) == NULL)
+        {
+            goto failed;
+        }
+    }
+    else if (tp != QP_NULL)
+    {
+        goto failed;
+    }
+
+    if (qp_current(&unpacker) == QP_NULL)
+    {
+        qp_next(&unpacker, NULL);
+    }
+    else if ((plan->mlist = siridb_aggregate_list_unpack(&unpacker)) == NULL)
+    {
+        goto failed;
+    }
+
+    if (qp_next(&unpacker, NULL) != QP_ARRAY_OPEN ||
+        (plan->series = vec_new(VEC_DEFAULT_SIZE)) == NULL)
+    {
+        goto failed;
+    }
+
+    while ((tp = qp_next(&unpacker, &qp_obj)) == QP_RAW)
+    {
+        if ((name = PLAN_strndup(&qp_obj)) == NULL ||
+            vec_append_safe(&plan->series, name))
+        {
+            free(name);
+            goto failed;
+        }
+    }
+
+    if (tp != QP_ARRAY_CLOSE ||
+        qp_next(&unpacker, NULL) != QP_ARRAY_OPEN ||
+        (plan->methods = vec_new(VEC_DEFAULT_SIZE)) == NULL)
+    {
+        goto failed;
+    }
+
+    while (qp_current(&unpacker) == QP_ARRAY3)
+    {
+        if ((method = PLAN_method_unpack(&unpacker)) == NULL ||
+            vec_append_safe(&plan->methods, method))
+        {
+            if (method != NULL)
+            {
+                PLAN_method_free(method);
+            }
+            goto failed;
+        }
+    }
+
+    if (qp_next(&unpacker, NULL) != QP_ARRAY_CLOSE || !plan->methods->len)
+    {
+        goto failed;
+    }
+
+    return plan;
+
+failed:
+    siridb_plan_free(plan);
+    return NULL;
+}
+
+static void PLAN_method_free(siridb_plan_method_t * method)
+{
+    free(method->prefix);
+    free(method->suffix);
+    if (method->alist != NULL)
+    {
+        siridb_aggregate_list_free(method->alist);
+    }
+    free(method);
+}
+
+/*
+ * Returns NULL when the method is not valid or in case of an allocation
+ * error.
+ */
+static siridb_plan_method_t * PLAN_method_unpack(qp_unpacker_t * unpacker)
+{
+    qp_obj_t qp_prefix, qp_suffix;
+    siridb_plan_method_t * method;
+
+    if (qp_next(unpacker, NULL) != QP_ARRAY3 ||
+        (qp_next(unpacker, &qp_prefix) != QP_RAW && qp_prefix.tp != QP_NULL) ||
+        (qp_next(unpacker, &qp_suffix) != QP_RAW && qp_suffix.tp != QP_NULL) ||
+        (method = calloc(1, sizeof(siridb_plan_method_t))) == NULL)
+    {
+        return NULL;
+    }
+
+    if ((qp_prefix.tp == QP_RAW &&
+            (method->prefix = PLAN_strndup(&qp_prefix)) == NULL) ||
+        (qp_suffix.tp == QP_RAW &&
+            (method->suffix = PLAN_strndup(&qp_suffix)) == NULL) ||
+        (method->alist = siridb_aggregate_list_unpack(unpacker)) == NULL)
+    {
+        PLAN_method_free(method);
+        return NULL;
+    }
+
+    return method;
+}
+
+static char * PLAN_strndup(qp_obj_t * qp_obj)
+{
+    return strndup((const char *) qp_obj->via.raw, qp_obj->len);
+}
@@ -1,6 +1,7 @@
 /*
  * points.c - Array object for points.
  */
+#include <siri/db/db.h>
 #include <siri/db/points.h>
 #include <logger/logger.h>
 #include <stdlib.h>
@@ -17,6 +18,35 @@
 #define DICT_SZ 0x3fff
 #define TOLERANCE_INTERVAL_DETECT 10
 
+/* worst case bits for a bit-packed double; 68 for time and 77 for value */
+#define BITPACK_DOUBLE_MAX_BITS 145
+
+/* number of points in a frame-of-reference block for bit-packed integers */
+#define BITPACK_BLOCK_SZ 64
+
+/* worst case block size; width + 64bit reference (varint) + data */
+#define BITPACK_BLOCK_MAX_SZ (1 + 10 + BITPACK_BLOCK_SZ * 8)
+
+typedef struct
+{
+    unsigned char * pt;
+    uint8_t nbits;      /* bits used in the current byte */
+} POINTS_bits_t;
+
+/*
+ * Hash table with recent positions for string compression. Each call to
+ * siridb_points_zip_string() uses its own table which makes compression
+ * safe to use from multiple threads.
+ */
+typedef struct
+{
+    uint32_t mask;
+    uint32_t * offsets;     /* position in the source + 1, 0 when unused */
+} POINTS_dict_t;
+
+/* lowered to SSE/AVX or NEON by the compiler, scalar code otherwise */
+typedef uint64_t POINTS_v4u64_t __attribute__ ((vector_size (32)));
+
 static unsigned char * POINTS_zip_raw(
         siridb_points_t * points,
         uint_fast32_t start,
@@ -47,6 +77,7 @@ static void POINTS_output_match(
         uint8_t ** out,
         uint8_t is_ascii);
 static void POINTS_zip_str(
+        POINTS_dict_t * dict,
         uint8_t ** out,
         uint8_t ** pt,
         uint8_t * src,
@@ -54,16 +85,41 @@ static void POINTS_zip_str(
         size_t n,
         uint8_t is_ascii);
 static int POINTS_set_cinfo_size(uint16_t * cinfo, size_t * size);
+static inline void POINTS_put_bits(
+        POINTS_bits_t * b,
+        uint64_t val,
+        uint8_t n);
+static inline uint64_t POINTS_get_bits(POINTS_bits_t * b, uint8_t n);
+static void POINTS_put_dod(POINTS_bits_t * b, int64_t dod);
+static int64_t POINTS_get_dod(POINTS_bits_t * b);
+static int POINTS_set_cinfo_bitpack(uint16_t * cinfo, size_t * size);
+static void POINTS_unzip_double_bits(
+        siridb_points_t * points,
+        unsigned char * bits,
+        uint16_t len,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        uint8_t has_overlap);
+static unsigned char * POINTS_pack_block(
+        unsigned char * pt,
+        uint64_t * u,
+        uint_fast32_t n);
+static unsigned char * POINTS_unpack_block(
+        unsigned char * pt,
+        unsigned char * end,
+        uint64_t * u,
+        uint_fast32_t n);
+static void POINTS_unzip_int_bits(
+        siridb_points_t * points,
+        unsigned char * bits,
+        uint16_t len,
+        uint16_t cinfo,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        uint8_t has_overlap);
 inline static uint16_t POINTS_hash(uint32_t h);
 static void POINTS_destroy(siridb_points_t * points);
 
-static uint8_t * dictionary[DICT_SZ + 1];
-
-void siridb_points_init(void)
-{
-    memset(dictionary, 0, sizeof(dictionary));
-}
-
 /*
  * Returns NULL in case an error has occurred.
  */
@@ -287,6 +343,67 @@ int siridb_points_pack(siridb_points_t * points, qp_packer_t * packer)
     return siri_err;
 }
 
+/*
+ * Pack points as columns: [tp, timestamps, values]
+ *
+ * The time-stamps are packed as one raw value with a 64-bit unsigned
+ * integer for each point and the values of integer and float series are
+ * packed the same way with a signed integer or double for each point. Like
+ * all other qpack numbers they use little-endian byte order. The values of
+ * string series are packed as an array of strings.
+ *
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+int siridb_points_pack_columns(siridb_points_t * points, qp_packer_t * packer)
+{
+    size_t i, size = points->len * sizeof(uint64_t);
+    siridb_point_t * point;
+    unsigned char * data;
+
+    if (qp_add_type(packer, QP_ARRAY3) ||
+        qp_add_int64(packer, (int64_t) points->tp) ||
+        qp_add_raw_alloc(packer, &data, size))
+    {
+        return -1;
+    }
+
+    for (i = 0, point = points->data; i < points->len; i++, point++)
+    {
+        memcpy(data, &point->ts, sizeof(uint64_t));
+        data += sizeof(uint64_t);
+    }
+
+    if (points->tp == TP_STRING)
+    {
+        if (qp_add_type(packer, QP_ARRAY_OPEN))
+        {
+            return -1;
+        }
+        for (i = 0, point = points->data; i < points->len; i++, point++)
+        {
+            if (qp_add_string(packer, point->val.str))
+            {
+                return -1;
+            }
+        }
+        return qp_add_type(packer, QP_ARRAY_CLOSE);
+    }
+
+    if (qp_add_raw_alloc(packer, &data, size))
+    {
+        return -1;
+    }
+
+    for (i = 0, point = points->data; i < points->len; i++, point++)
+    {
+        /* int64 and double have the same size */
+        memcpy(data, &point->val, sizeof(uint64_t));
+        data += sizeof(uint64_t);
+    }
+
+    return 0;
+}
+
 void siridb_points_ts_correction(siridb_points_t * points, double factor)
 {
     siridb_point_t * point = points->data;
@@ -330,6 +447,190 @@ int siridb_points_raw_pack(siridb_points_t * points, qp_packer_t * packer)
     return rc;
 }
 
+/*
+ * Pack points like siridb_points_raw_pack() but with numeric points
+ * compressed in chunks of at most POINTS_ZIP_CHUNK points, using the same
+ * codec as the database uses for shards. The type is increased with
+ * POINTS_ZIP_TP so the receiver knows the data is compressed.
+ *
+ * Each chunk starts with the number of points and the cinfo, both as
+ * little-endian uint16. The size of the chunk data follows from these two
+ * values. When compression does not reduce the size, or for strings, the
+ * points are packed like siridb_points_raw_pack() does.
+ *
+ * Returns 0 if successful or -1 and a SIGNAL is raised in case of an error.
+ */
+int siridb_points_zip_pack(
+        siridb_points_t * points,
+        qp_packer_t * packer,
+        uint8_t codec)
+{
+    size_t size, dsize, raw_size = points->len * sizeof(siridb_point_t);
+    uint_fast32_t start, end;
+    unsigned char * data, * pt, * cdata;
+    uint16_t cinfo, n;
+    int rc;
+
+    if (points->tp == TP_STRING || points->len < POINTS_ZIP_THRESHOLD)
+    {
+        return siridb_points_raw_pack(points, packer);
+    }
+
+    /* a chunk is never larger than the raw points plus header */
+    size = raw_size + (points->len / POINTS_ZIP_CHUNK + 1) * 28;
+    data = malloc(size);
+    if (data == NULL)
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
+    for (pt = data, start = 0; start < points->len; start = end)
+    {
+        end = start + POINTS_ZIP_CHUNK;
+        if (end > points->len)
+        {
+            end = points->len;
+        }
+
+        if (points->tp == TP_DOUBLE && codec != SIRIDB_CODEC_DEFAULT)
+        {
+            cdata = siridb_points_zip_double_bits(
+                    points, start, end, &cinfo, &dsize);
+        }
+        else if (points->tp == TP_INT && codec == SIRIDB_CODEC_BITPACK)
+        {
+            cdata = siridb_points_zip_int_bits(
+                    points, start, end, &cinfo, &dsize);
+        }
+        else
+        {
+            cdata = siridb_points_zip(points, start, end, &cinfo, &dsize);
+        }
+
+        if (cdata == NULL)
+        {
+            free(data);
+            ERR_ALLOC
+            return -1;
+        }
+
+        assert (dsize == siridb_points_get_size_zipped(cinfo, end - start));
+        assert (pt + 4 + dsize <= data + size);
+
+        n = (uint16_t) (end - start);
+        memcpy(pt, &n, sizeof(uint16_t));
+        pt += sizeof(uint16_t);
+        memcpy(pt, &cinfo, sizeof(uint16_t));
+        pt += sizeof(uint16_t);
+        memcpy(pt, cdata, dsize);
+        pt += dsize;
+
+        free(cdata);
+    }
+
+    size = pt - data;
+    if (size >= raw_size)
+    {
+        free(data);
+        return siridb_points_raw_pack(points, packer);
+    }
+
+    rc = -(qp_add_type(packer, QP_ARRAY_OPEN) ||
+            qp_add_int64(packer, (int64_t) points->tp + POINTS_ZIP_TP) ||
+            qp_add_int64(packer, (int64_t) points->len) ||
+            qp_add_raw(packer, data, size) ||
+            qp_add_type(packer, QP_ARRAY_CLOSE));
+
+    free(data);
+
+    return rc;
+}
+
+/*
+ * Returns new points from data packed by siridb_points_raw_pack() or
+ * siridb_points_zip_pack(), or NULL in case of an allocation error or when
+ * the data is not valid. Argument tp is the received type which might
+ * include POINTS_ZIP_TP.
+ */
+siridb_points_t * siridb_points_raw_unpack(
+        int64_t tp,
+        int64_t len,
+        unsigned char * data,
+        size_t size)
+{
+    siridb_points_t * points;
+    unsigned char * pt, * end = data + size;
+    uint16_t n, cinfo;
+    size_t csize;
+    int is_zip = tp >= POINTS_ZIP_TP;
+
+    tp -= is_zip ? POINTS_ZIP_TP : 0;
+
+    if (tp < TP_INT || tp > TP_STRING || len < 0 ||
+        (is_zip && tp == TP_STRING) ||
+        (points = siridb_points_new((size_t) len, (points_tp) tp)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (tp == TP_STRING)
+    {
+        if ((len < POINTS_ZIP_THRESHOLD)
+                ? siridb_points_unzip_string_raw(points, data, len)
+                : siridb_points_unzip_string(points, data, len, NULL, NULL, 0))
+        {
+            siridb_points_free(points);
+            return NULL;
+        }
+        return points;
+    }
+
+    if (!is_zip)
+    {
+        if (size != (size_t) len * sizeof(siridb_point_t))
+        {
+            siridb_points_free(points);
+            return NULL;
+        }
+        points->len = len;
+        memcpy(points->data, data, size);
+        return points;
+    }
+
+    for (pt = data; end - pt >= 4; pt += csize)
+    {
+        memcpy(&n, pt, sizeof(uint16_t));
+        pt += sizeof(uint16_t);
+        memcpy(&cinfo, pt, sizeof(uint16_t));
+        pt += sizeof(uint16_t);
+
+        csize = siridb_points_get_size_zipped(cinfo, n);
+
+        if (!n || n > (size_t) len - points->len || csize > (size_t) (end - pt))
+        {
+            break;
+        }
+
+        if (tp == TP_INT)
+        {
+            siridb_points_unzip_int(points, pt, n, cinfo, NULL, NULL, 0);
+        }
+        else
+        {
+            siridb_points_unzip_double(points, pt, n, cinfo, NULL, NULL, 0);
+        }
+    }
+
+    if (pt != end || points->len != (size_t) len)
+    {
+        siridb_points_free(points);
+        return NULL;
+    }
+
+    return points;
+}
+
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
  * (err_msg is set when an error has occurred)
@@ -596,6 +897,7 @@ unsigned char * siridb_points_zip_string(
     uint64_t tdiff = 0;
     uint8_t * src, * out, * pt, * spt, * sout;
     uint64_t mask;
+    POINTS_dict_t dict;
     size_t sz, m = n, i = end - 2;
     uint32_t sz_src = 0;
     siridb_point_t * point = points->data + i;
@@ -637,9 +939,15 @@ unsigned char * siridb_points_zip_string(
     /* calculate time-stamps size */
     sz = 13 + shift + tinfo*(n - 2);
 
+    /* small chunks do not need the complete hash table */
+    for (dict.mask = 0xff;
+         dict.mask < sz_src && dict.mask < DICT_SZ;
+         dict.mask = (dict.mask << 1) | 1);
+
+    dict.offsets = calloc(dict.mask + 1, sizeof(uint32_t));
     src = malloc(sz_src);
     out = malloc(sz + sz_src + (is_ascii ? 0 : (n * 8)));
-    if (src == NULL || out == NULL)
+    if (dict.offsets == NULL || src == NULL || out == NULL)
     {
         goto failed;
     }
@@ -654,7 +962,8 @@ unsigned char * siridb_points_zip_string(
     memcpy(pt, &point->ts, sizeof(uint64_t));
     pt += sizeof(uint64_t);
 
-    POINTS_zip_str(&sout, &spt, src, point->val.raw, sizes[m++], is_ascii);
+    POINTS_zip_str(
+            &dict, &sout, &spt, src, point->val.raw, sizes[m++], is_ascii);
 
     for (; shift-- > tinfo; ++pt)
     {
@@ -670,7 +979,8 @@ unsigned char * siridb_points_zip_string(
             *pt = ts >> (shift * 8);
         }
 
-        POINTS_zip_str(&sout, &spt, src, point->val.raw, sizes[m++], is_ascii);
+        POINTS_zip_str(
+                &dict, &sout, &spt, src, point->val.raw, sizes[m++], is_ascii);
     }
     sz = *size = sout - out;
 
@@ -696,11 +1006,13 @@ unsigned char * siridb_points_zip_string(
         }
     }
 
+    free(dict.offsets);
     free(sizes);
     free(src);
     return out;
 
 failed:
+    free(dict.offsets);
     free(sizes);
     free(src);
     free(out);
@@ -811,7 +1123,7 @@ unsigned char * siridb_points_zip_double(
     uint8_t vcount = 0;
     uint8_t vstore = 0;
     uint8_t shift = 0;
-    int vshift[RAW_VALUES_THRESHOLD];
+    int vshift[sizeof(uint64_t)];   /* one for each value byte */
     unsigned char * bits, *pt;
     int * pshift;
 
@@ -887,6 +1199,200 @@ unsigned char * siridb_points_zip_double(
     return bits;
 }
 
+/*
+ * Compress doubles using delta-of-delta time-stamps and XOR encoded values
+ * with leading and trailing zero compression (Gorilla).
+ *
+ * The chunk falls back to the byte codec (siridb_points_zip_double) when
+ * the result would be larger or when the size cannot be stored in cinfo.
+ *
+ * Return NULL in case an error has occurred.
+ */
+unsigned char * siridb_points_zip_double_bits(
+        siridb_points_t * points,
+        uint_fast32_t start,
+        uint_fast32_t end,
+        uint16_t * cinfo,
+        size_t * size)
+{
+    if (end - start < POINTS_ZIP_THRESHOLD)
+    {
+        return POINTS_zip_raw(points, start, end, cinfo, size);
+    }
+    POINTS_bits_t b;
+    siridb_point_t * point = points->data + start;
+    uint64_t ts = point->ts;
+    uint64_t val = point->val.uint64;
+    uint64_t delta = 0, tmp, xor;
+    uint8_t lead = 64, trail = 0, l, t;
+    unsigned char * bits, * zbits;
+    uint16_t zcinfo;
+    size_t zsize;
+    uint_fast32_t i;
+
+    zbits = siridb_points_zip_double(points, start, end, &zcinfo, &zsize);
+    if (zbits == NULL)
+    {
+        return NULL;
+    }
+
+    /* extra 63 bytes since large sizes are rounded up to blocks of 64 */
+    *size = 16 + ((end - start - 1) * BITPACK_DOUBLE_MAX_BITS + 7) / 8 + 63;
+    bits = calloc(*size, 1);
+    if (bits == NULL)
+    {
+        free(zbits);
+        return NULL;
+    }
+
+    memcpy(bits, &ts, sizeof(uint64_t));
+    memcpy(bits + sizeof(uint64_t), &val, sizeof(uint64_t));
+
+    b.pt = bits + 16;
+    b.nbits = 0;
+
+    for (i = start + 1; i < end; ++i)
+    {
+        ++point;
+
+        tmp = point->ts - ts;
+        POINTS_put_dod(&b, (int64_t) (tmp - delta));
+        delta = tmp;
+        ts = point->ts;
+
+        xor = point->val.uint64 ^ val;
+        val = point->val.uint64;
+
+        if (xor == 0)
+        {
+            POINTS_put_bits(&b, 0, 1);
+            continue;
+        }
+
+        l = __builtin_clzll(xor);
+        t = __builtin_ctzll(xor);
+
+        if (lead != 64 && l >= lead && t >= trail)
+        {
+            /* fits in the previous meaningful bits */
+            POINTS_put_bits(&b, 0x2, 2);
+            POINTS_put_bits(&b, xor >> trail, 64 - lead - trail);
+            continue;
+        }
+
+        lead = l > 31 ? 31 : l;
+        trail = t;
+
+        POINTS_put_bits(&b, 0x3, 2);
+        POINTS_put_bits(&b, lead, 5);
+        POINTS_put_bits(&b, (64 - lead - trail) & 0x3f, 6);
+        POINTS_put_bits(&b, xor >> trail, 64 - lead - trail);
+    }
+
+    *size = (b.pt - bits) + !!b.nbits;
+
+    if (POINTS_set_cinfo_bitpack(cinfo, size) || *size >= zsize)
+    {
+        free(bits);
+        *cinfo = zcinfo;
+        *size = zsize;
+        return zbits;
+    }
+
+    free(zbits);
+    return bits;
+}
+
+/*
+ * Compress integers using zigzag encoded delta-of-delta values for both
+ * time-stamps and values. The values are bit-packed in blocks of 64 points
+ * using a frame-of-reference so a single large value only affects the width
+ * of one block.
+ *
+ * The chunk falls back to the byte codec (siridb_points_zip_int) when the
+ * result would be larger or when the size cannot be stored in cinfo.
+ *
+ * Return NULL in case an error has occurred.
+ */
+unsigned char * siridb_points_zip_int_bits(
+        siridb_points_t * points,
+        uint_fast32_t start,
+        uint_fast32_t end,
+        uint16_t * cinfo,
+        size_t * size)
+{
+    if (end - start < POINTS_ZIP_THRESHOLD)
+    {
+        return POINTS_zip_raw(points, start, end, cinfo, size);
+    }
+    uint64_t tblock[BITPACK_BLOCK_SZ];
+    uint64_t vblock[BITPACK_BLOCK_SZ];
+    uint64_t tdelta = 0, vdelta = 0, tmp;
+    int64_t dod;
+    siridb_point_t * point = points->data + start;
+    unsigned char * bits, * zbits, * pt;
+    uint_fast32_t i, n, nblocks = (end - start - 2) / BITPACK_BLOCK_SZ + 1;
+    uint16_t zcinfo;
+    size_t zsize;
+
+    zbits = siridb_points_zip_int(points, start, end, &zcinfo, &zsize);
+    if (zbits == NULL)
+    {
+        return NULL;
+    }
+
+    /* extra 63 bytes since large sizes are rounded up to blocks of 64 */
+    *size = 16 + nblocks * 2 * BITPACK_BLOCK_MAX_SZ + 63;
+    bits = malloc(*size);
+    if (bits == NULL)
+    {
+        free(zbits);
+        return NULL;
+    }
+
+    memcpy(bits, &point->ts, sizeof(uint64_t));
+    memcpy(bits + sizeof(uint64_t), &point->val.uint64, sizeof(uint64_t));
+    pt = bits + 16;
+
+    for (i = start + 1, n = 0; i < end; ++i)
+    {
+        ++point;
+
+        tmp = point->ts - (point - 1)->ts;
+        dod = (int64_t) (tmp - tdelta);
+        tdelta = tmp;
+        tblock[n] = ((uint64_t) dod << 1) ^ (uint64_t) (dod >> 63);
+
+        tmp = point->val.uint64 - (point - 1)->val.uint64;
+        dod = (int64_t) (tmp - vdelta);
+        vdelta = tmp;
+        vblock[n] = ((uint64_t) dod << 1) ^ (uint64_t) (dod >> 63);
+
+        if (++n == BITPACK_BLOCK_SZ || i == end - 1)
+        {
+            pt = POINTS_pack_block(pt, tblock, n);
+            pt = POINTS_pack_block(pt, vblock, n);
+            n = 0;
+        }
+    }
+
+    *size = pt - bits;
+
+    if (POINTS_set_cinfo_bitpack(cinfo, size) || *size >= zsize)
+    {
+        free(bits);
+        *cinfo = zcinfo;
+        *size = zsize;
+        return zbits;
+    }
+
+    /* the size might be rounded up */
+    memset(pt, 0, *size - (pt - bits));
+
+    free(zbits);
+    return bits;
+}
+
 void siridb_points_unzip_int(
         siridb_points_t * points,
         unsigned char * bits,
@@ -901,6 +1407,11 @@ void siridb_points_unzip_int(
         return POINTS_unzip_raw(
                 points, bits, len, start_ts, end_ts, has_overlap);
     }
+    if ((cinfo & 0xf) == POINTS_CINFO_BITPACK)
+    {
+        return POINTS_unzip_int_bits(
+                points, bits, len, cinfo, start_ts, end_ts, has_overlap);
+    }
     uint8_t vstore, tcount, tshift, j;
     uint64_t ts, tmp, mask;
     int64_t val;
@@ -994,7 +1505,12 @@ void siridb_points_unzip_double(
         return POINTS_unzip_raw(
                 points, bits, len, start_ts, end_ts, has_overlap);
     }
-    int vshift[RAW_VALUES_THRESHOLD];
+    if ((cinfo & 0xf) == POINTS_CINFO_BITPACK)
+    {
+        return POINTS_unzip_double_bits(
+                points, bits, len, start_ts, end_ts, has_overlap);
+    }
+    int vshift[sizeof(uint64_t)];   /* one for each value byte */
     int * pshift;
     uint8_t vstore, tcount, tshift;
     size_t i, c, j;
@@ -1305,6 +1821,11 @@ size_t siridb_points_get_size_zipped(uint16_t cinfo, uint16_t len)
     {
         return len * 16;
     }
+    if ((cinfo & 0xf) == POINTS_CINFO_BITPACK)
+    {
+        size_t v = cinfo >> 4;
+        return v & 0x800 ? (v & 0x7ff) << 6 : v;
+    }
     uint8_t vcount = 0;
     uint8_t vstore = cinfo >> 8;
     uint8_t tcount = cinfo & 0xf;
@@ -1675,6 +2196,7 @@ static void POINTS_output_match(
 }
 
 static void POINTS_zip_str(
+        POINTS_dict_t * dict,
         uint8_t ** out,
         uint8_t ** pt,
         uint8_t * src,
@@ -1690,10 +2212,11 @@ static void POINTS_zip_str(
     while (*pt < tend)
     {
         uint32_t * inp = (uint32_t *) *pt;
-        uint16_t idx = POINTS_hash(*inp);
-        match = dictionary[POINTS_hash(idx)];
-        dictionary[idx] = *pt;
-        if (match >= src && match < *pt && *((uint32_t *) match) == *inp)
+        uint16_t idx = POINTS_hash(*inp) & dict->mask;
+        uint32_t pos = dict->offsets[idx];
+        dict->offsets[idx] = (*pt - src) + 1;
+        match = src + pos - 1;
+        if (pos && *((uint32_t *) match) == *inp)
         {
             if (literal < *pt)
             {
@@ -1744,6 +2267,468 @@ static int POINTS_set_cinfo_size(uint16_t * cinfo, size_t * size)
     return 0;
 }
 
+/*
+ * Sizes below 2048 bytes are stored as is, larger sizes are stored in blocks
+ * of 64 bytes in which case *size is rounded up.
+ *
+ * Returns -1 if the size is too large to fit in cinfo.
+ */
+static int POINTS_set_cinfo_bitpack(uint16_t * cinfo, size_t * size)
+{
+    size_t sz = *size;
+
+    if (sz >= 0x800)
+    {
+        sz = (sz + 63) >> 6;
+        if (sz > 0x7ff)
+        {
+            return -1;
+        }
+        *size = sz << 6;
+        sz |= 0x800;
+    }
+
+    *cinfo = (uint16_t) ((sz << 4) | POINTS_CINFO_BITPACK);
+    return 0;
+}
+
+/*
+ * Write the lower `n` bits from `val`, most significant bit first. The
+ * buffer must be initialized with zeros.
+ */
+static inline void POINTS_put_bits(
+        POINTS_bits_t * b,
+        uint64_t val,
+        uint8_t n)
+{
+    uint8_t avail, take;
+
+    while (n)
+    {
+        avail = 8 - b->nbits;
+        take = n < avail ? n : avail;
+        n -= take;
+
+        *b->pt |= (unsigned char) (
+                ((val >> n) & ((1u << take) - 1)) << (avail - take));
+
+        b->nbits += take;
+        if (b->nbits == 8)
+        {
+            ++b->pt;
+            b->nbits = 0;
+        }
+    }
+}
+
+static inline uint64_t POINTS_get_bits(POINTS_bits_t * b, uint8_t n)
+{
+    uint64_t val = 0;
+    uint8_t avail, take;
+
+    while (n)
+    {
+        avail = 8 - b->nbits;
+        take = n < avail ? n : avail;
+        n -= take;
+
+        val <<= take;
+        val |= (*b->pt >> (avail - take)) & ((1u << take) - 1);
+
+        b->nbits += take;
+        if (b->nbits == 8)
+        {
+            ++b->pt;
+            b->nbits = 0;
+        }
+    }
+    return val;
+}
+
+/*
+ * Delta-of-delta encoding:
+ *
+ *  '0'                     dod is zero
+ *  '10'    + 7 bits        -64..63
+ *  '110'   + 9 bits        -256..255
+ *  '1110'  + 12 bits       -2048..2047
+ *  '1111'  + 64 bits       everything else
+ */
+static void POINTS_put_dod(POINTS_bits_t * b, int64_t dod)
+{
+    if (dod == 0)
+    {
+        POINTS_put_bits(b, 0, 1);
+    }
+    else if (dod >= -64 && dod <= 63)
+    {
+        POINTS_put_bits(b, 0x2, 2);
+        POINTS_put_bits(b, (uint64_t) dod, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        POINTS_put_bits(b, 0x6, 3);
+        POINTS_put_bits(b, (uint64_t) dod, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        POINTS_put_bits(b, 0xe, 4);
+        POINTS_put_bits(b, (uint64_t) dod, 12);
+    }
+    else
+    {
+        POINTS_put_bits(b, 0xf, 4);
+        POINTS_put_bits(b, (uint64_t) dod, 64);
+    }
+}
+
+static int64_t POINTS_get_dod(POINTS_bits_t * b)
+{
+    uint8_t n;
+    uint64_t val;
+
+    if (!POINTS_get_bits(b, 1))
+    {
+        return 0;
+    }
+
+    n = !POINTS_get_bits(b, 1) ? 7 :
+        !POINTS_get_bits(b, 1) ? 9 :
+        !POINTS_get_bits(b, 1) ? 12 : 64;
+
+    val = POINTS_get_bits(b, n);
+
+    /* sign extend */
+    if (n < 64 && (val & (UINT64_C(1) << (n - 1))))
+    {
+        val |= ~((UINT64_C(1) << n) - 1);
+    }
+
+    return (int64_t) val;
+}
+
+static void POINTS_unzip_double_bits(
+        siridb_points_t * points,
+        unsigned char * bits,
+        uint16_t len,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        uint8_t has_overlap)
+{
+    POINTS_bits_t b;
+    siridb_point_t p;
+    uint64_t delta = 0;
+    uint8_t lead = 0, trail = 0, m;
+    size_t n = points->len;
+    uint16_t i;
+
+    memcpy(&p.ts, bits, sizeof(uint64_t));
+    memcpy(&p.val.uint64, bits + sizeof(uint64_t), sizeof(uint64_t));
+
+    b.pt = bits + 16;
+    b.nbits = 0;
+
+    for (i = 0; i < len; ++i)
+    {
+        if (i)
+        {
+            delta += (uint64_t) POINTS_get_dod(&b);
+            p.ts += delta;
+
+            if (POINTS_get_bits(&b, 1))
+            {
+                if (POINTS_get_bits(&b, 1))
+                {
+                    lead = POINTS_get_bits(&b, 5);
+                    m = POINTS_get_bits(&b, 6);
+                    trail = 64 - lead - (m ? m : 64);
+                }
+                p.val.uint64 ^= POINTS_get_bits(&b, 64 - lead - trail) << trail;
+            }
+        }
+
+        if (end_ts != NULL && p.ts >= *end_ts)
+        {
+            break;
+        }
+
+        if (start_ts != NULL && p.ts < *start_ts)
+        {
+            continue;
+        }
+
+        if (has_overlap && n)
+        {
+            siridb_points_add_point(points, &p.ts, &p.val);
+        }
+        else
+        {
+            memcpy(points->data + points->len++, &p, sizeof(siridb_point_t));
+        }
+    }
+}
+
+/*
+ * Pack `n` values as: <width> <reference (varint)> <data>. The reference is
+ * the smallest value and data contains `value - reference` using `width`
+ * bits per value, least significant bit first.
+ */
+static unsigned char * POINTS_pack_block(
+        unsigned char * pt,
+        uint64_t * u,
+        uint_fast32_t n)
+{
+    uint64_t ref = u[0], max = u[0], acc = 0, v;
+    uint_fast32_t i;
+    uint8_t width, nacc = 0;
+
+    for (i = 1; i < n; ++i)
+    {
+        ref = u[i] < ref ? u[i] : ref;
+        max = u[i] > max ? u[i] : max;
+    }
+
+    width = max == ref ? 0 : 64 - __builtin_clzll(max - ref);
+    *pt++ = width;
+
+    for (v = ref; v >= 0x80; v >>= 7)
+    {
+        *pt++ = (unsigned char) (v | 0x80);
+    }
+    *pt++ = (unsigned char) v;
+
+    if (width == 0)
+    {
+        return pt;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        v = u[i] - ref;
+        acc |= nacc ? v << nacc : v;
+
+        if (nacc + width >= 64)
+        {
+            memcpy(pt, &acc, sizeof(uint64_t));
+            pt += sizeof(uint64_t);
+            acc = nacc ? v >> (64 - nacc) : 0;
+            nacc = nacc + width - 64;
+        }
+        else
+        {
+            nacc += width;
+        }
+    }
+
+    for (; nacc; nacc = nacc > 8 ? nacc - 8 : 0, acc >>= 8)
+    {
+        *pt++ = (unsigned char) acc;
+    }
+
+    return pt;
+}
+
+/*
+ * Unpack values using a fixed width. For full blocks this function is
+ * inlined with a constant width so the loop can be unrolled and vectorized
+ * by the compiler. The source must be readable up to 8 bytes after the data.
+ */
+static inline __attribute__((always_inline)) void POINTS_unpack_w(
+        const unsigned char * src,
+        uint64_t * u,
+        uint_fast32_t n,
+        const uint8_t width)
+{
+    const uint64_t mask =
+            width == 64 ? UINT64_MAX : (UINT64_C(1) << width) - 1;
+    uint_fast32_t i, bit;
+    uint64_t v;
+
+    for (i = 0, bit = 0; i < n; ++i, bit += width)
+    {
+        memcpy(&v, src + (bit >> 3), sizeof(uint64_t));
+        v >>= bit & 7;
+        if (width > 56 && (bit & 7))
+        {
+            v |= (uint64_t) src[(bit >> 3) + 8] << (64 - (bit & 7));
+        }
+        u[i] = v & mask;
+    }
+}
+
+#define POINTS_UNPACK_CASE(w__) \
+    case w__: POINTS_unpack_w(src, u, BITPACK_BLOCK_SZ, w__); break;
+
+#define POINTS_UNPACK_CASE4(w__) \
+    POINTS_UNPACK_CASE(w__) \
+    POINTS_UNPACK_CASE(w__ + 1) \
+    POINTS_UNPACK_CASE(w__ + 2) \
+    POINTS_UNPACK_CASE(w__ + 3)
+
+/*
+ * Unpack `n` values written by POINTS_pack_block(). Adding the reference and
+ * the zigzag decoding use vector instructions.
+ */
+static unsigned char * POINTS_unpack_block(
+        unsigned char * pt,
+        unsigned char * end,
+        uint64_t * u,
+        uint_fast32_t n)
+{
+    unsigned char buf[BITPACK_BLOCK_SZ * 8 + 16];
+    const unsigned char * src;
+    POINTS_v4u64_t vec, one = {1, 1, 1, 1}, vref;
+    uint64_t ref = 0;
+    uint_fast32_t i;
+    uint8_t width = *pt++, shift;
+    size_t nbytes;
+
+    for (shift = 0; *pt & 0x80; shift += 7)
+    {
+        ref |= (uint64_t) (*pt++ & 0x7f) << shift;
+    }
+    ref |= (uint64_t) *pt++ << shift;
+
+    nbytes = (n * width + 7) / 8;
+
+    if (pt + nbytes + 8 <= end)
+    {
+        src = pt;
+    }
+    else
+    {
+        /* near the end of the chunk we need a padded copy */
+        memcpy(buf, pt, nbytes);
+        memset(buf + nbytes, 0, 16);
+        src = buf;
+    }
+
+    if (n != BITPACK_BLOCK_SZ)
+    {
+        POINTS_unpack_w(src, u, n, width);
+    }
+    else switch (width)
+    {
+    case 0: memset(u, 0, BITPACK_BLOCK_SZ * sizeof(uint64_t)); break;
+    POINTS_UNPACK_CASE4(1)
+    POINTS_UNPACK_CASE4(5)
+    POINTS_UNPACK_CASE4(9)
+    POINTS_UNPACK_CASE4(13)
+    POINTS_UNPACK_CASE4(17)
+    POINTS_UNPACK_CASE4(21)
+    POINTS_UNPACK_CASE4(25)
+    POINTS_UNPACK_CASE4(29)
+    POINTS_UNPACK_CASE4(33)
+    POINTS_UNPACK_CASE4(37)
+    POINTS_UNPACK_CASE4(41)
+    POINTS_UNPACK_CASE4(45)
+    POINTS_UNPACK_CASE4(49)
+    POINTS_UNPACK_CASE4(53)
+    POINTS_UNPACK_CASE4(57)
+    POINTS_UNPACK_CASE4(61)
+    }
+
+    /* frame-of-reference and zigzag decode, four values at a time */
+    vref = (POINTS_v4u64_t) {ref, ref, ref, ref};
+    for (i = 0; i < n; i += 4)
+    {
+        memcpy(&vec, u + i, sizeof(POINTS_v4u64_t));
+        vec += vref;
+        vec = (vec >> 1) ^ -(vec & one);
+        memcpy(u + i, &vec, sizeof(POINTS_v4u64_t));
+    }
+
+    return pt + nbytes;
+}
+
+static void POINTS_unzip_int_bits(
+        siridb_points_t * points,
+        unsigned char * bits,
+        uint16_t len,
+        uint16_t cinfo,
+        uint64_t * start_ts,
+        uint64_t * end_ts,
+        uint8_t has_overlap)
+{
+    uint64_t tblock[BITPACK_BLOCK_SZ];
+    uint64_t vblock[BITPACK_BLOCK_SZ];
+    uint64_t ts, val, tdelta = 0, vdelta = 0;
+    unsigned char * pt = bits + 16;
+    unsigned char * end = bits + siridb_points_get_size_zipped(cinfo, len);
+    siridb_point_t * point;
+    size_t n = points->len;
+    uint_fast32_t i, j, m;
+
+    memcpy(&ts, bits, sizeof(uint64_t));
+    memcpy(&val, bits + sizeof(uint64_t), sizeof(uint64_t));
+
+    tblock[0] = ts;
+    vblock[0] = val;
+
+    for (i = m = 1;; i += m)
+    {
+        if ((start_ts == NULL || tblock[0] >= *start_ts) &&
+            (end_ts == NULL || tblock[m - 1] < *end_ts) &&
+            !(has_overlap && n))
+        {
+            /* the complete block is within range */
+            point = points->data + points->len;
+            for (j = 0; j < m; ++j, ++point)
+            {
+                point->ts = tblock[j];
+                point->val.uint64 = vblock[j];
+            }
+            points->len += m;
+        }
+        else
+        {
+            for (j = 0; j < m; ++j)
+            {
+                if (end_ts != NULL && tblock[j] >= *end_ts)
+                {
+                    return;
+                }
+
+                if (start_ts != NULL && tblock[j] < *start_ts)
+                {
+                    continue;
+                }
+
+                if (has_overlap && n)
+                {
+                    siridb_points_add_point(
+                            points,
+                            &tblock[j],
+                            (qp_via_t *) &vblock[j]);
+                }
+                else
+                {
+                    point = points->data + points->len++;
+                    point->ts = tblock[j];
+                    point->val.uint64 = vblock[j];
+                }
+            }
+        }
+
+        if (i == len)
+        {
+            return;
+        }
+
+        m = len - i < BITPACK_BLOCK_SZ ? len - i : BITPACK_BLOCK_SZ;
+        pt = POINTS_unpack_block(pt, end, tblock, m);
+        pt = POINTS_unpack_block(pt, end, vblock, m);
+
+        for (j = 0; j < m; ++j)
+        {
+            tdelta += tblock[j];
+            tblock[j] = ts += tdelta;
+            vdelta += vblock[j];
+            vblock[j] = val += vdelta;
+        }
+    }
+}
+
 uint64_t siridb_points_get_interval(siridb_points_t * points)
 {
     size_t i, j, n;
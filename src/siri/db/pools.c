@@ -5,6 +5,7 @@
 #include <llist/llist.h>
 #include <logger/logger.h>
 #include <siri/db/pools.h>
+#include <siri/db/series.h>
 #include <siri/db/server.h>
 #include <siri/net/promises.h>
 #include <siri/optimize.h>
@@ -62,7 +63,9 @@ void siridb_pools_init(siridb_t * siridb)
     siridb->pools->prev_lookup = NULL;
 
     /* generate pool lookup for series */
-    siridb->pools->lookup = siridb_lookup_new(siridb->pools->len);
+    siridb->pools->lookup = siridb_lookup_new(
+            siridb->pools->len,
+            siridb->placement);
     if (siridb->pools->lookup == NULL)
     {
         siridb_pools_free(siridb->pools);
@@ -96,7 +99,9 @@ siridb_pool_t * siridb_pools_append(
         siridb_server_t * server)
 {
     siridb_pool_t * pool = NULL;
-    siridb_lookup_t * lookup = siridb_lookup_new(pools->len + 1);
+    siridb_lookup_t * lookup = siridb_lookup_new(
+            pools->len + 1,
+            pools->lookup->placement);
     if (lookup != NULL)
     {
         pool = (siridb_pool_t *)
@@ -321,6 +326,40 @@ static int POOLS_max_pool(siridb_server_t * server, uint16_t * max_pool)
     return 0;
 }
 
+/*
+ * Returns the number of series in 'this' pool which would move to a new pool
+ * when one pool is added to the database, or -1 in case of an allocation
+ * error.
+ *
+ * Only slots for the new pool change so series never move between existing
+ * pools. The series are counted for each slot so no series walk is needed.
+ */
+ssize_t siridb_pools_moved(siridb_t * siridb)
+{
+    ssize_t n = 0;
+    size_t i;
+    siridb_lookup_t * lookup = siridb_lookup_new(
+            siridb->pools->len + 1,
+            siridb->placement);
+
+    if (lookup == NULL)
+    {
+        return -1;  /* signal is raised */
+    }
+
+    /* the new pool has the highest pool id */
+    for (i = 0; i < SIRIDB_LOOKUP_SZ; i++)
+    {
+        if (lookup->pools[i] == siridb->pools->len)
+        {
+            n += siridb->series_slots[i];
+        }
+    }
+
+    siridb_lookup_free(lookup);
+    return n;
+}
+
 /*
  * Signal can be raised by this function when a fifo buffer for an optional
  * replica server can't be created.
@@ -99,6 +99,34 @@ siridb_presuf_t * siridb_presuf_add(
     return nps;
 }
 
+/*
+ * Add prefix-suffix from strings. Both prefix and suffix are allowed to be
+ * NULL. Use 'siridb_presuf_is_unique' to check if the new one is unique.
+ *
+ * Returns NULL and raises a SIGNAL in case an error has occurred.
+ * (presuf remains unchanged in case of an error)
+ */
+siridb_presuf_t * siridb_presuf_add_str(
+        siridb_presuf_t ** presuf,
+        const char * prefix,
+        const char * suffix)
+{
+    siridb_presuf_t * nps = PRESUF_add(presuf);
+    if (nps != NULL)
+    {
+        /* not critical if prefix or suffix is still NULL */
+        if (prefix != NULL && (nps->prefix = strdup(prefix)) != NULL)
+        {
+            nps->len += strlen(prefix);
+        }
+        if (suffix != NULL && (nps->suffix = strdup(suffix)) != NULL)
+        {
+            nps->len += strlen(suffix);
+        }
+    }
+    return nps;
+}
+
 /*
  * Check if the last presuf is unique compared to the others.
  */
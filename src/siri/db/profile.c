@@ -0,0 +1,428 @@
+/*
+ * profile.c - Execution profile for queries starting with `profile`.
+ */
+#include <siri/db/profile.h>
+#include <siri/metrics.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PROFILE_KEY "__profile__"
+
+static const char * PROFILE_stages[SIRIDB_PROFILE_END] = {
+    [SIRIDB_PROFILE_REGEX] = "regex",
+    [SIRIDB_PROFILE_FILTER] = "filter",
+    [SIRIDB_PROFILE_READ] = "read",
+    [SIRIDB_PROFILE_DECOMPRESS] = "decompress",
+    [SIRIDB_PROFILE_AGGREGATE] = "aggregate",
+    [SIRIDB_PROFILE_MERGE] = "merge",
+    [SIRIDB_PROFILE_PACK] = "pack",
+};
+
+__thread siridb_profile_t * siridb_profile_local = NULL;
+
+static void PROFILE_sum(siridb_profile_t * dst, siridb_profile_t * src);
+static int PROFILE_pack_node(siridb_profile_t * profile, qp_packer_t * packer);
+static int PROFILE_unpack_node(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker);
+static int PROFILE_unpack_stages(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker);
+static int PROFILE_unpack_reads(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker);
+static inline uint64_t PROFILE_cpu(void);
+static inline int PROFILE_eq(qp_obj_t * obj, const char * str);
+
+/*
+ * Returns NULL in case of an allocation error.
+ */
+siridb_profile_t * siridb_profile_new(void)
+{
+    return calloc(1, sizeof(siridb_profile_t));
+}
+
+void siridb_profile_free(siridb_profile_t * profile)
+{
+    if (profile->pools != NULL)
+    {
+        vec_destroy(profile->pools, (vec_destroy_cb) siridb_profile_free);
+    }
+    free(profile->server);
+    free(profile);
+}
+
+/*
+ * Start timing a stage. Does nothing when profile is NULL so this can be
+ * called for every query.
+ */
+void siridb_profile_start(
+        siridb_profile_t * profile,
+        siridb_profile_clock_t * clock)
+{
+    if (profile != NULL)
+    {
+        clock->wall = siri_metrics_now();
+        clock->cpu = PROFILE_cpu();
+    }
+}
+
+/*
+ * Add the time since siridb_profile_start() to a stage. Must be called on
+ * the same thread as siridb_profile_start() since the CPU time is measured
+ * for the thread.
+ */
+void siridb_profile_stop(
+        siridb_profile_t * profile,
+        siridb_profile_stage_t stage,
+        siridb_profile_clock_t * clock)
+{
+    if (profile != NULL)
+    {
+        siridb_profile_timer_t * timer = &profile->stages[stage];
+        timer->wall += siri_metrics_now() - clock->wall;
+        timer->cpu += PROFILE_cpu() - clock->cpu;
+        timer->count++;
+    }
+}
+
+/*
+ * Add the profile from a pool response as a child. The unpacker must be
+ * positioned before the profile key.
+ *
+ * Returns 0 if successful or -1 when no valid profile is found or in case
+ * of an allocation error. The profile is not changed in case of an error.
+ */
+int siridb_profile_from_unpacker(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker,
+        uint64_t network)
+{
+    siridb_profile_t * pool;
+    qp_obj_t qp_key;
+    qp_types_t tp = qp_next(unpacker, &qp_key);
+
+    while (qp_is_close(tp))
+    {
+        tp = qp_next(unpacker, &qp_key);
+    }
+
+    if (!qp_is_raw(tp) ||
+        !PROFILE_eq(&qp_key, PROFILE_KEY) ||
+        (profile->pools == NULL && (profile->pools = vec_new(2)) == NULL) ||
+        (pool = siridb_profile_new()) == NULL)
+    {
+        return -1;
+    }
+
+    if (PROFILE_unpack_node(pool, unpacker) ||
+        vec_append_safe(&profile->pools, pool))
+    {
+        siridb_profile_free(pool);
+        return -1;
+    }
+
+    pool->network = network;
+    return 0;
+}
+
+/*
+ * Pack the profile for this server, the profiles of the pools and a total
+ * for all servers. Time values are packed in seconds.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_profile_pack(
+        siridb_profile_t * profile,
+        qp_packer_t * packer,
+        const char * server,
+        double time)
+{
+    siridb_profile_t total = {0};
+    siridb_profile_t * pool;
+    size_t i, n = profile->pools == NULL ? 0 : profile->pools->len;
+    int rc;
+
+    PROFILE_sum(&total, profile);
+
+    rc = (  qp_add_raw(packer, (const unsigned char *) PROFILE_KEY,
+                strlen(PROFILE_KEY)) ||
+            qp_add_type(packer, QP_MAP_OPEN) ||
+            qp_add_raw(packer, (const unsigned char *) "server", 6) ||
+            qp_add_string(packer, server) ||
+            qp_add_raw(packer, (const unsigned char *) "time", 4) ||
+            qp_add_double(packer, time) ||
+            PROFILE_pack_node(profile, packer) ||
+            qp_add_raw(packer, (const unsigned char *) "pools", 5) ||
+            qp_add_type(packer, QP_ARRAY_OPEN));
+
+    for (i = 0; !rc && i < n; i++)
+    {
+        pool = profile->pools->data[i];
+        PROFILE_sum(&total, pool);
+
+        rc = (  qp_add_type(packer, QP_MAP_OPEN) ||
+                qp_add_raw(packer, (const unsigned char *) "server", 6) ||
+                qp_add_string(packer, pool->server ? pool->server : "") ||
+                qp_add_raw(packer, (const unsigned char *) "time", 4) ||
+                qp_add_double(packer, pool->time) ||
+                qp_add_raw(packer, (const unsigned char *) "network", 7) ||
+                qp_add_double(packer, (double) pool->network / 1e6) ||
+                PROFILE_pack_node(pool, packer) ||
+                qp_add_type(packer, QP_MAP_CLOSE));
+    }
+
+    return (rc ||
+            qp_add_type(packer, QP_ARRAY_CLOSE) ||
+            qp_add_raw(packer, (const unsigned char *) "total", 5) ||
+            qp_add_type(packer, QP_MAP_OPEN) ||
+            PROFILE_pack_node(&total, packer) ||
+            qp_add_type(packer, QP_MAP_CLOSE) ||
+            qp_add_type(packer, QP_MAP_CLOSE)) ? -1 : 0;
+}
+
+static void PROFILE_sum(siridb_profile_t * dst, siridb_profile_t * src)
+{
+    int i;
+
+    for (i = 0; i < SIRIDB_PROFILE_END; i++)
+    {
+        dst->stages[i].wall += src->stages[i].wall;
+        dst->stages[i].cpu += src->stages[i].cpu;
+        dst->stages[i].count += src->stages[i].count;
+    }
+
+    dst->chunks += src->chunks;
+    dst->bytes += src->bytes;
+    dst->points += src->points;
+    dst->cache_hits += src->cache_hits;
+    dst->cache_misses += src->cache_misses;
+}
+
+/*
+ * Pack the stages and reads keys for a profile.
+ */
+static int PROFILE_pack_node(siridb_profile_t * profile, qp_packer_t * packer)
+{
+    siridb_profile_timer_t * timer;
+    int i, rc;
+
+    rc = (  qp_add_raw(packer, (const unsigned char *) "stages", 6) ||
+            qp_add_type(packer, QP_MAP_OPEN));
+
+    for (i = 0; !rc && i < SIRIDB_PROFILE_END; i++)
+    {
+        timer = &profile->stages[i];
+        rc = (  qp_add_string(packer, PROFILE_stages[i]) ||
+                qp_add_type(packer, QP_MAP3) ||
+                qp_add_raw(packer, (const unsigned char *) "wall", 4) ||
+                qp_add_double(packer, (double) timer->wall / 1e6) ||
+                qp_add_raw(packer, (const unsigned char *) "cpu", 3) ||
+                qp_add_double(packer, (double) timer->cpu / 1e6) ||
+                qp_add_raw(packer, (const unsigned char *) "count", 5) ||
+                qp_add_int64(packer, (int64_t) timer->count));
+    }
+
+    return (rc ||
+            qp_add_type(packer, QP_MAP_CLOSE) ||
+            qp_add_raw(packer, (const unsigned char *) "reads", 5) ||
+            qp_add_type(packer, QP_MAP5) ||
+            qp_add_raw(packer, (const unsigned char *) "chunks", 6) ||
+            qp_add_int64(packer, (int64_t) profile->chunks) ||
+            qp_add_raw(packer, (const unsigned char *) "bytes", 5) ||
+            qp_add_int64(packer, (int64_t) profile->bytes) ||
+            qp_add_raw(packer, (const unsigned char *) "points", 6) ||
+            qp_add_int64(packer, (int64_t) profile->points) ||
+            qp_add_raw(packer, (const unsigned char *) "cache_hits", 10) ||
+            qp_add_int64(packer, (int64_t) profile->cache_hits) ||
+            qp_add_raw(packer, (const unsigned char *) "cache_misses", 12) ||
+            qp_add_int64(packer, (int64_t) profile->cache_misses)) ? -1 : 0;
+}
+
+/*
+ * Unpack the map for a single server. Keys which are not known, like the
+ * pools and total of the pool itself, are skipped.
+ */
+static int PROFILE_unpack_node(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker)
+{
+    qp_obj_t qp_key, qp_val;
+    qp_types_t tp;
+
+    if (qp_next(unpacker, NULL) != QP_MAP_OPEN)
+    {
+        return -1;
+    }
+
+    while (qp_is_raw(tp = qp_next(unpacker, &qp_key)))
+    {
+        if (PROFILE_eq(&qp_key, "server"))
+        {
+            if (!qp_is_raw(qp_next(unpacker, &qp_val)) ||
+                profile->server != NULL ||
+                (profile->server = strndup(qp_val.via.str, qp_val.len)) ==
+                        NULL)
+            {
+                return -1;
+            }
+        }
+        else if (PROFILE_eq(&qp_key, "time"))
+        {
+            if (!qp_is_double(qp_next(unpacker, &qp_val)))
+            {
+                return -1;
+            }
+            profile->time = qp_val.via.real;
+        }
+        else if (PROFILE_eq(&qp_key, "stages"))
+        {
+            if (PROFILE_unpack_stages(profile, unpacker))
+            {
+                return -1;
+            }
+        }
+        else if (PROFILE_eq(&qp_key, "reads"))
+        {
+            if (PROFILE_unpack_reads(profile, unpacker))
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            qp_skip_next(unpacker);
+        }
+    }
+
+    return tp == QP_MAP_CLOSE ? 0 : -1;
+}
+
+static int PROFILE_unpack_stages(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker)
+{
+    siridb_profile_timer_t * timer;
+    qp_obj_t qp_key, qp_val;
+    qp_types_t tp;
+    int i, n;
+
+    if (qp_next(unpacker, NULL) != QP_MAP_OPEN)
+    {
+        return -1;
+    }
+
+    while (qp_is_raw(tp = qp_next(unpacker, &qp_key)))
+    {
+        for (i = 0; i < SIRIDB_PROFILE_END; i++)
+        {
+            if (PROFILE_eq(&qp_key, PROFILE_stages[i]))
+            {
+                break;
+            }
+        }
+
+        if (i == SIRIDB_PROFILE_END)
+        {
+            /* a stage from a newer version */
+            qp_skip_next(unpacker);
+            continue;
+        }
+
+        timer = &profile->stages[i];
+
+        if (qp_next(unpacker, NULL) != QP_MAP3)
+        {
+            return -1;
+        }
+
+        for (n = 0; n < 3; n++)
+        {
+            if (!qp_is_raw(qp_next(unpacker, &qp_key)))
+            {
+                return -1;
+            }
+
+            tp = qp_next(unpacker, &qp_val);
+
+            if (qp_is_double(tp) && PROFILE_eq(&qp_key, "wall"))
+            {
+                timer->wall = (uint64_t) (qp_val.via.real * 1e6 + 0.5);
+            }
+            else if (qp_is_double(tp) && PROFILE_eq(&qp_key, "cpu"))
+            {
+                timer->cpu = (uint64_t) (qp_val.via.real * 1e6 + 0.5);
+            }
+            else if (qp_is_int(tp) && PROFILE_eq(&qp_key, "count"))
+            {
+                timer->count = (uint64_t) qp_val.via.int64;
+            }
+            else
+            {
+                return -1;
+            }
+        }
+    }
+
+    return tp == QP_MAP_CLOSE ? 0 : -1;
+}
+
+static int PROFILE_unpack_reads(
+        siridb_profile_t * profile,
+        qp_unpacker_t * unpacker)
+{
+    qp_obj_t qp_key, qp_val;
+    qp_types_t tp = qp_next(unpacker, NULL);
+    int n;
+
+    if (tp < QP_MAP0 || tp > QP_MAP5)
+    {
+        return -1;
+    }
+
+    for (n = tp - QP_MAP0; n--;)
+    {
+        if (!qp_is_raw(qp_next(unpacker, &qp_key)) ||
+            !qp_is_int(qp_next(unpacker, &qp_val)))
+        {
+            return -1;
+        }
+
+        if (PROFILE_eq(&qp_key, "chunks"))
+        {
+            profile->chunks = (uint64_t) qp_val.via.int64;
+        }
+        else if (PROFILE_eq(&qp_key, "bytes"))
+        {
+            profile->bytes = (uint64_t) qp_val.via.int64;
+        }
+        else if (PROFILE_eq(&qp_key, "points"))
+        {
+            profile->points = (uint64_t) qp_val.via.int64;
+        }
+        else if (PROFILE_eq(&qp_key, "cache_hits"))
+        {
+            profile->cache_hits = (uint64_t) qp_val.via.int64;
+        }
+        else if (PROFILE_eq(&qp_key, "cache_misses"))
+        {
+            profile->cache_misses = (uint64_t) qp_val.via.int64;
+        }
+    }
+
+    return 0;
+}
+
+static inline uint64_t PROFILE_cpu(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline int PROFILE_eq(qp_obj_t * obj, const char * str)
+{
+    size_t n = strlen(str);
+    return obj->len == n && memcmp(obj->via.raw, str, n) == 0;
+}
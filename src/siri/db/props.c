@@ -68,6 +68,10 @@ static void prop_buffer_size(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_codec(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_dbname(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -136,10 +140,22 @@ static void prop_open_files(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_placement(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_pool(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_query_cache_hit_rate(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
+static void prop_query_cache_time_saved(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_received_points(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -176,6 +192,10 @@ static void prop_tee(
         siridb_t * siridb,
         qp_packer_t * packer,
         int map);
+static void prop_tee_lag(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map);
 static void prop_timezone(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -218,6 +238,8 @@ void siridb_init_props(void)
             prop_buffer_path);
     props_set_cb(CLERI_GID_K_BUFFER_SIZE - KW_OFFSET,
             prop_buffer_size);
+    props_set_cb(CLERI_GID_K_CODEC - KW_OFFSET,
+            prop_codec);
     props_set_cb(CLERI_GID_K_DBNAME - KW_OFFSET,
             prop_dbname);
     props_set_cb(CLERI_GID_K_DBPATH - KW_OFFSET,
@@ -252,8 +274,14 @@ void siridb_init_props(void)
             prop_log_level);
     props_set_cb(CLERI_GID_K_OPEN_FILES - KW_OFFSET,
             prop_open_files);
+    props_set_cb(CLERI_GID_K_PLACEMENT - KW_OFFSET,
+            prop_placement);
     props_set_cb(CLERI_GID_K_POOL - KW_OFFSET,
             prop_pool);
+    props_set_cb(CLERI_GID_K_QUERY_CACHE_HIT_RATE - KW_OFFSET,
+            prop_query_cache_hit_rate);
+    props_set_cb(CLERI_GID_K_QUERY_CACHE_TIME_SAVED - KW_OFFSET,
+            prop_query_cache_time_saved);
     props_set_cb(CLERI_GID_K_RECEIVED_POINTS - KW_OFFSET,
             prop_received_points);
     props_set_cb(CLERI_GID_K_REINDEX_PROGRESS - KW_OFFSET,
@@ -272,6 +300,8 @@ void siridb_init_props(void)
             prop_sync_progress);
     props_set_cb(CLERI_GID_K_TEE - KW_OFFSET,
             prop_tee);
+    props_set_cb(CLERI_GID_K_TEE_LAG - KW_OFFSET,
+            prop_tee_lag);
     props_set_cb(CLERI_GID_K_TIMEZONE - KW_OFFSET,
             prop_timezone);
     props_set_cb(CLERI_GID_K_TIME_PRECISION - KW_OFFSET,
@@ -322,6 +352,15 @@ static void prop_buffer_size(
     qp_add_int64(packer, (int64_t) siridb->buffer->size);
 }
 
+static void prop_codec(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("codec", 5)
+    qp_add_string(packer, siridb_codec_name(siridb->codec));
+}
+
 static void prop_dbname(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -489,6 +528,15 @@ static void prop_open_files(
     qp_add_int64(packer, (int64_t) siridb_open_files(siridb));
 }
 
+static void prop_placement(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("placement", 9)
+    qp_add_string(packer, siridb_placement_name(siridb->placement));
+}
+
 static void prop_pool(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -498,6 +546,24 @@ static void prop_pool(
     qp_add_int64(packer, (int64_t) siridb->server->pool);
 }
 
+static void prop_query_cache_hit_rate(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("query_cache_hit_rate", 20)
+    qp_add_double(packer, siridb_qcache_hit_rate(siridb->qcache));
+}
+
+static void prop_query_cache_time_saved(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("query_cache_time_saved", 22)
+    qp_add_double(packer, siridb->qcache->time_saved / 1e9);
+}
+
 static void prop_received_points(
         siridb_t * siridb,
         qp_packer_t * packer,
@@ -581,6 +647,15 @@ static void prop_tee(
     qp_add_string(packer, siridb_tee_str(siridb->tee));
 }
 
+static void prop_tee_lag(
+        siridb_t * siridb,
+        qp_packer_t * packer,
+        int map)
+{
+    SIRIDB_PROP_MAP("tee_lag", 7)
+    qp_add_double(packer, siridb_tee_lag(siridb->tee));
+}
+
 static void prop_timezone(
         siridb_t * siridb,
         qp_packer_t * packer,
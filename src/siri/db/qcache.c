@@ -0,0 +1,219 @@
+/*
+ * qcache.c - LRU cache for parsed queries.
+ */
+#include <assert.h>
+#include <siri/db/qcache.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void QCACHE_unlink(
+        siridb_qcache_t * qcache,
+        siridb_qcache_entry_t * entry);
+static void QCACHE_push(
+        siridb_qcache_t * qcache,
+        siridb_qcache_entry_t * entry);
+static void QCACHE_entry_free(siridb_qcache_entry_t * entry);
+
+/*
+ * Returns NULL in case of an allocation error.
+ */
+siridb_qcache_t * siridb_qcache_new(void)
+{
+    siridb_qcache_t * qcache = calloc(1, sizeof(siridb_qcache_t));
+    if (qcache == NULL)
+    {
+        return NULL;
+    }
+
+    qcache->entries = ct_new();
+    if (qcache->entries == NULL)
+    {
+        free(qcache);
+        return NULL;
+    }
+
+    return qcache;
+}
+
+/*
+ * Destroy the cache. No entry should be in use at this point.
+ */
+void siridb_qcache_free(siridb_qcache_t * qcache)
+{
+    siridb_qcache_entry_t * entry;
+
+    while ((entry = qcache->head) != NULL)
+    {
+        assert (!entry->in_use);
+        qcache->head = entry->next;
+        QCACHE_entry_free(entry);
+    }
+
+    ct_free(qcache->entries, NULL);
+    free(qcache);
+}
+
+/*
+ * Returns a cached entry for the given query or NULL when the query is not
+ * cached or when the cached parse result is used by another query. The
+ * entry is marked as being used and must be released when the query is
+ * finished.
+ *
+ * Since the walker writes the evaluated expressions into the parse tree, a
+ * tree can only be used by one query at a time.
+ */
+siridb_qcache_entry_t * siridb_qcache_get(
+        siridb_qcache_t * qcache,
+        const char * q)
+{
+    siridb_qcache_entry_t * entry = ct_get(qcache->entries, q);
+
+    if (entry == NULL || entry->in_use)
+    {
+        qcache->misses++;
+        return NULL;
+    }
+
+    qcache->hits++;
+    qcache->time_saved += entry->parse_time;
+
+    entry->in_use = 1;
+
+    /* move the entry to the front */
+    QCACHE_unlink(qcache, entry);
+    QCACHE_push(qcache, entry);
+
+    return entry;
+}
+
+/*
+ * Add a valid parse result to the cache. On success the cache takes
+ * ownership of both the query text and the parse result, and the returned
+ * entry is marked as being used.
+ *
+ * Returns NULL when the query is not added, either because the query is
+ * already cached or in case of an allocation error.
+ */
+siridb_qcache_entry_t * siridb_qcache_add(
+        siridb_qcache_t * qcache,
+        char * q,
+        cleri_parse_t * pr,
+        uint64_t parse_time)
+{
+    siridb_qcache_entry_t * entry = malloc(sizeof(siridb_qcache_entry_t));
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    if (ct_add(qcache->entries, q, entry) != CT_OK)
+    {
+        free(entry);
+        return NULL;
+    }
+
+    entry->q = q;
+    entry->pr = pr;
+    entry->parse_time = parse_time;
+    entry->in_use = 1;
+    entry->evicted = 0;
+
+    QCACHE_push(qcache, entry);
+
+    if (++qcache->n > SIRIDB_QCACHE_SIZE)
+    {
+        /* remove the least recently used entry */
+        siridb_qcache_entry_t * lru = qcache->tail;
+
+        (void) ct_pop(qcache->entries, lru->q);
+        QCACHE_unlink(qcache, lru);
+        qcache->n--;
+
+        if (lru->in_use)
+        {
+            lru->evicted = 1;
+        }
+        else
+        {
+            QCACHE_entry_free(lru);
+        }
+    }
+
+    return entry;
+}
+
+/*
+ * Release an entry which is returned by siridb_qcache_get() or
+ * siridb_qcache_add().
+ */
+void siridb_qcache_release(siridb_qcache_entry_t * entry)
+{
+    assert (entry->in_use);
+
+    entry->in_use = 0;
+
+    if (entry->evicted)
+    {
+        QCACHE_entry_free(entry);
+    }
+}
+
+/*
+ * Returns the percentage of queries for which a cached parse result is used.
+ */
+double siridb_qcache_hit_rate(siridb_qcache_t * qcache)
+{
+    uint64_t total = qcache->hits + qcache->misses;
+    return total ? (double) qcache->hits / total * 100.0 : 0.0;
+}
+
+static void QCACHE_unlink(
+        siridb_qcache_t * qcache,
+        siridb_qcache_entry_t * entry)
+{
+    if (entry->prev == NULL)
+    {
+        qcache->head = entry->next;
+    }
+    else
+    {
+        entry->prev->next = entry->next;
+    }
+
+    if (entry->next == NULL)
+    {
+        qcache->tail = entry->prev;
+    }
+    else
+    {
+        entry->next->prev = entry->prev;
+    }
+
+    entry->prev = entry->next = NULL;
+}
+
+static void QCACHE_push(
+        siridb_qcache_t * qcache,
+        siridb_qcache_entry_t * entry)
+{
+    entry->prev = NULL;
+    entry->next = qcache->head;
+
+    if (qcache->head == NULL)
+    {
+        qcache->tail = entry;
+    }
+    else
+    {
+        qcache->head->prev = entry;
+    }
+
+    qcache->head = entry;
+}
+
+static void QCACHE_entry_free(siridb_qcache_entry_t * entry)
+{
+    cleri_parse_free(entry->pr);
+    free(entry->q);
+    free(entry);
+}
@@ -4,10 +4,12 @@
 #include <assert.h>
 #include <logger/logger.h>
 #include <siri/db/aggregate.h>
+#include <siri/db/partial.h>
 #include <siri/db/query.h>
 #include <siri/db/shard.h>
 #include <siri/db/queries.h>
 #include <siri/db/sset.h>
+#include <siri/metrics.h>
 #include <stddef.h>
 #include <stdlib.h>
 
@@ -78,6 +80,7 @@ query_select_t * query_select_new(void)
 
     q_select->tp = QUERIES_SELECT;
     q_select->nselects = 1;  /* we have at least one select function  */
+    q_select->lookup_start = siri_metrics_now();
     q_select->result = ct_new();
 
     if (q_select->result == NULL)
@@ -253,6 +256,11 @@ void query_select_free(uv_handle_t * handle)
         }
     }
 
+    if (q_select->partials != NULL)
+    {
+        ct_free(q_select->partials, (ct_free_cb) &siridb_partial_list_free);
+    }
+
     free(q_select->merge_as);
 
     if (q_select->alist != NULL)
@@ -265,6 +273,8 @@ void query_select_free(uv_handle_t * handle)
         siridb_aggregate_list_free(q_select->mlist);
     }
 
+    siridb_plan_free(q_select->plan);
+
     QUERIES_FREE(q_select, handle)
 }
 
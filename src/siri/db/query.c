@@ -8,6 +8,7 @@
 #include <logger/logger.h>
 #include <siri/async.h>
 #include <siri/db/nodes.h>
+#include <siri/db/plan.h>
 #include <siri/db/query.h>
 #include <siri/db/replicate.h>
 #include <siri/db/servers.h>
@@ -35,6 +36,7 @@
 #define SIRIDB_FWD_SERVERS_TIMEOUT 5000  /* 5 seconds  */
 
 static void QUERY_send_invalid_error(uv_async_t * handle);
+static int QUERY_parse_cached(siridb_query_t * query);
 static void QUERY_parse(uv_async_t * handle);
 static int QUERY_walk(
 #if SIRIDB_EXPR_ALLOC
@@ -56,6 +58,14 @@ static int QUERY_rebuild(
         size_t * size,
         const size_t max_size);
 static void QUERY_send_no_query(uv_async_t * handle);
+static siridb_query_t * QUERY_new(
+        uint16_t pid,
+        sirinet_stream_t * client,
+        const char * q,
+        size_t q_len,
+        float factor,
+        int flags);
+static qp_packer_t * QUERY_plan_pack(query_select_t * q_select);
 
 /*
  * This function can raise a SIGNAL.
@@ -74,79 +84,66 @@ void siridb_query_run(
         ERR_ALLOC
         return;
     }
-    siridb_query_t * query = malloc(sizeof(siridb_query_t));
+    siridb_query_t * query = QUERY_new(pid, client, q, q_len, factor, flags);
     if (query == NULL)
     {
-        ERR_ALLOC
         free(handle);
         return;
     }
 
-    /* set query */
-    if ((query->q = strndup(q, q_len)) == NULL)
+    if (Logger.level == LOGGER_DEBUG && strstr(query->q, "password") == NULL)
     {
-        ERR_ALLOC
-        free(query);
-        free(handle);
-        return;
+        log_debug("Parsing query (%d): %s", query->flags, query->q);
     }
 
-    #if SIRIDB_EXPR_ALLOC
-    if ((query->expr_cache = llist_new()) == NULL)
+    /* send next call */
+    uv_async_init(siri.loop, handle, (uv_async_cb) QUERY_parse);
+    handle->data = query;
+    uv_async_send(handle);
+}
+
+/*
+ * Run a select query using a plan from the master server. The query text is
+ * only used for logging since the plan replaces the parse result. The query
+ * takes ownership of the plan, also in case of an error.
+ *
+ * This function can raise a SIGNAL.
+ */
+void siridb_query_run_plan(
+        uint16_t pid,
+        sirinet_stream_t * client,
+        const char * q,
+        size_t q_len,
+        int flags,
+        siridb_plan_t * plan)
+{
+    uv_async_t * handle = malloc(sizeof(uv_async_t));
+    if (handle == NULL)
     {
         ERR_ALLOC
-        free(query->q);
-        free(query);
+        siridb_plan_free(plan);
+        return;
+    }
+    siridb_query_t * query = QUERY_new(pid, client, q, q_len, 0.0, flags);
+    if (query == NULL)
+    {
         free(handle);
+        siridb_plan_free(plan);
         return;
     }
-    #endif
-
-    /*
-     * Set start time.
-     * (must be real time since we translate now with this value)
-     */
-    clock_gettime(CLOCK_REALTIME, &query->start);
-
-    /* bind pid, client and flags so we can send back the result */
-    query->pid = pid;
-
-    /* increment client and siridb reference counters */
-    sirinet_stream_incref(client);
-    siridb_incref(client->siridb);
-
-    query->client = client;
-    query->siridb = client->siridb;
-    query->flags = flags;
-
-    /* bind time precision factor */
-    query->factor = factor;
-
-    /* set the default callback, this might change when custom
-     * data is linked to the query handle
-     */
-    query->free_cb = siridb_query_free;
-    query->ref = 1;
-
-    /* We should initialize the packer based on query type */
-    query->packer = NULL;
-    query->timeit = NULL;
 
-    /* make sure all *other* pointers are set to NULL */
-    query->data = NULL;
-    query->pr = NULL;
-    query->nodes = NULL;
-
-    if (Logger.level == LOGGER_DEBUG && strstr(query->q, "password") == NULL)
+    if (Logger.level == LOGGER_DEBUG)
     {
-        log_debug("Parsing query (%d): %s", query->flags, query->q);
+        log_debug("Running query plan (%d): %s", query->flags, query->q);
     }
 
-    /* increment active tasks */
-    siridb_tasks_inc(client->siridb->tasks);
+    /* the listener replaces the plan with the select query */
+    query->data = plan;
 
-    /* send next call */
-    uv_async_init(siri.loop, handle, (uv_async_cb) QUERY_parse);
+    uv_async_init(
+            siri.loop,
+            handle,
+            (uv_async_cb) siridb_listener_run_plan);
     handle->data = query;
     uv_async_send(handle);
 }
@@ -174,11 +171,20 @@ void siridb_query_free(uv_handle_t * handle)
         qp_packer_free(query->timeit);
     }
 
+    if (query->profile != NULL)
+    {
+        siridb_profile_free(query->profile);
+    }
+
     /* free node list */
     siridb_nodes_free(query->nodes);
 
-    /* free query result */
-    if (query->pr != NULL)
+    /* free query result, unless the result is owned by the query cache */
+    if (query->cached != NULL)
+    {
+        siridb_qcache_release(query->cached);
+    }
+    else if (query->pr != NULL)
     {
         cleri_parse_free(query->pr);
     }
@@ -215,7 +221,18 @@ void siridb_send_query_result(uv_async_t * handle)
             query->pid,
             CPROTO_RES_QUERY);
 
-    sirinet_pkg_send(query->client, pkg);
+    /*
+     * A large response for another server is sent in frames so it does not
+     * block other packages on the same connection.
+     */
+    if (query->flags & SIRIDB_QUERY_FLAG_FRAMES)
+    {
+        sirinet_pkg_send_frames(query->client, pkg);
+    }
+    else
+    {
+        sirinet_pkg_send(query->client, pkg);
+    }
 
     query->packer = NULL;
 
@@ -282,15 +299,33 @@ void siridb_query_forward(
         return;
     }
 
+    /*
+     * A select query which is only forwarded to some pools might have a
+     * plan so the pools do not need to parse the query again.
+     */
+    qp_packer_t * plan = (fwd == SIRIDB_QUERY_FWD_SOME_POOLS) ?
+            QUERY_plan_pack(query->data) : NULL;
+
     /*
      * For backwards compatibility with SiriDB version < 2.0.24 we send an
-     * extra value SIRIDB_TIME_DEFAULT.
+     * extra value SIRIDB_TIME_DEFAULT. The next value contains the query
+     * flags which are supported by this server and an optional last value
+     * contains the plan. Older servers only read the query and ignore the
+     * other values.
      */
-    qp_add_type(packer, QP_ARRAY2);
+    qp_add_type(packer, (plan == NULL) ? QP_ARRAY3 : QP_ARRAY4);
 
     /* add the query to the packer */
     QUERY_to_packer(packer, query);
     qp_add_int64(packer, SIRIDB_TIME_DEFAULT);  /* Only for version < 2.0.24 */
+    qp_add_int64(packer, SIRIDB_QUERY_FLAG_PARTIAL|SIRIDB_QUERY_FLAG_FRAMES|(
+            siri.cfg->select_compression ? SIRIDB_QUERY_FLAG_ZIP : 0));
+
+    if (plan != NULL)
+    {
+        qp_add_raw(packer, plan->buffer, plan->len);
+        qp_packer_free(plan);
+    }
 
 
     sirinet_pkg_t * pkg = sirinet_pkg_new(0, packer->len, 0, packer->buffer);
@@ -583,6 +618,66 @@ static void QUERY_send_no_query(uv_async_t * handle)
     siridb_send_query_result(handle);
 }
 
+/*
+ * Set the parse result for a query, either from the query cache or by
+ * parsing the query. Valid parse results are added to the cache.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error or when the
+ * maximum recursion depth is reached.
+ */
+static int QUERY_parse_cached(siridb_query_t * query)
+{
+    siridb_qcache_t * qcache = query->siridb->qcache;
+    struct timespec start, end;
+    char * q;
+    int cacheable = (
+            strlen(query->q) <= SIRIDB_QCACHE_MAX_QUERY_LEN &&
+            strstr(query->q, "password") == NULL);
+
+    if (cacheable &&
+        (query->cached = siridb_qcache_get(qcache, query->q)) != NULL)
+    {
+        query->pr = query->cached->pr;
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if ((query->pr = cleri_parse_m(siri.grammar, query->q)) == NULL)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!cacheable || !query->pr->is_valid || (q = strdup(query->q)) == NULL)
+    {
+        return 0;
+    }
+
+    /*
+     * The parse result points into the query text so on success the cache
+     * owns the current text and the query continues with the copy.
+     */
+    query->cached = siridb_qcache_add(
+            qcache,
+            query->q,
+            query->pr,
+            (end.tv_sec - start.tv_sec) * 1000000000ULL +
+            end.tv_nsec - start.tv_nsec);
+
+    if (query->cached == NULL)
+    {
+        free(q);
+    }
+    else
+    {
+        query->q = q;
+    }
+
+    return 0;
+}
+
 static void QUERY_parse(uv_async_t * handle)
 {
     int rc;
@@ -595,7 +690,7 @@ static void QUERY_parse(uv_async_t * handle)
             &query->flags);
 
     if (    walker == NULL ||
-            (query->pr = cleri_parse_m(siri.grammar, query->q)) == NULL)
+            QUERY_parse_cached(query))
     {
         if (walker != NULL)
         {
@@ -1108,3 +1203,101 @@ static int QUERY_rebuild(
     }
     return 0;
 }
+
+/*
+ * Returns a new query or NULL in case of an error. (a SIGNAL is raised)
+ */
+static siridb_query_t * QUERY_new(
+        uint16_t pid,
+        sirinet_stream_t * client,
+        const char * q,
+        size_t q_len,
+        float factor,
+        int flags)
+{
+    siridb_query_t * query = malloc(sizeof(siridb_query_t));
+    if (query == NULL)
+    {
+        ERR_ALLOC
+        return NULL;
+    }
+
+    /* set query */
+    if ((query->q = strndup(q, q_len)) == NULL)
+    {
+        ERR_ALLOC
+        free(query);
+        return NULL;
+    }
+
+    #if SIRIDB_EXPR_ALLOC
+    if ((query->expr_cache = llist_new()) == NULL)
+    {
+        ERR_ALLOC
+        free(query->q);
+        free(query);
+        return NULL;
+    }
+    #endif
+
+    /*
+     * Set start time.
+     * (must be real time since we translate now with this value)
+     */
+    clock_gettime(CLOCK_REALTIME, &query->start);
+
+    /* bind pid, client and flags so we can send back the result */
+    query->pid = pid;
+
+    /* increment client and siridb reference counters */
+    sirinet_stream_incref(client);
+    siridb_incref(client->siridb);
+
+    query->client = client;
+    query->siridb = client->siridb;
+    query->flags = flags;
+
+    /* bind time precision factor */
+    query->factor = factor;
+
+    /* set the default callback, this might change when custom
+     * data is linked to the query handle
+     */
+    query->free_cb = siridb_query_free;
+    query->ref = 1;
+
+    /* We should initialize the packer based on query type */
+    query->packer = NULL;
+    query->timeit = NULL;
+    query->profile = NULL;
+
+    /* make sure all *other* pointers are set to NULL */
+    query->data = NULL;
+    query->pr = NULL;
+    query->cached = NULL;
+    query->nodes = NULL;
+
+    /* increment active tasks */
+    siridb_tasks_inc(client->siridb->tasks);
+
+    return query;
+}
+
+/*
+ * Returns the packed plan for a select query or NULL when the query has no
+ * plan or the plan cannot be packed.
+ */
+static qp_packer_t * QUERY_plan_pack(query_select_t * q_select)
+{
+    assert (q_select->tp == QUERIES_SELECT);
+
+    return (q_select->plan == NULL) ? NULL : siridb_plan_pack(
+            q_select->plan,
+            (q_select->flags & QUERIES_SKIP_GET_POINTS) ?
+                    SIRIDB_PLAN_FLAG_SKIP_GET_POINTS : 0,
+            q_select->start_ts,
+            q_select->end_ts,
+            q_select->headtail,
+            q_select->merge_as,
+            q_select->mlist);
+}
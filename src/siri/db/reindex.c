@@ -26,6 +26,7 @@
 #include <siri/db/server.h>
 #include <siri/db/servers.h>
 #include <siri/err.h>
+#include <siri/expire.h>
 #include <siri/net/protocol.h>
 #include <siri/optimize.h>
 #include <stddef.h>
@@ -114,7 +115,9 @@ siridb_reindex_t * siridb_reindex_open(siridb_t * siridb, int create_new)
                 else
                 {
                     siridb->pools->prev_lookup =
-                            siridb_lookup_new(siridb->pools->len - 1);
+                            siridb_lookup_new(
+                                    siridb->pools->len - 1,
+                                    siridb->placement);
                     if (siridb->pools->prev_lookup == NULL)
                     {
                         siridb_reindex_free(&reindex);  /* signal is raised */
@@ -304,9 +307,9 @@ void siridb_reindex_start(uv_timer_t * timer)
     else
     {
         assert (siri.optimize->pause);
-        if (!SIRI_OPTIMZE_IS_PAUSED)
+        if (!SIRI_OPTIMZE_IS_PAUSED || siri_expire_is_running())
         {
-            log_debug("Wait for the optimize task to pause");
+            log_debug("Wait for the optimize and expire tasks to pause");
             uv_timer_start(timer, siridb_reindex_start, 1000, 0);
         }
         else
@@ -46,6 +46,7 @@ int siridb_replicate_init(siridb_t * siridb, siridb_initsync_t * initsync)
     }
 
     siridb->replicate->initsync = initsync;
+    siridb->replicate->pending = 0;
 
     siridb->replicate->timer = malloc(sizeof(uv_timer_t));
     if (siridb->replicate->timer == NULL)
@@ -107,9 +108,13 @@ void siridb_replicate_free(siridb_replicate_t ** replicate)
 int siridb_replicate_pkg(siridb_t * siridb, sirinet_pkg_t * pkg)
 {
     int rc = siridb_fifo_append(siridb->fifo, pkg);
-    if (!rc && siridb_replicate_is_idle(siridb->replicate))
+    if (!rc)
     {
-        siridb_replicate_start(siridb->replicate);
+        siridb->replicate->pending++;
+        if (siridb_replicate_is_idle(siridb->replicate))
+        {
+            siridb_replicate_start(siridb->replicate);
+        }
     }
     return rc;
 }
@@ -352,6 +357,12 @@ static void REPLICATE_on_repl_response(
         break;
     }
 
+    /* packages from before a restart are not counted as pending */
+    if (status != PROMISE_WRITE_ERROR && siridb->replicate->pending)
+    {
+        siridb->replicate->pending--;
+    }
+
     if (siridb->replicate->status != REPLICATE_CLOSED)
     {
         uv_timer_start(
@@ -6,11 +6,15 @@
  *
  *  Main thread:
  *      siridb->series_map :    read (no lock)      write (lock)
+ *      siridb->series_slots :  read (no lock)      write (lock)
  *      series->idx :           read (lock)         write (lock)
+ *      shard->series :         read (lock)         write (lock)
  *
  *  Other threads:
  *      siridb->series_map :    read (lock)          write (not allowed)
+ *      siridb->series_slots :  read (lock)          write (not allowed)
  *      series->idx :           read (lock)         write (lock)
+ *      shard->series :         read (lock)         write (lock)
  *
  *  Note:   One exception to 'not allowed' are the free functions
  *          since they only run when no other references to the object exist.
@@ -39,6 +43,16 @@
 #define SIRIDB_SERIES_SCHEMA 1
 #define DROPPED_DUMMY 1
 
+/*
+ * Counter for local series in the lookup slot of a series. The counters are
+ * updated together with siridb->series_map.
+ */
+#define SERIES_slot(siridb__, series__) (siridb__)->series_slots[ \
+        siridb_lookup_slot(                                         \
+            (siridb__)->placement,                                  \
+            (series__)->name,                                       \
+            (series__)->name_len)]
+
 /*
  * Used for storing double and integers as string. this is not very important
  * if it will not store all characters generated so 64 is more than enough
@@ -326,6 +340,8 @@ siridb_series_t * siridb_series_new(
         return NULL;
     }
 
+    SERIES_slot(siridb, series)++;
+
     /* we can ignore the result code since this is not critical and logging
      * is done by the function.
      */
@@ -424,6 +440,13 @@ int siridb_series_add_idx(
 {
     idx_t * idx;
     uint32_t i = series->idx_len;
+
+    if (siridb_shard_add_series(shard, series->id))
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
     series->idx_len++;
 
     /* never zero */
@@ -483,7 +506,10 @@ int siridb_series_add_idx(
 void siridb_series_drop_prepare(siridb_t * siridb, siridb_series_t * series)
 {
     /* remove series from map */
-    imap_pop(siridb->series_map, series->id);
+    if (imap_pop(siridb->series_map, series->id) != NULL)
+    {
+        SERIES_slot(siridb, series)--;
+    }
 
     /* remove series from tree */
     ct_pop(siridb->series, series->name);
@@ -615,6 +641,8 @@ void siridb_series_remove_shard(
 
     if (offset)
     {
+        (void) imap_pop(shard->series, series->id);
+
         if (!series->length)
         {
             series->idx_len = 0;
@@ -656,6 +684,7 @@ void siridb_series_remove_shard(
             {
                 SERIES_update_end(series);
             }
+            siridb_zones_update(siridb, series);
         }
     }
 }
@@ -679,6 +708,7 @@ void siridb_series_update_props(siridb_t * siridb, siridb_series_t * series)
     {
         SERIES_update_start(series);
         SERIES_update_end(series);
+        siridb_zones_update(siridb, series);
 
         if (!series->length)
         {
@@ -1290,6 +1320,13 @@ int siridb_series_optimize_shard(
         return rc;
     }
 
+    /* the new shard must know this series before indexes are moved */
+    if (siridb_shard_add_series(shard, series->id))
+    {
+        ERR_ALLOC
+        return -1;
+    }
+
     end += new_idx;
 
     size_t pos;
@@ -1838,6 +1875,7 @@ static int SERIES_load(siridb_t * siridb, imap_t * dropped)
 
                     (void) ct_pop(siridb->series, series->name);
                     (void) imap_pop(siridb->series_map, other->id);
+                    SERIES_slot(siridb, other)--;
 
                     siridb__series_free(other);
 
@@ -1849,6 +1887,7 @@ static int SERIES_load(siridb_t * siridb, imap_t * dropped)
                     log_critical("series cannot be added");
                     return -1;
                 }
+                SERIES_slot(siridb, series)++;
             }
         }
     }
@@ -10,6 +10,7 @@
 #include <siri/db/fifo.h>
 #include <siri/db/tee.h>
 #include <siri/err.h>
+#include <siri/metrics.h>
 #include <siri/net/promise.h>
 #include <siri/net/stream.h>
 #include <siri/net/tcp.h>
@@ -25,7 +26,22 @@
 #define FMT_AS_IPV6(addr) (strchr(addr, ':') != NULL)
 
 static int SERVER_update_name(siridb_server_t * server);
-static void SERVER_timeout_pkg(uv_timer_t * handle);
+static int SERVER_send_pkg(
+        siridb_server_t * server,
+        sirinet_stream_t * client,
+        sirinet_pkg_t * pkg,
+        uint64_t timeout,
+        sirinet_promise_cb cb,
+        void * data,
+        int flags);
+static sirinet_stream_t * SERVER_stream(siridb_server_t * server, uint8_t tp);
+static sirinet_stream_t * SERVER_stream_new(
+        siridb_t * siridb,
+        siridb_server_t * server);
+static void SERVER_connect_stream(
+        siridb_server_t * server,
+        sirinet_stream_t * client);
+static void SERVER_timeout_pkg(sirinet_twheel_entry_t * entry);
 static void SERVER_write_cb(uv_write_t * req, int status);
 static void SERVER_on_auth_response(
         sirinet_promise_t * promise,
@@ -41,10 +57,11 @@ static void SERVER_on_resolved(
         int status,
         struct addrinfo * res);
 static int SERVER_resolve_dns(
-        siridb_server_t * server,
+        sirinet_stream_t * client,
         int ai_family,
         uv_getaddrinfo_cb getaddrinfo_cb);
 static void SERVER_on_data(sirinet_stream_t * client, sirinet_pkg_t * pkg);
+static void SERVER_on_frame(siridb_server_t * server, sirinet_pkg_t * pkg);
 static void SERVER_cancel_promise(sirinet_promise_t * promise);
 static void SERVER_upd_flag_queue_full(siridb_server_t * server);
 
@@ -96,7 +113,11 @@ siridb_server_t * siridb_server_new(
 
     /* we set the promises later because we don't need one for self */
     server->promises = NULL;
+    server->twheel = NULL;
     server->client = NULL;
+    memset(server->extra, 0, sizeof(server->extra));
+    server->extra_auth = 0;
+    server->extra_next = 0;
 
     /* sets address:port to name property */
     if (SERVER_update_name(server))
@@ -119,6 +140,7 @@ siridb_server_t * siridb_server_new(
  *
  * (default timeout PROMISE_DEFAULT_TIMEOUT is used when timeout 0 is set)
  *
+ * The connection is selected by the package type, see SERVER_stream().
  */
 int siridb_server_send_pkg(
         siridb_server_t * server,
@@ -129,25 +151,40 @@ int siridb_server_send_pkg(
         int flags)
 {
     assert (server->client != NULL);
+    return SERVER_send_pkg(
+            server,
+            SERVER_stream(server, pkg->tp),
+            pkg,
+            timeout,
+            cb,
+            data,
+            flags);
+}
+
+/*
+ * Send a package using the given connection. All connections to a server
+ * share the same promises so a response can be received on any of them.
+ */
+static int SERVER_send_pkg(
+        siridb_server_t * server,
+        sirinet_stream_t * client,
+        sirinet_pkg_t * pkg,
+        uint64_t timeout,
+        sirinet_promise_cb cb,
+        void * data,
+        int flags)
+{
     assert (server->promises != NULL);
     assert (cb != NULL);
     int rc;
     uint8_t n = 0;
-    sirinet_promise_t * promise = malloc(sizeof(sirinet_promise_t));
+    sirinet_promise_t * promise = sirinet_promise_new();
     if (promise == NULL)
     {
         ERR_ALLOC
         return -1;
     }
 
-    promise->timer = malloc(sizeof(uv_timer_t));
-    if (promise->timer == NULL)
-    {
-        ERR_ALLOC
-        free(promise);
-        return -1;
-    }
-    promise->timer->data = promise;
     promise->cb = cb;
     promise->pkg = (flags & FLAG_KEEP_PKG) ? NULL : pkg;
     promise->ref = 2;
@@ -157,13 +194,13 @@ int siridb_server_send_pkg(
      */
     promise->server = server;
     promise->data = data;
+    promise->sent = siri_metrics_now();
 
     uv_write_t * req = malloc(sizeof(uv_write_t));
     if (req == NULL)
     {
         ERR_ALLOC
-        free(promise->timer);
-        free(promise);
+        sirinet_promise_free(promise);
         return -1;
     }
 
@@ -185,8 +222,7 @@ int siridb_server_send_pkg(
         if (rc == OMAP_ERR_ALLOC)
         {
             /* memory allocation error */
-            free(promise->timer);
-            free(promise);
+            sirinet_promise_free(promise);
             free(req);
             ERR_ALLOC
             return -1;
@@ -204,20 +240,25 @@ int siridb_server_send_pkg(
          */
         log_critical("Cannot add promise to queue for '%s'", server->name);
         ERR_C
-        free(promise->timer);
-        free(promise);
+        sirinet_promise_free(promise);
         free(req);
         return -1;
     }
 
-    pkg->pid = promise->pid;
+    if (sirinet_twheel_add(
+            server->twheel,
+            &promise->tentry,
+            (timeout) ? timeout : PROMISE_DEFAULT_TIMEOUT))
+    {
+        omap_rm(server->promises, promise->pid);
+        SERVER_upd_flag_queue_full(server);
+        sirinet_promise_free(promise);
+        free(req);
+        ERR_ALLOC
+        return -1;
+    }
 
-    uv_timer_init(siri.loop, promise->timer);
-    uv_timer_start(
-            promise->timer,
-            SERVER_timeout_pkg,
-            (timeout) ? timeout : PROMISE_DEFAULT_TIMEOUT,
-            0);
+    pkg->pid = promise->pid;
 
     log_debug("Sending (pid: %" PRIu16 ", len: %" PRIu32 ", tp: %s) to '%s'",
             pkg->pid,
@@ -236,7 +277,7 @@ int siridb_server_send_pkg(
 
     uv_write(
             req,
-            server->client->stream,
+            client->stream,
             &wrbuf,
             1,
             SERVER_write_cb);
@@ -244,6 +285,38 @@ int siridb_server_send_pkg(
     return 0;
 }
 
+/*
+ * Returns the connection for a package type.
+ *
+ * The control connection (server->client) is used for authentication, flags
+ * and other small requests. Inserts, replication and other updates need to
+ * stay in order so they always use the control connection as well. Queries
+ * are spread over the extra connections so a large select response cannot
+ * delay heart-beats or inserts.
+ *
+ * The control connection is used as long as the selected extra connection
+ * is not authenticated.
+ */
+static sirinet_stream_t * SERVER_stream(siridb_server_t * server, uint8_t tp)
+{
+    int n = siri.cfg->server_connections - 1;
+    int i;
+
+    switch ((bproto_client_t) tp)
+    {
+    case BPROTO_QUERY_SERVER:
+    case BPROTO_REQ_GROUPS:
+    case BPROTO_REQ_TAGS:
+        i = (n > 0) ? server->extra_next++ % n : -1;
+        break;
+    default:
+        i = -1;
+    }
+
+    return (i >= 0 && (server->extra_auth & (1 << i))) ?
+            server->extra[i] : server->client;
+}
+
 /*
  * Register and return a new server from qpack data.
  * The qpack data should contain: [uuid, address, port, pool]
@@ -281,7 +354,7 @@ siridb_server_t * siridb_server_register(
 
         if (server != NULL)
         {
-            if (    (server->promises = omap_create()) == NULL ||
+            if (    siridb_server_init_promises(server) ||
                     siridb_servers_register(siridb, server))
             {
                 siridb__server_free(server);
@@ -293,6 +366,19 @@ siridb_server_t * siridb_server_register(
     return server;
 }
 
+/*
+ * Create the promises map and time-out wheel. Only servers other than
+ * 'this' server need promises.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_server_init_promises(siridb_server_t * server)
+{
+    server->promises = omap_create();
+    server->twheel = sirinet_twheel_new(siri.loop, SERVER_timeout_pkg);
+    return (server->promises == NULL || server->twheel == NULL) ? -1 : 0;
+}
+
 /*
  * This function can raise a SIGNAL.
  */
@@ -385,6 +471,9 @@ int siridb_server_update_address(
 
 /*
  * Connect to a SiriDB Server.
+ *
+ * Only the control connection is created, extra connections are created
+ * when authentication on the control connection was successful.
  */
 void siridb_server_connect(siridb_t * siridb, siridb_server_t * server)
 {
@@ -392,72 +481,159 @@ void siridb_server_connect(siridb_t * siridb, siridb_server_t * server)
     assert (server->client == NULL);
 
     ++server->retry_attempts;
-    server->client = sirinet_stream_new(STREAM_TCP_SERVER, &SERVER_on_data);
+    server->client = SERVER_stream_new(siridb, server);
 
     if (server->client != NULL)
     {
-        struct in_addr sa;
-        struct in6_addr sa6;
-        server->client->origin = server;
-        server->client->siridb = siridb;
-        siridb_incref(siridb);
-        siridb_server_incref(server);
-        uv_tcp_init(siri.loop, (uv_tcp_t *) server->client->stream);
+        SERVER_connect_stream(server, server->client);
+    }
+}
 
-        if (inet_pton(AF_INET, server->address, &sa))
-        {
-            /* IPv4 */
-            struct sockaddr_in dest;
+/*
+ * Create the missing extra connections to a server, the number of extra
+ * connections depends on the 'server_connections' option.
+ */
+void siridb_server_connect_extra(siridb_t * siridb, siridb_server_t * server)
+{
+    int i, n = siri.cfg->server_connections - 1;
 
-            uv_connect_t * req = malloc(sizeof(uv_connect_t));
-            if (req == NULL)
+    for (i = 0; i < n; i++)
+    {
+        if (server->extra[i] == NULL)
+        {
+            server->extra[i] = SERVER_stream_new(siridb, server);
+            if (server->extra[i] == NULL)
             {
-                ERR_ALLOC
-                sirinet_stream_decref(server->client);
+                return;
             }
-            else
+            SERVER_connect_stream(server, server->extra[i]);
+        }
+    }
+}
+
+/*
+ * Called when a connection to a server is closed.
+ *
+ * When the control connection is lost, the server is marked as offline and
+ * the extra connections are closed as well.
+ */
+void siridb_server_stream_closed(
+        siridb_server_t * server,
+        sirinet_stream_t * client)
+{
+    sirinet_stream_t * extra;
+    int i;
+
+    if (client == server->client)
+    {
+        server->client = NULL;
+        server->flags = 0;
+
+        for (i = 0; i < SIRIDB_SERVER_MAX_CONNECTIONS - 1; i++)
+        {
+            if ((extra = server->extra[i]) != NULL)
             {
-                log_debug("Trying to connect to '%s'...", server->name);
-                uv_ip4_addr(server->address, server->port, &dest);
-                uv_tcp_connect(
-                        req,
-                        (uv_tcp_t *) server->client->stream,
-                        (const struct sockaddr *) &dest,
-                        SERVER_on_connect);
+                server->extra[i] = NULL;
+                sirinet_stream_decref(extra);
             }
         }
-        else if (inet_pton(AF_INET6, server->address, &sa6))
+        server->extra_auth = 0;
+        return;
+    }
+
+    for (i = 0; i < SIRIDB_SERVER_MAX_CONNECTIONS - 1; i++)
+    {
+        if (client == server->extra[i])
         {
-            /* IPv6 */
-            struct sockaddr_in6 dest6;
+            server->extra[i] = NULL;
+            server->extra_auth &= ~(1 << i);
+            return;
+        }
+    }
+}
 
-            uv_connect_t * req = malloc(sizeof(uv_connect_t));
-            if (req == NULL)
-            {
-                ERR_ALLOC
-                sirinet_stream_decref(server->client);
-            }
-            else
-            {
-                log_debug("Trying to connect to '%s'...", server->name);
-                uv_ip6_addr(server->address, server->port, &dest6);
-                uv_tcp_connect(
-                        req,
-                        (uv_tcp_t *) server->client->stream,
-                        (const struct sockaddr *) &dest6,
-                        SERVER_on_connect);
-            }
+/*
+ * Returns a new server stream or NULL in case of an error.
+ * (a SIGNAL might be raised)
+ */
+static sirinet_stream_t * SERVER_stream_new(
+        siridb_t * siridb,
+        siridb_server_t * server)
+{
+    sirinet_stream_t * client;
+
+    client = sirinet_stream_new(STREAM_TCP_SERVER, &SERVER_on_data);
+    if (client != NULL)
+    {
+        client->origin = server;
+        client->siridb = siridb;
+        siridb_incref(siridb);
+        siridb_server_incref(server);
+        uv_tcp_init(siri.loop, (uv_tcp_t *) client->stream);
+    }
+    return client;
+}
+
+static void SERVER_connect_stream(
+        siridb_server_t * server,
+        sirinet_stream_t * client)
+{
+    struct in_addr sa;
+    struct in6_addr sa6;
+
+    if (inet_pton(AF_INET, server->address, &sa))
+    {
+        /* IPv4 */
+        struct sockaddr_in dest;
+
+        uv_connect_t * req = malloc(sizeof(uv_connect_t));
+        if (req == NULL)
+        {
+            ERR_ALLOC
+            sirinet_stream_decref(client);
         }
         else
         {
-            /* Try DNS */
-            if (SERVER_resolve_dns(
-                    server,
-                    dns_req_family_map(siri.cfg->ip_support),
-                    SERVER_on_resolved))
-            {
-                sirinet_stream_decref(server->client);
-            }
+            log_debug("Trying to connect to '%s'...", server->name);
+            uv_ip4_addr(server->address, server->port, &dest);
+            uv_tcp_connect(
+                    req,
+                    (uv_tcp_t *) client->stream,
+                    (const struct sockaddr *) &dest,
+                    SERVER_on_connect);
+        }
+    }
+    else if (inet_pton(AF_INET6, server->address, &sa6))
+    {
+        /* IPv6 */
+        struct sockaddr_in6 dest6;
+
+        uv_connect_t * req = malloc(sizeof(uv_connect_t));
+        if (req == NULL)
+        {
+            ERR_ALLOC
+            sirinet_stream_decref(client);
+        }
+        else
+        {
+            log_debug("Trying to connect to '%s'...", server->name);
+            uv_ip6_addr(server->address, server->port, &dest6);
+            uv_tcp_connect(
+                    req,
+                    (uv_tcp_t *) client->stream,
+                    (const struct sockaddr *) &dest6,
+                    SERVER_on_connect);
+        }
+    }
+    else
+    {
+        /* Try DNS */
+        if (SERVER_resolve_dns(
+                client,
+                dns_req_family_map(siri.cfg->ip_support),
+                SERVER_on_resolved))
+        {
+            sirinet_stream_decref(client);
         }
     }
 }
@@ -470,10 +646,11 @@ void siridb_server_connect(siridb_t * siridb, siridb_server_t * server)
  * callback will not be called.
  */
 static int SERVER_resolve_dns(
-        siridb_server_t * server,
+        sirinet_stream_t * client,
         int ai_family,
         uv_getaddrinfo_cb getaddrinfo_cb)
 {
+    siridb_server_t * server = client->origin;
 
     struct addrinfo hints;
     hints.ai_family = ai_family;
@@ -490,7 +667,7 @@ static int SERVER_resolve_dns(
     }
 
     int result;
-    resolver->data = server;
+    resolver->data = client;
 
     char port[6]= {'\0'};
     sprintf(port, "%u", server->port);
@@ -520,7 +697,8 @@ static void SERVER_on_resolved(
         int status,
         struct addrinfo * res)
 {
-    siridb_server_t * server = resolver->data;
+    sirinet_stream_t * client = resolver->data;
+    siridb_server_t * server = client->origin;
 
     if (status < 0)
     {
@@ -528,7 +706,7 @@ static void SERVER_on_resolved(
                 server->name,
                 uv_err_name(status));
 
-        sirinet_stream_decref(server->client);
+        sirinet_stream_decref(client);
     }
     else
     {
@@ -560,12 +738,13 @@ static void SERVER_on_resolved(
         if (req == NULL)
         {
             ERR_ALLOC
+            sirinet_stream_decref(client);
         }
         else
         {
             uv_tcp_connect(
                     req,
-                    (uv_tcp_t *) server->client->stream,
+                    (uv_tcp_t *) client->stream,
                     (const struct sockaddr *) res->ai_addr,
                     SERVER_on_connect);
         }
@@ -576,11 +755,13 @@ static void SERVER_on_resolved(
 }
 
 /*
- * Update SERVER_FLAG_QUEUE_FULL based on number of promises.
+ * Update SERVER_FLAG_QUEUE_FULL based on number of promises. Each configured
+ * connection adds to the queue size.
  */
 static void SERVER_upd_flag_queue_full(siridb_server_t * server)
 {
-    if (server->promises->n >= SIRIDB_SERVER_PROMISES_QUEUE_SIZE)
+    if (server->promises->n >=
+            SIRIDB_SERVER_PROMISES_QUEUE_SIZE * siri.cfg->server_connections)
     {
         server->flags |= SERVER_FLAG_QUEUE_FULL;
     }
@@ -614,9 +795,7 @@ static void SERVER_write_cb(uv_write_t * req, int status)
             return;
         }
         SERVER_upd_flag_queue_full(promise->server);
-
-        uv_timer_stop(promise->timer);
-        uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
+        sirinet_twheel_remove(promise->server->twheel, &promise->tentry);
 
         promise->cb(promise, NULL, PROMISE_WRITE_ERROR);
     }
@@ -630,9 +809,9 @@ static void SERVER_write_cb(uv_write_t * req, int status)
 /*
  * Timeout received.
  */
-static void SERVER_timeout_pkg(uv_timer_t * handle)
+static void SERVER_timeout_pkg(sirinet_twheel_entry_t * entry)
 {
-    sirinet_promise_t * promise = handle->data;
+    sirinet_promise_t * promise = entry->data;
 
     if (omap_rm(promise->server->promises, promise->pid) == NULL)
     {
@@ -651,9 +830,6 @@ static void SERVER_timeout_pkg(uv_timer_t * handle)
                 promise->pid,
                 promise->server->name);
     }
-    /* the timer is stopped but we still need to close the timer */
-    uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
-
     promise->cb(promise, NULL, PROMISE_TIMEOUT_ERROR);
 }
 
@@ -672,7 +848,10 @@ static void SERVER_on_connect(uv_connect_t * req, int status)
                 "Connection created to back-end server: '%s', "
                 "sending authentication request", server->name);
 
-        server->retry_attempts = 0;  /* reset connection attempts */
+        if (client == server->client)
+        {
+            server->retry_attempts = 0;  /* reset connection attempts */
+        }
 
         uv_read_start(
                 req->handle,
@@ -710,12 +889,14 @@ static void SERVER_on_connect(uv_connect_t * req, int status)
             {
                 pkg = sirinet_packer2pkg(packer, 0, BPROTO_AUTH_REQUEST);
 
-                if (siridb_server_send_pkg(
+                /* authenticate on this connection */
+                if (SERVER_send_pkg(
                         server,
+                        client,
                         pkg,
                         0,
                         (sirinet_promise_cb) SERVER_on_auth_response,
-                        NULL,
+                        client,
                         0))
                 {
                     free(pkg);
@@ -741,7 +922,15 @@ static void SERVER_on_connect(uv_connect_t * req, int status)
 static void SERVER_on_data(sirinet_stream_t * client, sirinet_pkg_t * pkg)
 {
     siridb_server_t * server = client->origin;
-    sirinet_promise_t * promise = omap_rm(server->promises, pkg->pid);
+    sirinet_promise_t * promise;
+
+    if (pkg->tp == BPROTO_RES_FRAME)
+    {
+        SERVER_on_frame(server, pkg);
+        return;
+    }
+
+    promise = omap_rm(server->promises, pkg->pid);
 
     log_debug(
             "Response received (pid: %" PRIu16
@@ -762,12 +951,82 @@ static void SERVER_on_data(sirinet_stream_t * client, sirinet_pkg_t * pkg)
     else
     {
         SERVER_upd_flag_queue_full(promise->server);
-        uv_timer_stop(promise->timer);
-        uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
+        sirinet_twheel_remove(server->twheel, &promise->tentry);
         promise->cb(promise, pkg, PROMISE_SUCCESS);
     }
 }
 
+/*
+ * A large response can be split into frames. The promise is kept until the
+ * last frame is received and then promise->cb() is called with the complete
+ * package.
+ */
+static void SERVER_on_frame(siridb_server_t * server, sirinet_pkg_t * pkg)
+{
+    sirinet_promise_t * promise = omap_get(server->promises, pkg->pid);
+    sirinet_pkg_t * full;
+    int rc;
+
+    if (promise == NULL)
+    {
+        /* only warn once for each response, the other frames are dropped */
+        if (sirinet_pkg_frame_is_first(pkg))
+        {
+            log_warning(
+                    "Received a frame (PID %" PRIu16
+                    ") from server '%s' which has probably timed-out earlier.",
+                    pkg->pid,
+                    server->name);
+        }
+        else
+        {
+            log_debug(
+                    "Dropped a frame (PID %" PRIu16
+                    ") from server '%s' which has timed-out earlier.",
+                    pkg->pid,
+                    server->name);
+        }
+        return;
+    }
+
+    rc = sirinet_pkg_frame_add(&promise->frames, &promise->frames_n, pkg);
+    if (rc == 0)
+    {
+        return;  /* more frames are expected */
+    }
+
+    (void) omap_rm(server->promises, pkg->pid);
+    SERVER_upd_flag_queue_full(server);
+    sirinet_twheel_remove(server->twheel, &promise->tentry);
+
+    if (rc < 0)
+    {
+        log_error(
+                "Invalid frame (PID %" PRIu16 ") received from server '%s'",
+                pkg->pid,
+                server->name);
+        free(promise->frames);
+        promise->frames = NULL;
+        promise->cb(promise, NULL, PROMISE_PKG_TYPE_ERROR);
+        return;
+    }
+
+    /* take the package since the call-back might free the promise */
+    full = promise->frames;
+    promise->frames = NULL;
+
+    log_debug(
+            "Response received (pid: %" PRIu16
+            ", len: %" PRIu32 ", tp: %s) from '%s' using frames",
+            full->pid,
+            full->len,
+            sirinet_bproto_server_str(full->tp),
+            server->name);
+
+    promise->cb(promise, full, PROMISE_SUCCESS);
+    free(full);
+}
+
 /*
  * Returns the current server status (flags) as string. the returned value
  * is created with malloc() so do not forget to free the result.
@@ -939,6 +1198,10 @@ void siridb__server_free(siridb_server_t * server)
     {
         omap_destroy(server->promises, (omap_destroy_cb) SERVER_cancel_promise);
     }
+    if (server->twheel != NULL)
+    {
+        sirinet_twheel_free(server->twheel);
+    }
     free(server->name);
     free(server->address);
     free(server->version);
@@ -1187,11 +1450,7 @@ int siridb_server_cexpr_cb(
  */
 static void SERVER_cancel_promise(sirinet_promise_t * promise)
 {
-    if (!uv_is_closing((uv_handle_t *) promise->timer))
-    {
-        uv_timer_stop(promise->timer);
-        uv_close((uv_handle_t *) promise->timer, (uv_close_cb) free);
-    }
+    sirinet_twheel_remove(promise->server->twheel, &promise->tentry);
     promise->cb(promise, NULL, PROMISE_CANCELLED_ERROR);
 }
 
@@ -1249,32 +1508,68 @@ static void SERVER_on_auth_response(
         sirinet_pkg_t * pkg,
         int status)
 {
+    siridb_server_t * server = promise->server;
+    sirinet_stream_t * client = promise->data;
+    int i;
+
     if (status)
     {
         /* we already have a log entry so this can be a debug log */
         log_debug(
                 "Error while sending authentication request to '%s' (%s)",
-                promise->server->name,
+                server->name,
                 sirinet_promise_strstatus(status));
     }
     else if (pkg->tp == BPROTO_AUTH_SUCCESS)
     {
-        log_info("Successful authenticated to server '%s'",
-                promise->server->name);
+        if (client == server->client)
+        {
+            log_info("Successful authenticated to server '%s'", server->name);
 
-        promise->server->flags |= SERVER_FLAG_AUTHENTICATED;
+            server->flags |= SERVER_FLAG_AUTHENTICATED;
+            siridb_server_connect_extra(client->siridb, server);
+        }
+        else
+        {
+            for (i = 0; i < SIRIDB_SERVER_MAX_CONNECTIONS - 1; i++)
+            {
+                if (client == server->extra[i])
+                {
+                    log_debug(
+                            "Extra connection %d authenticated to "
+                            "server '%s'", i + 1, server->name);
+                    server->extra_auth |= 1 << i;
+                    break;
+                }
+            }
+        }
     }
     else
     {
         log_error("Authentication with server '%s' failed, error code: %d",
-                promise->server->name,
+                server->name,
                 pkg->tp);
     }
 
-    if (    (status || pkg->tp != BPROTO_AUTH_SUCCESS) &&
-            promise->server->client != NULL)
+    if (status || pkg->tp != BPROTO_AUTH_SUCCESS)
     {
-        sirinet_stream_decref(promise->server->client);
+        /* the connection might be closed and replaced in the meantime */
+        if (client == server->client)
+        {
+            sirinet_stream_decref(client);
+        }
+        else
+        {
+            for (i = 0; i < SIRIDB_SERVER_MAX_CONNECTIONS - 1; i++)
+            {
+                if (client == server->extra[i])
+                {
+                    server->extra[i] = NULL;
+                    sirinet_stream_decref(client);
+                    break;
+                }
+            }
+        }
     }
 
     /* we must free the promise */
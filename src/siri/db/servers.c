@@ -136,8 +136,7 @@ int siridb_servers_load(siridb_t * siridb)
             else
             {
                 /* if this is not me, create promises */
-                server->promises = omap_create();
-                if (server->promises == NULL)
+                if (siridb_server_init_promises(server))
                 {
                     log_critical("Memory allocation error");
                     rc = -1;
@@ -9,13 +9,16 @@
 #include <imap/imap.h>
 #include <limits.h>
 #include <logger/logger.h>
+#include <siri/db/expire.h>
 #include <siri/db/series.h>
 #include <siri/db/shard.h>
 #include <siri/db/shards.h>
 #include <siri/db/points.h>
+#include <siri/db/profile.h>
 #include <siri/optimize.h>
 #include <siri/err.h>
 #include <siri/file/pointer.h>
+#include <siri/metrics.h>
 #include <siri/siri.h>
 #include <vec/vec.h>
 #include <stdio.h>
@@ -23,8 +26,8 @@
 #include <unistd.h>
 #include <xstr/xstr.h>
 
-/* max read buffer size used for reading from index file */
-#define SIRIDB_SHARD_MAX_CHUNK_SZ 65536
+/* read buffer size used for scanning index headers in a shard file */
+#define SIRIDB_SHARD_SCAN_SZ 262144
 
 /* growing with this block size */
 #define SHARD_GROW_SZ 131072
@@ -106,21 +109,18 @@ const char shard_type_map[2][7] = {
         "log"
 };
 
-static ssize_t SHARD_apply_idx(
-        siridb_t * siridb,
+static ssize_t SHARD_idx_size(
         siridb_shard_t * shard,
         char * pt,
-        size_t pos,
-        int is_ts64);
-static int SHARD_get_idx(
-        siridb_t * siridb,
-        siridb_shard_t * shard,
         int is_ts64);
-static int SHARD_load_idx(
+static ssize_t SHARD_apply_idx(
         siridb_t * siridb,
         siridb_shard_t * shard,
-        FILE * fp,
+        char * pt,
+        size_t pos,
         int is_ts64);
+static int SHARD_read_idx(siridb_shard_loader_t * loader);
+static void SHARD_read_tail(siridb_shard_loader_t * loader, FILE * fp);
 static inline int SHARD_init_fn(siridb_t * siridb, siridb_shard_t * shard);
 static int SHARD_grow(siridb_shard_t * shard, const size_t required_size);
 static size_t SHARD_write_header(
@@ -132,6 +132,13 @@ static size_t SHARD_write_header(
         uint16_t * cinfo,
         FILE * fp);
 static int SHARD_remove(siridb_shard_t * shard);
+static int SHARD_open_fp(siridb_shard_t * shard);
+static void SHARD_count_read(idx_t * idx, size_t size);
+static int SHARD_series_ref(
+        siridb_t * siridb,
+        siridb_shard_t * shard,
+        imap_t * skip,
+        vec_t ** vec);
 
 uint64_t siridb_shard_duration_from_interval(siridb_t * siridb, uint64_t interval)
 {
@@ -259,27 +266,53 @@ int siridb_shard_migrate(
 }
 
 /*
+ * Load a shard and apply the index to the series.
+ *
  * Returns 0 if successful or -1 in case of an error.
- * When an error occurs, a SIGNAL can be raised in some cases but not for sure.
+ * (a SIGNAL might be raised in case of an error)
  */
 int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
 {
-    int is_ts64;
+    siridb_shard_loader_t * loader = siridb_shard_read(siridb, id, duration);
+    return loader == NULL ? -1 : siridb_shard_apply(siridb, loader);
+}
+
+/*
+ * Read the header and index for a shard without touching the series. This
+ * function does not use any shared state and can therefore run in parallel
+ * for different shards. Use siridb_shard_apply() to finish loading.
+ *
+ * Returns NULL in case of an error.
+ * (a SIGNAL might be raised in case of an error)
+ */
+siridb_shard_loader_t * siridb_shard_read(
+        siridb_t * siridb,
+        uint64_t id,
+        uint64_t duration)
+{
     FILE * fp;
     off_t shard_sz;
+    siridb_shard_loader_t * loader;
     siridb_shard_t * shard = malloc(sizeof(siridb_shard_t));
-    omap_t * shards;
 
     if (shard == NULL)
     {
         ERR_ALLOC
-        return -1;  /* signal is raised */
+        return NULL;  /* signal is raised */
     }
     shard->fp = siri_fp_new();
     if (shard->fp == NULL)
     {
         free(shard);
-        return -1;  /* signal is raised */
+        return NULL;  /* signal is raised */
+    }
+    shard->series = imap_new();
+    if (shard->series == NULL)
+    {
+        siri_fp_decref(shard->fp);
+        free(shard);
+        ERR_ALLOC
+        return NULL;
     }
 
     shard->id = id;
@@ -292,16 +325,29 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
     {
         ERR_ALLOC
         siridb_shard_decref(shard);
-        return -1;  /* signal is raised */
+        return NULL;  /* signal is raised */
     }
 
+    loader = malloc(sizeof(siridb_shard_loader_t));
+    if (loader == NULL)
+    {
+        ERR_ALLOC
+        siridb_shard_decref(shard);
+        return NULL;  /* signal is raised */
+    }
+
+    loader->shard = shard;
+    loader->data = NULL;
+    loader->n_idx = 0;
+    loader->n_tail = 0;
+
     log_info("Loading shard %" PRIu64, id);
 
     if ((fp = fopen(shard->fn, "r")) == NULL)
     {
         log_error("Cannot open shard file for reading: '%s'", shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     if (fseeko(fp, 0, SEEK_END) ||
@@ -310,8 +356,8 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
     {
         fclose(fp);
         log_critical("Index and/or shard corrupt: '%s'", shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     shard->size = (size_t) shard_sz;
@@ -321,12 +367,12 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
     if (fread(&header, HEADER_SIZE, 1, fp) != 1)
     {
         /* cannot read header from shard file,
-         * close file decrement reference shard and return -1
+         * close file decrement reference shard and return NULL
          */
         fclose(fp);
         log_critical("Missing header in shard file: '%s'", shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     uint8_t schema = (uint8_t) header[HEADER_SCHEMA];
@@ -336,8 +382,8 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
         log_critical(
                 "Shard file '%s' has schema '%u' which is not supported with "
                 "this version of SiriDB.", shard->fn, schema);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     /* set shard type, flags and max_chunk_sz */
@@ -356,64 +402,97 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
                 siridb_time_short_map(time_precision),
                 siridb_time_short_map(siridb->time->precision),
                 shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     switch (shard->tp)
     {
     case SIRIDB_SHARD_TP_NUMBER:
     case SIRIDB_SHARD_TP_LOG:
-        is_ts64 = time_precision > SIRIDB_TIME_SECONDS;
+        loader->is_ts64 = time_precision > SIRIDB_TIME_SECONDS;
+        loader->idx_sz = (
+                (shard->flags & SIRIDB_SHARD_IS_COMPRESSED) ||
+                (shard->tp == SIRIDB_SHARD_TP_LOG)) ?
+                    (loader->is_ts64 ? IDX64E_SZ : IDX32E_SZ) :
+                    (loader->is_ts64 ? IDX64_SZ : IDX32_SZ);
 
-        if (SHARD_get_idx(siridb, shard, is_ts64))
+        if (SHARD_read_idx(loader))
         {
             fclose(fp);
             log_critical("Cannot read index for shard: '%s'", shard->fn);
-            siridb_shard_decref(shard);
-            return -1;
+            siridb_shard_loader_free(loader);
+            return NULL;
         }
 
         if (shard->size > shard->len)
         {
-            if (fseeko(fp, (off_t) shard->len, SEEK_SET))
-            {
-                fclose(fp);
-                log_critical("Seek error in: '%s'", shard->fn);
-                siridb_shard_decref(shard);
-                return -1;
-            }
-
-            SHARD_load_idx(siridb, shard, fp, is_ts64);
+            SHARD_read_tail(loader, fp);
         }
         break;
 
     default:
         fclose(fp);
         log_critical("Unknown type shard file: '%s'", shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
     if (fclose(fp))
     {
         log_critical("Cannot close shard file: '%s'", shard->fn);
-        siridb_shard_decref(shard);
-        return -1;
+        siridb_shard_loader_free(loader);
+        return NULL;
     }
 
-    shards = imap_get(siridb->shards, id);
+    return loader;
+}
+
+/*
+ * Apply the index from a loader to the series and add the shard to the
+ * database. This function must run in the main thread and in the same order
+ * as the shards would be loaded one by one.
+ *
+ * The loader is destroyed by this function.
+ *
+ * Returns 0 if successful or -1 in case of an error.
+ * (a SIGNAL might be raised in case of an error)
+ */
+int siridb_shard_apply(siridb_t * siridb, siridb_shard_loader_t * loader)
+{
+    siridb_shard_t * shard = loader->shard;
+    const unsigned int idx_sz = loader->idx_sz;
+    char * pt = loader->data;
+    size_t i, pos = HEADER_SIZE;
+    omap_t * shards;
+
+    for (i = 0; i < loader->n_idx; i++, pt += idx_sz)
+    {
+        pos += SHARD_apply_idx(siridb, shard, pt, pos, loader->is_ts64);
+    }
+
+    for (i = 0; i < loader->n_tail; i++, pt += idx_sz)
+    {
+        pos += idx_sz;
+        pos += SHARD_apply_idx(siridb, shard, pt, pos, loader->is_ts64);
+    }
+
+    /* the shard is now owned by this function */
+    loader->shard = NULL;
+    siridb_shard_loader_free(loader);
+
+    shards = imap_get(siridb->shards, shard->id);
     if (shards == NULL)
     {
         shards = omap_create();
-        if (shards == NULL || imap_set(siridb->shards, id, shards) == -1)
+        if (shards == NULL || imap_set(siridb->shards, shard->id, shards) == -1)
         {
             siridb_shard_decref(shard);
             return -1;
         }
     }
 
-    if (omap_set(shards, duration, shard) == NULL)
+    if (omap_set(shards, shard->duration, shard) == NULL)
     {
         siridb_shard_decref(shard);
         return -1;
@@ -422,9 +501,34 @@ int siridb_shard_load(siridb_t * siridb, uint64_t id, uint64_t duration)
     /* remove LOADING flag from shard status */
     shard->flags &= ~SIRIDB_SHARD_IS_LOADING;
 
+    if (siridb_expire_add(
+            siridb->expire,
+            shard->id,
+            shard->duration,
+            shard->tp))
+    {
+        /* not critical, the optimize task drops the shard when expired */
+        log_error("Cannot add shard id %" PRIu64 " to the expire heap",
+                shard->id);
+    }
+
     return 0;
 }
 
+/*
+ * Destroy a loader which is not applied.
+ * (a SIGNAL might be raised in case closing the shard file fails)
+ */
+void siridb_shard_loader_free(siridb_shard_loader_t * loader)
+{
+    if (loader->shard != NULL)
+    {
+        siridb_shard_decref(loader->shard);
+    }
+    free(loader->data);
+    free(loader);
+}
+
 /*
  * Create a new shard file and return a siridb_shard_t object.
  *
@@ -451,6 +555,13 @@ siridb_shard_t *  siridb_shard_create(
         free(shard);
         return NULL;  /* signal is raised */
     }
+    if ((shard->series = imap_new()) == NULL)
+    {
+        siri_fp_decref(shard->fp);
+        free(shard);
+        ERR_ALLOC
+        return NULL;
+    }
     shard->id = id;
     shard->ref = 1;
     shard->tp = tp;
@@ -559,6 +670,17 @@ siridb_shard_t *  siridb_shard_create(
      */
     siri_fopen(siri.fh, shard->fp, shard->fn, "r+");
 
+    /*
+     * A replacing shard has the same id and duration as the shard it
+     * replaces, so the one in the expire heap is still valid.
+     */
+    if (replacing == NULL &&
+        siridb_expire_add(siridb->expire, id, duration, tp))
+    {
+        /* not critical, the optimize task drops the shard when expired */
+        log_error("Cannot add shard id %" PRIu64 " to the expire heap", id);
+    }
+
     return shard;
 }
 
@@ -672,7 +794,20 @@ size_t siridb_shard_write_points(
 
     if (shard->flags & SIRIDB_SHARD_IS_COMPRESSED)
     {
-        cdata = siridb_points_zip(points, start, end, cinfo, &dsize);
+        if (points->tp == TP_DOUBLE && siridb->codec != SIRIDB_CODEC_DEFAULT)
+        {
+            cdata = siridb_points_zip_double_bits(
+                    points, start, end, cinfo, &dsize);
+        }
+        else if (points->tp == TP_INT && siridb->codec == SIRIDB_CODEC_BITPACK)
+        {
+            cdata = siridb_points_zip_int_bits(
+                    points, start, end, cinfo, &dsize);
+        }
+        else
+        {
+            cdata = siridb_points_zip(points, start, end, cinfo, &dsize);
+        }
         if (cdata == NULL)
         {
             ERR_ALLOC
@@ -799,15 +934,9 @@ int siridb_shard_get_points_num32(
     uint32_t * temp,* pt;
     size_t len = points->len + idx->len;
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
 
     temp = malloc(sizeof(uint32_t) * idx->len * 3);
@@ -841,6 +970,8 @@ int siridb_shard_get_points_num32(
         return -1;
     }
 
+    SHARD_count_read(idx, 12 * idx->len);
+
     /* set pointer to start */
     pt = temp;
 
@@ -896,15 +1027,9 @@ int siridb_shard_get_points_num64(
     uint64_t * temp, * pt;
     size_t len = points->len + idx->len;
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
 
     temp = malloc(sizeof(uint64_t) * idx->len * 2);
@@ -938,6 +1063,8 @@ int siridb_shard_get_points_num64(
         return -1;
     }
 
+    SHARD_count_read(idx, 16 * idx->len);
+
     /* set pointer to start */
     pt = temp;
 
@@ -991,16 +1118,12 @@ int siridb_shard_get_points_num_compressed(
 {
     unsigned char * bits;
     size_t size = siridb_points_get_size_zipped(idx->cinfo, idx->len);
+    siridb_profile_clock_t clock;
+    uint64_t start;
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
 
     bits = malloc(size);
@@ -1030,6 +1153,10 @@ int siridb_shard_get_points_num_compressed(
         return -1;
     }
 
+    SHARD_count_read(idx, size);
+    start = siri_metrics_now();
+    siridb_profile_start(siridb_profile_local, &clock);
+
     switch (points->tp)
     {
     case TP_INT:
@@ -1055,6 +1182,12 @@ int siridb_shard_get_points_num_compressed(
     case TP_STRING: assert(0);
     }
 
+    siri_metrics_since(SIRI_METRICS_SELECT_DECOMPRESS, start);
+    siridb_profile_stop(
+            siridb_profile_local,
+            SIRIDB_PROFILE_DECOMPRESS,
+            &clock);
+
     free(bits);
     return 0;
 }
@@ -1076,16 +1209,12 @@ int siridb_shard_get_points_log_compressed(
 
     uint8_t * bits;
     size_t size = siridb_points_get_size_log(idx->cinfo);
+    siridb_profile_clock_t clock;
+    uint64_t start;
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
     bits = malloc(size);
     if (bits == NULL)
@@ -1118,6 +1247,10 @@ int siridb_shard_get_points_log_compressed(
         return -1;
     }
 
+    SHARD_count_read(idx, size);
+    start = siri_metrics_now();
+    siridb_profile_start(siridb_profile_local, &clock);
+
     rc = siridb_points_unzip_string(
             points,
             bits,
@@ -1126,6 +1259,12 @@ int siridb_shard_get_points_log_compressed(
             end_ts,
             has_overlap && (idx->shard->flags & SIRIDB_SHARD_HAS_OVERLAP));
 
+    siri_metrics_since(SIRI_METRICS_SELECT_DECOMPRESS, start);
+    siridb_profile_stop(
+            siridb_profile_local,
+            SIRIDB_PROFILE_DECOMPRESS,
+            &clock);
+
     free(bits);
 
     return rc;
@@ -1146,15 +1285,9 @@ int siridb_shard_get_points_log32(
     size_t len = points->len + idx->len;
     size_t dsize = siridb_points_get_size_log(idx->cinfo);
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
 
     tdata = malloc(sizeof(uint32_t) * idx->len);
@@ -1195,6 +1328,8 @@ int siridb_shard_get_points_log32(
         return -1;
     }
 
+    SHARD_count_read(idx, sizeof(uint32_t) * idx->len + dsize);
+
     /* set pointer to start */
     tpt = tdata;
     cpt = cdata;
@@ -1263,15 +1398,9 @@ int siridb_shard_get_points_log64(
     size_t len = points->len + idx->len;
     size_t dsize = siridb_points_get_size_log(idx->cinfo);
 
-    if (idx->shard->fp->fp == NULL)
+    if (SHARD_open_fp(idx->shard))
     {
-        if (siri_fopen(siri.fh, idx->shard->fp, idx->shard->fn, "r+"))
-        {
-            log_critical(
-                    "Cannot open file '%s', skip reading points",
-                    idx->shard->fn);
-            return -1;
-        }
+        return -1;
     }
 
     tdata = malloc(sizeof(uint64_t) * idx->len);
@@ -1312,6 +1441,8 @@ int siridb_shard_get_points_log64(
         return -1;
     }
 
+    SHARD_count_read(idx, sizeof(uint64_t) * idx->len + dsize);
+
     /* set pointer to start */
     tpt = tdata;
     cpt = cdata;
@@ -1439,13 +1570,20 @@ int siridb_shard_optimize(siridb_shard_t * shard, siridb_t * siridb)
 
     uv_mutex_lock(&siridb->series_mutex);
 
-    vec_t * vec = imap_2vec_ref(siridb->series_map);
+    /* only series with chunks in the shard need to be optimized */
+    vec_t * vec = vec_new(shard->series->len);
+    if (vec != NULL && SHARD_series_ref(siridb, shard, NULL, &vec))
+    {
+        vec_destroy(vec, (vec_destroy_cb) siridb__series_decref);
+        vec = NULL;
+    }
 
     uv_mutex_unlock(&siridb->series_mutex);
 
     if (vec == NULL)
     {
         ERR_ALLOC
+        siridb_shard_decref(new_shard);
         return -1;
     }
 
@@ -1653,44 +1791,41 @@ void siridb_shard_drop(siridb_shard_t * shard, siridb_t * siridb)
      */
     if (optimizing)
     {
-        vec_t * vec = imap_2vec_ref(siridb->series_map);
+        /* the new shard can have series which are not in the old shard */
+        vec_t * vec = vec_new(shard->series->len);
         size_t i;
 
-        if (vec == NULL)
+        if (    vec == NULL ||
+                SHARD_series_ref(siridb, shard, NULL, &vec) ||
+                SHARD_series_ref(siridb, pop_shard, shard->series, &vec))
         {
             ERR_ALLOC
         }
         else for (i = 0; i < vec->len; i++)
         {
             series = (siridb_series_t *) vec->data[i];
-            if (shard->id % shard->duration == series->mask)
-            {
-                siridb_series_remove_shard(siridb, series, shard);
-                siridb_series_remove_shard(siridb, series, pop_shard);
-            }
-            siridb_series_decref(series);
+            siridb_series_remove_shard(siridb, series, shard);
+            siridb_series_remove_shard(siridb, series, pop_shard);
         }
 
-        vec_free(vec);
+        vec_destroy(vec, (vec_destroy_cb) siridb__series_decref);
     }
     else
     {
-        vec_t * vec = imap_2vec(siridb->series_map);
+        vec_t * vec = vec_new(shard->series->len);
         size_t i;
 
-        if (vec == NULL)
+        if (vec == NULL || SHARD_series_ref(siridb, shard, NULL, &vec))
         {
             ERR_ALLOC
         }
         else for (i = 0; i < vec->len; i++)
         {
             series = (siridb_series_t *) vec->data[i];
-            if (shard->id % shard->duration == series->mask)
-            {
-                siridb_series_remove_shard(siridb, series, shard);
-            }
+            siridb_series_remove_shard(siridb, series, shard);
         }
-        vec_free(vec);
+
+        vec_destroy(vec, (vec_destroy_cb) siridb__series_decref);
     }
 
     if (pop_shard != NULL)
@@ -1724,6 +1859,7 @@ void siridb__shard_free(siridb_shard_t * shard)
 
     uv_mutex_unlock(&siri.fh->lock_);
 
+    imap_free(shard->series, NULL);
     free(shard->fn);
     free(shard);
 }
@@ -1780,33 +1916,23 @@ static int SHARD_remove(siridb_shard_t * shard)
 }
 
 /*
- * This function applies the index on the appropriate series. In case the
- * series is not found, a log line will be displayed if this is the first
- * one in the shard which is not found. The next series which cannot be found
- * is simply ignored. In case the series id is not possible (invalid id),
- * then an log error is displayed and the return value will be -1.
+ * Returns the size of the data which belongs to an index entry. The size is
+ * 0 for an empty entry (series id 0).
  */
-static ssize_t SHARD_apply_idx(
-        siridb_t * siridb,
+static ssize_t SHARD_idx_size(
         siridb_shard_t * shard,
         char * pt,
-        size_t pos,
         int is_ts64)
 {
     ssize_t size;
-    uint16_t len;
-    uint32_t series_id;
-    siridb_series_t * series;
-    uint16_t cinfo = 0;
+    uint16_t len, cinfo;
 
-    series_id = *((uint32_t *) pt);
-    if (series_id == 0)
+    if (*((uint32_t *) pt) == 0)
     {
         return 0;
     }
 
     len = *((uint16_t *) (pt + (is_ts64 ? 20 : 12)));  /* LEN POS IN INDEX  */
-    series = imap_get(siridb->series_map, series_id);
 
     if (shard->tp == SIRIDB_SHARD_TP_LOG)
     {
@@ -1830,6 +1956,45 @@ static ssize_t SHARD_apply_idx(
         size = len * (is_ts64 ? 16 : 12);
     }
 
+    return size;
+}
+
+/*
+ * This function applies the index on the appropriate series. In case the
+ * series is not found, a log line will be displayed if this is the first
+ * one in the shard which is not found. The next series which cannot be found
+ * is simply ignored. In case the series id is not possible (invalid id),
+ * then an log error is displayed and the return value will be -1.
+ */
+static ssize_t SHARD_apply_idx(
+        siridb_t * siridb,
+        siridb_shard_t * shard,
+        char * pt,
+        size_t pos,
+        int is_ts64)
+{
+    ssize_t size;
+    uint16_t len;
+    uint32_t series_id;
+    siridb_series_t * series;
+    uint16_t cinfo = 0;
+
+    series_id = *((uint32_t *) pt);
+    if (series_id == 0)
+    {
+        return 0;
+    }
+
+    len = *((uint16_t *) (pt + (is_ts64 ? 20 : 12)));  /* LEN POS IN INDEX  */
+    series = imap_get(siridb->series_map, series_id);
+    size = SHARD_idx_size(shard, pt, is_ts64);
+
+    if ((shard->flags & SIRIDB_SHARD_IS_COMPRESSED) ||
+        shard->tp == SIRIDB_SHARD_TP_LOG)
+    {
+        cinfo = *((uint16_t *)(pt + (is_ts64 ? IDX64_SZ : IDX32_SZ)));
+    }
+
     if (series == NULL)
     {
         if (series_id > siridb->max_series_id)
@@ -1913,24 +2078,19 @@ static ssize_t SHARD_apply_idx(
 
 /*
  * Read an index file for a shard in case the shard has flag
- * SIRIDB_SHARD_HAS_INDEX set. Returns 0 in case the index was read successful
+ * SIRIDB_SHARD_HAS_INDEX set. The index file is read at once since it only
+ * contains index entries. Returns 0 in case the index was read successful
  * and if the flag was not set. Returns a negative value in case of an error.
  *
  * Member shard->len will be updated according the index.
  */
-static int SHARD_get_idx(
-        siridb_t * siridb,
-        siridb_shard_t * shard,
-        int is_ts64)
+static int SHARD_read_idx(siridb_shard_loader_t * loader)
 {
-    const unsigned int idx_sz = (
-            (shard->flags & SIRIDB_SHARD_IS_COMPRESSED) ||
-            (shard->tp == SIRIDB_SHARD_TP_LOG)) ?
-                (is_ts64 ? IDX64E_SZ : IDX32E_SZ) :
-                (is_ts64 ? IDX64_SZ : IDX32_SZ);
+    siridb_shard_t * shard = loader->shard;
+    const unsigned int idx_sz = loader->idx_sz;
     size_t i, n;
-    char * data, * pt;
-    ssize_t size;
+    off_t fsize;
+    char * pt;
     FILE * fp;
 
     if (~shard->flags & SIRIDB_SHARD_HAS_INDEX)
@@ -1938,16 +2098,6 @@ static int SHARD_get_idx(
         return 0;
     }
 
-    n = SIRIDB_SHARD_MAX_CHUNK_SZ / idx_sz;
-    data = malloc(n * idx_sz);
-
-    if (data == NULL)
-    {
-        log_critical("Memory allocation error");
-        free(data);
-        return -1;
-    }
-
     /* get the index file name */
     siridb_shard_idx_file(fn, shard->fn);
 
@@ -1955,97 +2105,127 @@ static int SHARD_get_idx(
     if (fp == NULL)
     {
         log_critical("Cannot open index file for reading: '%s'", fn);
-        free(data);
         return -1;
     }
 
-    while ((n = fread(data, idx_sz, n, fp)))
+    if (fseeko(fp, 0, SEEK_END) ||
+        (fsize = ftello(fp)) < 0 ||
+        fseeko(fp, 0, SEEK_SET))
     {
-        pt = data;
-        for (i = 0; i < n; i++, pt += idx_sz)
-        {
-            size = SHARD_apply_idx(
-                    siridb,
-                    shard,
-                    pt,
-                    shard->len,
-                    is_ts64);
+        log_critical("Cannot read size of index file: '%s'", fn);
+        fclose(fp);
+        return -1;
+    }
 
-            if (size < 0)
-            {
-                log_critical("Error while reading index file: '%s'", fn);
-                fclose(fp);
-                free(data);
-                return -1;
-            }
+    n = (size_t) fsize / idx_sz;
 
-            shard->len += size;
+    if (n)
+    {
+        loader->data = malloc(n * idx_sz);
+        if (loader->data == NULL)
+        {
+            log_critical("Memory allocation error");
+            fclose(fp);
+            return -1;
+        }
+
+        if (fread(loader->data, idx_sz, n, fp) != n)
+        {
+            log_critical("Error while reading index file: '%s'", fn);
+            fclose(fp);
+            return -1;
         }
     }
 
     fclose(fp);
-    free(data);
 
+    for (i = 0, pt = loader->data; i < n; i++, pt += idx_sz)
+    {
+        shard->len += SHARD_idx_size(shard, pt, loader->is_ts64);
+    }
+
+    loader->n_idx = n;
     return 0;
 }
 
 /*
- * Returns 0 if successful or -1 in case of an error.
+ * Scan the shard file after shard->len for index headers which are not yet
+ * optimized. The file is read sequentially using a large buffer instead of
+ * seeking from one header to the next.
  *
  * A SIGNAL might be raised in case of memory errors. We mark the shard as
  * corrupt in case of disk errors and try to recover on the next optimize
  * cycle.
  */
-static int SHARD_load_idx(
-        siridb_t * siridb,
-        siridb_shard_t * shard,
-        FILE * fp,
-        int is_ts64)
+static void SHARD_read_tail(siridb_shard_loader_t * loader, FILE * fp)
 {
-    const unsigned int idx_sz = (
-            (shard->flags & SIRIDB_SHARD_IS_COMPRESSED) ||
-            (shard->tp == SIRIDB_SHARD_TP_LOG)) ?
-                is_ts64 ? IDX64E_SZ : IDX32E_SZ :
-                is_ts64 ? IDX64_SZ : IDX32_SZ;
-
-    char idx[idx_sz];
-    ssize_t sz;
-    int rc;
-    size_t size, pos;
+    siridb_shard_t * shard = loader->shard;
+    const unsigned int idx_sz = loader->idx_sz;
+    size_t n = loader->n_idx, m = loader->n_idx;
+    size_t pos = shard->len;
+    size_t offset = 0, got = 0;
+    ssize_t rc, sz;
+    char * buf, * pt, * tmp;
+    int fd = fileno(fp);
+
+    buf = malloc(SIRIDB_SHARD_SCAN_SZ);
+    if (buf == NULL)
+    {
+        ERR_ALLOC
+        return;
+    }
 
-    while ((size = fread(&idx, 1, idx_sz, fp)) == idx_sz)
+    while (pos + idx_sz <= shard->size)
     {
-        pos = shard->len + idx_sz;
+        if (pos < offset || pos + idx_sz > offset + got)
+        {
+            offset = pos;
+            rc = pread(fd, buf, SIRIDB_SHARD_SCAN_SZ, (off_t) offset);
+            if (rc < (ssize_t) idx_sz)
+            {
+                log_error(
+                    "Read error in shard %" PRIu64 " (%s) at position %zu. "
+                    "Mark this shard as corrupt. The next optimize cycle "
+                    "will most likely fix this shard but you might loose "
+                    "some data.",
+                    shard->id,
+                    shard->fn,
+                    pos);
+                shard->flags |= SIRIDB_SHARD_IS_CORRUPT;
+                break;
+            }
+            got = (size_t) rc;
+        }
+
+        pt = buf + (pos - offset);
 
-        sz = SHARD_apply_idx(siridb, shard, idx, pos, is_ts64);
+        sz = SHARD_idx_size(shard, pt, loader->is_ts64);
         if (sz == 0)
         {
             break;
         }
-        else if (sz < 0)
-        {
-            return -1;
-        }
 
-        rc = fseeko(fp, sz, SEEK_CUR);  /* 16 = NUM64 point size  */
-        if (rc != 0)
+        if (n == m)
         {
-            log_error(
-                "Seek error in shard %" PRIu64 " (%s) at position %ld. "
-                "Mark this shard as corrupt. The next optimize cycle will "
-                "most likely fix this shard but you might loose some data.",
-                shard->id,
-                shard->fn,
-                pos);
-            shard->flags |= SIRIDB_SHARD_IS_CORRUPT;
-            return -1;
+            m = m ? m * 2 : 64;
+            tmp = realloc(loader->data, m * idx_sz);
+            if (tmp == NULL)
+            {
+                ERR_ALLOC
+                break;
+            }
+            loader->data = tmp;
         }
 
+        memcpy(loader->data + n * idx_sz, pt, idx_sz);
+        ++n;
+
         shard->flags |= SIRIDB_SHARD_HAS_NEW_VALUES;
-        shard->len = pos + sz;
+        shard->len = pos = pos + idx_sz + sz;
     }
 
-    return siri_err;
+    loader->n_tail = n - loader->n_idx;
+    free(buf);
 }
 
 /*
@@ -2152,3 +2332,123 @@ static int SHARD_grow(siridb_shard_t * shard, const size_t required_size)
 
     return 0;
 }
+
+/*
+ * Make sure the shard file is open for reading. Shard files stay open in the
+ * file handler until they are pushed out by other files, so a read which
+ * finds the file open counts as a cache hit.
+ *
+ * Returns 0 if successful or -1 when the file cannot be opened.
+ */
+static int SHARD_open_fp(siridb_shard_t * shard)
+{
+    if (shard->fp->fp != NULL)
+    {
+        siri_metrics_incr(SIRI_METRICS_FCACHE_HITS, 1);
+        if (siridb_profile_local != NULL)
+        {
+            siridb_profile_local->cache_hits++;
+        }
+        return 0;
+    }
+
+    siri_metrics_incr(SIRI_METRICS_FCACHE_MISSES, 1);
+    if (siridb_profile_local != NULL)
+    {
+        siridb_profile_local->cache_misses++;
+    }
+
+    if (siri_fopen(siri.fh, shard->fp, shard->fn, "r+"))
+    {
+        log_critical(
+                "Cannot open file '%s', skip reading points",
+                shard->fn);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Count a chunk which is read from a shard. The bytes are added to the
+ * metrics and when the points are read for a profiled query, the chunk is
+ * also added to the profile.
+ */
+static void SHARD_count_read(idx_t * idx, size_t size)
+{
+    siri_metrics_incr(SIRI_METRICS_SHARD_READ_BYTES, size);
+
+    if (siridb_profile_local != NULL)
+    {
+        siridb_profile_local->chunks++;
+        siridb_profile_local->bytes += size;
+        siridb_profile_local->points += idx->len;
+    }
+}
+
+/*
+ * Remember that a series has chunks in a shard. The series_mutex must be
+ * locked, except while loading the database.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_shard_add_series(siridb_shard_t * shard, uint32_t series_id)
+{
+    /* series ids start at 1, the id itself is stored since a series
+     * pointer could be freed while the id is still in the set */
+    return imap_add(
+            shard->series,
+            series_id,
+            (void *) (uintptr_t) series_id) == -1 ? -1 : 0;
+}
+
+/*
+ * Append a reference to each series with chunks in the shard to 'vec'.
+ * Series which are dropped are skipped and so are series which are in 'skip'
+ * (if not NULL). The series_mutex must be locked.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error, in which
+ * case the references which are already in 'vec' are kept.
+ */
+static int SHARD_series_ref(
+        siridb_t * siridb,
+        siridb_shard_t * shard,
+        imap_t * skip,
+        vec_t ** vec)
+{
+    siridb_series_t * series;
+    uint32_t series_id;
+    size_t i;
+    vec_t * ids = imap_2vec(shard->series);
+
+    if (ids == NULL)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < ids->len; i++)
+    {
+        series_id = (uint32_t) (uintptr_t) ids->data[i];
+
+        if (skip != NULL && imap_get(skip, series_id) != NULL)
+        {
+            continue;
+        }
+
+        series = imap_get(siridb->series_map, series_id);
+        if (series == NULL)
+        {
+            continue;
+        }
+
+        if (vec_append_safe(vec, series))
+        {
+            vec_free(ids);
+            return -1;
+        }
+        siridb_series_incref(series);
+    }
+
+    vec_free(ids);
+    return 0;
+}
@@ -30,6 +30,31 @@
 
 #define SIRIDB_SHARD_LEN 37
 
+/* maximum number of threads used for reading shards at startup */
+#define SHARDS_MAX_LOAD_THREADS 8
+
+typedef struct
+{
+    uint64_t shard_id;
+    uint64_t duration;
+    char * fn;                          /* base file name for logging */
+    siridb_shard_loader_t * loader;
+    int done;
+} SHARDS_job_t;
+
+typedef struct
+{
+    siridb_t * siridb;
+    SHARDS_job_t * jobs;
+    size_t n;
+    size_t next;        /* next job to read */
+    size_t applied;     /* jobs below this are handled by the main thread */
+    size_t window;      /* number of jobs which may be read ahead */
+    int stop;
+    uv_mutex_t lock;
+    uv_cond_t cond;
+} SHARDS_load_t;
+
 static bool SHARDS_must_migrate_shard(
         char * fn,
         const char * ext,
@@ -132,6 +157,170 @@ static bool SHARDS_remove_shard_file(const char * path, const char * fn)
 }
 
 
+/*
+ * Worker thread for reading shards. Reading may not run too far ahead of the
+ * main thread since each loaded index is kept in memory until applied.
+ */
+static void SHARDS_load_work(void * arg)
+{
+    SHARDS_load_t * load = arg;
+    SHARDS_job_t * job;
+
+    uv_mutex_lock(&load->lock);
+
+    while (!load->stop && load->next < load->n)
+    {
+        if (load->next >= load->applied + load->window)
+        {
+            uv_cond_wait(&load->cond, &load->lock);
+            continue;
+        }
+
+        job = load->jobs + load->next++;
+
+        uv_mutex_unlock(&load->lock);
+
+        job->loader = siridb_shard_read(
+                load->siridb,
+                job->shard_id,
+                job->duration);
+
+        uv_mutex_lock(&load->lock);
+
+        job->done = 1;
+        uv_cond_broadcast(&load->cond);
+    }
+
+    uv_mutex_unlock(&load->lock);
+}
+
+/*
+ * Shard files are read by a pool of threads while the main thread applies
+ * the index of each shard to the series, in the original order.
+ *
+ * Returns 0 if successful or -1 in case of an error.
+ * (a SIGNAL might be raised in case of an error)
+ */
+static int SHARDS_load_jobs(
+        siridb_t * siridb,
+        const char * path,
+        SHARDS_job_t * jobs,
+        size_t n)
+{
+    SHARDS_load_t load;
+    SHARDS_job_t * job;
+    uv_thread_t threads[SHARDS_MAX_LOAD_THREADS];
+    long nproc = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t i, nthreads = 0, max_threads;
+    bool ignore_broken_data = siri.cfg->ignore_broken_data;
+    int rc = 0;
+
+    max_threads = nproc < 1
+            ? 1
+            : nproc > SHARDS_MAX_LOAD_THREADS
+            ? SHARDS_MAX_LOAD_THREADS
+            : (size_t) nproc;
+
+    if (max_threads > n)
+    {
+        max_threads = n;
+    }
+
+    load.siridb = siridb;
+    load.jobs = jobs;
+    load.n = n;
+    load.next = 0;
+    load.applied = 0;
+    load.window = max_threads * 2;
+    load.stop = 0;
+
+    uv_mutex_init(&load.lock);
+    uv_cond_init(&load.cond);
+
+    /* when no thread can be created, the main thread reads all shards */
+    while (nthreads < max_threads &&
+           uv_thread_create(threads + nthreads, SHARDS_load_work, &load) == 0)
+    {
+        ++nthreads;
+    }
+
+    log_debug("Reading shards using %zu thread(s)", nthreads);
+
+    for (i = 0; i < n; i++)
+    {
+        job = jobs + i;
+
+        uv_mutex_lock(&load.lock);
+
+        if (load.next == i)
+        {
+            /* the job is not yet taken by a thread, read it ourselves */
+            ++load.next;
+            uv_mutex_unlock(&load.lock);
+
+            job->loader = siridb_shard_read(
+                    siridb,
+                    job->shard_id,
+                    job->duration);
+
+            uv_mutex_lock(&load.lock);
+            job->done = 1;
+        }
+
+        while (!job->done)
+        {
+            uv_cond_wait(&load.cond, &load.lock);
+        }
+
+        uv_mutex_unlock(&load.lock);
+
+        if (job->loader == NULL ||
+            siridb_shard_apply(siridb, job->loader) ||
+            siri_err)
+        {
+            job->loader = NULL;
+            log_error("Error while loading shard: '%s'", job->fn);
+            if (siri_err ||
+                !ignore_broken_data ||
+                !SHARDS_remove_shard_file(path, job->fn))
+            {
+                rc = -1;
+                break;
+            }
+        }
+        job->loader = NULL;
+
+        uv_mutex_lock(&load.lock);
+        load.applied = i + 1;
+        uv_cond_broadcast(&load.cond);
+        uv_mutex_unlock(&load.lock);
+    }
+
+    uv_mutex_lock(&load.lock);
+    load.stop = 1;
+    uv_cond_broadcast(&load.cond);
+    uv_mutex_unlock(&load.lock);
+
+    for (i = 0; i < nthreads; i++)
+    {
+        uv_thread_join(threads + i);
+    }
+
+    /* cleanup shards which are read but not applied due to an error */
+    for (i = 0; i < n; i++)
+    {
+        if (jobs[i].loader != NULL)
+        {
+            siridb_shard_loader_free(jobs[i].loader);
+        }
+    }
+
+    uv_cond_destroy(&load.cond);
+    uv_mutex_destroy(&load.lock);
+
+    return rc;
+}
+
 /*
  * Returns 0 if successful or -1 in case of an error.
  * (a SIGNAL might be raised in case of an error)
@@ -142,8 +331,10 @@ int siridb_shards_load(siridb_t * siridb)
     struct dirent ** shard_list;
     char buffer[XPATH_MAX];
     int n, total, rc = 0;
+    size_t njobs = 0;
     uint64_t shard_id, duration;
     bool ignore_broken_data = siri.cfg->ignore_broken_data;
+    SHARDS_job_t * jobs;
 
     memset(&st, 0, sizeof(struct stat));
 
@@ -178,7 +369,14 @@ int siridb_shards_load(siridb_t * siridb)
         return -1;
     }
 
-    for (n = 0; n < total; n++)
+    jobs = malloc(sizeof(SHARDS_job_t) * (total ? total : 1));
+    if (jobs == NULL)
+    {
+        ERR_ALLOC
+        rc = -1;
+    }
+
+    for (n = 0; jobs != NULL && n < total; n++)
     {
         char * base_fn = shard_list[n]->d_name;
 
@@ -229,21 +427,21 @@ int siridb_shards_load(siridb_t * siridb)
         }
 
         /* we are sure this fits since the filename is checked */
-        if (siridb_shard_load(siridb, shard_id, duration))
-        {
-           log_error("Error while loading shard: '%s'", base_fn);
-            if (!ignore_broken_data || !SHARDS_remove_shard_file(path, base_fn))
-            {
-                rc = -1;
-                break;
-            }
-            else
-            {
-                continue;
-            }
-        }
+        jobs[njobs].shard_id = shard_id;
+        jobs[njobs].duration = duration;
+        jobs[njobs].fn = base_fn;
+        jobs[njobs].loader = NULL;
+        jobs[njobs].done = 0;
+        ++njobs;
     }
 
+    if (rc == 0 && njobs)
+    {
+        rc = SHARDS_load_jobs(siridb, path, jobs, njobs);
+    }
+
+    free(jobs);
+
     while (total--)
     {
         free(shard_list[total]);
@@ -311,6 +509,7 @@ int siridb_shards_add_points(
         {
             series->length -= end - start;
             series_update_start_end(series);
+            siridb_zones_update(siridb, series);
             continue;
         }
 
@@ -0,0 +1,513 @@
+/*
+ * sketch.c - Mergeable sketches for percentile() and distinct().
+ */
+#include <assert.h>
+#include <math.h>
+#include <siri/db/lookup.h>
+#include <siri/db/sketch.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SKETCH_HEADER_SZ offsetof(siridb_sketch_t, via)
+
+/* both alpha and the small range correction are from Flajolet et al. */
+#define HLL_ALPHA (0.7213 / (1.0 + 1.079 / SIRIDB_HLL_SZ))
+
+static void TDIGEST_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp);
+static void TDIGEST_flush(siridb_sketch_t * sketch, double * buf, size_t n);
+static void TDIGEST_merge(siridb_sketch_t * dst, siridb_sketch_t * src);
+static void TDIGEST_compress(
+        siridb_sketch_t * sketch,
+        siridb_centroid_t * items,
+        size_t n);
+static inline double TDIGEST_limit(double q);
+static int TDIGEST_cmp(const void * a, const void * b);
+static double TDIGEST_percentile(siridb_sketch_t * sketch, double q);
+static void HLL_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp);
+static inline uint64_t HLL_hash(siridb_point_t * point, points_tp tp);
+static inline uint64_t HLL_mix(uint64_t h);
+
+/*
+ * Initialize a sketch. This function is used for sketches which are only
+ * used during a single aggregation and can live on the stack.
+ */
+void siridb_sketch_init(siridb_sketch_t * sketch, uint32_t tp)
+{
+    assert (tp == SIRIDB_SKETCH_TDIGEST || tp == SIRIDB_SKETCH_HLL);
+
+    sketch->tp = tp;
+    sketch->n = 0;
+    sketch->min = INFINITY;
+    sketch->max = -INFINITY;
+
+    if (tp == SIRIDB_SKETCH_HLL)
+    {
+        sketch->len = SIRIDB_HLL_SZ;
+        memset(sketch->via.registers, 0, SIRIDB_HLL_SZ);
+    }
+    else
+    {
+        sketch->len = 0;
+    }
+}
+
+/*
+ * Returns a new sketch or NULL in case of an allocation error.
+ */
+siridb_sketch_t * siridb_sketch_new(uint32_t tp)
+{
+    siridb_sketch_t * sketch = malloc(sizeof(siridb_sketch_t));
+    if (sketch != NULL)
+    {
+        siridb_sketch_init(sketch, tp);
+    }
+    return sketch;
+}
+
+/*
+ * Add points to a sketch. The t-digest only accepts integer and float
+ * values and ignores NaN, the HyperLogLog accepts all types.
+ *
+ * Integer and float values which are equal are counted as one distinct
+ * value so the result does not change when series with different types are
+ * merged.
+ */
+void siridb_sketch_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp)
+{
+    if (sketch->tp == SIRIDB_SKETCH_HLL)
+    {
+        HLL_add(sketch, data, n, tp);
+    }
+    else
+    {
+        assert (tp != TP_STRING);
+        TDIGEST_add(sketch, data, n, tp);
+    }
+}
+
+/*
+ * Merge sketch src into dst. Both sketches must have the same type.
+ */
+void siridb_sketch_merge(siridb_sketch_t * dst, siridb_sketch_t * src)
+{
+    size_t i;
+
+    assert (dst->tp == src->tp);
+
+    if (dst->tp == SIRIDB_SKETCH_TDIGEST)
+    {
+        TDIGEST_merge(dst, src);
+        return;
+    }
+
+    for (i = 0; i < SIRIDB_HLL_SZ; i++)
+    {
+        if (src->via.registers[i] > dst->via.registers[i])
+        {
+            dst->via.registers[i] = src->via.registers[i];
+        }
+    }
+    dst->n += src->n;
+}
+
+/*
+ * Returns the estimated value at the given percentile (0..100) or NaN when
+ * no values are added to the t-digest.
+ *
+ * The estimate is exact as long as all centroids hold a single value and
+ * uses the same linear interpolation as median() in that case.
+ */
+double siridb_sketch_percentile(siridb_sketch_t * sketch, double percentile)
+{
+    double val;
+
+    assert (sketch->tp == SIRIDB_SKETCH_TDIGEST);
+
+    if (!sketch->len)
+    {
+        return NAN;
+    }
+
+    val = TDIGEST_percentile(sketch, percentile / 100.0);
+
+    return (val < sketch->min) ?
+            sketch->min : (val > sketch->max) ? sketch->max : val;
+}
+
+/*
+ * Returns the estimated number of distinct values in a HyperLogLog.
+ */
+int64_t siridb_sketch_distinct(siridb_sketch_t * sketch)
+{
+    double sum = 0.0;
+    double estimate;
+    size_t zeros = 0;
+    size_t i;
+
+    assert (sketch->tp == SIRIDB_SKETCH_HLL);
+
+    for (i = 0; i < SIRIDB_HLL_SZ; i++)
+    {
+        sum += ldexp(1.0, -sketch->via.registers[i]);
+        zeros += !sketch->via.registers[i];
+    }
+
+    estimate = HLL_ALPHA * SIRIDB_HLL_SZ * SIRIDB_HLL_SZ / sum;
+
+    if (estimate <= 2.5 * SIRIDB_HLL_SZ && zeros)
+    {
+        /* linear counting is more accurate for small cardinalities */
+        estimate = SIRIDB_HLL_SZ * log((double) SIRIDB_HLL_SZ / zeros);
+    }
+
+    /* there cannot be more distinct values than values */
+    return (estimate > (double) sketch->n) ?
+            (int64_t) sketch->n : (int64_t) (estimate + 0.5);
+}
+
+/*
+ * Returns the number of bytes used by a sketch.
+ */
+size_t siridb_sketch_size(siridb_sketch_t * sketch)
+{
+    return SKETCH_HEADER_SZ + ((sketch->tp == SIRIDB_SKETCH_TDIGEST) ?
+            sketch->len * sizeof(siridb_centroid_t) : sketch->len);
+}
+
+/*
+ * Returns a new sketch from raw data or NULL when the data is not valid or
+ * in case of an allocation error. The number of bytes read from data is
+ * stored in consumed.
+ */
+siridb_sketch_t * siridb_sketch_unpack(
+        const unsigned char * data,
+        size_t size,
+        size_t * consumed)
+{
+    siridb_sketch_t header;
+    siridb_sketch_t * sketch;
+    size_t sz;
+
+    if (size < SKETCH_HEADER_SZ)
+    {
+        return NULL;
+    }
+
+    memcpy(&header, data, SKETCH_HEADER_SZ);
+
+    if (!((header.tp == SIRIDB_SKETCH_TDIGEST &&
+            header.len <= SIRIDB_TDIGEST_SZ) ||
+          (header.tp == SIRIDB_SKETCH_HLL &&
+            header.len == SIRIDB_HLL_SZ)))
+    {
+        return NULL;
+    }
+
+    sz = siridb_sketch_size(&header);
+    if (size < sz || (sketch = malloc(sizeof(siridb_sketch_t))) == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(sketch, data, sz);
+    *consumed = sz;
+
+    return sketch;
+}
+
+/*
+ * Values are added in batches of SIRIDB_TDIGEST_BUF sorted values so the
+ * memory used does not depend on the number of points.
+ */
+static void TDIGEST_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp)
+{
+    double buf[SIRIDB_TDIGEST_BUF];
+    size_t i, nbuf = 0;
+    double val;
+
+    for (i = 0; i < n; i++)
+    {
+        val = (tp == TP_INT) ? (double) data[i].val.int64 : data[i].val.real;
+        if (isnan(val))
+        {
+            continue;
+        }
+
+        buf[nbuf++] = val;
+        if (nbuf == SIRIDB_TDIGEST_BUF)
+        {
+            TDIGEST_flush(sketch, buf, nbuf);
+            nbuf = 0;
+        }
+    }
+
+    if (nbuf)
+    {
+        TDIGEST_flush(sketch, buf, nbuf);
+    }
+}
+
+/*
+ * Merge a buffer with values into the centroids.
+ */
+static void TDIGEST_flush(siridb_sketch_t * sketch, double * buf, size_t n)
+{
+    siridb_centroid_t items[SIRIDB_TDIGEST_SZ + SIRIDB_TDIGEST_BUF];
+    siridb_centroid_t * centroid = sketch->via.centroids;
+    siridb_centroid_t * end = centroid + sketch->len;
+    siridb_centroid_t * item = items;
+    double * val = buf;
+    double * val_end = buf + n;
+
+    qsort(buf, n, sizeof(double), TDIGEST_cmp);
+
+    if (*buf < sketch->min)
+    {
+        sketch->min = *buf;
+    }
+    if (buf[n - 1] > sketch->max)
+    {
+        sketch->max = buf[n - 1];
+    }
+
+    while (centroid < end || val < val_end)
+    {
+        if (val == val_end || (centroid < end && centroid->mean <= *val))
+        {
+            *item = *centroid++;
+        }
+        else
+        {
+            item->mean = *val++;
+            item->weight = 1.0;
+        }
+        item++;
+    }
+
+    sketch->n += n;
+    TDIGEST_compress(sketch, items, item - items);
+}
+
+static void TDIGEST_merge(siridb_sketch_t * dst, siridb_sketch_t * src)
+{
+    siridb_centroid_t items[SIRIDB_TDIGEST_SZ * 2];
+    siridb_centroid_t * a = dst->via.centroids;
+    siridb_centroid_t * a_end = a + dst->len;
+    siridb_centroid_t * b = src->via.centroids;
+    siridb_centroid_t * b_end = b + src->len;
+    siridb_centroid_t * item = items;
+
+    if (!src->len)
+    {
+        return;
+    }
+
+    while (a < a_end || b < b_end)
+    {
+        *item++ = (b == b_end || (a < a_end && a->mean <= b->mean)) ?
+                *a++ : *b++;
+    }
+
+    if (src->min < dst->min)
+    {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max)
+    {
+        dst->max = src->max;
+    }
+
+    dst->n += src->n;
+    TDIGEST_compress(dst, items, item - items);
+}
+
+/*
+ * Combine sorted items into the centroids of the sketch. A centroid may
+ * grow as long as the quantile at its right edge stays within the limit for
+ * its left edge, which allows at most SIRIDB_TDIGEST_SZ centroids.
+ */
+static void TDIGEST_compress(
+        siridb_sketch_t * sketch,
+        siridb_centroid_t * items,
+        size_t n)
+{
+    siridb_centroid_t * centroid = sketch->via.centroids;
+    double total = (double) sketch->n;
+    double done = 0.0;
+    double limit = TDIGEST_limit(0.0) * total;
+    size_t i;
+
+    assert (n);
+
+    *centroid = *items;
+    sketch->len = 1;
+
+    for (i = 1; i < n; i++)
+    {
+        if (done + centroid->weight + items[i].weight <= limit ||
+            sketch->len == SIRIDB_TDIGEST_SZ)
+        {
+            centroid->weight += items[i].weight;
+            centroid->mean += (items[i].mean - centroid->mean) *
+                    items[i].weight / centroid->weight;
+        }
+        else
+        {
+            done += centroid->weight;
+            limit = TDIGEST_limit(done / total) * total;
+            *(++centroid) = items[i];
+            sketch->len++;
+        }
+    }
+}
+
+/*
+ * Returns the largest quantile which may be covered by a centroid starting
+ * at quantile q. This is the inverse of the k1 scale function from Dunning
+ * and Ertl with a step of one.
+ */
+static inline double TDIGEST_limit(double q)
+{
+    double k = asin(2.0 * q - 1.0) + 2.0 * M_PI / SIRIDB_TDIGEST_DELTA;
+    return (k >= M_PI_2) ? 1.0 : (sin(k) + 1.0) / 2.0;
+}
+
+static int TDIGEST_cmp(const void * a, const void * b)
+{
+    double da = *((const double *) a);
+    double db = *((const double *) b);
+    return (da > db) - (da < db);
+}
+
+/*
+ * Each centroid is placed at the rank of its center so a centroid with a
+ * single value is placed at the exact rank of that value. The result is
+ * interpolated between the two centroids around the requested rank, or
+ * between the outer centroids and the minimum or maximum value.
+ */
+static double TDIGEST_percentile(siridb_sketch_t * sketch, double q)
+{
+    siridb_centroid_t * c = sketch->via.centroids;
+    double rank = q * ((double) sketch->n - 1.0);
+    double cum = 0.0;
+    double center, next;
+    size_t i;
+
+    center = (c->weight - 1.0) / 2.0;
+    if (rank <= center)
+    {
+        return (center > 0.0) ?
+                sketch->min + (c->mean - sketch->min) * rank / center :
+                c->mean;
+    }
+
+    for (i = 0; i < sketch->len - 1; i++)
+    {
+        center = cum + (c[i].weight - 1.0) / 2.0;
+        next = cum + c[i].weight + (c[i + 1].weight - 1.0) / 2.0;
+        if (rank <= next)
+        {
+            return c[i].mean +
+                    (c[i + 1].mean - c[i].mean) *
+                    (rank - center) / (next - center);
+        }
+        cum += c[i].weight;
+    }
+
+    center = cum + (c[i].weight - 1.0) / 2.0;
+    next = (double) sketch->n - 1.0;
+
+    return (next > center) ?
+            c[i].mean + (sketch->max - c[i].mean) *
+            (rank - center) / (next - center) :
+            c[i].mean;
+}
+
+static void HLL_add(
+        siridb_sketch_t * sketch,
+        siridb_point_t * data,
+        size_t n,
+        points_tp tp)
+{
+    uint64_t h;
+    uint8_t rho;
+    size_t i, idx;
+
+    for (i = 0; i < n; i++)
+    {
+        h = HLL_hash(data + i, tp);
+        idx = h >> (64 - SIRIDB_HLL_BITS);
+
+        /* the guard bit limits the rank to 64 - SIRIDB_HLL_BITS + 1 */
+        rho = __builtin_clzll(
+                (h << SIRIDB_HLL_BITS) | (1ULL << (SIRIDB_HLL_BITS - 1))) + 1;
+
+        if (rho > sketch->via.registers[idx])
+        {
+            sketch->via.registers[idx] = rho;
+        }
+    }
+
+    sketch->n += n;
+}
+
+/*
+ * Float values without a fraction are hashed as integer values.
+ */
+static inline uint64_t HLL_hash(siridb_point_t * point, points_tp tp)
+{
+    uint64_t bits;
+    double val;
+
+    switch (tp)
+    {
+    case TP_INT:
+        return HLL_mix((uint64_t) point->val.int64);
+
+    case TP_DOUBLE:
+        val = point->val.real;
+        if (val == trunc(val) && val >= -9.2e18 && val <= 9.2e18)
+        {
+            return HLL_mix((uint64_t) (int64_t) val);
+        }
+        memcpy(&bits, &val, sizeof(uint64_t));
+        return HLL_mix(bits);
+
+    case TP_STRING:
+        return siridb_lookup_xxhash(
+                point->val.str,
+                strlen(point->val.str));
+    }
+
+    assert (0);
+    return 0;
+}
+
+/*
+ * Finalizer from MurmurHash3 which spreads all input bits over the hash.
+ */
+static inline uint64_t HLL_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
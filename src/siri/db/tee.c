@@ -9,11 +9,29 @@
 #include <siri/siri.h>
 #include <siri/net/tcp.h>
 #include <logger/logger.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <xpath/xpath.h>
 
 #define TEE__BUF_SZ 512
+#define TEE__FRAME_SZ 65536             /* initial size for a frame buffer */
+#define TEE__REPLAY_SZ 1048576          /* max spool data replayed per frame */
+#define TEE__MAX_MEM 8388608            /* spill to disk above 8MB */
+#define TEE__SPOOL_MAX_FILES 10         /* about 1GB using default fifo files */
+
 static char tee__buf[TEE__BUF_SZ];
 static char tee__address[SIRI_CFG_MAX_LEN_ADDRESS+7];
 
+typedef struct
+{
+    uv_write_t req;
+    siridb_tee_t * tee;
+    char * data;
+    size_t n;
+} tee__frame_t;
+
+static void tee__flush(siridb_tee_t * tee);
 
 static void tee__alloc_buffer(
     uv_handle_t * handle __attribute__((unused)),
@@ -24,15 +42,336 @@ static void tee__alloc_buffer(
     buf->len = TEE__BUF_SZ;
 }
 
+/*
+ * Open the disk spool. An existing spool from a previous run is opened on
+ * the first call, a new spool is only created when `create` is true.
+ *
+ * Returns 0 if the spool is available or -1 if not.
+ */
+static int tee__spool_init(siridb_tee_t * tee, int create)
+{
+    char * path;
+
+    if (tee->spool)
+    {
+        return 0;
+    }
+
+    if ((tee->flags & SIRIDB_TEE_FLAG_SPOOL_INIT) && !create)
+    {
+        return -1;
+    }
+
+    tee->flags |= SIRIDB_TEE_FLAG_SPOOL_INIT;
+
+    if (asprintf(&path, "%stee/", tee->siridb->dbpath) < 0)
+    {
+        log_error("Cannot allocate the tee spool path");
+        return -1;
+    }
+
+    if (xpath_is_dir(path) || (create && mkdir(path, 0700) == 0))
+    {
+        tee->spool = siridb_fifo_new_path(path);
+        if (tee->spool && siridb_fifo_has_data(tee->spool))
+        {
+            log_info("Found spooled tee data in '%s'", path);
+            tee->spool_since = uv_now(siri.loop);
+        }
+    }
+    else if (create)
+    {
+        log_error("Cannot create tee spool directory '%s'", path);
+    }
+
+    free(path);
+    return tee->spool ? 0 : -1;
+}
+
+static void tee__spool(siridb_tee_t * tee, sirinet_pkg_t * pkg)
+{
+    siridb_fifo_t * spool;
+    size_t size = sizeof(sirinet_pkg_t) + pkg->len + 2 * sizeof(uint32_t);
+
+    if (tee__spool_init(tee, 1))
+    {
+        goto dropped;
+    }
+
+    spool = tee->spool;
+
+    if (siridb_fifo_size(spool) >= TEE__SPOOL_MAX_FILES &&
+        spool->in->free_space < size)
+    {
+        goto dropped;
+    }
+
+    if (siridb_fifo_append(spool, pkg))
+    {
+        log_error("Cannot write package to the tee spool");
+        goto dropped;
+    }
+
+    if (!tee->spool_since)
+    {
+        tee->spool_since = uv_now(siri.loop);
+    }
+    ++tee->n_spooled;
+    return;
+
+dropped:
+    if (tee->n_dropped++ % 1000 == 0)
+    {
+        log_warning(
+                "Tee spool is not available or full, "
+                "%" PRIu64 " package(s) are dropped",
+                tee->n_dropped);
+    }
+}
+
+/*
+ * Write packages from memory to the spool. The packages in a buffer are not
+ * aligned so each package is copied first.
+ *
+ * Note that the packages are now behind data which might already be spooled.
+ */
+static void tee__respool(siridb_tee_t * tee, const char * data, size_t n)
+{
+    const char * end = data + n;
+    sirinet_pkg_t * pkg;
+    uint32_t len;
+    size_t size;
+
+    while (data < end)
+    {
+        memcpy(&len, data, sizeof(uint32_t));
+        size = sizeof(sirinet_pkg_t) + len;
+
+        pkg = malloc(size);
+        if (pkg == NULL)
+        {
+            ++tee->n_dropped;
+        }
+        else
+        {
+            memcpy(pkg, data, size);
+            tee__spool(tee, pkg);
+            free(pkg);
+        }
+        data += size;
+    }
+}
+
+/*
+ * Returns 0 if the package is added to the frame buffer or -1 in case of an
+ * allocation error.
+ */
+static int tee__buffer(siridb_tee_t * tee, sirinet_pkg_t * pkg)
+{
+    size_t size = sizeof(sirinet_pkg_t) + pkg->len;
+
+    if (tee->len + size > tee->size)
+    {
+        size_t sz = tee->size ? tee->size : TEE__FRAME_SZ;
+        char * tmp;
+
+        while (sz < tee->len + size)
+        {
+            sz <<= 1;
+        }
+
+        tmp = realloc(tee->buf, sz);
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        tee->buf = tmp;
+        tee->size = sz;
+    }
+
+    if (!tee->len)
+    {
+        tee->buf_since = uv_now(siri.loop);
+    }
+
+    memcpy(tee->buf + tee->len, pkg, size);
+    tee->len += size;
+    return 0;
+}
+
+/*
+ * Put the packages from a failed frame back in front of the frame buffer so
+ * they are written before the packages which are received in the meantime.
+ * This does not exceed TEE__MAX_MEM since the frame was counted as in flight.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int tee__unshift(
+        siridb_tee_t * tee,
+        const char * data,
+        size_t n,
+        uint64_t since)
+{
+    if (tee->len + n > tee->size)
+    {
+        size_t sz = tee->size ? tee->size : TEE__FRAME_SZ;
+        char * tmp;
+
+        while (sz < tee->len + n)
+        {
+            sz <<= 1;
+        }
+
+        tmp = realloc(tee->buf, sz);
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        tee->buf = tmp;
+        tee->size = sz;
+    }
+
+    memmove(tee->buf + n, tee->buf, tee->len);
+    memcpy(tee->buf, data, n);
+    tee->len += n;
+    tee->buf_since = since;
+    return 0;
+}
+
+/*
+ * Move packages from the spool to the frame buffer. Packages are removed
+ * from the spool once they are copied to the buffer.
+ */
+static void tee__replay(siridb_tee_t * tee)
+{
+    sirinet_pkg_t * pkg;
+
+    while (tee->len < TEE__REPLAY_SZ && siridb_fifo_has_data(tee->spool))
+    {
+        pkg = siridb_fifo_pop(tee->spool);
+        if (pkg == NULL)
+        {
+            if (siri_err)
+            {
+                break;
+            }
+            continue;  /* the corrupt package is skipped by the fifo */
+        }
+
+        if (tee__buffer(tee, pkg))
+        {
+            free(pkg);
+            break;
+        }
+        free(pkg);
+
+        if (siridb_fifo_commit(tee->spool))
+        {
+            break;
+        }
+    }
+
+    if (tee->len)
+    {
+        tee->buf_since = tee->spool_since;
+    }
+
+    if (!siridb_fifo_has_data(tee->spool))
+    {
+        tee->spool_since = 0;
+    }
+}
+
 static void tee__write_cb(uv_write_t * req, int status)
 {
-    sirinet_pkg_t * pkg = req->data;
+    tee__frame_t * frame = req->data;
+    siridb_tee_t * tee = frame->tee;
+    uint64_t since = tee->flight_since;
+
+    tee->in_flight = 0;
+    tee->flight_since = 0;
+
     if (status)
     {
         log_error("Socket (tee) write error: %s", uv_strerror(status));
+
+        /* the frame is older than all buffered and spooled packages */
+        if (tee__unshift(tee, frame->data, frame->n, since))
+        {
+            tee__respool(tee, frame->data, frame->n);
+        }
+
+        /* a new connection will be made on the next write */
+        if (tee->tcp && !uv_is_closing((uv_handle_t *) tee->tcp))
+        {
+            uv_close((uv_handle_t *) tee->tcp, (uv_close_cb) free);
+            tee->tcp = NULL;
+        }
     }
-    free(pkg);
-    free(req);
+
+    free(frame->data);
+    free(frame);
+
+    tee__flush(tee);
+}
+
+/*
+ * Write all buffered packages as a single frame. Only one frame is written
+ * at a time, packages received in the meantime are collected for the next
+ * frame. When the buffer is empty, spooled data will be replayed.
+ */
+static void tee__flush(siridb_tee_t * tee)
+{
+    tee__frame_t * frame;
+    uv_buf_t buf;
+
+    if (tee->tcp == NULL || tee->in_flight)
+    {
+        return;
+    }
+
+    if (!tee->len && tee->spool)
+    {
+        tee__replay(tee);
+    }
+
+    if (!tee->len)
+    {
+        return;
+    }
+
+    frame = malloc(sizeof(tee__frame_t));
+    if (frame == NULL)
+    {
+        log_error("Cannot write to tee");
+        return;
+    }
+
+    frame->tee = tee;
+    frame->data = tee->buf;
+    frame->n = tee->len;
+    frame->req.data = frame;
+
+    buf = uv_buf_init(frame->data, frame->n);
+
+    if (uv_write(
+            &frame->req,
+            (uv_stream_t *) tee->tcp,
+            &buf,
+            1,
+            tee__write_cb))
+    {
+        free(frame);
+        log_error("Cannot write to tee");
+        return;
+    }
+
+    tee->in_flight = frame->n;
+    tee->flight_since = tee->buf_since;
+    tee->buf = NULL;
+    tee->len = 0;
+    tee->size = 0;
+    tee->buf_since = 0;
 }
 
 static void tee__on_data(
@@ -69,37 +408,6 @@ static void tee__on_data(
             tee->port);
 }
 
-static void tee__do_write(siridb_tee_t * tee, sirinet_pkg_t * pkg)
-{
-    uv_write_t * req;
-    uv_buf_t buf;
-
-    pkg = sirinet_pkg_dup(pkg);
-    if (!pkg)
-    {
-        log_error("Failed to create duplicate for tee");
-        return;
-    }
-
-    req = malloc(sizeof(uv_write_t));
-    buf = uv_buf_init((char *) pkg, sizeof(sirinet_pkg_t) + pkg->len);
-
-    if (req)
-    {
-        int rc;
-        req->data = pkg;
-        rc = uv_write(req, (uv_stream_t *) tee->tcp, &buf, 1, tee__write_cb);
-        if (rc == 0)
-        {
-            return;  /* success */
-        }
-        free(req);
-    }
-    free(pkg);
-    log_error("Cannot write to tee");
-    return;
-}
-
 static void tee__on_connect(uv_connect_t * req, int status)
 {
     uv_tcp_t * tcp = (uv_tcp_t *) req->handle;
@@ -140,6 +448,9 @@ fail:
 done:
     free(req);
     uv_mutex_unlock(&tee->lock_);
+
+    /* write buffered and spooled packages */
+    tee__flush(tee);
 }
 
 void tee__make_connection(siridb_tee_t * tee, const struct sockaddr * dest)
@@ -276,7 +587,7 @@ void tee__connect(siridb_tee_t * tee)
     }
 }
 
-siridb_tee_t * siridb_tee_new(void)
+siridb_tee_t * siridb_tee_new(siridb_t * siridb)
 {
     siridb_tee_t * tee = malloc(sizeof(siridb_tee_t));
     if (tee == NULL)
@@ -287,6 +598,17 @@ siridb_tee_t * siridb_tee_new(void)
     tee->tcp = NULL;
     tee->flags = SIRIDB_TEE_FLAG;
     tee->err_code = 0;
+    tee->siridb = siridb;
+    tee->spool = NULL;
+    tee->buf = NULL;
+    tee->len = 0;
+    tee->size = 0;
+    tee->in_flight = 0;
+    tee->buf_since = 0;
+    tee->flight_since = 0;
+    tee->spool_since = 0;
+    tee->n_spooled = 0;
+    tee->n_dropped = 0;
     uv_mutex_init(&tee->lock_);
     return tee;
 }
@@ -307,7 +629,19 @@ void siridb_tee_free(siridb_tee_t * tee)
     /* must be closed before free can be used */
     assert (tee->tcp == NULL);
 
+    /* keep packages which are not written for the next run */
+    if (tee->len)
+    {
+        tee__respool(tee, tee->buf, tee->len);
+    }
+
+    if (tee->spool)
+    {
+        siridb_fifo_free(tee->spool);
+    }
+
     uv_mutex_destroy(&tee->lock_);
+    free(tee->buf);
     free(tee->address);
     free(tee);
 }
@@ -332,12 +666,49 @@ const char * siridb_tee_str(siridb_tee_t * tee)
     return "disabled";
 }
 
+/*
+ * Returns the age in seconds of the oldest package which is not yet written
+ * to the tee, or 0 when the tee is up-to-date.
+ */
+double siridb_tee_lag(siridb_tee_t * tee)
+{
+    uint64_t since = tee->flight_since;
+
+    if (tee->buf_since && (!since || tee->buf_since < since))
+    {
+        since = tee->buf_since;
+    }
+
+    if (tee->spool_since && (!since || tee->spool_since < since))
+    {
+        since = tee->spool_since;
+    }
+
+    return since ? (double) (uv_now(siri.loop) - since) / 1000.0 : 0.0;
+}
+
+/*
+ * Packages are collected in a frame buffer until the tee is ready to write.
+ * When the memory limit is reached or when the spool already contains data,
+ * packages are written to the disk spool instead.
+ */
 void siridb_tee_write(siridb_tee_t * tee, sirinet_pkg_t * pkg)
 {
     assert (tee->address);
+
+    /* open a spool from a previous run, if any */
+    (void) tee__spool_init(tee, 0);
+
+    if ((tee->spool && siridb_fifo_has_data(tee->spool)) ||
+        tee->len + tee->in_flight + pkg->len > TEE__MAX_MEM ||
+        tee__buffer(tee, pkg))
+    {
+        tee__spool(tee, pkg);
+    }
+
     if (tee->tcp)
     {
-        tee__do_write(tee, pkg);
+        tee__flush(tee);
     }
     else
     {
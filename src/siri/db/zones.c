@@ -0,0 +1,294 @@
+/*
+ * zones.c - Min/max zone maps for filtering series on their properties.
+ */
+#include <logger/logger.h>
+#include <siri/db/zones.h>
+#include <siri/grammar/grammar.h>
+#include <stdlib.h>
+
+static int ZONES_grow(siridb_zones_t * zones, size_t len);
+static int ZONES_add_cb(siridb_series_t * series, siridb_zones_t * zones);
+static int ZONES_cexpr_cb(siridb_zone_t * zone, cexpr_condition_t * cond);
+
+/*
+ * Returns zone maps for all series in the given map or NULL in case of an
+ * allocation error. Argument max_id is only used to allocate enough zones at
+ * once.
+ */
+siridb_zones_t * siridb_zones_new(imap_t * series_map, uint32_t max_id)
+{
+    siridb_zones_t * zones = calloc(1, sizeof(siridb_zones_t));
+    if (zones == NULL)
+    {
+        return NULL;
+    }
+
+    if (ZONES_grow(zones, (max_id >> SIRIDB_ZONES_BITS) + 1) ||
+        imap_walk(series_map, (imap_cb) ZONES_add_cb, zones))
+    {
+        siridb_zones_free(zones);
+        return NULL;
+    }
+
+    return zones;
+}
+
+/*
+ * Destroy zone maps. (parsing NULL is allowed)
+ */
+void siridb_zones_free(siridb_zones_t * zones)
+{
+    if (zones != NULL)
+    {
+        free(zones->zone);
+        free(zones);
+    }
+}
+
+/*
+ * Widen the zone of the given series so it includes the current properties
+ * of the series.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siridb_zones_add(siridb_zones_t * zones, siridb_series_t * series)
+{
+    size_t i, n = series->id >> SIRIDB_ZONES_BITS;
+    siridb_zone_t * zone;
+    int64_t props[SIRIDB_ZONES_PROPS];
+
+    if (n >= zones->len && ZONES_grow(zones, n + 1))
+    {
+        return -1;
+    }
+
+    /* use the same types as siridb_series_cexpr_cb() */
+    props[SIRIDB_ZONES_START] = (int64_t) series->start;
+    props[SIRIDB_ZONES_END] = (int64_t) series->end;
+    props[SIRIDB_ZONES_LENGTH] = series->length;
+    props[SIRIDB_ZONES_POOL] = series->pool;
+    props[SIRIDB_ZONES_TYPE] = series->tp;
+
+    zone = zones->zone + n;
+
+    for (i = 0; i < SIRIDB_ZONES_PROPS; i++)
+    {
+        if (props[i] < zone->min[i])
+        {
+            zone->min[i] = props[i];
+        }
+        if (props[i] > zone->max[i])
+        {
+            zone->max[i] = props[i];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Returns 1 when a series in the zone might match the where expression or
+ * 0 when no series in the zone can match.
+ */
+int siridb_zones_match(siridb_zone_t * zone, cexpr_t * where_expr)
+{
+    /* an empty zone has no series */
+    return zone->min[0] <= zone->max[0] && cexpr_run(
+            where_expr,
+            (cexpr_cb_t) ZONES_cexpr_cb,
+            zone);
+}
+
+/*
+ * Update the zone maps, if they exist, after the start, end or length of a
+ * series has changed. This must be called for both growing and shrinking
+ * values since a zone only matches values within its range. In case of an
+ * allocation error the maps are removed and created again when they are
+ * needed.
+ */
+void siridb_zones_update(siridb_t * siridb, siridb_series_t * series)
+{
+    if (siridb->zones != NULL && siridb_zones_add(siridb->zones, series))
+    {
+        log_error(
+                "Cannot update the zone maps for database '%s'",
+                siridb->dbname);
+        siridb_zones_free(siridb->zones);
+        siridb->zones = NULL;
+    }
+}
+
+/*
+ * Returns a vector with references to all series which might match the
+ * where expression, or NULL in case of an allocation error. Each series in
+ * the vector still needs to be checked using the where expression. When the
+ * zone maps do not reduce the number of series, or when the where expression
+ * is NULL, all series are returned.
+ *
+ * This function should be called while holding the series_mutex.
+ */
+vec_t * siridb_zones_series(siridb_t * siridb, cexpr_t * where_expr)
+{
+    siridb_zones_t * zones;
+    siridb_series_t * series;
+    vec_t * vec;
+    size_t i, n;
+    uint64_t id, end;
+
+    if (where_expr == NULL)
+    {
+        return imap_2vec_ref(siridb->series_map);
+    }
+
+    if (siridb->zones == NULL)
+    {
+        siridb->zones = siridb_zones_new(
+                siridb->series_map,
+                siridb->max_series_id);
+        if (siridb->zones == NULL)
+        {
+            log_error(
+                    "Cannot create the zone maps for database '%s'",
+                    siridb->dbname);
+            return imap_2vec_ref(siridb->series_map);
+        }
+    }
+
+    zones = siridb->zones;
+
+    for (n = 0, i = 0; i < zones->len; i++)
+    {
+        n += siridb_zones_match(zones->zone + i, where_expr);
+    }
+
+    if (n * SIRIDB_ZONES_SCAN > zones->len)
+    {
+        return imap_2vec_ref(siridb->series_map);
+    }
+
+    vec = vec_new(VEC_DEFAULT_SIZE);
+    if (vec == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < zones->len; i++)
+    {
+        if (!siridb_zones_match(zones->zone + i, where_expr))
+        {
+            continue;
+        }
+
+        for (   id = i << SIRIDB_ZONES_BITS, end = id + SIRIDB_ZONES_SZ;
+                id < end;
+                id++)
+        {
+            series = imap_get(siridb->series_map, id);
+            if (series != NULL && vec_append_safe(&vec, series))
+            {
+                vec_free(vec);
+                return NULL;
+            }
+        }
+    }
+
+    /* take references only when successful, so no clean-up is required */
+    for (i = 0; i < vec->len; i++)
+    {
+        siridb_series_incref((siridb_series_t *) vec->data[i]);
+    }
+
+    return vec;
+}
+
+/*
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+static int ZONES_grow(siridb_zones_t * zones, size_t len)
+{
+    siridb_zone_t * tmp;
+    size_t i, j;
+
+    if (len <= zones->len)
+    {
+        return 0;
+    }
+
+    tmp = realloc(zones->zone, len * sizeof(siridb_zone_t));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+
+    for (i = zones->len; i < len; i++)
+    {
+        for (j = 0; j < SIRIDB_ZONES_PROPS; j++)
+        {
+            tmp[i].min[j] = INT64_MAX;
+            tmp[i].max[j] = INT64_MIN;
+        }
+    }
+
+    zones->zone = tmp;
+    zones->len = len;
+
+    return 0;
+}
+
+static int ZONES_add_cb(siridb_series_t * series, siridb_zones_t * zones)
+{
+    return siridb_zones_add(zones, series);
+}
+
+/*
+ * Returns 1 when the condition is true for at least one value within the
+ * range of the zone. Properties which are not in the zone maps, like the
+ * name, might always match.
+ */
+static int ZONES_cexpr_cb(siridb_zone_t * zone, cexpr_condition_t * cond)
+{
+    int64_t min, max;
+    siridb_zones_prop_t prop;
+
+    switch ((enum cleri_grammar_ids) cond->prop)
+    {
+    case CLERI_GID_K_START:
+        prop = SIRIDB_ZONES_START;
+        break;
+    case CLERI_GID_K_END:
+        prop = SIRIDB_ZONES_END;
+        break;
+    case CLERI_GID_K_LENGTH:
+        prop = SIRIDB_ZONES_LENGTH;
+        break;
+    case CLERI_GID_K_POOL:
+        prop = SIRIDB_ZONES_POOL;
+        break;
+    case CLERI_GID_K_TYPE:
+        prop = SIRIDB_ZONES_TYPE;
+        break;
+    default:
+        return 1;
+    }
+
+    min = zone->min[prop];
+    max = zone->max[prop];
+
+    switch (cond->operator)
+    {
+    case CEXPR_EQ:
+        return min <= cond->int64 && cond->int64 <= max;
+    case CEXPR_NE:
+        return min != cond->int64 || max != cond->int64;
+    case CEXPR_GT:
+        return max > cond->int64;
+    case CEXPR_LT:
+        return min < cond->int64;
+    case CEXPR_GE:
+        return max >= cond->int64;
+    case CEXPR_LE:
+        return min <= cond->int64;
+    default:
+        return 1;
+    }
+}
@@ -2,6 +2,7 @@
  * siri/evars.c
  */
 #include <stdbool.h>
+#include <siri/db/server.h>
 #include <siri/evars.h>
 #include <siri/net/tcp.h>
 
@@ -140,6 +141,9 @@ void siri_evars_parse(siri_t * siri)
     evars__bool(
             "SIRIDB_ENABLE_SHARD_COMPRESSION",
             &siri->cfg->shard_compression);
+    evars__bool(
+            "SIRIDB_ENABLE_SELECT_COMPRESSION",
+            &siri->cfg->select_compression);
     evars__bool(
             "SIRIDB_ENABLE_SHARD_AUTO_DURATION",
             &siri->cfg->shard_auto_duration);
@@ -163,6 +167,14 @@ void siri_evars_parse(siri_t * siri)
             "SIRIDB_HEARTBEAT_INTERVAL",
             &siri->cfg->heartbeat_interval,
             3, 300);
+    evars__u16_mm(
+            "SIRIDB_SERVER_CONNECTIONS",
+            &siri->cfg->server_connections,
+            1, SIRIDB_SERVER_MAX_CONNECTIONS);
+    evars__u16_mm(
+            "SIRIDB_INSERT_COALESCE_WINDOW",
+            &siri->cfg->insert_coalesce_window,
+            0, 50);
     evars__u32_mm(
             "SIRIDB_OPTIMIZING_INTERVAL",
             &siri->cfg->optimize_interval,
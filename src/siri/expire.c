@@ -0,0 +1,167 @@
+/*
+ * expire.c - Shard expiration task SiriDB.
+ */
+#include <logger/logger.h>
+#include <siri/db/expire.h>
+#include <siri/expire.h>
+#include <siri/optimize.h>
+#include <uv.h>
+#include <vec/vec.h>
+
+static uv_timer_t expire;
+static uv_work_t work;
+static vec_t * expire_dbs = NULL;   /* databases with expired shards */
+
+#define EXPIRE_INIT_TIMEOUT 1000
+
+static void EXPIRE_cb(uv_timer_t * handle);
+static void EXPIRE_work(uv_work_t * work);
+static void EXPIRE_work_finish(uv_work_t * work, int status);
+
+void siri_expire_init(siri_t * siri)
+{
+    siri->expire = &expire;
+    uv_timer_init(siri->loop, &expire);
+    uv_timer_start(&expire, EXPIRE_cb, EXPIRE_INIT_TIMEOUT, 0);
+}
+
+void siri_expire_stop(siri_t * siri)
+{
+    /* stop the timer so it will not run again */
+    uv_timer_stop(&expire);
+    uv_close((uv_handle_t *) &expire, NULL);
+
+    /* a running work thread checks this to see if we are stopped */
+    siri->expire = NULL;
+}
+
+/*
+ * Run the expiration task as soon as possible. This should be called when
+ * the expiration of a database is changed.
+ */
+void siri_expire_schedule(void)
+{
+    /* when a work thread is running, the timer is started when finished */
+    if (siri.expire != NULL && expire_dbs == NULL)
+    {
+        uv_timer_start(&expire, EXPIRE_cb, 0, 0);
+    }
+}
+
+/*
+ * Returns 1 while expired shards are dropped in a work thread. The work
+ * stops dropping shards once the optimize task is paused, so the backup mode
+ * and the re-index task must wait until this returns 0.
+ */
+int siri_expire_is_running(void)
+{
+    return expire_dbs != NULL;
+}
+
+static void EXPIRE_cb(uv_timer_t * handle __attribute__((unused)))
+{
+    uint64_t timeout = siri.cfg->heartbeat_interval * 1000;
+    siridb_t * siridb;
+    llist_node_t * siridb_node;
+    uint64_t next;
+
+    expire_dbs = vec_new(VEC_DEFAULT_SIZE);
+    if (expire_dbs == NULL)
+    {
+        log_critical("Cannot allocate a list for the expire task");
+        uv_timer_start(&expire, EXPIRE_cb, timeout, 0);
+        return;
+    }
+
+    siridb_node = siri.siridb_list->first;
+
+    while (siridb_node != NULL)
+    {
+        siridb = (siridb_t *) siridb_node->data;
+
+        /* inserts use these time stamps to skip expired points */
+        siridb_update_shard_expiration(siridb);
+
+        next = siridb_expire_next(siridb);
+
+        if (next == 0)
+        {
+            /* shards must not be removed while the optimize task, and
+             * therefore the backup mode or re-index task, is paused */
+            if (!siri.optimize->pause &&
+                vec_append_safe(&expire_dbs, siridb) == 0)
+            {
+                siridb_incref(siridb);
+            }
+        }
+        else if (next < timeout)
+        {
+            timeout = next;
+        }
+
+        siridb_node = siridb_node->next;
+    }
+
+    if (expire_dbs->len)
+    {
+        uv_queue_work(siri.loop, &work, EXPIRE_work, EXPIRE_work_finish);
+        return;
+    }
+
+    vec_free(expire_dbs);
+    expire_dbs = NULL;
+
+    uv_timer_start(&expire, EXPIRE_cb, timeout, 0);
+}
+
+static void EXPIRE_work(uv_work_t * work __attribute__((unused)))
+{
+    /*
+     * Expire Thread
+     */
+    size_t i, n;
+    siridb_t * siridb;
+
+    for (i = 0; i < expire_dbs->len && !siri_err; i++)
+    {
+        siridb = (siridb_t *) expire_dbs->data[i];
+        n = siridb_expire_drop(siridb);
+        if (n)
+        {
+            log_info(
+                    "Dropped %zu expired shard(s) from database '%s'",
+                    n, siridb->dbname);
+        }
+    }
+}
+
+static void EXPIRE_work_finish(
+        uv_work_t * work __attribute__((unused)),
+        int status)
+{
+    /*
+     * Main Thread
+     */
+    siridb_t * siridb;
+    size_t i;
+
+    if (status)
+    {
+        log_error("Expire task failed (error: %s)", uv_strerror(status));
+    }
+
+    for (i = 0; i < expire_dbs->len; i++)
+    {
+        siridb = (siridb_t *) expire_dbs->data[i];
+        siridb_decref(siridb);
+    }
+
+    vec_free(expire_dbs);
+    expire_dbs = NULL;
+
+    if (siri.expire != NULL)
+    {
+        /* check again, more shards might be expired in the meantime */
+        uv_timer_start(&expire, EXPIRE_cb, 0, 0);
+    }
+}
@@ -43,6 +43,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_between = cleri_keyword(CLERI_GID_K_BETWEEN, "between", CLERI_CASE_SENSITIVE);
     cleri_t * k_buffer_path = cleri_keyword(CLERI_GID_K_BUFFER_PATH, "buffer_path", CLERI_CASE_SENSITIVE);
     cleri_t * k_buffer_size = cleri_keyword(CLERI_GID_K_BUFFER_SIZE, "buffer_size", CLERI_CASE_SENSITIVE);
+    cleri_t * k_codec = cleri_keyword(CLERI_GID_K_CODEC, "codec", CLERI_CASE_SENSITIVE);
     cleri_t * k_count = cleri_keyword(CLERI_GID_K_COUNT, "count", CLERI_CASE_SENSITIVE);
     cleri_t * k_create = cleri_keyword(CLERI_GID_K_CREATE, "create", CLERI_CASE_SENSITIVE);
     cleri_t * k_critical = cleri_keyword(CLERI_GID_K_CRITICAL, "critical", CLERI_CASE_SENSITIVE);
@@ -52,6 +53,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_debug = cleri_keyword(CLERI_GID_K_DEBUG, "debug", CLERI_CASE_SENSITIVE);
     cleri_t * k_derivative = cleri_keyword(CLERI_GID_K_DERIVATIVE, "derivative", CLERI_CASE_SENSITIVE);
     cleri_t * k_difference = cleri_keyword(CLERI_GID_K_DIFFERENCE, "difference", CLERI_CASE_SENSITIVE);
+    cleri_t * k_distinct = cleri_keyword(CLERI_GID_K_DISTINCT, "distinct", CLERI_CASE_SENSITIVE);
     cleri_t * k_drop = cleri_keyword(CLERI_GID_K_DROP, "drop", CLERI_CASE_SENSITIVE);
     cleri_t * k_drop_threshold = cleri_keyword(CLERI_GID_K_DROP_THRESHOLD, "drop_threshold", CLERI_CASE_SENSITIVE);
     cleri_t * k_duration_log = cleri_keyword(CLERI_GID_K_DURATION_LOG, "duration_log", CLERI_CASE_SENSITIVE);
@@ -114,6 +116,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_merge = cleri_keyword(CLERI_GID_K_MERGE, "merge", CLERI_CASE_SENSITIVE);
     cleri_t * k_min = cleri_keyword(CLERI_GID_K_MIN, "min", CLERI_CASE_SENSITIVE);
     cleri_t * k_modify = cleri_keyword(CLERI_GID_K_MODIFY, "modify", CLERI_CASE_SENSITIVE);
+    cleri_t * k_moved = cleri_keyword(CLERI_GID_K_MOVED, "moved", CLERI_CASE_SENSITIVE);
     cleri_t * k_name = cleri_keyword(CLERI_GID_K_NAME, "name", CLERI_CASE_SENSITIVE);
     cleri_t * k_nan = cleri_keyword(CLERI_GID_K_NAN, "nan", CLERI_CASE_SENSITIVE);
     cleri_t * k_ninf = cleri_sequence(
@@ -129,12 +132,17 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_open_files = cleri_keyword(CLERI_GID_K_OPEN_FILES, "open_files", CLERI_CASE_SENSITIVE);
     cleri_t * k_or = cleri_keyword(CLERI_GID_K_OR, "or", CLERI_CASE_SENSITIVE);
     cleri_t * k_password = cleri_keyword(CLERI_GID_K_PASSWORD, "password", CLERI_CASE_SENSITIVE);
+    cleri_t * k_percentile = cleri_keyword(CLERI_GID_K_PERCENTILE, "percentile", CLERI_CASE_SENSITIVE);
+    cleri_t * k_placement = cleri_keyword(CLERI_GID_K_PLACEMENT, "placement", CLERI_CASE_SENSITIVE);
     cleri_t * k_points = cleri_keyword(CLERI_GID_K_POINTS, "points", CLERI_CASE_SENSITIVE);
     cleri_t * k_pool = cleri_keyword(CLERI_GID_K_POOL, "pool", CLERI_CASE_SENSITIVE);
     cleri_t * k_pools = cleri_keyword(CLERI_GID_K_POOLS, "pools", CLERI_CASE_SENSITIVE);
     cleri_t * k_port = cleri_keyword(CLERI_GID_K_PORT, "port", CLERI_CASE_SENSITIVE);
     cleri_t * k_prefix = cleri_keyword(CLERI_GID_K_PREFIX, "prefix", CLERI_CASE_SENSITIVE);
+    cleri_t * k_profile = cleri_keyword(CLERI_GID_K_PROFILE, "profile", CLERI_CASE_SENSITIVE);
     cleri_t * k_pvariance = cleri_keyword(CLERI_GID_K_PVARIANCE, "pvariance", CLERI_CASE_SENSITIVE);
+    cleri_t * k_query_cache_hit_rate = cleri_keyword(CLERI_GID_K_QUERY_CACHE_HIT_RATE, "query_cache_hit_rate", CLERI_CASE_SENSITIVE);
+    cleri_t * k_query_cache_time_saved = cleri_keyword(CLERI_GID_K_QUERY_CACHE_TIME_SAVED, "query_cache_time_saved", CLERI_CASE_SENSITIVE);
     cleri_t * k_read = cleri_keyword(CLERI_GID_K_READ, "read", CLERI_CASE_SENSITIVE);
     cleri_t * k_received_points = cleri_keyword(CLERI_GID_K_RECEIVED_POINTS, "received_points", CLERI_CASE_SENSITIVE);
     cleri_t * k_reindex_progress = cleri_keyword(CLERI_GID_K_REINDEX_PROGRESS, "reindex_progress", CLERI_CASE_SENSITIVE);
@@ -151,6 +159,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_show = cleri_keyword(CLERI_GID_K_SHOW, "show", CLERI_CASE_SENSITIVE);
     cleri_t * k_sid = cleri_keyword(CLERI_GID_K_SID, "sid", CLERI_CASE_SENSITIVE);
     cleri_t * k_size = cleri_keyword(CLERI_GID_K_SIZE, "size", CLERI_CASE_SENSITIVE);
+    cleri_t * k_slots = cleri_keyword(CLERI_GID_K_SLOTS, "slots", CLERI_CASE_SENSITIVE);
     cleri_t * k_start = cleri_keyword(CLERI_GID_K_START, "start", CLERI_CASE_SENSITIVE);
     cleri_t * k_startup_time = cleri_keyword(CLERI_GID_K_STARTUP_TIME, "startup_time", CLERI_CASE_SENSITIVE);
     cleri_t * k_status = cleri_keyword(CLERI_GID_K_STATUS, "status", CLERI_CASE_SENSITIVE);
@@ -170,6 +179,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * k_tags = cleri_keyword(CLERI_GID_K_TAGS, "tags", CLERI_CASE_SENSITIVE);
     cleri_t * k_tail = cleri_keyword(CLERI_GID_K_TAIL, "tail", CLERI_CASE_SENSITIVE);
     cleri_t * k_tee = cleri_keyword(CLERI_GID_K_TEE, "tee", CLERI_CASE_SENSITIVE);
+    cleri_t * k_tee_lag = cleri_keyword(CLERI_GID_K_TEE_LAG, "tee_lag", CLERI_CASE_SENSITIVE);
     cleri_t * k_time_precision = cleri_keyword(CLERI_GID_K_TIME_PRECISION, "time_precision", CLERI_CASE_SENSITIVE);
     cleri_t * k_timeit = cleri_keyword(CLERI_GID_K_TIMEIT, "timeit", CLERI_CASE_SENSITIVE);
     cleri_t * k_timeval = cleri_keyword(CLERI_GID_K_TIMEVAL, "timeval", CLERI_CASE_SENSITIVE);
@@ -370,10 +380,12 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * pool_props = cleri_choice(
         CLERI_GID_POOL_PROPS,
         CLERI_FIRST_MATCH,
-        3,
+        5,
         k_pool,
         k_servers,
-        k_series
+        k_series,
+        k_slots,
+        k_moved
     );
     cleri_t * pool_columns = cleri_list(CLERI_GID_POOL_COLUMNS, pool_props, cleri_token(CLERI_NONE, ","), 1, 0, 0);
     cleri_t * bool_operator = cleri_tokens(CLERI_GID_BOOL_OPERATOR, "== !=");
@@ -1051,6 +1063,28 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         cleri_optional(CLERI_NONE, time_expr),
         cleri_token(CLERI_NONE, ")")
     );
+    cleri_t * f_percentile = cleri_sequence(
+        CLERI_GID_F_PERCENTILE,
+        5,
+        k_percentile,
+        cleri_token(CLERI_NONE, "("),
+        r_float,
+        cleri_optional(CLERI_NONE, cleri_sequence(
+            CLERI_NONE,
+            2,
+            cleri_token(CLERI_NONE, ","),
+            time_expr
+        )),
+        cleri_token(CLERI_NONE, ")")
+    );
+    cleri_t * f_distinct = cleri_sequence(
+        CLERI_GID_F_DISTINCT,
+        4,
+        k_distinct,
+        cleri_token(CLERI_NONE, "("),
+        cleri_optional(CLERI_NONE, time_expr),
+        cleri_token(CLERI_NONE, ")")
+    );
     cleri_t * f_offset = cleri_sequence(
         CLERI_GID_F_OFFSET,
         4,
@@ -1123,7 +1157,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
     cleri_t * aggregate_functions = cleri_list(CLERI_GID_AGGREGATE_FUNCTIONS, cleri_choice(
         CLERI_NONE,
         CLERI_FIRST_MATCH,
-        22,
+        24,
         f_all,
         f_offset,
         f_limit,
@@ -1132,6 +1166,8 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         f_median,
         f_median_low,
         f_median_high,
+        f_percentile,
+        f_distinct,
         f_min,
         f_max,
         f_count,
@@ -1195,6 +1231,13 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         k_backup_mode,
         _boolean
     );
+    cleri_t * set_codec = cleri_sequence(
+        CLERI_GID_SET_CODEC,
+        3,
+        k_set,
+        k_codec,
+        string
+    );
     cleri_t * set_drop_threshold = cleri_sequence(
         CLERI_GID_SET_DROP_THRESHOLD,
         3,
@@ -1300,7 +1343,8 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         cleri_choice(
             CLERI_NONE,
             CLERI_FIRST_MATCH,
-            7,
+            8,
+            set_codec,
             set_drop_threshold,
             set_list_limit,
             set_select_points_limit,
@@ -1716,11 +1760,12 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         cleri_list(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_FIRST_MATCH,
-            37,
+            42,
             k_active_handles,
             k_active_tasks,
             k_buffer_path,
             k_buffer_size,
+            k_codec,
             k_dbname,
             k_dbpath,
             k_drop_threshold,
@@ -1738,7 +1783,10 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
             k_max_open_files,
             k_mem_usage,
             k_open_files,
+            k_placement,
             k_pool,
+            k_query_cache_hit_rate,
+            k_query_cache_time_saved,
             k_received_points,
             k_reindex_progress,
             k_selected_points,
@@ -1748,6 +1796,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
             k_status,
             k_sync_progress,
             k_tee,
+            k_tee_lag,
             k_time_precision,
             k_timezone,
             k_uptime,
@@ -1757,11 +1806,18 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         ), cleri_token(CLERI_NONE, ","), 0, 0, 0)
     );
     cleri_t * timeit_stmt = cleri_dup(CLERI_GID_TIMEIT_STMT, k_timeit);
+    cleri_t * profile_stmt = cleri_dup(CLERI_GID_PROFILE_STMT, k_profile);
     cleri_t * help_stmt = cleri_ref();
     cleri_t * START = cleri_sequence(
         CLERI_GID_START,
         3,
-        cleri_optional(CLERI_NONE, timeit_stmt),
+        cleri_optional(CLERI_NONE, cleri_choice(
+            CLERI_NONE,
+            CLERI_MOST_GREEDY,
+            2,
+            timeit_stmt,
+            profile_stmt
+        )),
         cleri_optional(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_FIRST_MATCH,
@@ -1882,6 +1938,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         ))
     );
     cleri_t * help_noaccess = cleri_keyword(CLERI_GID_HELP_NOACCESS, "noaccess", CLERI_CASE_SENSITIVE);
+    cleri_t * help_profile = cleri_keyword(CLERI_GID_HELP_PROFILE, "profile", CLERI_CASE_SENSITIVE);
     cleri_t * help_revoke = cleri_keyword(CLERI_GID_HELP_REVOKE, "revoke", CLERI_CASE_SENSITIVE);
     cleri_t * help_select = cleri_keyword(CLERI_GID_HELP_SELECT, "select", CLERI_CASE_SENSITIVE);
     cleri_t * help_show = cleri_keyword(CLERI_GID_HELP_SHOW, "show", CLERI_CASE_SENSITIVE);
@@ -1894,7 +1951,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
         cleri_optional(CLERI_NONE, cleri_choice(
             CLERI_NONE,
             CLERI_MOST_GREEDY,
-            14,
+            15,
             help_access,
             help_alter,
             help_count,
@@ -1904,6 +1961,7 @@ cleri_grammar_t * compile_siri_grammar_grammar(void)
             help_grant,
             help_list,
             help_noaccess,
+            help_profile,
             help_revoke,
             help_select,
             help_show,
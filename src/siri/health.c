@@ -2,6 +2,7 @@
  * health.c
  */
 #include <siri/health.h>
+#include <siri/metrics.h>
 #include <siri/siri.h>
 #include <siri/net/tcp.h>
 #include <logger/logger.h>
@@ -55,6 +56,12 @@
     "\r\n" \
     "BACKUP MODE\n"
 
+#define METRICS_HEADER \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: text/plain; version=0.0.4\r\n" \
+    "Content-Length: %zu\r\n" \
+    "\r\n"
+
 /* static response buffers */
 static uv_buf_t health__uv_ok_buf;
 static uv_buf_t health__uv_nok_buf;
@@ -70,6 +77,7 @@ static http_parser_settings health__settings;
 static void health__close_cb(uv_handle_t * handle)
 {
     siri_health_request_t * web_request = handle->data;
+    free(web_request->metrics.base);
     free(web_request);
 }
 
@@ -209,6 +217,100 @@ static uv_buf_t * health__get_ready_response(void)
     return &health__uv_nok_buf;
 }
 
+/*
+ * Write metrics for each database. The replication lag is the number of
+ * packages which are queued for the replica since this server is started.
+ */
+static int health__write_db_metrics(siri_metrics_buf_t * buf)
+{
+    siridb_t * siridb;
+    llist_node_t * siridb_node;
+    int rc = siri_metrics_printf(buf,
+            "# HELP siridb_received_points_total "
+            "Number of points received by a database.\n"
+            "# TYPE siridb_received_points_total counter\n");
+
+    for (   siridb_node = siri.siridb_list->first;
+            siridb_node != NULL;
+            siridb_node = siridb_node->next)
+    {
+        siridb = (siridb_t *) siridb_node->data;
+        rc |= siri_metrics_printf(buf,
+                "siridb_received_points_total{database=\"%s\"} %zu\n",
+                siridb->dbname,
+                siridb->received_points);
+    }
+
+    rc |= siri_metrics_printf(buf,
+            "# HELP siridb_selected_points_total "
+            "Number of points selected from a database.\n"
+            "# TYPE siridb_selected_points_total counter\n");
+
+    for (   siridb_node = siri.siridb_list->first;
+            siridb_node != NULL;
+            siridb_node = siridb_node->next)
+    {
+        siridb = (siridb_t *) siridb_node->data;
+        rc |= siri_metrics_printf(buf,
+                "siridb_selected_points_total{database=\"%s\"} %zu\n",
+                siridb->dbname,
+                siridb->selected_points);
+    }
+
+    rc |= siri_metrics_printf(buf,
+            "# HELP siridb_replication_lag_packages "
+            "Number of packages waiting to be replicated.\n"
+            "# TYPE siridb_replication_lag_packages gauge\n");
+
+    for (   siridb_node = siri.siridb_list->first;
+            siridb_node != NULL;
+            siridb_node = siridb_node->next)
+    {
+        siridb = (siridb_t *) siridb_node->data;
+        if (siridb->replicate != NULL)
+        {
+            rc |= siri_metrics_printf(buf,
+                    "siridb_replication_lag_packages{database=\"%s\"} "
+                    "%" PRIu64 "\n",
+                    siridb->dbname,
+                    siridb->replicate->pending);
+        }
+    }
+
+    return rc;
+}
+
+/*
+ * Returns the metrics response or the not found response in case of an
+ * allocation error.
+ */
+static uv_buf_t * health__get_metrics_response(
+        siri_health_request_t * web_request)
+{
+    siri_metrics_buf_t body = {0};
+    siri_metrics_buf_t response = {0};
+
+    if (web_request->metrics.base != NULL)
+    {
+        return &web_request->metrics;
+    }
+
+    if (siri_metrics_write(&body) == 0 &&
+        health__write_db_metrics(&body) == 0 &&
+        siri_metrics_printf(&response, METRICS_HEADER, body.len) == 0 &&
+        siri_metrics_printf(&response, "%.*s", (int) body.len, body.data) == 0)
+    {
+        free(body.data);
+        web_request->metrics = uv_buf_init(response.data, response.len);
+        return &web_request->metrics;
+    }
+
+    log_error("cannot create metrics response");
+    free(body.data);
+    free(response.data);
+    return &health__uv_nfound_buf;
+}
+
 static int health__url_cb(http_parser * parser, const char * at, size_t length)
 {
     siri_health_request_t * web_request = parser->data;
@@ -228,6 +330,10 @@ static int health__url_cb(http_parser * parser, const char * at, size_t length)
         : (length == 8 && memcmp(at, "/healthy", 8) == 0)
         ? &health__uv_ok_buf
 
+        /* metrics response */
+        : (length == 8 && memcmp(at, "/metrics", 8) == 0)
+        ? health__get_metrics_response(web_request)
+
         /* everything else */
         : &health__uv_nfound_buf;
 
@@ -284,6 +390,7 @@ static void health__connection_cb(uv_stream_t * server, int status)
 
     web_request->flags = SIRIDB_HEALTH_FLAG;
     web_request->is_closed = false;
+    web_request->metrics.base = NULL;
     web_request->uvstream.data = web_request;
     web_request->parser.data = web_request;
 
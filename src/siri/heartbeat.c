@@ -59,8 +59,6 @@ static void HEARTBEAT_cb(uv_timer_t * handle __attribute__((unused)))
     {
         siridb = (siridb_t *) siridb_node->data;
 
-        siridb_update_shard_expiration(siridb);
-
         server_node = siridb->servers->first;
         while (server_node != NULL)
         {
@@ -72,6 +70,7 @@ static void HEARTBEAT_cb(uv_timer_t * handle __attribute__((unused)))
             }
             else if (siridb_server_is_online(server))
             {
+                siridb_server_connect_extra(siridb, server);
                 siridb_server_send_flags(server);
             }
 
@@ -0,0 +1,459 @@
+/*
+ * metrics.c - Counters and latency histograms for hot paths.
+ */
+#include <logger/logger.h>
+#include <pthread.h>
+#include <siri/metrics.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define METRICS_BUF_SZ 8192
+#define METRICS_LE_FIRST 4      /* first histogram bound is 2^4 usec        */
+#define METRICS_LE_LAST 34      /* last histogram bound is 2^34 usec        */
+
+typedef struct metrics_local_s metrics_local_t;
+
+struct metrics_local_s
+{
+    metrics_local_t * next;
+    int in_use;
+    uint64_t counters[SIRI_METRICS_COUNTER_END];
+    siri_metrics_hist_t hists[SIRI_METRICS_TIMER_END];
+};
+
+static metrics_local_t * METRICS_get_local(void);
+static void METRICS_release_local(void * arg);
+static void METRICS_init(void);
+static inline void METRICS_add(uint64_t * counter, uint64_t n);
+static inline size_t METRICS_idx(uint64_t usec);
+static inline uint64_t METRICS_lower(size_t idx);
+
+static const struct
+{
+    const char * name;
+    const char * help;
+} METRICS_counters[SIRI_METRICS_COUNTER_END] = {
+    [SIRI_METRICS_SHARD_READ_BYTES] = {
+        "siridb_shard_read_bytes_total",
+        "Number of bytes read from shard files."},
+    [SIRI_METRICS_FCACHE_HITS] = {
+        "siridb_fcache_hits_total",
+        "Number of shard reads which found the shard file open."},
+    [SIRI_METRICS_FCACHE_MISSES] = {
+        "siridb_fcache_misses_total",
+        "Number of shard reads which had to open the shard file."},
+};
+
+/* timers which share a name must be listed next to each other */
+static const struct
+{
+    const char * name;
+    const char * help;
+    const char * label;
+} METRICS_timers[SIRI_METRICS_TIMER_END] = {
+    [SIRI_METRICS_INSERT] = {
+        "siridb_insert_duration_seconds",
+        "Time between receiving an insert and sending the response.",
+        NULL},
+    [SIRI_METRICS_SELECT_LOOKUP] = {
+        "siridb_select_duration_seconds",
+        "Time spent in each stage of a select query. (read includes "
+        "decompress)",
+        "stage=\"lookup\""},
+    [SIRI_METRICS_SELECT_READ] = {
+        "siridb_select_duration_seconds",
+        NULL,
+        "stage=\"read\""},
+    [SIRI_METRICS_SELECT_DECOMPRESS] = {
+        "siridb_select_duration_seconds",
+        NULL,
+        "stage=\"decompress\""},
+    [SIRI_METRICS_SELECT_AGGREGATE] = {
+        "siridb_select_duration_seconds",
+        NULL,
+        "stage=\"aggregate\""},
+    [SIRI_METRICS_SELECT_PACK] = {
+        "siridb_select_duration_seconds",
+        NULL,
+        "stage=\"pack\""},
+    [SIRI_METRICS_OPTIMIZE] = {
+        "siridb_optimize_duration_seconds",
+        "Duration of an optimize cycle.",
+        NULL},
+};
+
+static __thread metrics_local_t * METRICS_local;
+static metrics_local_t * METRICS_locals;
+static pthread_key_t METRICS_key;
+static pthread_once_t METRICS_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Returns the monotonic time in microseconds.
+ */
+uint64_t siri_metrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Increment a counter by n. (the update is lost in case of an allocation
+ * error)
+ */
+void siri_metrics_incr(siri_metrics_counter_t counter, uint64_t n)
+{
+    metrics_local_t * local = METRICS_get_local();
+    if (local != NULL)
+    {
+        METRICS_add(&local->counters[counter], n);
+    }
+}
+
+/*
+ * Record a duration in microseconds. (the value is lost in case of an
+ * allocation error)
+ */
+void siri_metrics_observe(siri_metrics_timer_t timer, uint64_t usec)
+{
+    metrics_local_t * local = METRICS_get_local();
+    if (local != NULL)
+    {
+        siri_metrics_hist_t * hist = &local->hists[timer];
+        METRICS_add(&hist->count, 1);
+        METRICS_add(&hist->sum, usec);
+        METRICS_add(&hist->buckets[METRICS_idx(usec)], 1);
+    }
+}
+
+/*
+ * Returns the sum of a counter over all threads.
+ */
+uint64_t siri_metrics_counter(siri_metrics_counter_t counter)
+{
+    metrics_local_t * local;
+    uint64_t n = 0;
+
+    for (local = __atomic_load_n(&METRICS_locals, __ATOMIC_ACQUIRE);
+         local != NULL;
+         local = local->next)
+    {
+        n += __atomic_load_n(&local->counters[counter], __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+/*
+ * Fill a histogram with the sum of a timer over all threads. Since threads
+ * keep updating their histograms, the count might be slightly off from the
+ * sum of the buckets.
+ */
+void siri_metrics_hist(siri_metrics_timer_t timer, siri_metrics_hist_t * hist)
+{
+    metrics_local_t * local;
+    siri_metrics_hist_t * h;
+    size_t i;
+
+    memset(hist, 0, sizeof(siri_metrics_hist_t));
+
+    for (local = __atomic_load_n(&METRICS_locals, __ATOMIC_ACQUIRE);
+         local != NULL;
+         local = local->next)
+    {
+        h = &local->hists[timer];
+        hist->count += __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+        hist->sum += __atomic_load_n(&h->sum, __ATOMIC_RELAXED);
+        for (i = 0; i < SIRI_METRICS_HIST_SZ; i++)
+        {
+            hist->buckets[i] +=
+                    __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ * Returns the value in microseconds at the given percentile (0..100). The
+ * value is the middle of the bucket holding the percentile, or 0 when the
+ * histogram is empty.
+ */
+uint64_t siri_metrics_percentile(siri_metrics_hist_t * hist, double p)
+{
+    uint64_t total = 0, rank, n = 0;
+    size_t i;
+
+    for (i = 0; i < SIRI_METRICS_HIST_SZ; i++)
+    {
+        total += hist->buckets[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    rank = (uint64_t) (p / 100.0 * total + 0.5);
+    rank = rank ? rank : 1;
+    rank = rank > total ? total : rank;
+
+    for (i = 0; i < SIRI_METRICS_HIST_SZ; i++)
+    {
+        n += hist->buckets[i];
+        if (n >= rank)
+        {
+            break;
+        }
+    }
+
+    return i + 1 < SIRI_METRICS_HIST_SZ
+            ? (METRICS_lower(i) + METRICS_lower(i + 1) - 1) / 2
+            : METRICS_lower(i);
+}
+
+/*
+ * Append to a buffer. The buffer starts with zeros and the data must be
+ * freed by the caller, even when an error is returned.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siri_metrics_printf(siri_metrics_buf_t * buf, const char * fmt, ...)
+{
+    va_list args, cp;
+    size_t room = buf->size - buf->len;
+    int n;
+
+    va_start(args, fmt);
+    va_copy(cp, args);
+
+    n = vsnprintf(buf->data ? buf->data + buf->len : NULL, room, fmt, args);
+    if (n >= 0 && (size_t) n >= room)
+    {
+        size_t size = buf->size ? buf->size : METRICS_BUF_SZ;
+        char * tmp;
+
+        while (size - buf->len <= (size_t) n)
+        {
+            size *= 2;
+        }
+
+        tmp = realloc(buf->data, size);
+        if (tmp == NULL)
+        {
+            n = -1;
+        }
+        else
+        {
+            buf->data = tmp;
+            buf->size = size;
+            n = vsnprintf(buf->data + buf->len, size - buf->len, fmt, cp);
+        }
+    }
+
+    va_end(cp);
+    va_end(args);
+
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    buf->len += n;
+    return 0;
+}
+
+/*
+ * Write all counters and timers in Prometheus text format. Timers are
+ * written as histograms in seconds with a bucket for each power of two
+ * microseconds.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error.
+ */
+int siri_metrics_write(siri_metrics_buf_t * buf)
+{
+    siri_metrics_hist_t hist;
+    const char * name;
+    const char * label;
+    uint64_t n;
+    size_t i, idx;
+    int k, rc = 0;
+
+    for (i = 0; i < SIRI_METRICS_COUNTER_END; i++)
+    {
+        name = METRICS_counters[i].name;
+        rc |= siri_metrics_printf(buf,
+                "# HELP %s %s\n"
+                "# TYPE %s counter\n"
+                "%s %" PRIu64 "\n",
+                name, METRICS_counters[i].help,
+                name,
+                name, siri_metrics_counter(i));
+    }
+
+    rc |= siri_metrics_printf(buf,
+            "# HELP siridb_log_dropped_lines_total "
+            "Number of log lines dropped because the log writer lagged.\n"
+            "# TYPE siridb_log_dropped_lines_total counter\n"
+            "siridb_log_dropped_lines_total %" PRIu64 "\n",
+            logger_dropped());
+
+    for (i = 0; i < SIRI_METRICS_TIMER_END; i++)
+    {
+        name = METRICS_timers[i].name;
+        label = METRICS_timers[i].label;
+
+        if (METRICS_timers[i].help != NULL)
+        {
+            rc |= siri_metrics_printf(buf,
+                    "# HELP %s %s\n"
+                    "# TYPE %s histogram\n",
+                    name, METRICS_timers[i].help,
+                    name);
+        }
+
+        siri_metrics_hist(i, &hist);
+
+        for (idx = 0, n = 0, k = METRICS_LE_FIRST; k <= METRICS_LE_LAST; k++)
+        {
+            for (; METRICS_lower(idx) < (1ULL << k); idx++)
+            {
+                n += hist.buckets[idx];
+            }
+            rc |= siri_metrics_printf(buf,
+                    "%s_bucket{%s%sle=\"%g\"} %" PRIu64 "\n",
+                    name,
+                    label ? label : "",
+                    label ? "," : "",
+                    (double) (1ULL << k) / 1e6,
+                    n);
+        }
+
+        rc |= siri_metrics_printf(buf,
+                "%s_bucket{%s%sle=\"+Inf\"} %" PRIu64 "\n"
+                "%s_sum%s%s%s %g\n"
+                "%s_count%s%s%s %" PRIu64 "\n",
+                name, label ? label : "", label ? "," : "", hist.count,
+                name, label ? "{" : "", label ? label : "", label ? "}" : "",
+                (double) hist.sum / 1e6,
+                name, label ? "{" : "", label ? label : "", label ? "}" : "",
+                hist.count);
+    }
+
+    return rc;
+}
+
+/*
+ * Returns the block for the current thread or NULL in case of an allocation
+ * error. A released block is used when available so the number of blocks
+ * never exceeds the number of threads alive at the same time. Blocks are
+ * never freed since the counters must keep their values.
+ */
+static metrics_local_t * METRICS_get_local(void)
+{
+    metrics_local_t * local = METRICS_local;
+    int expected;
+
+    if (local != NULL)
+    {
+        return local;
+    }
+
+    (void) pthread_once(&METRICS_once, METRICS_init);
+
+    for (local = __atomic_load_n(&METRICS_locals, __ATOMIC_ACQUIRE);
+         local != NULL;
+         local = local->next)
+    {
+        expected = 0;
+        if (__atomic_compare_exchange_n(
+                &local->in_use, &expected, 1, 0,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+    }
+
+    if (local == NULL)
+    {
+        local = calloc(1, sizeof(metrics_local_t));
+        if (local == NULL)
+        {
+            return NULL;
+        }
+
+        local->in_use = 1;
+        local->next = __atomic_load_n(&METRICS_locals, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(
+                &METRICS_locals, &local->next, local, 1,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    /* the key releases the block when the thread exits */
+    (void) pthread_setspecific(METRICS_key, local);
+    METRICS_local = local;
+    return local;
+}
+
+static void METRICS_release_local(void * arg)
+{
+    metrics_local_t * local = arg;
+    __atomic_store_n(&local->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void METRICS_init(void)
+{
+    (void) pthread_key_create(&METRICS_key, METRICS_release_local);
+}
+
+/*
+ * Only the owning thread writes to a block so there is no need for a locked
+ * instruction, the atomic store only makes sure a reader never sees a torn
+ * value.
+ */
+static inline void METRICS_add(uint64_t * counter, uint64_t n)
+{
+    __atomic_store_n(
+            counter,
+            __atomic_load_n(counter, __ATOMIC_RELAXED) + n,
+            __ATOMIC_RELAXED);
+}
+
+static inline size_t METRICS_idx(uint64_t usec)
+{
+    int exp;
+
+    if (usec < SIRI_METRICS_SUB)
+    {
+        return (size_t) usec;
+    }
+
+    if (usec >> SIRI_METRICS_MAX_BITS)
+    {
+        return SIRI_METRICS_HIST_SZ - 1;
+    }
+
+    exp = 63 - __builtin_clzll(usec);
+
+    return (size_t) (exp - SIRI_METRICS_SUB_BITS + 1) * SIRI_METRICS_SUB +
+            (size_t) ((usec >> (exp - SIRI_METRICS_SUB_BITS)) -
+                    SIRI_METRICS_SUB);
+}
+
+/*
+ * Returns the lowest value in microseconds which is stored in a bucket.
+ */
+static inline uint64_t METRICS_lower(size_t idx)
+{
+    int exp;
+
+    if (idx < SIRI_METRICS_SUB)
+    {
+        return (uint64_t) idx;
+    }
+
+    exp = (int) (idx / SIRI_METRICS_SUB) - 1 + SIRI_METRICS_SUB_BITS;
+
+    return (uint64_t) (SIRI_METRICS_SUB + idx % SIRI_METRICS_SUB) <<
+            (exp - SIRI_METRICS_SUB_BITS);
+}
@@ -6,6 +6,7 @@
 #include <siri/db/auth.h>
 #include <siri/db/groups.h>
 #include <siri/db/insert.h>
+#include <siri/db/plan.h>
 #include <siri/db/query.h>
 #include <siri/db/replicate.h>
 #include <siri/db/server.h>
@@ -503,6 +504,9 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg, int flags)
     qp_unpacker_init(&unpacker, pkg->data, pkg->len);
 
     qp_obj_t qp_query;
+    qp_obj_t qp_flags;
+    qp_obj_t qp_plan;
+    siridb_plan_t * plan;
 
     if (flags & SIRIDB_QUERY_FLAG_UPDATE_REPLICA)
     {
@@ -517,13 +521,45 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg, int flags)
     if (    qp_is_array(qp_next(&unpacker, NULL)) &&
             qp_next(&unpacker, &qp_query) == QP_RAW)
     {
-        siridb_query_run(
-                pkg->pid,
-                client,
-                (const char *) qp_query.via.raw,
-                qp_query.len,
-                0.0,
-                0);
+        /*
+         * Skip the time precision and read the flags which are supported by
+         * the sending server. (older versions do not send these flags)
+         */
+        flags = (
+            qp_is_int(qp_next(&unpacker, NULL)) &&
+            qp_is_int(qp_next(&unpacker, &qp_flags))
+        ) ? (int) (qp_flags.via.int64 & (
+                SIRIDB_QUERY_FLAG_PARTIAL|
+                SIRIDB_QUERY_FLAG_FRAMES|
+                SIRIDB_QUERY_FLAG_ZIP)) : 0;
+
+        /*
+         * A select query might include a plan. When the plan cannot be used,
+         * for example when created by another version, we parse the query.
+         */
+        plan = (qp_next(&unpacker, &qp_plan) == QP_RAW) ?
+                siridb_plan_unpack(qp_plan.via.raw, qp_plan.len) : NULL;
+
+        if (plan != NULL)
+        {
+            siridb_query_run_plan(
+                    pkg->pid,
+                    client,
+                    (const char *) qp_query.via.raw,
+                    qp_query.len,
+                    flags,
+                    plan);
+        }
+        else
+        {
+            siridb_query_run(
+                    pkg->pid,
+                    client,
+                    (const char *) qp_query.via.raw,
+                    qp_query.len,
+                    0.0,
+                    flags);
+        }
     }
     else
     {
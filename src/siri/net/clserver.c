@@ -478,8 +478,10 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg)
     qp_unpacker_t unpacker;
     qp_obj_t qp_query;
     qp_obj_t qp_time_precision;
+    qp_obj_t qp_options;
     float factor;
     siridb_timep_t tp = SIRIDB_TIME_DEFAULT;
+    int flags = SIRIDB_QUERY_FLAG_MASTER;
 
     qp_unpacker_init(&unpacker, pkg->data, pkg->len);
 
@@ -497,13 +499,20 @@ static void on_query(sirinet_stream_t * client, sirinet_pkg_t * pkg)
         factor = (tp == SIRIDB_TIME_DEFAULT) ? 0.0 :
                 pow(1000.0, tp - siridb->time->precision);
 
+        /* options are optional, older clients only send two items */
+        if (qp_next(&unpacker, &qp_options) == QP_INT64 &&
+            (qp_options.via.int64 & CPROTO_QUERY_OPT_COLUMNS))
+        {
+            flags |= SIRIDB_QUERY_FLAG_COLUMNS;
+        }
+
         siridb_query_run(
                 pkg->pid,
                 client,
                 (const char *) qp_query.via.raw,
                 qp_query.len,
                 factor,
-                SIRIDB_QUERY_FLAG_MASTER);
+                flags);
     }
     else
     {
@@ -18,7 +18,17 @@ typedef struct pkg_send_s
     sirinet_stream_t * client;
 } pkg_send_t;
 
+typedef struct pkg_frames_s
+{
+    sirinet_pkg_t * pkg;
+    sirinet_stream_t * client;
+    size_t offset;
+    sirinet_pkg_t header;       /* header for the frame which is written */
+} pkg_frames_t;
+
 static void PKG_write_cb(uv_write_t * req, int status);
+static int PKG_write_frame(uv_write_t * req);
+static void PKG_frame_cb(uv_write_t * req, int status);
 
 /*
  * Returns NULL and raises a SIGNAL in case an error has occurred.
@@ -226,6 +236,135 @@ int sirinet_pkg_send(sirinet_stream_t * client, sirinet_pkg_t * pkg)
     return 0;
 }
 
+/*
+ * Send a package in frames of at most SIRINET_PKG_FRAME_SIZE bytes. The next
+ * frame is written when the previous frame is written so other packages for
+ * the same stream can be written in between. Small packages are sent using
+ * sirinet_pkg_send().
+ *
+ * Only use this function for a server which supports frames.
+ *
+ * Returns 0 if successful or -1 when an error has occurred.
+ * (signal is raised in case of an error)
+ *
+ * Note: pkg will be freed after calling this function.
+ */
+int sirinet_pkg_send_frames(sirinet_stream_t * client, sirinet_pkg_t * pkg)
+{
+    if (sizeof(sirinet_pkg_t) * 2 + pkg->len <= SIRINET_PKG_FRAME_SIZE)
+    {
+        return sirinet_pkg_send(client, pkg);
+    }
+
+    uv_write_t * req = malloc(sizeof(uv_write_t));
+    pkg_frames_t * frames = malloc(sizeof(pkg_frames_t));
+
+    if (req == NULL || frames == NULL)
+    {
+        ERR_ALLOC
+        free(pkg);
+        free(req);
+        free(frames);
+        return -1;
+    }
+
+    /* increment client reference counter */
+    sirinet_stream_incref(client);
+
+    /* the original header is sent as part of the first frame */
+    pkg->checkbit = pkg->tp ^ 255;
+
+    frames->pkg = pkg;
+    frames->client = client;
+    frames->offset = 0;
+    frames->header.pid = pkg->pid;
+    frames->header.tp = BPROTO_RES_FRAME;
+    frames->header.checkbit = BPROTO_RES_FRAME ^ 255;
+    req->data = frames;
+
+    if (PKG_write_frame(req))
+    {
+        sirinet_stream_decref(client);
+        free(pkg);
+        free(frames);
+        free(req);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Add a received frame to a package. Each frame holds the next part of the
+ * original package, starting with the header of the original package. The
+ * package must be NULL for the first frame and 'n' is used to store the
+ * number of received bytes.
+ *
+ * Returns 1 when the package is complete, 0 when more frames are expected or
+ * -1 when the frame is invalid or in case of an allocation error.
+ */
+int sirinet_pkg_frame_add(
+        sirinet_pkg_t ** pkg,
+        size_t * n,
+        sirinet_pkg_t * frame)
+{
+    size_t size;
+
+    if (*pkg == NULL)
+    {
+        sirinet_pkg_t header;
+
+        if (!sirinet_pkg_frame_is_first(frame))
+        {
+            return -1;
+        }
+
+        memcpy(&header, frame->data, sizeof(sirinet_pkg_t));
+
+        *pkg = malloc(sizeof(sirinet_pkg_t) + header.len);
+        if (*pkg == NULL)
+        {
+            return -1;
+        }
+        *n = 0;
+        size = sizeof(sirinet_pkg_t) + header.len;
+    }
+    else
+    {
+        size = sizeof(sirinet_pkg_t) + (*pkg)->len;
+    }
+
+    if (frame->len > size - *n)
+    {
+        return -1;
+    }
+
+    memcpy((char *) *pkg + *n, frame->data, frame->len);
+    *n += frame->len;
+
+    return *n == size;
+}
+
+/*
+ * Returns 1 when the frame starts with the header of the original package,
+ * which is only the case for the first frame of a package.
+ */
+int sirinet_pkg_frame_is_first(sirinet_pkg_t * frame)
+{
+    sirinet_pkg_t header;
+    uint8_t check;
+
+    if (frame->len < sizeof(sirinet_pkg_t))
+    {
+        return 0;
+    }
+
+    memcpy(&header, frame->data, sizeof(sirinet_pkg_t));
+    check = header.tp ^ 255;
+
+    return header.pid == frame->pid && check == header.checkbit;
+}
+
 /*
  * Returns a copy of package allocated using malloc().
  * In case of an error, NULL is returned.
@@ -256,3 +395,53 @@ static void PKG_write_cb(uv_write_t * req, int status)
     free(data);
     free(req);
 }
+
+/*
+ * Write the next frame. Returns 0 if successful or an uv error code.
+ */
+static int PKG_write_frame(uv_write_t * req)
+{
+    pkg_frames_t * frames = (pkg_frames_t *) req->data;
+    size_t n = sizeof(sirinet_pkg_t) + frames->pkg->len - frames->offset;
+
+    if (n > SIRINET_PKG_FRAME_SIZE - sizeof(sirinet_pkg_t))
+    {
+        n = SIRINET_PKG_FRAME_SIZE - sizeof(sirinet_pkg_t);
+    }
+
+    frames->header.len = (uint32_t) n;
+
+    uv_buf_t wrbufs[2] = {
+        uv_buf_init((char *) &frames->header, sizeof(sirinet_pkg_t)),
+        uv_buf_init((char *) frames->pkg + frames->offset, n)
+    };
+
+    frames->offset += n;
+
+    return uv_write(req, frames->client->stream, wrbufs, 2, PKG_frame_cb);
+}
+
+static void PKG_frame_cb(uv_write_t * req, int status)
+{
+    pkg_frames_t * frames = (pkg_frames_t *) req->data;
+
+    if (status)
+    {
+        log_error("Socket write error: %s", uv_strerror(status));
+    }
+    else if (frames->offset < sizeof(sirinet_pkg_t) + frames->pkg->len)
+    {
+        if (PKG_write_frame(req) == 0)
+        {
+            return;
+        }
+        log_error("Cannot write the next frame (pid: %" PRIu16 ")",
+                frames->pkg->pid);
+    }
+
+    sirinet_stream_decref(frames->client);
+
+    free(frames->pkg);
+    free(frames);
+    free(req);
+}
@@ -5,6 +5,22 @@
 #include <logger/logger.h>
 #include <siri/err.h>
 #include <siri/net/promise.h>
+#include <stdlib.h>
+
+typedef struct promise_slab_s promise_slab_t;
+
+struct promise_slab_s
+{
+    promise_slab_t * next;
+    sirinet_promise_t promises[PROMISE_SLAB_SIZE];
+};
+
+/*
+ * Promises are only created and destroyed on the main loop so the slabs do
+ * not need a lock. Unused promises are linked using the data pointer.
+ */
+static promise_slab_t * promise_slabs = NULL;
+static sirinet_promise_t * promise_free = NULL;
 
 const char * sirinet_promise_strstatus(sirinet_promise_status_t status)
 {
@@ -22,7 +38,70 @@ const char * sirinet_promise_strstatus(sirinet_promise_status_t status)
 }
 
 /*
- * Creating a new promise is done in 'siridb_server_send_pkg'.
+ * Returns a promise from the slab or NULL in case of an allocation error.
+ *
+ * Slabs are never released until sirinet_promise_slab_destroy() is called,
+ * so the memory used is bound to the maximum number of promises which were
+ * in use at the same time.
+ */
+sirinet_promise_t * sirinet_promise_new(void)
+{
+    sirinet_promise_t * promise;
+
+    if (promise_free == NULL)
+    {
+        size_t i;
+        promise_slab_t * slab = malloc(sizeof(promise_slab_t));
+        if (slab == NULL)
+        {
+            return NULL;
+        }
+        slab->next = promise_slabs;
+        promise_slabs = slab;
+
+        for (i = 0; i < PROMISE_SLAB_SIZE; i++)
+        {
+            slab->promises[i].data = promise_free;
+            promise_free = &slab->promises[i];
+        }
+    }
+
+    promise = promise_free;
+    promise_free = promise->data;
+
+    promise->tentry.next = NULL;
+    promise->tentry.pprev = NULL;
+    promise->tentry.data = promise;
+    promise->frames = NULL;
+    promise->sent = 0;
+    promise->rtt = 0;
+
+    return promise;
+}
+
+/*
+ * Return a promise to the slab. Use sirinet_promise_decref() instead of
+ * calling this function directly.
  */
+void sirinet_promise_free(sirinet_promise_t * promise)
+{
+    assert (!sirinet_twheel_is_pending(&promise->tentry));
+    free(promise->frames);
+    promise->data = promise_free;
+    promise_free = promise;
+}
 
+/*
+ * Free all slabs. Should only be called at exit when no promises are in use.
+ */
+void sirinet_promise_slab_destroy(void)
+{
+    promise_slab_t * slab;
 
+    while ((slab = promise_slabs) != NULL)
+    {
+        promise_slabs = slab->next;
+        free(slab);
+    }
+    promise_free = NULL;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <logger/logger.h>
 #include <siri/err.h>
+#include <siri/metrics.h>
 #include <siri/net/promise.h>
 #include <siri/net/promises.h>
 
@@ -74,6 +75,8 @@ void sirinet_promises_on_response(
 {
     sirinet_promises_t * promises = (sirinet_promises_t *) promise->data;
 
+    promise->rtt = siri_metrics_now() - promise->sent;
+
     if (status)
     {
         /* we already have a log entry so this can be a debug log */
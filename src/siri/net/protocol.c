@@ -129,6 +129,7 @@ const char * sirinet_bproto_server_str(bproto_server_t n)
     case BPROTO_RES_TAGS: return "BPROTO_RES_TAGS";
     case BPROTO_ACK_SERIES_TAGS: return "BPROTO_ACK_SERIES_TAGS";
     case BPROTO_ACK_EMPTY_TAGS: return "BPROTO_ACK_EMPTY_TAGS";
+    case BPROTO_RES_FRAME: return "BPROTO_RES_FRAME";
     default:
         sprintf(protocol_str, "BPROTO_SERVER_TYPE_UNKNOWN (%d)", n);
         return protocol_str;
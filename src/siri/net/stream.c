@@ -3,6 +3,7 @@
  */
 #include <assert.h>
 #include <logger/logger.h>
+#include <siri/api.h>
 #include <siri/service/client.h>
 #include <siri/err.h>
 #include <siri/net/protocol.h>
@@ -13,8 +14,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_ALLOWED_PKG_SIZE 41943040      /* 40 MB  */
-
 #define QUIT_STREAM                     \
     free(client->buf);                  \
     client->buf = NULL;                 \
@@ -250,6 +249,8 @@ void sirinet__stream_free(uv_stream_t * uvclient)
     switch ((sirinet_stream_tp_t) client->tp)
     {
     case STREAM_API_CLIENT:
+        siri_api_free_request((siri_api_request_t *) client);
+        /* fall through */
     case STREAM_PIPE_CLIENT:
     case STREAM_TCP_CLIENT:  /* listens to client connections  */
         log_debug("Client connection lost");
@@ -269,8 +270,7 @@ void sirinet__stream_free(uv_stream_t * uvclient)
     case STREAM_TCP_SERVER:  /* a server connection  */
         {
             siridb_server_t * server = client->origin;
-            server->client = NULL;
-            server->flags = 0;
+            siridb_server_stream_closed(server, client);
             siridb_server_decref(server);
         }
         break;
@@ -0,0 +1,238 @@
+/*
+ * twheel.c - Hierarchical timer wheel for promise time-outs.
+ */
+#include <assert.h>
+#include <siri/net/twheel.h>
+#include <stdlib.h>
+
+#define TWHEEL_MASK (SIRINET_TWHEEL_SLOTS - 1)
+#define TWHEEL_MAX_TICKS \
+    (1ULL << (SIRINET_TWHEEL_BITS * SIRINET_TWHEEL_LEVELS))
+
+static inline uint64_t TWHEEL_now(sirinet_twheel_t * twheel);
+static void TWHEEL_place(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry);
+static inline void TWHEEL_unlink(sirinet_twheel_entry_t * entry);
+static void TWHEEL_cascade(sirinet_twheel_t * twheel, int level);
+static void TWHEEL_run(sirinet_twheel_t * twheel);
+static void TWHEEL_on_tick(uv_timer_t * timer);
+
+/*
+ * Returns a new timer wheel or NULL in case of an allocation error.
+ *
+ * The call-back is called for each entry which expires. At this point the
+ * entry is already removed from the wheel. The call-back is allowed to add
+ * and remove entries but should never destroy the wheel.
+ */
+sirinet_twheel_t * sirinet_twheel_new(uv_loop_t * loop, sirinet_twheel_cb cb)
+{
+    sirinet_twheel_t * twheel = calloc(1, sizeof(sirinet_twheel_t));
+    if (twheel == NULL)
+    {
+        return NULL;
+    }
+    twheel->loop = loop;
+    twheel->cb = cb;
+    twheel->start = uv_now(loop);
+    return twheel;
+}
+
+/*
+ * Destroy a timer wheel. All entries must be removed before calling this
+ * function.
+ */
+void sirinet_twheel_free(sirinet_twheel_t * twheel)
+{
+    assert (twheel->n == 0);
+
+    /* the timer might be closed already when the loop is stopped */
+    if (    twheel->timer != NULL &&
+            !uv_is_closing((uv_handle_t *) twheel->timer))
+    {
+        uv_timer_stop(twheel->timer);
+        uv_close((uv_handle_t *) twheel->timer, (uv_close_cb) free);
+    }
+    free(twheel);
+}
+
+/*
+ * Add an entry which expires after 'timeout' milliseconds. The timeout is
+ * rounded up to the next tick.
+ *
+ * Returns 0 if successful or -1 when the timer cannot be started.
+ */
+int sirinet_twheel_add(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry,
+        uint64_t timeout)
+{
+    uint64_t now = TWHEEL_now(twheel);
+
+    assert (!sirinet_twheel_is_pending(entry));
+
+    if (twheel->timer == NULL)
+    {
+        twheel->timer = malloc(sizeof(uv_timer_t));
+        if (twheel->timer == NULL)
+        {
+            return -1;
+        }
+
+        uv_timer_init(twheel->loop, twheel->timer);
+        twheel->timer->data = twheel;
+        uv_timer_start(
+                twheel->timer,
+                TWHEEL_on_tick,
+                SIRINET_TWHEEL_TICK,
+                SIRINET_TWHEEL_TICK);
+
+        /* the wheel is empty so there are no ticks to catch up */
+        assert (twheel->n == 0);
+        twheel->tick = now;
+    }
+
+    entry->expire = now +
+            (timeout + SIRINET_TWHEEL_TICK - 1) / SIRINET_TWHEEL_TICK;
+
+    if (entry->expire <= twheel->tick)
+    {
+        entry->expire = twheel->tick + 1;
+    }
+    else if (entry->expire - twheel->tick >= TWHEEL_MAX_TICKS)
+    {
+        entry->expire = twheel->tick + TWHEEL_MAX_TICKS - 1;
+    }
+
+    TWHEEL_place(twheel, entry);
+    twheel->n++;
+
+    return 0;
+}
+
+/*
+ * Remove an entry from the wheel. (removing an entry which is not in the
+ * wheel is allowed)
+ */
+void sirinet_twheel_remove(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry)
+{
+    if (sirinet_twheel_is_pending(entry))
+    {
+        TWHEEL_unlink(entry);
+        twheel->n--;
+    }
+}
+
+static inline uint64_t TWHEEL_now(sirinet_twheel_t * twheel)
+{
+    return (uv_now(twheel->loop) - twheel->start) / SIRINET_TWHEEL_TICK;
+}
+
+/*
+ * Add an entry to the lowest level which can hold the expiration tick.
+ */
+static void TWHEEL_place(
+        sirinet_twheel_t * twheel,
+        sirinet_twheel_entry_t * entry)
+{
+    uint64_t delta = entry->expire - twheel->tick;
+    sirinet_twheel_entry_t ** head;
+    int level = 0;
+
+    while (level < SIRINET_TWHEEL_LEVELS - 1 &&
+           delta >= 1ULL << (SIRINET_TWHEEL_BITS * (level + 1)))
+    {
+        level++;
+    }
+
+    head = &twheel->slots[level][
+        (entry->expire >> (SIRINET_TWHEEL_BITS * level)) & TWHEEL_MASK];
+
+    entry->next = *head;
+    if (entry->next != NULL)
+    {
+        entry->next->pprev = &entry->next;
+    }
+    entry->pprev = head;
+    *head = entry;
+}
+
+static inline void TWHEEL_unlink(sirinet_twheel_entry_t * entry)
+{
+    *entry->pprev = entry->next;
+    if (entry->next != NULL)
+    {
+        entry->next->pprev = entry->pprev;
+    }
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+/*
+ * Move the entries from the current slot on the given level to a lower
+ * level.
+ */
+static void TWHEEL_cascade(sirinet_twheel_t * twheel, int level)
+{
+    sirinet_twheel_entry_t ** head = &twheel->slots[level][
+        (twheel->tick >> (SIRINET_TWHEEL_BITS * level)) & TWHEEL_MASK];
+    sirinet_twheel_entry_t * entry;
+
+    while ((entry = *head) != NULL)
+    {
+        TWHEEL_unlink(entry);
+        TWHEEL_place(twheel, entry);
+    }
+}
+
+/*
+ * Expire all entries for the current tick.
+ */
+static void TWHEEL_run(sirinet_twheel_t * twheel)
+{
+    sirinet_twheel_entry_t ** head =
+            &twheel->slots[0][twheel->tick & TWHEEL_MASK];
+    sirinet_twheel_entry_t * entry;
+    int level;
+
+    for (level = 1; level < SIRINET_TWHEEL_LEVELS; level++)
+    {
+        if ((twheel->tick >> (SIRINET_TWHEEL_BITS * (level - 1))) &
+                TWHEEL_MASK)
+        {
+            break;
+        }
+        TWHEEL_cascade(twheel, level);
+    }
+
+    /* call-backs might add or remove other entries */
+    while ((entry = *head) != NULL)
+    {
+        assert (entry->expire == twheel->tick);
+        TWHEEL_unlink(entry);
+        twheel->n--;
+        twheel->cb(entry);
+    }
+}
+
+static void TWHEEL_on_tick(uv_timer_t * timer)
+{
+    sirinet_twheel_t * twheel = timer->data;
+    uint64_t now = TWHEEL_now(twheel);
+
+    while (twheel->tick < now)
+    {
+        twheel->tick++;
+        TWHEEL_run(twheel);
+    }
+
+    if (twheel->n == 0)
+    {
+        /* no need to keep the loop busy while the wheel is empty */
+        uv_timer_stop(timer);
+        uv_close((uv_handle_t *) timer, (uv_close_cb) free);
+        twheel->timer = NULL;
+    }
+}
@@ -13,6 +13,7 @@
 #include <logger/logger.h>
 #include <siri/db/shard.h>
 #include <siri/db/shards.h>
+#include <siri/metrics.h>
 #include <siri/optimize.h>
 #include <siri/siri.h>
 #include <vec/vec.h>
@@ -264,6 +265,7 @@ static void OPTIMIZE_work(uv_work_t * work  __attribute__((unused)))
     uint8_t c = siri.cfg->shard_compression;
     size_t i;
     uint64_t expi[2];
+    uint64_t start = siri_metrics_now();
 
     log_info("Start optimize task");
 
@@ -387,6 +389,7 @@ static void OPTIMIZE_work(uv_work_t * work  __attribute__((unused)))
         }
         log_debug("Finished optimizing database '%s'", siridb->dbname);
     }
+    siri_metrics_since(SIRI_METRICS_OPTIMIZE, start);
     OPTIMIZE_cleanup(slsiridb);
 }
 
@@ -632,7 +632,9 @@ static void CLIENT_on_file_database(
         qp_exp_log,
         qp_exp_num,
         qp_tee_address,
-        qp_tee_port;
+        qp_tee_port,
+        qp_codec,
+        qp_placement;
     siridb_t * siridb;
     int rc;
     /* 13 = strlen("database.dat")+1  */
@@ -708,6 +710,32 @@ static void CLIENT_on_file_database(
         qp_tee_port.via.int64 = SIRIDB_TEE_DEFAULT_TCP_PORT;
     }
 
+    if (qp_schema.via.int64 >= 8)
+    {
+        if (qp_next(&unpacker, &qp_codec) != QP_INT64)
+        {
+            CLIENT_err(adm_client, "invalid database file received");
+            return;
+        }
+    }
+    else
+    {
+        qp_codec.via.int64 = SIRIDB_CODEC_DEFAULT;
+    }
+
+    if (qp_schema.via.int64 >= 9)
+    {
+        if (qp_next(&unpacker, &qp_placement) != QP_INT64)
+        {
+            CLIENT_err(adm_client, "invalid database file received");
+            return;
+        }
+    }
+    else
+    {
+        qp_placement.via.int64 = SIRIDB_PLACEMENT_SUM;
+    }
+
     if ((fpacker = qp_open(fn, "w")) == NULL)
     {
         CLIENT_err(adm_client, "cannot write or create file: %s", fn);
@@ -735,6 +763,8 @@ static void CLIENT_on_file_database(
                             qp_tee_address.len)
                     : qp_fadd_type(fpacker, QP_NULL)) ||
             qp_fadd_int64(fpacker, qp_tee_port.via.int64) ||
+            qp_fadd_int64(fpacker, qp_codec.via.int64) ||
+            qp_fadd_int64(fpacker, qp_placement.via.int64) ||
             qp_fadd_type(fpacker, QP_ARRAY_CLOSE) ||
             qp_close(fpacker));
 
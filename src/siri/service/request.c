@@ -553,10 +553,11 @@ static cproto_server_t SERVICE_on_new_database(
         qp_time_precision,
         qp_buffer_size,
         qp_duration_num,
-        qp_duration_log;
+        qp_duration_log,
+        qp_placement;
     size_t dbpath_len;
     int pcre_exec_ret;
-    int rc;
+    int rc, placement;
     struct stat st;
     int8_t time_precision;
     int64_t buffer_size, duration_num, duration_log;
@@ -578,6 +579,7 @@ static cproto_server_t SERVICE_on_new_database(
     qp_buffer_size.tp = QP_HOOK;
     qp_duration_num.tp = QP_HOOK;
     qp_duration_log.tp = QP_HOOK;
+    qp_placement.tp = QP_HOOK;
 
     if (!qp_is_map(qp_next(qp_unpacker, NULL)))
     {
@@ -626,6 +628,14 @@ static cproto_server_t SERVICE_on_new_database(
         {
             continue;
         }
+        if (    strncmp(
+                    (const char *) qp_key.via.raw,
+                    "placement",
+                    qp_key.len) == 0 &&
+                qp_next(qp_unpacker, &qp_placement) == QP_RAW)
+        {
+            continue;
+        }
         return CPROTO_ERR_SERVICE_INVALID_REQUEST;
     }
 
@@ -679,6 +689,22 @@ static cproto_server_t SERVICE_on_new_database(
         return CPROTO_ERR_SERVICE;
     }
 
+    placement = (qp_placement.tp == QP_HOOK) ?
+            SIRIDB_PLACEMENT_SUM : siridb_placement_by_name(
+                    (const char *) qp_placement.via.raw,
+                    qp_placement.len);
+
+    if (placement == -1)
+    {
+        snprintf(
+                err_msg,
+                SIRI_MAX_SIZE_ERR_MSG,
+                "invalid placement: '%.*s' (expecting sum or xxhash)",
+                (int) qp_placement.len,
+                qp_placement.via.raw);
+        return CPROTO_ERR_SERVICE;
+    }
+
     buffer_size = (qp_buffer_size.tp == QP_HOOK) ?
             DEFAULT_BUFFER_SIZE : qp_buffer_size.via.int64;
 
@@ -725,6 +751,8 @@ static cproto_server_t SERVICE_on_new_database(
         qp_fadd_int64(fp, 0) ||
         qp_fadd_type(fp, QP_NULL) ||
         qp_fadd_int64(fp, SIRIDB_TEE_DEFAULT_TCP_PORT) ||
+        qp_fadd_int64(fp, SIRIDB_CODEC_DEFAULT) ||
+        qp_fadd_int64(fp, placement) ||
         qp_fadd_type(fp, QP_ARRAY_CLOSE))
     {
         rc = -1;
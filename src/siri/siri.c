@@ -38,6 +38,7 @@
 #include <siri/net/bserver.h>
 #include <siri/net/clserver.h>
 #include <siri/net/pipe.h>
+#include <siri/net/promise.h>
 #include <siri/net/stream.h>
 #include <siri/service/account.h>
 #include <siri/service/request.h>
@@ -85,6 +86,7 @@ siri_t siri = {
         .fh=NULL,
         .optimize=NULL,
         .heartbeat=NULL,
+        .expire=NULL,
         .buffersync=NULL,
         .cfg=NULL,
         .args=NULL,
@@ -320,6 +322,9 @@ int siri_start(void)
     /* initialize heart-beat task (bind siri.heartbeat) */
     siri_heartbeat_init(&siri);
 
+    /* initialize shard expiration task (bind siri.expire) */
+    siri_expire_init(&siri);
+
     /* initialize buffer-sync task (bind siri.buffersync) */
     siri_buffersync_init(&siri);
 
@@ -379,6 +384,9 @@ void siri_free(void)
     /* free the file handler */
     siri_fh_free(siri.fh);
 
+    /* free the promise slabs */
+    sirinet_promise_slab_destroy();
+
     /* free event loop */
     free(siri.loop);
 }
@@ -580,6 +588,9 @@ static void SIRI_signal_handler(
         /* stop heart-beat task */
         siri_heartbeat_stop(&siri);
 
+        /* stop shard expiration task */
+        siri_expire_stop(&siri);
+
         /* stop buffer-sync task */
         siri_buffersync_stop(&siri);
 
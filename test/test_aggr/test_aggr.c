@@ -2,6 +2,7 @@
 #include "../test.h"
 #include <siri/db/points.h>
 #include <siri/db/aggregate.h>
+#include <siri/db/partial.h>
 
 
 #define SIRIDB_MAX_SIZE_ERR_MSG 1024
@@ -238,6 +239,84 @@ static int test_median_low(void)
     return test_end();
 }
 
+static int test_percentile(void)
+{
+    test_start("aggr (percentile)");
+
+    siridb_points_t * aggrp, * points = prepare_points();
+
+    aggr.gid = CLERI_GID_F_PERCENTILE;
+    aggr.group_by = 7;
+    aggr.limit = 0;
+    aggr.offset = 0;
+    aggr.percentile = 50.0;
+
+    aggrp = siridb_aggregate_run(points, &aggr, err_msg);
+
+    /* small groups are exact and equal to median() */
+    _assert (aggrp != NULL);
+    _assert (aggrp->len == 4);
+    _assert (aggrp->tp == TP_DOUBLE);
+    _assert (aggrp->data->ts == 7 && aggrp->data->val.real == 1.0);
+    _assert ((aggrp->data + 1)->ts == 14 &&
+            (aggrp->data + 1)->val.real == 3.5);
+
+    siridb_points_free(aggrp);
+
+    aggr.group_by = 0;
+    aggr.percentile = 90.0;
+
+    aggrp = siridb_aggregate_run(points, &aggr, err_msg);
+
+    _assert (aggrp != NULL);
+    _assert (aggrp->len == 1);
+    _assert (aggrp->data->ts == 27 &&
+            fabs(aggrp->data->val.real - 6.2) < 1e-9);
+
+    siridb_points_free(aggrp);
+    siridb_points_free(points);
+
+    return test_end();
+}
+
+static int test_distinct(void)
+{
+    test_start("aggr (distinct)");
+
+    siridb_points_t * aggrp, * points = prepare_points();
+
+    aggr.gid = CLERI_GID_F_DISTINCT;
+    aggr.group_by = 7;
+    aggr.limit = 0;
+    aggr.offset = 0;
+
+    aggrp = siridb_aggregate_run(points, &aggr, err_msg);
+
+    _assert (aggrp != NULL);
+    _assert (aggrp->len == 4);
+    _assert (aggrp->tp == TP_INT);
+    _assert (aggrp->data->ts == 7 && aggrp->data->val.int64 == 3);
+    _assert ((aggrp->data + 1)->ts == 14 &&
+            (aggrp->data + 1)->val.int64 == 4);
+    _assert ((aggrp->data + 3)->ts == 28 &&
+            (aggrp->data + 3)->val.int64 == 2);
+
+    siridb_points_free(aggrp);
+
+    aggr.group_by = 0;
+
+    aggrp = siridb_aggregate_run(points, &aggr, err_msg);
+
+    _assert (aggrp != NULL);
+    _assert (aggrp->len == 1);
+    _assert (aggrp->data->val.int64 == 8);
+
+    siridb_points_free(aggrp);
+    siridb_points_free(points);
+
+    return test_end();
+}
+
 static int test_min(void)
 {
     test_start("aggr (min)");
@@ -368,6 +447,199 @@ static int test_variance(void)
     return test_end();
 }
 
+static siridb_points_t * prepare_series(size_t n, uint64_t step, points_tp tp)
+{
+    siridb_points_t * points = siridb_points_new(n, tp);
+    uint64_t ts;
+    qp_via_t val;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        ts = 2 + i * step;
+        if (tp == TP_INT)
+        {
+            val.int64 = (int64_t) ((i * 7 + step) % 13) - 4;
+        }
+        else
+        {
+            val.real = ((i * 7 + step) % 13) * 0.1 - 1.0;
+        }
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static int test_partial_gid(uint32_t gid, uint64_t group_by, int with_double)
+{
+    siridb_points_t * series[3];
+    siridb_points_t * merged, * expect, * result;
+    siridb_partial_t * partial;
+    vec_t * plist, * left, * right, * partials;
+    qp_packer_t * packer;
+    qp_unpacker_t unpacker;
+    qp_obj_t qp_tp, qp_len, qp_raw;
+    size_t i;
+
+    aggr.gid = gid;
+    aggr.group_by = group_by;
+    aggr.limit = 0;
+    aggr.offset = 0;
+
+    series[0] = prepare_series(40, 3, TP_INT);
+    series[1] = prepare_series(25, 5, TP_INT);
+    series[2] = prepare_series(30, 4, with_double ? TP_DOUBLE : TP_INT);
+
+    /* expected result using all raw points */
+    plist = vec_new(3);
+    for (i = 0; i < 3; i++)
+    {
+        vec_append(plist, siridb_points_copy(series[i]));
+    }
+    merged = siridb_points_merge(plist, err_msg);
+    expect = siridb_aggregate_run(merged, &aggr, err_msg);
+
+    /* one "pool" sends partial states, the other sends raw points */
+    left = vec_new(2);
+    vec_append(left, series[0]);
+    vec_append(left, series[2]);
+    right = vec_new(1);
+    vec_append(right, series[1]);
+
+    /* a sum on float series is not reduced, the master uses the raw points */
+    _assert (siridb_partial_is_exact(left, &aggr) ==
+            !(with_double && gid == CLERI_GID_F_SUM));
+    if (with_double && gid == CLERI_GID_F_SUM)
+    {
+        /* integer sums from another pool cannot be combined with floats */
+        partials = vec_new(1);
+        vec_append(partials, siridb_partial_merge(
+                right,
+                NULL,
+                &aggr,
+                err_msg));
+        _assert (siridb_partial_merge(left, partials, &aggr, err_msg) == NULL);
+        siridb_partial_list_free(partials);
+        goto done;
+    }
+
+    partial = siridb_partial_merge(left, NULL, &aggr, err_msg);
+    _assert (partial != NULL);
+
+    packer = qp_packer_new(1024);
+    _assert (siridb_partial_raw_pack(partial, packer) == 0);
+    siridb_partial_free(partial);
+
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+    _assert (qp_is_array(qp_next(&unpacker, NULL)));
+    _assert (qp_is_int(qp_next(&unpacker, &qp_tp)));
+    _assert (qp_is_int(qp_next(&unpacker, &qp_len)));
+    _assert (qp_is_raw(qp_next(&unpacker, &qp_raw)));
+    _assert (qp_tp.via.int64 >= SIRIDB_PARTIAL_TP);
+
+    partials = vec_new(1);
+    vec_append(partials, siridb_partial_raw_unpack(
+            qp_tp.via.int64 - SIRIDB_PARTIAL_TP,
+            qp_len.via.int64,
+            &qp_raw,
+            &aggr));
+
+    partial = siridb_partial_merge(right, partials, &aggr, err_msg);
+    _assert (partial != NULL);
+    _assert (partials->len == 0);
+
+    result = siridb_partial_finalize(partial, &aggr, err_msg);
+
+    _assert (expect != NULL && result != NULL);
+    _assert (result->tp == expect->tp);
+    _assert (result->len == expect->len);
+
+    for (i = 0; i < result->len; i++)
+    {
+        _assert (result->data[i].ts == expect->data[i].ts);
+        if (result->tp == TP_INT)
+        {
+            _assert (result->data[i].val.int64 == expect->data[i].val.int64);
+        }
+        else if (gid == CLERI_GID_F_PERCENTILE)
+        {
+            /* merged t-digest centroids may differ in rounding */
+            _assert (fabs(
+                    result->data[i].val.real -
+                    expect->data[i].val.real) < 1e-9);
+        }
+        else
+        {
+            _assert (result->data[i].val.real == expect->data[i].val.real);
+        }
+    }
+
+    siridb_partial_free(partial);
+    siridb_points_free(result);
+    qp_packer_free(packer);
+    siridb_partial_list_free(partials);
+
+done:
+    siridb_points_free(expect);
+    siridb_points_free(merged);
+    free(left);
+    free(right);
+    free(plist);
+    for (i = 0; i < 3; i++)
+    {
+        siridb_points_free(series[i]);
+    }
+
+    return status;
+}
+
+static int test_partial(void)
+{
+    test_start("aggr (partial)");
+
+    uint32_t gids[6] = {
+        CLERI_GID_F_COUNT,
+        CLERI_GID_F_DISTINCT,
+        CLERI_GID_F_MAX,
+        CLERI_GID_F_MIN,
+        CLERI_GID_F_PERCENTILE,
+        CLERI_GID_F_SUM,
+    };
+    uint32_t raw_gids[5] = {
+        CLERI_GID_F_MEAN,
+        CLERI_GID_F_MEDIAN,
+        CLERI_GID_F_PVARIANCE,
+        CLERI_GID_F_STDDEV,
+        CLERI_GID_F_VARIANCE,
+    };
+    size_t i;
+
+    siridb_init_aggregates();
+    aggr.percentile = 90.0;
+
+    for (i = 0; i < 6; i++)
+    {
+        /* group by, without group by and with int to double promotion */
+        test_partial_gid(gids[i], 10, 0);
+        test_partial_gid(gids[i], 0, 0);
+        test_partial_gid(gids[i], 7, 1);
+    }
+
+    /* these need all points or depend on the order of the values */
+    for (i = 0; i < 5; i++)
+    {
+        aggr.gid = raw_gids[i];
+        _assert (!siridb_partial_is_supported(&aggr));
+    }
+
+    aggr.gid = CLERI_GID_F_SUM;
+    aggr.limit = 5;
+    _assert (!siridb_partial_is_supported(&aggr));
+
+    return test_end();
+}
+
 int main()
 {
     return (
@@ -379,11 +651,14 @@ int main()
         test_median() ||
         test_median_high() ||
         test_median_low() ||
+        test_percentile() ||
+        test_distinct() ||
         test_min() ||
         test_pvariance() ||
         test_stddev() ||
         test_sum() ||
         test_variance() ||
+        test_partial() ||
         0
     );
 }
@@ -0,0 +1,84 @@
+#include "../test.h"
+#include <heap/heap.h>
+
+#define NKEYS 1000
+
+int main()
+{
+    test_start("heap");
+
+    /* empty heap */
+    {
+        heap_t * heap = heap_new(0);
+        _assert (heap->len == 0);
+        _assert (heap_peek(heap) == NULL);
+        _assert (heap_pop(heap) == NULL);
+        heap_free(heap);
+    }
+
+    /* keys are returned in order */
+    {
+        heap_t * heap = heap_new(0);
+        uint64_t keys[NKEYS];
+        uint64_t prev = 0;
+        unsigned int seed = 42;
+        size_t i;
+
+        for (i = 0; i < NKEYS; i++)
+        {
+            /* include duplicate keys */
+            keys[i] = rand_r(&seed) % (NKEYS / 2);
+            _assert (heap_push(&heap, keys[i], &keys[i]) == 0);
+        }
+        _assert (heap->len == NKEYS);
+        _assert (heap->size >= NKEYS);
+
+        for (i = 0; i < NKEYS; i++)
+        {
+            heap_node_t * node = heap_peek(heap);
+            uint64_t * data;
+
+            _assert (node != NULL);
+            _assert (node->key >= prev);
+            _assert (*(uint64_t *) node->data == node->key);
+            prev = node->key;
+
+            data = heap_pop(heap);
+            _assert (*data == prev);
+        }
+        _assert (heap->len == 0);
+        _assert (heap_pop(heap) == NULL);
+        heap_free(heap);
+    }
+
+    /* push and pop mixed */
+    {
+        heap_t * heap = heap_new(HEAP_DEFAULT_SIZE);
+        char * a = "a", * b = "b", * c = "c", * d = "d";
+
+        _assert (heap_push(&heap, 30, c) == 0);
+        _assert (heap_push(&heap, 10, a) == 0);
+        _assert (heap_push(&heap, 20, b) == 0);
+        _assert (heap_pop(heap) == a);
+        _assert (heap_push(&heap, 5, d) == 0);
+        _assert (heap_peek(heap)->key == 5);
+        _assert (heap_pop(heap) == d);
+        _assert (heap_pop(heap) == b);
+        _assert (heap_pop(heap) == c);
+        heap_free(heap);
+    }
+
+    /* destroy calls the call-back for each node */
+    {
+        heap_t * heap = heap_new(0);
+        size_t i;
+
+        for (i = 0; i < 20; i++)
+        {
+            _assert (heap_push(&heap, i, malloc(8)) == 0);
+        }
+        heap_destroy(heap, free);
+    }
+
+    return test_end();
+}
@@ -0,0 +1,98 @@
+#include "../test.h"
+#include <logger/logger.h>
+#include <uv.h>
+
+
+#define NTHREADS 4
+#define NLINES 2000
+
+static size_t count_lines(FILE * fp, char level, size_t * longest)
+{
+    char buf[4096];
+    size_t n = 0, len;
+
+    rewind(fp);
+    *longest = 0;
+    while (fgets(buf, sizeof(buf), fp) != NULL)
+    {
+        if (buf[1] == level)
+        {
+            n++;
+            len = strlen(buf);
+            *longest = (len > *longest) ? len : *longest;
+        }
+    }
+    return n;
+}
+
+static void log_lines(void * arg)
+{
+    size_t i, n = *((size_t *) arg);
+    for (i = 0; i < n; i++)
+    {
+        log_info("line %zu from a worker thread", i);
+    }
+}
+
+static int test_logger(void)
+{
+    test_start("logger");
+
+    FILE * fp = tmpfile();
+    uv_thread_t threads[NTHREADS];
+    size_t i, n = NLINES, longest;
+    char big[2000];
+    uint64_t dropped;
+
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    logger_init(fp, LOGGER_INFO);
+
+    /* before the writer is started lines are written directly */
+    log_info("%s", big);
+    _assert (count_lines(fp, 'I', &longest) == 1);
+    _assert (longest > sizeof(big));
+    fseek(fp, 0, SEEK_END);
+
+    _assert (logger_start() == 0);
+
+    /* long lines are truncated when written asynchronous */
+    log_warning("%s", big);
+
+    for (i = 0; i < NTHREADS; i++)
+    {
+        _assert (uv_thread_create(threads + i, log_lines, &n) == 0);
+    }
+    for (i = 0; i < NTHREADS; i++)
+    {
+        uv_thread_join(threads + i);
+    }
+
+    /* critical lines are written directly */
+    LOGC("critical");
+
+    logger_stop();
+    dropped = logger_dropped();
+
+    _assert (count_lines(fp, 'I', &longest) ==
+            1 + NTHREADS * NLINES - dropped);
+    _assert (count_lines(fp, 'W', &longest) >= (dropped ? 2 : 1));
+    _assert (longest < LOGGER_LINE_SZ + 32);
+    _assert (count_lines(fp, 'C', &longest) == 1);
+
+    /* after the writer is stopped lines are written directly again */
+    log_error("stopped");
+    _assert (count_lines(fp, 'E', &longest) == 1);
+
+    fclose(fp);
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_logger() ||
+        0
+    );
+}
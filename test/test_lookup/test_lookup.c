@@ -2,10 +2,12 @@
 #include "../test.h"
 #include <siri/db/lookup.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 
 /* to at least 42 pools we devide series within 20% off from ideal */
 #define NPOOLS 42
+#define NSERIES 20000
 
 static double percentage_unequal = 0.2;
 static unsigned int countersa[NPOOLS];
@@ -44,18 +46,18 @@ int main()
             lower = ideal - (percentage_unequal * ideal);
             upper = ideal + (percentage_unequal * ideal);
             init_counters();
-            lookup = siridb_lookup_new(num_pools);
+            lookup = siridb_lookup_new(num_pools, SIRIDB_PLACEMENT_SUM);
             _assert (lookup);
             for (n = 0; n < SIRIDB_LOOKUP_SZ; ++n)
             {
                 /* check for SIRIDB_SERIES_IS_SERVER_ONE flag */
                 if ((bool) ((n / 11) % 2))
                 {
-                    countersa[(*lookup)[n]]++;
+                    countersa[lookup->pools[n]]++;
                 }
                 else
                 {
-                    countersb[(*lookup)[n]]++;
+                    countersb[lookup->pools[n]]++;
                 }
             }
             for (p = 0; p < num_pools; ++p)
@@ -67,14 +69,84 @@ int main()
         }
     }
 
-    lookup = siridb_lookup_new(4);
+    lookup = siridb_lookup_new(4, SIRIDB_PLACEMENT_SUM);
     _assert (lookup);
 
     for (i = 0; i < 30; i++)
     {
-        _assert( match[i] == (*lookup)[i] );
+        _assert( match[i] == lookup->pools[i] );
     }
 
     free(lookup);
+
+    /* xxhash placement must return the reference XXH64 values */
+    _assert (siridb_lookup_xxhash("", 0) == 0xEF46DB3751D8E999ULL);
+    _assert (siridb_lookup_xxhash("abc", 3) == 0x44BC2CF5AD770999ULL);
+    _assert (siridb_lookup_xxhash(
+            "Nobody inspects the spammish repetition", 39) ==
+            0xFBCEA83C8A378BF1ULL);
+
+    /* similar series names must spread over the pools */
+    {
+        char name[32];
+        unsigned int p, ideal, lower, upper;
+        ideal = NSERIES / 4;
+        lower = ideal - (percentage_unequal * ideal);
+        upper = ideal + (percentage_unequal * ideal);
+        init_counters();
+        lookup = siridb_lookup_new(4, SIRIDB_PLACEMENT_XXHASH);
+        _assert (lookup);
+        for (i = 0; i < NSERIES; i++)
+        {
+            sprintf(name, "host%05u.cpu", i);
+            countersa[siridb_lookup_sn(lookup, name)]++;
+        }
+        for (p = 0; p < 4; ++p)
+        {
+            _assert (countersa[p] >= lower && countersa[p] <= upper);
+        }
+        free(lookup);
+    }
+
+    /* adding a pool moves series only to the new pool */
+    {
+        static uint32_t slots[SIRIDB_LOOKUP_SZ];
+        char name[32];
+        unsigned int moved = 0;
+        size_t n;
+        uint16_t pool;
+        siridb_lookup_t * prev = siridb_lookup_new(4, SIRIDB_PLACEMENT_XXHASH);
+        lookup = siridb_lookup_new(5, SIRIDB_PLACEMENT_XXHASH);
+        _assert (prev && lookup);
+        for (i = 0; i < NSERIES; i++)
+        {
+            size_t len = sprintf(name, "host%05u.cpu", i);
+            pool = siridb_lookup_sn_raw(lookup, name, len);
+            _assert (pool == siridb_lookup_sn(lookup, name));
+            slots[siridb_lookup_slot(SIRIDB_PLACEMENT_XXHASH, name, len)]++;
+            if (pool != siridb_lookup_sn_raw(prev, name, len))
+            {
+                _assert (pool == 4);
+                moved++;
+            }
+        }
+        _assert (moved > NSERIES / 5 * (1.0 - percentage_unequal));
+        _assert (moved < NSERIES / 5 * (1.0 + percentage_unequal));
+        for (i = 0, n = 0; i < 5; i++)
+        {
+            n += siridb_lookup_slots(lookup, i);
+        }
+        _assert (n == SIRIDB_LOOKUP_SZ);
+
+        /* moved series can be counted using the series for each slot */
+        for (i = 0, n = 0; i < SIRIDB_LOOKUP_SZ; i++)
+        {
+            n += (lookup->pools[i] == 4) ? slots[i] : 0;
+        }
+        _assert (n == moved);
+        free(prev);
+        free(lookup);
+    }
+
     return test_end();
 }
@@ -0,0 +1,142 @@
+#include "../test.h"
+#include <lproto/lproto.h>
+
+static int test_parse(void)
+{
+    test_start("lproto (parse)");
+
+    lproto_t lp;
+    lproto_field_t field;
+    char data[] =
+        "# comment\n"
+        "cpu,host=a\\ b usage=0.5,count=3i,ok=t,msg=\"x \\\"y\\\"\" 1700000000\r\n"
+        "\n"
+        "mem free=12u\n"
+        "disk,dev=sda used=-1.5e3";
+
+    lproto_init(&lp, data, sizeof(data) - 1);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 12 && memcmp(lp.key, "cpu,host=a b", 12) == 0);
+    _assert (lp.has_ts && lp.ts == 1700000000);
+
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.name_n == 5 && memcmp(field.name, "usage", 5) == 0);
+    _assert (field.tp == LPROTO_DOUBLE && field.via.real == 0.5);
+
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.tp == LPROTO_INT64 && field.via.int64 == 3);
+
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.tp == LPROTO_INT64 && field.via.int64 == 1);
+
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.tp == LPROTO_STRING && field.len == 5);
+    _assert (memcmp(field.via.str, "x \"y\"", 5) == 0);
+
+    _assert (lproto_next_field(&lp, &field) == LPROTO_END);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 3 && !lp.has_ts);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.tp == LPROTO_INT64 && field.via.int64 == 12);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_END);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.tp == LPROTO_DOUBLE && field.via.real == -1500.0);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_END);
+
+    _assert (lproto_next_line(&lp) == LPROTO_END);
+
+    return test_end();
+}
+
+static int test_keys(void)
+{
+    test_start("lproto (keys)");
+
+    lproto_t lp;
+    lproto_field_t field;
+    char data[] =
+        "cpu,b=2,a=1 f=1\n"
+        "cpu,a=1,b=2 f=1\n"
+        "cpu,ab=1,a\\=b=x\\,y,a=0 f\\ 1=1\n"
+        "c\\,pu f=1\n";
+
+    lproto_init(&lp, data, sizeof(data) - 1);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 11 && memcmp(lp.key, "cpu,a=1,b=2", 11) == 0);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 11 && memcmp(lp.key, "cpu,a=1,b=2", 11) == 0);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 20);
+    _assert (memcmp(lp.key, "cpu,a=0,a=b=x,y,ab=1", 20) == 0);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_OK);
+    _assert (field.name_n == 3 && memcmp(field.name, "f 1", 3) == 0);
+
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lp.key_n == 4 && memcmp(lp.key, "c,pu", 4) == 0);
+
+    _assert (lproto_next_line(&lp) == LPROTO_END);
+
+    return test_end();
+}
+
+static int test_errors(void)
+{
+    test_start("lproto (errors)");
+
+    lproto_t lp;
+    lproto_field_t field;
+    char missing_fields[] = "cpu\n";
+    char invalid_ts[] = "cpu v=1 12x\n";
+    char invalid_int[] = "cpu v=1.5i\n";
+    char trailing_comma[] = "cpu v=1,";
+    char open_string[] = "cpu v=\"abc 1\n";
+    char unsigned_neg[] = "cpu v=-1u";
+    char empty_tag[] = "cpu,,a=1 v=1";
+    char tag_no_value[] = "cpu,a v=1";
+
+    lproto_init(&lp, missing_fields, sizeof(missing_fields) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_ERR);
+
+    lproto_init(&lp, invalid_ts, sizeof(invalid_ts) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_ERR);
+
+    lproto_init(&lp, invalid_int, sizeof(invalid_int) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_ERR);
+
+    lproto_init(&lp, trailing_comma, sizeof(trailing_comma) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_ERR);
+
+    lproto_init(&lp, open_string, sizeof(open_string) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_ERR);
+
+    lproto_init(&lp, unsigned_neg, sizeof(unsigned_neg) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_OK);
+    _assert (lproto_next_field(&lp, &field) == LPROTO_ERR);
+
+    lproto_init(&lp, empty_tag, sizeof(empty_tag) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_ERR);
+
+    lproto_init(&lp, tag_no_value, sizeof(tag_no_value) - 1);
+    _assert (lproto_next_line(&lp) == LPROTO_ERR);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_parse() ||
+        test_keys() ||
+        test_errors() ||
+        0
+    );
+}
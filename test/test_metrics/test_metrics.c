@@ -0,0 +1,150 @@
+#include "../test.h"
+#include <siri/metrics.h>
+#include <uv.h>
+
+
+#define NTHREADS 4
+#define NINCR 100000
+
+static void incr_counter(void * arg __attribute__((unused)))
+{
+    size_t i;
+    for (i = 0; i < NINCR; i++)
+    {
+        siri_metrics_incr(SIRI_METRICS_FCACHE_HITS, 1);
+    }
+    siri_metrics_observe(SIRI_METRICS_OPTIMIZE, 1000);
+}
+
+static int test_counters(void)
+{
+    test_start("metrics (counters)");
+
+    uv_thread_t threads[NTHREADS];
+    siri_metrics_hist_t hist;
+    size_t i;
+
+    siri_metrics_incr(SIRI_METRICS_SHARD_READ_BYTES, 12);
+    siri_metrics_incr(SIRI_METRICS_SHARD_READ_BYTES, 30);
+    _assert (siri_metrics_counter(SIRI_METRICS_SHARD_READ_BYTES) == 42);
+
+    for (i = 0; i < NTHREADS; i++)
+    {
+        _assert (uv_thread_create(threads + i, incr_counter, NULL) == 0);
+    }
+    for (i = 0; i < NTHREADS; i++)
+    {
+        uv_thread_join(threads + i);
+    }
+
+    /* counters from threads which are finished are kept */
+    _assert (siri_metrics_counter(SIRI_METRICS_FCACHE_HITS) ==
+            NTHREADS * NINCR);
+    _assert (siri_metrics_counter(SIRI_METRICS_FCACHE_MISSES) == 0);
+
+    siri_metrics_hist(SIRI_METRICS_OPTIMIZE, &hist);
+    _assert (hist.count == NTHREADS);
+    _assert (hist.sum == NTHREADS * 1000);
+
+    return test_end();
+}
+
+static int test_histogram(void)
+{
+    test_start("metrics (histogram)");
+
+    siri_metrics_hist_t hist;
+    uint64_t v, p;
+    double expected[] = {50.0, 90.0, 99.0, 99.9};
+    size_t i;
+
+    siri_metrics_hist(SIRI_METRICS_INSERT, &hist);
+    _assert (hist.count == 0);
+    _assert (siri_metrics_percentile(&hist, 50.0) == 0);
+
+    for (v = 1; v <= 100000; v++)
+    {
+        siri_metrics_observe(SIRI_METRICS_INSERT, v);
+    }
+
+    /* a value larger than the histogram range goes to the last bucket */
+    siri_metrics_observe(SIRI_METRICS_SELECT_PACK, 1ULL << 50);
+    siri_metrics_hist(SIRI_METRICS_SELECT_PACK, &hist);
+    _assert (hist.buckets[SIRI_METRICS_HIST_SZ - 1] == 1);
+
+    siri_metrics_hist(SIRI_METRICS_INSERT, &hist);
+    _assert (hist.count == 100000);
+    _assert (hist.sum == 100000ULL * 100001 / 2);
+
+    /* small values are exact */
+    siri_metrics_observe(SIRI_METRICS_SELECT_LOOKUP, 3);
+    siri_metrics_hist(SIRI_METRICS_SELECT_LOOKUP, &hist);
+    _assert (siri_metrics_percentile(&hist, 50.0) == 3);
+
+    siri_metrics_hist(SIRI_METRICS_INSERT, &hist);
+    for (i = 0; i < sizeof(expected) / sizeof(double); i++)
+    {
+        p = siri_metrics_percentile(&hist, expected[i]);
+        v = (uint64_t) (expected[i] * 1000);
+        /* each bucket covers at most a quarter of its magnitude */
+        _assert (p > v - v / SIRI_METRICS_SUB && p < v + v / SIRI_METRICS_SUB);
+    }
+
+    return test_end();
+}
+
+static int test_write(void)
+{
+    test_start("metrics (prometheus)");
+
+    siri_metrics_buf_t buf = {0};
+    char * line;
+    uint64_t n, prev = 0;
+    size_t nbuckets = 0;
+
+    _assert (siri_metrics_write(&buf) == 0);
+    _assert (buf.len == strlen(buf.data));
+
+    _assert (strstr(buf.data,
+            "# TYPE siridb_shard_read_bytes_total counter\n"
+            "siridb_shard_read_bytes_total 42\n"));
+    _assert (strstr(buf.data,
+            "# TYPE siridb_select_duration_seconds histogram\n"));
+    _assert (strstr(buf.data,
+            "siridb_select_duration_seconds_count{stage=\"decompress\"} 0\n"));
+    _assert (strstr(buf.data, "siridb_log_dropped_lines_total 0\n"));
+
+    /* help and type are written once for each name */
+    line = strstr(buf.data, "# HELP siridb_select_duration_seconds");
+    _assert (line);
+    _assert (!strstr(line + 1, "# HELP siridb_select_duration_seconds"));
+
+    /* buckets are cumulative and end with the total count */
+    for (line = strstr(buf.data, "siridb_insert_duration_seconds_bucket");
+         line != NULL;
+         line = strstr(line + 1, "siridb_insert_duration_seconds_bucket"))
+    {
+        n = strtoull(strchr(line, '}') + 1, NULL, 10);
+        _assert (n >= prev);
+        prev = n;
+        nbuckets++;
+    }
+    _assert (nbuckets > 20);
+    _assert (prev == 100000);
+    _assert (strstr(buf.data, "le=\"0.001024\"} 1023\n"));
+    _assert (strstr(buf.data, "siridb_insert_duration_seconds_sum 5000.05\n"));
+
+    free(buf.data);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_counters() ||
+        test_histogram() ||
+        test_write() ||
+        0
+    );
+}
@@ -0,0 +1,120 @@
+#include "../test.h"
+#include <siri/db/aggregate.h>
+#include <siri/db/plan.h>
+#include <siri/grammar/grammar.h>
+
+
+static siridb_aggr_t * new_aggr(uint32_t gid, uint64_t group_by)
+{
+    siridb_aggr_t * aggr = calloc(1, sizeof(siridb_aggr_t));
+    aggr->gid = gid;
+    aggr->group_by = group_by;
+    aggr->timespan = 1.0;
+    aggr->filter_tp = TP_INT;
+    return aggr;
+}
+
+static int test_plan(void)
+{
+    test_start("plan");
+
+    siridb_presuf_t presuf = {
+        .prefix = "mean-",
+        .suffix = NULL,
+        .len = 6,
+        .prev = NULL
+    };
+    uint64_t start_ts = 1579521271;
+    siridb_plan_t * plan = siridb_plan_new();
+    siridb_plan_method_t * method;
+    siridb_aggr_t * aggr;
+    qp_packer_t * packer;
+    vec_t * alist = vec_new(2);
+    vec_t * mlist = vec_new(1);
+    size_t len;
+
+    _assert (plan != NULL);
+    _assert (siridb_plan_add_series(plan, "series-001") == 0);
+    _assert (siridb_plan_add_series(plan, "series-002") == 0);
+
+    /* mean(1h) => filter(> 0.5) */
+    vec_append(alist, new_aggr(CLERI_GID_F_MEAN, 3600));
+    aggr = new_aggr(CLERI_GID_F_FILTER, 0);
+    aggr->filter_opr = CEXPR_GT;
+    aggr->filter_tp = TP_DOUBLE;
+    aggr->filter_via.real = 0.5;
+    vec_append(alist, aggr);
+    _assert (siridb_plan_add_method(plan, &presuf, alist) == 0);
+
+    /* string filters cannot be packed */
+    len = plan->packer->len;
+    aggr = new_aggr(CLERI_GID_F_FILTER, 0);
+    aggr->filter_tp = TP_STRING;
+    aggr->filter_via.raw = (unsigned char *) strdup("error");
+    vec_append(mlist, aggr);
+    _assert (siridb_plan_add_method(plan, &presuf, mlist) == 1);
+    _assert (plan->packer->len == len && plan->n == 1);
+    _assert (siridb_plan_pack(
+            plan, 0, NULL, NULL, 0, "merged", mlist) == NULL);
+    siridb_aggregate_list_free(mlist);
+
+    mlist = vec_new(1);
+    vec_append(mlist, new_aggr(CLERI_GID_F_SUM, 0));
+    packer = siridb_plan_pack(
+            plan,
+            SIRIDB_PLAN_FLAG_SKIP_GET_POINTS,
+            &start_ts,
+            NULL,
+            -10,
+            "merged",
+            mlist);
+    _assert (packer != NULL);
+    siridb_plan_free(plan);
+
+    /* round trip */
+    plan = siridb_plan_unpack(packer->buffer, packer->len);
+    _assert (plan != NULL);
+    _assert (plan->flags & SIRIDB_PLAN_FLAG_SKIP_GET_POINTS);
+    _assert (plan->flags & SIRIDB_PLAN_FLAG_START_TS);
+    _assert (~plan->flags & SIRIDB_PLAN_FLAG_END_TS);
+    _assert (plan->start_ts == start_ts);
+    _assert (plan->headtail == -10);
+    _assert (strcmp(plan->merge_as, "merged") == 0);
+    _assert (plan->mlist->len == 1);
+    _assert (((siridb_aggr_t *) plan->mlist->data[0])->gid == CLERI_GID_F_SUM);
+    _assert (plan->series->len == 2);
+    _assert (strcmp(plan->series->data[1], "series-002") == 0);
+    _assert (plan->methods->len == 1);
+
+    method = plan->methods->data[0];
+    _assert (strcmp(method->prefix, "mean-") == 0);
+    _assert (method->suffix == NULL);
+    _assert (method->alist->len == 2);
+
+    aggr = method->alist->data[0];
+    _assert (aggr->gid == CLERI_GID_F_MEAN && aggr->group_by == 3600);
+    aggr = method->alist->data[1];
+    _assert (aggr->gid == CLERI_GID_F_FILTER);
+    _assert (aggr->filter_opr == CEXPR_GT && aggr->filter_tp == TP_DOUBLE);
+    _assert (aggr->filter_via.real == 0.5);
+    siridb_plan_free(plan);
+
+    /* truncated data or another version cannot be used */
+    _assert (siridb_plan_unpack(packer->buffer, packer->len - 2) == NULL);
+    packer->buffer[2] = '9';
+    _assert (siridb_plan_unpack(packer->buffer, packer->len) == NULL);
+
+    qp_packer_free(packer);
+    siridb_aggregate_list_free(mlist);
+    siridb_aggregate_list_free(alist);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_plan() ||
+        0
+    );
+}
@@ -0,0 +1,843 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "../test.h"
+#include <siri/db/db.h>
+#include <siri/db/points.h>
+
+#define BENCH_CHUNK 800
+#define BENCH_ROUNDS 2000
+#define ZIP_THREADS 4
+
+typedef unsigned char * (*zip_cb)(
+        siridb_points_t *,
+        uint_fast32_t,
+        uint_fast32_t,
+        uint16_t *,
+        size_t *);
+
+static siridb_points_t * prepare_doubles(size_t n)
+{
+    siridb_points_t * points = siridb_points_new(n, TP_DOUBLE);
+    uint64_t ts = 1579521271;
+    qp_via_t val;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        /* mostly regular time-stamps with a few jumps */
+        ts += (i % 17 == 0) ? 3600 + i : 300;
+        val.real = (i % 5 == 0) ? 0.5 : sin((double) i) * 100.0;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static siridb_points_t * prepare_counter(size_t n, unsigned int seed)
+{
+    siridb_points_t * points = siridb_points_new(n, TP_INT);
+    uint64_t ts = 1579521271000;
+    qp_via_t val;
+    size_t i;
+
+    srand(seed);
+    val.int64 = 1000000;
+
+    for (i = 0; i < n; i++)
+    {
+        /* ten second interval with some jitter and a counter reset */
+        ts += 10000 + rand() % 5;
+        val.int64 = (i == n / 2) ? 0 : val.int64 + rand() % 200;
+        siridb_points_add_point(points, &ts, &val);
+    }
+
+    return points;
+}
+
+static siridb_points_t * prepare_log(size_t n, unsigned int seed)
+{
+    siridb_points_t * points = siridb_points_new(n, TP_STRING);
+    const char * levels[] = {"info", "warning", "error"};
+    char buf[128];
+    uint64_t ts = 1579521271;
+    size_t i;
+
+    srand(seed);
+
+    for (i = 0; i < n; i++)
+    {
+        ts += 1 + rand() % 60;
+        snprintf(buf, sizeof(buf),
+                "[%s] connection from 10.0.0.%d closed after %d ms",
+                levels[rand() % 3], rand() % 255, rand() % 10000);
+        points->data[i].ts = ts;
+        points->data[i].val.str = strdup(buf);
+        points->len++;
+    }
+
+    return points;
+}
+
+/*
+ * Chunks written by the string encoder which used a process-wide hash table
+ * (before each call used its own table). The input is created by
+ * prepare_legacy_log() and the encoder found different matches, so these
+ * chunks are not always equal to the output of the current encoder.
+ */
+static const unsigned char LEGACY_ASCII[349] = {
+        0x11, 0xf4, 0x04, 0x00, 0x00, 0xf8, 0x94, 0x25, 0x5e, 0x00, 0x00, 0x00,
+        0x00, 0x08, 0x0f, 0x16, 0x1d, 0x24, 0x2b, 0x32, 0x39, 0x04, 0x0b, 0x12,
+        0x19, 0x20, 0x27, 0x2e, 0x35, 0x3c, 0x07, 0x0e, 0x15, 0x1c, 0x23, 0x2a,
+        0x5b, 0x77, 0x61, 0x72, 0x6e, 0x69, 0x6e, 0x67, 0x5d, 0x20, 0x63, 0x6f,
+        0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x66, 0x72, 0x6f,
+        0x6d, 0x20, 0x31, 0x30, 0x2e, 0x82, 0x85, 0x20, 0x63, 0x6c, 0x6f, 0x73,
+        0x65, 0x64, 0x20, 0x61, 0x66, 0x74, 0x65, 0x72, 0x20, 0x30, 0x20, 0x6d,
+        0x73, 0x00, 0x5b, 0x69, 0x6e, 0x66, 0x6f, 0xb2, 0x99, 0x31, 0xb2, 0x8e,
+        0x33, 0x37, 0x20, 0x6d, 0x73, 0x00, 0xb3, 0x9e, 0x32, 0xb3, 0x8e, 0x37,
+        0x34, 0x20, 0x6d, 0x73, 0x00, 0xdb, 0x02, 0xa1, 0x33, 0xb6, 0x8e, 0x31,
+        0x31, 0x31, 0x20, 0x6d, 0x73, 0x00, 0xea, 0x01, 0x9e, 0x34, 0xb4, 0x8f,
+        0x34, 0x38, 0x20, 0x6d, 0x73, 0x00, 0xb4, 0x9e, 0x30, 0xb4, 0x8f, 0x38,
+        0x35, 0x20, 0x6d, 0x73, 0x00, 0xdf, 0x02, 0xa1, 0xc8, 0x04, 0x8f, 0x32,
+        0x32, 0x32, 0x20, 0x6d, 0x73, 0x00, 0xeb, 0x01, 0x9e, 0xc9, 0x04, 0x8f,
+        0x32, 0x35, 0x39, 0x20, 0x6d, 0x73, 0x00, 0xb4, 0x9e, 0xc7, 0x04, 0x8f,
+        0x32, 0x39, 0x36, 0x20, 0x6d, 0x73, 0x00, 0xdf, 0x02, 0xa1, 0xca, 0x04,
+        0x8f, 0x33, 0x33, 0x33, 0x20, 0x6d, 0x73, 0x00, 0xeb, 0x01, 0x9e, 0xca,
+        0x04, 0x8f, 0x33, 0x37, 0xcf, 0x08, 0x85, 0xb4, 0x9e, 0xc7, 0x04, 0x8f,
+        0x34, 0x30, 0xd0, 0x08, 0x85, 0xdf, 0x02, 0xa1, 0xca, 0x04, 0x8f, 0x34,
+        0x34, 0xd4, 0x08, 0x85, 0xeb, 0x01, 0x9e, 0xca, 0x04, 0x8f, 0x34, 0x38,
+        0xd1, 0x08, 0x85, 0xb4, 0x9e, 0xc7, 0x04, 0x8f, 0x35, 0x31, 0xd1, 0x08,
+        0x85, 0xdf, 0x02, 0xa1, 0xca, 0x04, 0x8f, 0x35, 0x35, 0xd4, 0x08, 0x85,
+        0xeb, 0x01, 0x9e, 0xca, 0x04, 0x8f, 0x35, 0x39, 0xd1, 0x08, 0x85, 0xb4,
+        0x9e, 0xc7, 0x04, 0x8f, 0x36, 0x32, 0xd1, 0x08, 0x85, 0xdf, 0x02, 0xa1,
+        0xca, 0x04, 0x8f, 0x36, 0x36, 0xd4, 0x08, 0x85, 0xeb, 0x01, 0x9e, 0xca,
+        0x04, 0x8f, 0x37, 0x30, 0xd1, 0x08, 0x85, 0xb4, 0x9e, 0xc7, 0x04, 0x8f,
+        0x37, 0x34, 0xd1, 0x08, 0x85, 0xdf, 0x02, 0xa1, 0xca, 0x04, 0x8f, 0x37,
+        0x37, 0xd4, 0x08, 0x85, 0xeb, 0x01, 0x9e, 0xca, 0x04, 0x8f, 0x38, 0x31,
+        0xd1, 0x08, 0x85, 0xb4, 0x9e, 0xc7, 0x04, 0x8f, 0x38, 0x35, 0xd1, 0x08,
+        0x85,
+};
+static const unsigned char LEGACY_UTF8[210] = {
+        0x11, 0xe0, 0x01, 0x00, 0x00, 0xf8, 0x94, 0x25, 0x5e, 0x00, 0x00, 0x00,
+        0x00, 0x08, 0x0f, 0x16, 0x1d, 0x24, 0x2b, 0x32, 0x39, 0x04, 0x0b, 0x12,
+        0x19, 0x20, 0x27, 0x2e, 0x9e, 0x74, 0x65, 0x6d, 0x70, 0xc3, 0xa9, 0x72,
+        0x61, 0x74, 0x75, 0x72, 0x65, 0x20, 0x63, 0x61, 0x70, 0x74, 0x65, 0x75,
+        0x72, 0x20, 0x30, 0x3a, 0x20, 0x31, 0x35, 0xc2, 0xb0, 0x43, 0x00, 0x1e,
+        0x15, 0x89, 0x31, 0x3a, 0x20, 0x31, 0x36, 0xc2, 0xb0, 0x43, 0x00, 0x1e,
+        0x15, 0x89, 0x32, 0x3a, 0x20, 0x31, 0x37, 0xc2, 0xb0, 0x43, 0x00, 0x1e,
+        0x15, 0x89, 0x33, 0x3a, 0x20, 0x31, 0x38, 0xc2, 0xb0, 0x43, 0x00, 0x1e,
+        0x15, 0x78, 0x01, 0x04, 0x85, 0x39, 0xc2, 0xb0, 0x43, 0x00, 0x1e, 0x15,
+        0x89, 0x31, 0x3a, 0x20, 0x32, 0x30, 0xc2, 0xb0, 0x43, 0x00, 0x1e, 0x15,
+        0x89, 0x32, 0x3a, 0x20, 0x32, 0x31, 0xc2, 0xb0, 0x43, 0x00, 0x1e, 0x15,
+        0x89, 0x33, 0x3a, 0x20, 0x32, 0x32, 0xc2, 0xb0, 0x43, 0x00, 0x1e, 0x15,
+        0x89, 0x30, 0x3a, 0x20, 0x32, 0x33, 0xc2, 0xb0, 0x43, 0x00, 0x1e, 0x15,
+        0x70, 0x03, 0x04, 0x4e, 0x04, 0x05, 0x1e, 0x15, 0x70, 0x03, 0x04, 0x4e,
+        0x04, 0x05, 0x1e, 0x15, 0x70, 0x03, 0x04, 0x4e, 0x04, 0x05, 0x1e, 0x15,
+        0x70, 0x03, 0x04, 0x4e, 0x04, 0x05, 0x1e, 0x15, 0x78, 0x01, 0x04, 0x4e,
+        0x04, 0x05, 0x1e, 0x15, 0x70, 0x03, 0x04, 0x4e, 0x04, 0x05, 0x1e, 0x15,
+        0x70, 0x03, 0x04, 0x4e, 0x04, 0x05,
+};
+
+static siridb_points_t * prepare_legacy_log(size_t n, int utf8)
+{
+    siridb_points_t * points = siridb_points_new(n, TP_STRING);
+    char buf[128];
+    uint64_t ts = 1579521271;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        ts += 1 + (i * 7) % 60;
+        if (utf8)
+        {
+            snprintf(buf, sizeof(buf),
+                    "temp\xc3\xa9rature capteur %zu: %zu\xc2\xb0" "C",
+                    i % 4, 15 + i % 9);
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf),
+                    "[%s] connection from 10.0.0.%zu closed after %zu ms",
+                    (i % 3) ? "info" : "warning", i % 5, (i * 37) % 1000);
+        }
+        points->data[i].ts = ts;
+        points->data[i].val.str = strdup(buf);
+        points->len++;
+    }
+
+    return points;
+}
+
+typedef struct
+{
+    siridb_points_t * points;
+    unsigned char * bits;
+    size_t size;
+} zip_job_t;
+
+static void * zip_string_work(void * arg)
+{
+    zip_job_t * job = arg;
+    uint16_t cinfo;
+    int i;
+
+    /* compress a couple of times so threads overlap */
+    for (i = 0; i < 50; i++)
+    {
+        free(job->bits);
+        job->bits = siridb_points_zip_string(
+                job->points, 0, job->points->len, &cinfo, &job->size);
+    }
+    return NULL;
+}
+
+static int points_equal(siridb_points_t * a, siridb_points_t * b)
+{
+    size_t i;
+
+    if (a->len != b->len)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < a->len; i++)
+    {
+        if (a->data[i].ts != b->data[i].ts || ((a->tp == TP_STRING)
+                ? strcmp(a->data[i].val.str, b->data[i].val.str)
+                : a->data[i].val.uint64 != b->data[i].val.uint64))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int test_double_bytes(void)
+{
+    test_start("points (double)");
+
+    size_t i, n, size;
+    uint16_t cinfo;
+    unsigned char * bits;
+    uint64_t ts;
+    qp_via_t val;
+    siridb_points_t * points, * unzipped;
+
+    /* all eight value bytes differ so each byte needs a shift */
+    for (n = 2; n < 200; n += 13)
+    {
+        points = siridb_points_new(n, TP_DOUBLE);
+        for (i = 0; i < n; i++)
+        {
+            ts = 1579521271 + i * 60;
+            val.uint64 = 0x0101010101010101ULL * (i + 1);
+            siridb_points_add_point(points, &ts, &val);
+        }
+
+        bits = siridb_points_zip_double(
+                points, 0, points->len, &cinfo, &size);
+        _assert (bits != NULL);
+        _assert (size == siridb_points_get_size_zipped(cinfo, n));
+
+        unzipped = siridb_points_new(n, TP_DOUBLE);
+        siridb_points_unzip_double(unzipped, bits, n, cinfo, NULL, NULL, 0);
+        _assert (points_equal(points, unzipped));
+
+        free(bits);
+        siridb_points_free(unzipped);
+        siridb_points_free(points);
+    }
+
+    return test_end();
+}
+
+static int test_double_bits(void)
+{
+    test_start("points (gorilla)");
+
+    /* bit-packed doubles round trip */
+    {
+        size_t n, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        siridb_points_t * points, * unzipped;
+
+        for (n = 1; n < 3000; n += 37)
+        {
+            points = prepare_doubles(n);
+            bits = siridb_points_zip_double_bits(
+                    points, 0, points->len, &cinfo, &size);
+            _assert (bits != NULL);
+            _assert (size <= siridb_points_get_size_zipped(cinfo, n));
+
+            unzipped = siridb_points_new(n, TP_DOUBLE);
+            siridb_points_unzip_double(
+                    unzipped, bits, n, cinfo, NULL, NULL, 0);
+            _assert (points_equal(points, unzipped));
+
+            free(bits);
+            siridb_points_free(unzipped);
+            siridb_points_free(points);
+        }
+    }
+
+    /* regular series select the bit-packed codec */
+    {
+        size_t i, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        uint64_t ts, start_ts, end_ts;
+        qp_via_t val;
+        siridb_points_t * points = siridb_points_new(500, TP_DOUBLE);
+        siridb_points_t * unzipped = siridb_points_new(500, TP_DOUBLE);
+
+        for (i = 0; i < 500; i++)
+        {
+            ts = 1000 + i * 10;
+            val.real = 20.0 + (i / 50) * 0.25;
+            siridb_points_add_point(points, &ts, &val);
+        }
+
+        bits = siridb_points_zip_double_bits(
+                points, 0, points->len, &cinfo, &size);
+        _assert (bits != NULL);
+        _assert (siridb_points_is_bitpack(cinfo, 500));
+        _assert (size == siridb_points_get_size_zipped(cinfo, 500));
+
+        /* only points within the range must be returned */
+        start_ts = 1100;
+        end_ts = 1200;
+        siridb_points_unzip_double(
+                unzipped, bits, 500, cinfo, &start_ts, &end_ts, 0);
+        _assert (unzipped->len == 10);
+        _assert (unzipped->data[0].ts == 1100);
+        _assert (unzipped->data[9].ts == 1190);
+
+        free(bits);
+        siridb_points_free(unzipped);
+        siridb_points_free(points);
+    }
+
+    return test_end();
+}
+
+static int test_int_bits(void)
+{
+    test_start("points (bitpack)");
+
+    /* bit-packed integers round trip */
+    {
+        size_t n, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        siridb_points_t * points, * unzipped;
+
+        for (n = 1; n < 3000; n += 37)
+        {
+            points = prepare_counter(n, n);
+            bits = siridb_points_zip_int_bits(
+                    points, 0, points->len, &cinfo, &size);
+            _assert (bits != NULL);
+            _assert (size <= siridb_points_get_size_zipped(cinfo, n));
+
+            unzipped = siridb_points_new(n, TP_INT);
+            siridb_points_unzip_int(
+                    unzipped, bits, n, cinfo, NULL, NULL, 0);
+            _assert (points_equal(points, unzipped));
+
+            free(bits);
+            siridb_points_free(unzipped);
+            siridb_points_free(points);
+        }
+    }
+
+    /* extreme values require the full 64 bit width */
+    {
+        size_t i, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        uint64_t ts;
+        qp_via_t val;
+        siridb_points_t * points = siridb_points_new(200, TP_INT);
+        siridb_points_t * unzipped = siridb_points_new(200, TP_INT);
+
+        for (i = 0; i < 200; i++)
+        {
+            ts = i * i * 1000;
+            val.int64 = (i % 3 == 0) ? INT64_MIN : (i % 3 == 1) ? INT64_MAX : 0;
+            siridb_points_add_point(points, &ts, &val);
+        }
+
+        bits = siridb_points_zip_int_bits(
+                points, 0, points->len, &cinfo, &size);
+        _assert (bits != NULL);
+        siridb_points_unzip_int(unzipped, bits, 200, cinfo, NULL, NULL, 0);
+        _assert (points_equal(points, unzipped));
+
+        free(bits);
+        siridb_points_free(unzipped);
+        siridb_points_free(points);
+    }
+
+    /* counters select the bit-packed codec */
+    {
+        size_t size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        uint64_t start_ts, end_ts;
+        siridb_points_t * points = prepare_counter(BENCH_CHUNK, 1);
+        siridb_points_t * unzipped = siridb_points_new(BENCH_CHUNK, TP_INT);
+
+        bits = siridb_points_zip_int_bits(
+                points, 0, points->len, &cinfo, &size);
+        _assert (bits != NULL);
+        _assert (siridb_points_is_bitpack(cinfo, BENCH_CHUNK));
+
+        start_ts = points->data[100].ts;
+        end_ts = points->data[200].ts;
+        siridb_points_unzip_int(
+                unzipped, bits, BENCH_CHUNK, cinfo, &start_ts, &end_ts, 0);
+        _assert (unzipped->len == 100);
+        _assert (unzipped->data[0].ts == start_ts);
+        _assert (unzipped->data[99].val.int64 == points->data[199].val.int64);
+
+        free(bits);
+        siridb_points_free(unzipped);
+        siridb_points_free(points);
+    }
+
+    return test_end();
+}
+
+static int test_string(void)
+{
+    test_start("points (string)");
+
+    /* round trip */
+    {
+        size_t i, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        siridb_points_t * points = prepare_log(500, 7);
+        siridb_points_t * unzipped = siridb_points_new(500, TP_STRING);
+
+        bits = siridb_points_zip_string(
+                points, 0, points->len, &cinfo, &size);
+        _assert (bits != NULL);
+        _assert (size == siridb_points_get_size_log(cinfo));
+        _assert (siridb_points_unzip_string(
+                unzipped, bits, 500, NULL, NULL, 0) == 0);
+        _assert (unzipped->len == 500);
+
+        for (i = 0; i < unzipped->len; i++)
+        {
+            _assert (unzipped->data[i].ts == points->data[i].ts);
+            _assert (strcmp(
+                    unzipped->data[i].val.str,
+                    points->data[i].val.str) == 0);
+        }
+
+        free(bits);
+        siridb_points_free(unzipped);
+        siridb_points_free(points);
+    }
+
+    /* chunks written by the previous encoder can be read and written again */
+    {
+        const unsigned char * legacy[2] = {LEGACY_ASCII, LEGACY_UTF8};
+        size_t legacy_sz[2] = {sizeof(LEGACY_ASCII), sizeof(LEGACY_UTF8)};
+        size_t legacy_n[2] = {24, 16};
+        size_t i, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+
+        for (i = 0; i < 2; i++)
+        {
+            siridb_points_t * points = prepare_legacy_log(legacy_n[i], i);
+            siridb_points_t * old = siridb_points_new(legacy_n[i], TP_STRING);
+            siridb_points_t * new = siridb_points_new(legacy_n[i], TP_STRING);
+            unsigned char * copy = malloc(legacy_sz[i]);
+
+            memcpy(copy, legacy[i], legacy_sz[i]);
+            _assert (siridb_points_unzip_string(
+                    old, copy, legacy_n[i], NULL, NULL, 0) == 0);
+            _assert (points_equal(old, points));
+
+            bits = siridb_points_zip_string(
+                    old, 0, old->len, &cinfo, &size);
+            _assert (bits != NULL);
+            _assert (siridb_points_unzip_string(
+                    new, bits, legacy_n[i], NULL, NULL, 0) == 0);
+            _assert (points_equal(new, points));
+
+            free(bits);
+            free(copy);
+            siridb_points_free(new);
+            siridb_points_free(old);
+            siridb_points_free(points);
+        }
+    }
+
+    /* compression from multiple threads gives the same result */
+    {
+        size_t i, size;
+        uint16_t cinfo;
+        unsigned char * bits;
+        pthread_t threads[ZIP_THREADS];
+        zip_job_t jobs[ZIP_THREADS];
+
+        for (i = 0; i < ZIP_THREADS; i++)
+        {
+            jobs[i].points = prepare_log(800, i);
+            jobs[i].bits = NULL;
+            pthread_create(&threads[i], NULL, zip_string_work, &jobs[i]);
+        }
+
+        for (i = 0; i < ZIP_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+            bits = siridb_points_zip_string(
+                    jobs[i].points, 0, jobs[i].points->len, &cinfo, &size);
+
+            _assert (bits != NULL && jobs[i].bits != NULL);
+            _assert (size == jobs[i].size);
+            _assert (memcmp(bits, jobs[i].bits, size) == 0);
+
+            free(bits);
+            free(jobs[i].bits);
+            siridb_points_free(jobs[i].points);
+        }
+    }
+
+    return test_end();
+}
+
+static double bench_decode(
+        siridb_points_t * points,
+        siridb_points_t * unzipped,
+        zip_cb zip,
+        size_t * size)
+{
+    struct timeval t0, t1;
+    uint16_t cinfo;
+    unsigned char * bits;
+    double sec;
+    size_t i;
+
+    bits = zip(points, 0, points->len, &cinfo, size);
+    _assert (bits != NULL);
+    if (bits == NULL)
+    {
+        return 0.0;
+    }
+
+    gettimeofday(&t0, 0);
+    for (i = 0; i < BENCH_ROUNDS; ++i)
+    {
+        unzipped->len = 0;
+        siridb_points_unzip_int(
+                unzipped, bits, points->len, cinfo, NULL, NULL, 0);
+    }
+    gettimeofday(&t1, 0);
+
+    _assert (points_equal(points, unzipped));
+    free(bits);
+
+    sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1000000.0;
+    return sec > 0
+            ? (double) BENCH_ROUNDS * points->len * sizeof(siridb_point_t) /
+                    sec / 1e9
+            : 0.0;
+}
+
+static int test_int_bench(void)
+{
+    test_start("points (bitpack, decode throughput)");
+
+    siridb_points_t * points = prepare_counter(BENCH_CHUNK, 42);
+    siridb_points_t * unzipped = siridb_points_new(BENCH_CHUNK, TP_INT);
+    size_t raw = BENCH_CHUNK * sizeof(siridb_point_t), bsize, psize;
+    double bgbs, pgbs;
+
+    bgbs = bench_decode(points, unzipped, siridb_points_zip_int, &bsize);
+    pgbs = bench_decode(points, unzipped, siridb_points_zip_int_bits, &psize);
+
+    _assert (psize < bsize);
+
+    siridb_points_free(unzipped);
+    siridb_points_free(points);
+    test_end();
+
+    printf("    byte codec: ratio %.2f, decode %.2f GB/s\n",
+            (double) raw / bsize, bgbs);
+    printf("    bitpack:    ratio %.2f, decode %.2f GB/s\n",
+            (double) raw / psize, pgbs);
+
+    return status;
+}
+
+static int test_columns(void)
+{
+    test_start("points (columns)");
+
+    /* numeric columns contain the raw time-stamps and values */
+    {
+        size_t i;
+        qp_obj_t qp_tp, qp_ts, qp_vals;
+        qp_unpacker_t unpacker;
+        qp_packer_t * packer = qp_packer_new(64);
+        siridb_points_t * points = prepare_doubles(300);
+
+        _assert (siridb_points_pack_columns(points, packer) == 0);
+
+        qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+        _assert (qp_next(&unpacker, NULL) == QP_ARRAY3);
+        _assert (qp_next(&unpacker, &qp_tp) == QP_INT64);
+        _assert (qp_tp.via.int64 == TP_DOUBLE);
+        _assert (qp_next(&unpacker, &qp_ts) == QP_RAW);
+        _assert (qp_next(&unpacker, &qp_vals) == QP_RAW);
+        _assert (qp_next(&unpacker, NULL) == QP_END);
+        _assert (qp_ts.len == 300 * sizeof(uint64_t));
+        _assert (qp_vals.len == 300 * sizeof(double));
+
+        for (i = 0; i < points->len; i++)
+        {
+            uint64_t ts;
+            double val;
+            memcpy(&ts, qp_ts.via.raw + i * sizeof(uint64_t), sizeof(ts));
+            memcpy(&val, qp_vals.via.raw + i * sizeof(double), sizeof(val));
+            _assert (ts == points->data[i].ts);
+            _assert (val == points->data[i].val.real);
+        }
+
+        qp_packer_free(packer);
+        siridb_points_free(points);
+    }
+
+    /* string values are packed as an array */
+    {
+        size_t i;
+        qp_obj_t qp_tp, qp_ts, qp_val;
+        qp_unpacker_t unpacker;
+        qp_packer_t * packer = qp_packer_new(64);
+        siridb_points_t * points = prepare_log(50, 3);
+
+        _assert (siridb_points_pack_columns(points, packer) == 0);
+
+        qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+        _assert (qp_next(&unpacker, NULL) == QP_ARRAY3);
+        _assert (qp_next(&unpacker, &qp_tp) == QP_INT64);
+        _assert (qp_tp.via.int64 == TP_STRING);
+        _assert (qp_next(&unpacker, &qp_ts) == QP_RAW);
+        _assert (qp_ts.len == 50 * sizeof(uint64_t));
+        _assert (qp_next(&unpacker, NULL) == QP_ARRAY_OPEN);
+
+        for (i = 0; i < points->len; i++)
+        {
+            _assert (qp_next(&unpacker, &qp_val) == QP_RAW);
+            _assert (qp_val.len == strlen(points->data[i].val.str));
+            _assert (memcmp(
+                    qp_val.via.raw,
+                    points->data[i].val.str,
+                    qp_val.len) == 0);
+        }
+        _assert (qp_next(&unpacker, NULL) == QP_ARRAY_CLOSE);
+
+        qp_packer_free(packer);
+        siridb_points_free(points);
+    }
+
+    /* an empty result has empty columns */
+    {
+        qp_packer_t * packer = qp_packer_new(64);
+        siridb_points_t * points = siridb_points_new(0, TP_INT);
+
+        _assert (siridb_points_pack_columns(points, packer) == 0);
+        _assert (packer->len == 4);
+
+        qp_packer_free(packer);
+        siridb_points_free(points);
+    }
+
+    return test_end();
+}
+
+static double bench_pack(
+        siridb_points_t * points,
+        int (*pack)(siridb_points_t *, qp_packer_t *),
+        size_t * size)
+{
+    struct timeval t0, t1;
+    qp_packer_t * packer = qp_packer_new(QP_SUGGESTED_SIZE);
+    double sec;
+    size_t i;
+
+    gettimeofday(&t0, 0);
+    for (i = 0; i < BENCH_ROUNDS; ++i)
+    {
+        packer->len = 0;
+        pack(points, packer);
+    }
+    gettimeofday(&t1, 0);
+
+    *size = packer->len;
+    qp_packer_free(packer);
+
+    sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1000000.0;
+    return sec > 0 ? (double) BENCH_ROUNDS * points->len / sec / 1e6 : 0.0;
+}
+
+static int test_columns_bench(void)
+{
+    test_start("points (columns, pack throughput)");
+
+    siridb_points_t * points = prepare_counter(BENCH_CHUNK * 10, 42);
+    size_t asize, csize;
+    double amps, cmps;
+
+    amps = bench_pack(points, siridb_points_pack, &asize);
+    cmps = bench_pack(points, siridb_points_pack_columns, &csize);
+
+    /* array, type, two raw16 headers and 64 bits per time-stamp and value */
+    _assert (csize == 2 + 2 * 3 + points->len * 2 * sizeof(uint64_t));
+
+    siridb_points_free(points);
+    test_end();
+
+    printf("    array2 points: %zu bytes, %.1f M points/s\n", asize, amps);
+    printf("    columns:       %zu bytes, %.1f M points/s\n", csize, cmps);
+
+    return status;
+}
+
+/*
+ * Pack the points with the given codec, or raw when codec < 0, and returns
+ * the points unpacked from the result.
+ */
+static siridb_points_t * zip_roundtrip(
+        siridb_points_t * points,
+        int codec,
+        size_t * size)
+{
+    qp_packer_t * packer = qp_packer_new(QP_SUGGESTED_SIZE);
+    qp_unpacker_t unpacker;
+    qp_obj_t qp_tp, qp_len, qp_raw;
+    siridb_points_t * unpacked = NULL;
+
+    if ((codec < 0)
+            ? siridb_points_raw_pack(points, packer)
+            : siridb_points_zip_pack(points, packer, (uint8_t) codec))
+    {
+        qp_packer_free(packer);
+        return NULL;
+    }
+
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+
+    if (qp_is_array(qp_next(&unpacker, NULL)) &&
+        qp_is_int(qp_next(&unpacker, &qp_tp)) &&
+        qp_is_int(qp_next(&unpacker, &qp_len)) &&
+        qp_is_raw(qp_next(&unpacker, &qp_raw)))
+    {
+        *size = qp_raw.len;
+        unpacked = siridb_points_raw_unpack(
+                qp_tp.via.int64,
+                qp_len.via.int64,
+                qp_raw.via.raw,
+                qp_raw.len);
+
+        /* a truncated payload must be rejected */
+        if (qp_tp.via.int64 >= POINTS_ZIP_TP)
+        {
+            siridb_points_t * broken = siridb_points_raw_unpack(
+                    qp_tp.via.int64,
+                    qp_len.via.int64,
+                    qp_raw.via.raw,
+                    qp_raw.len - 1);
+            if (broken != NULL)
+            {
+                siridb_points_free(broken);
+                siridb_points_free(unpacked);
+                unpacked = NULL;
+            }
+        }
+    }
+
+    qp_packer_free(packer);
+    return unpacked;
+}
+
+static int test_zip_pack(void)
+{
+    test_start("points (compressed select payload)");
+
+    siridb_points_t * doubles = prepare_doubles(BENCH_CHUNK * 4 + 7);
+    siridb_points_t * counter = prepare_counter(BENCH_CHUNK * 4 + 7, 42);
+    siridb_points_t * logs = prepare_log(100, 42);
+    siridb_points_t * small = prepare_counter(POINTS_ZIP_THRESHOLD - 1, 42);
+    siridb_points_t * unpacked;
+    size_t raw_sz, dbl_sz, dbl_bits_sz, int_sz, int_bits_sz, size;
+
+    /* uncompressed, like older servers send */
+    unpacked = zip_roundtrip(counter, -1, &raw_sz);
+    _assert (unpacked != NULL && points_equal(counter, unpacked));
+    _assert (raw_sz == counter->len * sizeof(siridb_point_t));
+    siridb_points_free(unpacked);
+
+    unpacked = zip_roundtrip(doubles, SIRIDB_CODEC_DEFAULT, &dbl_sz);
+    _assert (unpacked != NULL && points_equal(doubles, unpacked));
+    siridb_points_free(unpacked);
+
+    unpacked = zip_roundtrip(doubles, SIRIDB_CODEC_GORILLA, &dbl_bits_sz);
+    _assert (unpacked != NULL && points_equal(doubles, unpacked));
+    siridb_points_free(unpacked);
+
+    unpacked = zip_roundtrip(counter, SIRIDB_CODEC_DEFAULT, &int_sz);
+    _assert (unpacked != NULL && points_equal(counter, unpacked));
+    siridb_points_free(unpacked);
+
+    unpacked = zip_roundtrip(counter, SIRIDB_CODEC_BITPACK, &int_bits_sz);
+    _assert (unpacked != NULL && points_equal(counter, unpacked));
+    siridb_points_free(unpacked);
+
+    _assert (dbl_sz < raw_sz && dbl_bits_sz <= dbl_sz);
+    _assert (int_sz < raw_sz / 2 && int_bits_sz <= int_sz);
+
+    /* strings and small series use the uncompressed format */
+    unpacked = zip_roundtrip(logs, SIRIDB_CODEC_BITPACK, &size);
+    _assert (unpacked != NULL && points_equal(logs, unpacked));
+    siridb_points_free(unpacked);
+
+    unpacked = zip_roundtrip(small, SIRIDB_CODEC_BITPACK, &size);
+    _assert (unpacked != NULL && points_equal(small, unpacked));
+    _assert (size == small->len * sizeof(siridb_point_t));
+    siridb_points_free(unpacked);
+
+    siridb_points_free(doubles);
+    siridb_points_free(counter);
+    siridb_points_free(logs);
+    siridb_points_free(small);
+    test_end();
+
+    printf("    raw:             %zu bytes\n", raw_sz);
+    printf("    double (byte):   %zu bytes\n", dbl_sz);
+    printf("    double (bits):   %zu bytes\n", dbl_bits_sz);
+    printf("    counter (byte):  %zu bytes\n", int_sz);
+    printf("    counter (bits):  %zu bytes\n", int_bits_sz);
+
+    return status;
+}
+
+int main()
+{
+    return (
+        test_double_bytes() ||
+        test_double_bits() ||
+        test_int_bits() ||
+        test_string() ||
+        test_int_bench() ||
+        test_columns() ||
+        test_columns_bench() ||
+        test_zip_pack()
+    );
+}
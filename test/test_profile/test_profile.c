@@ -0,0 +1,170 @@
+#include "../test.h"
+#include <siri/db/profile.h>
+#include <string.h>
+
+
+static siridb_profile_t * new_pool_profile(void)
+{
+    siridb_profile_t * profile = siridb_profile_new();
+    if (profile == NULL)
+    {
+        return NULL;
+    }
+    profile->stages[SIRIDB_PROFILE_READ].wall = 2500000;
+    profile->stages[SIRIDB_PROFILE_READ].cpu = 500000;
+    profile->stages[SIRIDB_PROFILE_READ].count = 3;
+    profile->chunks = 6;
+    profile->bytes = 4096;
+    profile->points = 1200;
+    profile->cache_hits = 5;
+    profile->cache_misses = 1;
+    return profile;
+}
+
+/*
+ * Move the unpacker to the value of the given key in the profile map.
+ */
+static int find_key(qp_unpacker_t * unpacker, const char * key)
+{
+    qp_obj_t qp_key;
+    size_t n = strlen(key);
+
+    while (qp_is_raw(qp_next(unpacker, &qp_key)))
+    {
+        if (qp_key.len == n && memcmp(qp_key.via.raw, key, n) == 0)
+        {
+            return 0;
+        }
+        qp_skip_next(unpacker);
+    }
+    return -1;
+}
+
+static int test_start_stop(void)
+{
+    test_start("profile (start/stop)");
+
+    siridb_profile_t * profile = siridb_profile_new();
+    siridb_profile_clock_t clock = {0};
+    volatile size_t i, x = 0;
+
+    _assert (profile != NULL);
+
+    /* a query which is not profiled does nothing */
+    siridb_profile_start(NULL, &clock);
+    siridb_profile_stop(NULL, SIRIDB_PROFILE_READ, &clock);
+    _assert (clock.wall == 0 && clock.cpu == 0);
+
+    siridb_profile_start(profile, &clock);
+    for (i = 0; i < 1000000; i++)
+    {
+        x += i;
+    }
+    siridb_profile_stop(profile, SIRIDB_PROFILE_AGGREGATE, &clock);
+    siridb_profile_start(profile, &clock);
+    siridb_profile_stop(profile, SIRIDB_PROFILE_AGGREGATE, &clock);
+
+    _assert (profile->stages[SIRIDB_PROFILE_AGGREGATE].count == 2);
+    _assert (profile->stages[SIRIDB_PROFILE_AGGREGATE].cpu > 0);
+    _assert (profile->stages[SIRIDB_PROFILE_READ].count == 0);
+
+    siridb_profile_free(profile);
+
+    return test_end();
+}
+
+static int test_round_trip(void)
+{
+    test_start("profile (pack/unpack)");
+
+    siridb_profile_t * pool = new_pool_profile();
+    siridb_profile_t * master = siridb_profile_new();
+    siridb_profile_t * check = siridb_profile_new();
+    siridb_profile_t * child;
+    qp_packer_t * packer = qp_packer_new(1024);
+    qp_unpacker_t unpacker;
+    qp_obj_t qp_val;
+
+    _assert (pool && master && check && packer);
+
+    /* a pool packs its profile after the query result */
+    qp_add_type(packer, QP_MAP_OPEN);
+    qp_add_raw(packer, (const unsigned char *) "select", 6);
+    qp_add_type(packer, QP_MAP0);
+    _assert (siridb_profile_pack(pool, packer, "pool1:9010", 0.25) == 0);
+    siridb_profile_free(pool);
+
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+    _assert (qp_is_map(qp_next(&unpacker, NULL)));
+    _assert (qp_is_raw(qp_next(&unpacker, NULL)));
+    _assert (qp_is_map(qp_next(&unpacker, NULL)));
+    _assert (siridb_profile_from_unpacker(master, &unpacker, 1500) == 0);
+
+    _assert (master->pools != NULL && master->pools->len == 1);
+    child = master->pools->data[0];
+    _assert (strcmp(child->server, "pool1:9010") == 0);
+    _assert (child->time == 0.25);
+    _assert (child->network == 1500);
+    _assert (child->stages[SIRIDB_PROFILE_READ].wall == 2500000);
+    _assert (child->stages[SIRIDB_PROFILE_READ].cpu == 500000);
+    _assert (child->stages[SIRIDB_PROFILE_READ].count == 3);
+    _assert (child->chunks == 6);
+    _assert (child->bytes == 4096);
+    _assert (child->points == 1200);
+    _assert (child->cache_hits == 5);
+    _assert (child->cache_misses == 1);
+
+    /* a response without a profile is not accepted */
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+    _assert (siridb_profile_from_unpacker(master, &unpacker, 0) == -1);
+    _assert (master->pools->len == 1);
+
+    /* the server which received the query adds its own stages */
+    master->stages[SIRIDB_PROFILE_READ].wall = 500000;
+    master->stages[SIRIDB_PROFILE_READ].count = 1;
+    master->chunks = 4;
+
+    packer->len = 0;
+    _assert (siridb_profile_pack(master, packer, "server0:9010", 0.5) == 0);
+
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+    _assert (siridb_profile_from_unpacker(check, &unpacker, 0) == 0);
+    child = check->pools->data[0];
+    _assert (strcmp(child->server, "server0:9010") == 0);
+    _assert (child->stages[SIRIDB_PROFILE_READ].wall == 500000);
+    _assert (child->chunks == 4);
+
+    /* the total includes all servers */
+    qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+    _assert (qp_is_raw(qp_next(&unpacker, NULL)));
+    _assert (qp_next(&unpacker, NULL) == QP_MAP_OPEN);
+    _assert (find_key(&unpacker, "total") == 0);
+    _assert (qp_next(&unpacker, NULL) == QP_MAP_OPEN);
+    _assert (find_key(&unpacker, "stages") == 0);
+    _assert (qp_next(&unpacker, NULL) == QP_MAP_OPEN);
+    _assert (find_key(&unpacker, "read") == 0);
+    _assert (qp_is_map(qp_next(&unpacker, NULL)));
+    _assert (find_key(&unpacker, "wall") == 0);
+    _assert (qp_is_double(qp_next(&unpacker, &qp_val)));
+    _assert (qp_val.via.real == 3.0);
+    _assert (find_key(&unpacker, "cpu") == 0);
+    qp_skip_next(&unpacker);
+    _assert (find_key(&unpacker, "count") == 0);
+    _assert (qp_is_int(qp_next(&unpacker, &qp_val)));
+    _assert (qp_val.via.int64 == 4);
+
+    qp_packer_free(packer);
+    siridb_profile_free(master);
+    siridb_profile_free(check);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_start_stop() ||
+        test_round_trip() ||
+        0
+    );
+}
@@ -0,0 +1,172 @@
+#include "../test.h"
+#include <siri/net/promise.h>
+#include <siri/net/twheel.h>
+#include <uv.h>
+
+#define BENCH_PROMISES 1000000
+#define BENCH_BATCH 250     /* max concurrent promises for one server */
+
+static int expired[8];
+static int nexpired;
+static sirinet_twheel_t * twheel;
+static sirinet_promise_t * promises[BENCH_BATCH];
+
+static void on_expired(sirinet_twheel_entry_t * entry)
+{
+    sirinet_promise_t * promise = entry->data;
+
+    expired[nexpired++] = promise->pid;
+
+    /* adding a new entry from within a call-back must be possible */
+    if (promise->pid == 2)
+    {
+        promise->pid = 5;
+        _assert (sirinet_twheel_add(twheel, &promise->tentry, 0) == 0);
+        return;
+    }
+    sirinet_promise_decref(promise);
+}
+
+static int test_twheel(void)
+{
+    test_start("promise (timer wheel)");
+
+    /* time-outs in ms, covering all levels of the wheel */
+    uint64_t timeouts[] = {100, 10000, 36000000, 600000, 20};
+    sirinet_promise_t * promise;
+    uv_loop_t loop;
+    int i;
+
+    uv_loop_init(&loop);
+    twheel = sirinet_twheel_new(&loop, on_expired);
+    _assert (twheel != NULL);
+
+    for (i = 0; i < 5; i++)
+    {
+        promise = sirinet_promise_new();
+        promise->pid = i;
+        promise->ref = 1;
+        _assert (sirinet_twheel_add(
+                twheel,
+                &promise->tentry,
+                timeouts[i]) == 0);
+        promises[i] = promise;
+    }
+    _assert (twheel->n == 5);
+    _assert (twheel->slots[1][
+        (promises[1]->tentry.expire >> 6) & 63] == &promises[1]->tentry);
+    _assert (twheel->slots[3][
+        (promises[2]->tentry.expire >> 18) & 63] == &promises[2]->tentry);
+
+    /* removed entries should never expire */
+    sirinet_twheel_remove(twheel, &promises[3]->tentry);
+    _assert (!sirinet_twheel_is_pending(&promises[3]->tentry));
+    _assert (twheel->n == 4);
+    sirinet_promise_decref(promises[3]);
+
+    /* pretend twelve hours have passed, the first tick must catch up */
+    twheel->start -= 12 * 3600 * 1000;
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    /* the loop stops once the wheel is empty and the timer is closed */
+    _assert (twheel->n == 0 && twheel->timer == NULL);
+    _assert (nexpired == 5);
+    _assert (expired[0] == 4 && expired[1] == 0 && expired[2] == 1);
+    _assert (expired[3] == 2 && expired[4] == 5);
+
+    sirinet_twheel_free(twheel);
+    uv_loop_close(&loop);
+
+    return test_end();
+}
+
+static void bench_timeout(uv_timer_t * handle __attribute__((unused)))
+{
+}
+
+static int test_throughput(void)
+{
+    test_start("promise (create/resolve throughput)");
+
+    struct timeval t0, t1, t2;
+    sirinet_promise_t * promise;
+    uv_loop_t loop;
+    size_t i, j;
+    double sec_wheel, sec_timer;
+
+    uv_loop_init(&loop);
+    twheel = sirinet_twheel_new(&loop, on_expired);
+
+    /* slab promises with time-outs in the wheel */
+    gettimeofday(&t0, 0);
+    for (i = 0; i < BENCH_PROMISES; i += BENCH_BATCH)
+    {
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            promise = promises[j] = sirinet_promise_new();
+            promise->ref = 1;
+            sirinet_twheel_add(
+                    twheel,
+                    &promise->tentry,
+                    PROMISE_DEFAULT_TIMEOUT);
+        }
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            sirinet_twheel_remove(twheel, &promises[j]->tentry);
+            sirinet_promise_decref(promises[j]);
+        }
+    }
+    gettimeofday(&t1, 0);
+    _assert (twheel->n == 0);
+
+    /* the previous implementation, a malloc and uv timer per promise */
+    for (i = 0; i < BENCH_PROMISES; i += BENCH_BATCH)
+    {
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            promise = promises[j] = malloc(sizeof(sirinet_promise_t));
+            promise->data = malloc(sizeof(uv_timer_t));
+            uv_timer_init(&loop, promise->data);
+            uv_timer_start(
+                    promise->data,
+                    bench_timeout,
+                    PROMISE_DEFAULT_TIMEOUT,
+                    0);
+        }
+        for (j = 0; j < BENCH_BATCH; j++)
+        {
+            uv_timer_stop(promises[j]->data);
+            uv_close(promises[j]->data, (uv_close_cb) free);
+            free(promises[j]);
+        }
+        uv_run(&loop, UV_RUN_NOWAIT);
+    }
+    gettimeofday(&t2, 0);
+
+    sirinet_twheel_free(twheel);
+    uv_run(&loop, UV_RUN_DEFAULT);
+    _assert (uv_loop_close(&loop) == 0);
+    sirinet_promise_slab_destroy();
+
+    test_end();
+
+    sec_wheel = (t1.tv_sec - t0.tv_sec) +
+            (t1.tv_usec - t0.tv_usec) / 1000000.0;
+    sec_timer = (t2.tv_sec - t1.tv_sec) +
+            (t2.tv_usec - t1.tv_usec) / 1000000.0;
+    printf("    slab + wheel:   %.2f M promises/s\n",
+            sec_wheel > 0 ? BENCH_PROMISES / sec_wheel / 1000000.0 : 0.0);
+    printf("    malloc + timer: %.2f M promises/s\n",
+            sec_timer > 0 ? BENCH_PROMISES / sec_timer / 1000000.0 : 0.0);
+
+    return status;
+}
+
+int main()
+{
+    return (
+        test_twheel() ||
+        test_throughput() ||
+        0
+    );
+}
@@ -0,0 +1,89 @@
+#include "../test.h"
+#include <siri/db/qcache.h>
+#include <siri/grammar/grammar.h>
+#include <siri/grammar/gramp.h>
+
+
+static siridb_qcache_entry_t * add_query(
+        siridb_qcache_t * qcache,
+        cleri_grammar_t * grammar,
+        const char * query)
+{
+    char * q = strdup(query);
+    cleri_parse_t * pr = cleri_parse_m(grammar, q);
+    siridb_qcache_entry_t * entry = siridb_qcache_add(qcache, q, pr, 1000);
+    if (entry == NULL)
+    {
+        cleri_parse_free(pr);
+        free(q);
+    }
+    return entry;
+}
+
+static int test_qcache(void)
+{
+    test_start("qcache");
+
+    cleri_grammar_t * grammar = compile_siri_grammar_grammar();
+    siridb_qcache_t * qcache = siridb_qcache_new();
+    siridb_qcache_entry_t * entry, * first;
+    char buf[32];
+    size_t i;
+
+    _assert (qcache != NULL);
+    _assert (siridb_qcache_get(qcache, "select * from 'a'") == NULL);
+
+    first = add_query(qcache, grammar, "select * from 'a'");
+    _assert (first != NULL && first->in_use);
+
+    /* entries in use cannot be used by another query */
+    _assert (siridb_qcache_get(qcache, "select * from 'a'") == NULL);
+    siridb_qcache_release(first);
+
+    entry = siridb_qcache_get(qcache, "select * from 'a'");
+    _assert (entry == first && entry->pr->is_valid);
+    _assert (qcache->hits == 1 && qcache->misses == 2);
+    _assert (qcache->time_saved == 1000);
+
+    /* fill the cache while the first entry is in use */
+    for (i = 0; i < SIRIDB_QCACHE_SIZE; i++)
+    {
+        sprintf(buf, "select * from 's%zu'", i);
+        entry = add_query(qcache, grammar, buf);
+        _assert (entry != NULL);
+        siridb_qcache_release(entry);
+    }
+
+    /* the first entry is evicted but must stay valid until released */
+    _assert (qcache->n == SIRIDB_QCACHE_SIZE);
+    _assert (qcache->tail != first && first->evicted);
+    _assert (first->pr->is_valid);
+    siridb_qcache_release(first);
+
+    /* the least recently used entry is evicted first */
+    entry = siridb_qcache_get(qcache, "select * from 's0'");
+    _assert (entry != NULL);
+    siridb_qcache_release(entry);
+    entry = add_query(qcache, grammar, "select * from 'b'");
+    _assert (entry != NULL);
+    siridb_qcache_release(entry);
+    _assert (siridb_qcache_get(qcache, "select * from 's1'") == NULL);
+    entry = siridb_qcache_get(qcache, "select * from 's0'");
+    _assert (entry != NULL);
+    siridb_qcache_release(entry);
+
+    _assert (siridb_qcache_hit_rate(qcache) == 50.0);
+
+    siridb_qcache_free(qcache);
+    cleri_grammar_free(grammar);
+
+    return test_end();
+}
+
+int main()
+{
+    return (
+        test_qcache() ||
+        0
+    );
+}
@@ -0,0 +1,80 @@
+#include "../test.h"
+#include <qpack/qpack.h>
+
+
+int main()
+{
+    test_start("qpack (packer)");
+
+    /* the buffer grows geometric and keeps a multiple of alloc_size */
+    {
+        size_t i, reallocs = 0, buffer_size;
+        qp_packer_t * packer = qp_packer_new(64);
+        _assert (packer);
+        buffer_size = packer->buffer_size;
+
+        for (i = 0; i < 100000; i++)
+        {
+            _assert (qp_add_int64(packer, (int64_t) i) == 0);
+            if (packer->buffer_size != buffer_size)
+            {
+                _assert (packer->buffer_size >= buffer_size * 2);
+                _assert (packer->buffer_size % packer->alloc_size == 0);
+                buffer_size = packer->buffer_size;
+                reallocs++;
+            }
+        }
+
+        _assert (packer->len <= packer->buffer_size);
+        _assert (reallocs < 20);
+        qp_packer_free(packer);
+    }
+
+    /* reserve allocates the requested size at once */
+    {
+        size_t i, buffer_size;
+        qp_packer_t * packer = qp_packer_new(64);
+        _assert (packer);
+
+        _assert (qp_packer_reserve(packer, 10000) == 0);
+        _assert (packer->buffer_size == 10000);
+        buffer_size = packer->buffer_size;
+
+        for (i = 0; i < 1000; i++)
+        {
+            _assert (qp_add_double(packer, i + 0.5) == 0);
+        }
+        _assert (packer->len == 9000);
+        _assert (packer->buffer_size == buffer_size);
+
+        /* reserving less than available does nothing */
+        _assert (qp_packer_reserve(packer, 1000) == 0);
+        _assert (packer->buffer_size == buffer_size);
+
+        qp_packer_free(packer);
+    }
+
+    /* raw alloc reserves space for the caller */
+    {
+        qp_obj_t qp_raw;
+        qp_unpacker_t unpacker;
+        unsigned char * raw;
+        qp_packer_t * packer = qp_packer_new(64);
+        _assert (packer);
+
+        _assert (qp_add_raw_alloc(packer, &raw, 300) == 0);
+        memset(raw, 'x', 300);
+        _assert (qp_add_int64(packer, 42) == 0);
+
+        qp_unpacker_init(&unpacker, packer->buffer, packer->len);
+        _assert (qp_next(&unpacker, &qp_raw) == QP_RAW);
+        _assert (qp_raw.len == 300);
+        _assert (qp_raw.via.raw[0] == 'x' && qp_raw.via.raw[299] == 'x');
+        _assert (qp_next(&unpacker, &qp_raw) == QP_INT64);
+        _assert (qp_raw.via.int64 == 42);
+
+        qp_packer_free(packer);
+    }
+
+    return test_end();
+}
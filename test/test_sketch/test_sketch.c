@@ -0,0 +1,233 @@
+#include <math.h>
+#include "../test.h"
+#include <siri/db/sketch.h>
+
+
+#define NVALUES 1000000
+#define NPARTS 4
+
+static siridb_point_t points[NVALUES];
+static double sorted[NVALUES];
+
+static uint64_t lcg(uint64_t * state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 11;
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double da = *((const double *) a);
+    double db = *((const double *) b);
+    return (da > db) - (da < db);
+}
+
+/* same linear interpolation as median() */
+static double exact(double percentile)
+{
+    double rank = percentile / 100.0 * (NVALUES - 1);
+    size_t i = (size_t) rank;
+    return (i + 1 < NVALUES) ?
+            sorted[i] + (sorted[i + 1] - sorted[i]) * (rank - i) :
+            sorted[i];
+}
+
+static int test_tdigest(void)
+{
+    test_start("sketch (t-digest)");
+
+    double percentiles[5] = {0.1, 1.0, 50.0, 99.0, 99.9};
+    double errors[5] = {0.002, 0.002, 0.005, 0.002, 0.002};
+    siridb_sketch_t * sketch = siridb_sketch_new(SIRIDB_SKETCH_TDIGEST);
+    siridb_sketch_t * parts[NPARTS];
+    siridb_sketch_t * unpacked;
+    uint64_t state = 42;
+    size_t i, n = NVALUES / NPARTS, consumed, len, size;
+    double max_err = 0.0, err;
+
+    /* mixture of two normal-ish distributions so the median is not trivial */
+    for (i = 0; i < NVALUES; i++)
+    {
+        points[i].ts = i;
+        points[i].val.real =
+                ((lcg(&state) % 1000000) + (lcg(&state) % 1000000)) / 2e6 +
+                ((i % 3 == 0) ? 3.0 : 0.0);
+        sorted[i] = points[i].val.real;
+    }
+    qsort(sorted, NVALUES, sizeof(double), cmp_double);
+
+    siridb_sketch_add(sketch, points, NVALUES, TP_DOUBLE);
+
+    for (i = 0; i < NPARTS; i++)
+    {
+        parts[i] = siridb_sketch_new(SIRIDB_SKETCH_TDIGEST);
+        siridb_sketch_add(parts[i], points + i * n, n, TP_DOUBLE);
+        if (i)
+        {
+            siridb_sketch_merge(*parts, parts[i]);
+        }
+    }
+
+    _assert (sketch->n == NVALUES && (*parts)->n == NVALUES);
+    _assert (sketch->len <= SIRIDB_TDIGEST_SZ);
+    _assert (sketch->min == sorted[0]);
+    _assert (sketch->max == sorted[NVALUES - 1]);
+    _assert (siridb_sketch_percentile(sketch, 0.0) == sorted[0]);
+    _assert (siridb_sketch_percentile(sketch, 100.0) == sorted[NVALUES - 1]);
+
+    for (i = 0; i < 5; i++)
+    {
+        err = fabs(siridb_sketch_percentile(sketch, percentiles[i]) -
+                exact(percentiles[i]));
+        _assert (err < errors[i]);
+        max_err = (err > max_err) ? err : max_err;
+
+        /* merged sketches are as accurate as a single sketch */
+        err = fabs(siridb_sketch_percentile(*parts, percentiles[i]) -
+                exact(percentiles[i]));
+        _assert (err < errors[i]);
+    }
+
+    /* a sketch can be used as raw data */
+    unpacked = siridb_sketch_unpack(
+            (const unsigned char *) sketch,
+            siridb_sketch_size(sketch),
+            &consumed);
+    _assert (unpacked != NULL);
+    _assert (consumed == siridb_sketch_size(sketch));
+    _assert (siridb_sketch_percentile(unpacked, 99.0) ==
+            siridb_sketch_percentile(sketch, 99.0));
+    _assert (siridb_sketch_unpack(
+            (const unsigned char *) sketch,
+            consumed - 1,
+            &consumed) == NULL);
+
+    len = sketch->len;
+    size = siridb_sketch_size(sketch);
+
+    siridb_sketch_free(unpacked);
+    siridb_sketch_free(sketch);
+    for (i = 0; i < NPARTS; i++)
+    {
+        siridb_sketch_free(parts[i]);
+    }
+    test_end();
+
+    printf("    %zu centroids (%zu bytes), max error %.5f\n",
+            len, size, max_err);
+
+    return status;
+}
+
+static int test_tdigest_small(void)
+{
+    test_start("sketch (t-digest, exact)");
+
+    siridb_sketch_t sketch;
+    siridb_point_t data[5] = {
+        {.ts = 1, .val.int64 = 7},
+        {.ts = 2, .val.int64 = -3},
+        {.ts = 3, .val.int64 = 12},
+        {.ts = 4, .val.int64 = 0},
+        {.ts = 5, .val.int64 = 4},
+    };
+
+    siridb_sketch_init(&sketch, SIRIDB_SKETCH_TDIGEST);
+    _assert (isnan(siridb_sketch_percentile(&sketch, 50.0)));
+
+    siridb_sketch_add(&sketch, data, 5, TP_INT);
+
+    /* -3, 0, 4, 7, 12 */
+    _assert (sketch.len == 5);
+    _assert (siridb_sketch_percentile(&sketch, 0.0) == -3.0);
+    _assert (siridb_sketch_percentile(&sketch, 50.0) == 4.0);
+    _assert (siridb_sketch_percentile(&sketch, 62.5) == 5.5);
+    _assert (siridb_sketch_percentile(&sketch, 100.0) == 12.0);
+
+    return test_end();
+}
+
+static int test_hll(void)
+{
+    test_start("sketch (hyperloglog)");
+
+    siridb_sketch_t * a = siridb_sketch_new(SIRIDB_SKETCH_HLL);
+    siridb_sketch_t * b = siridb_sketch_new(SIRIDB_SKETCH_HLL);
+    siridb_sketch_t * unpacked;
+    siridb_point_t data[3];
+    static uint8_t seen[200000];
+    uint64_t state = 7;
+    size_t i, consumed, size, x, half = 0, total = 0;
+    double err;
+
+    /* values from a domain of 200000, each value is added about five times */
+    for (i = 0; i < NVALUES; i++)
+    {
+        x = lcg(&state) % 200000;
+        points[i].ts = i;
+        points[i].val.int64 = (int64_t) x * 3 - 100000;
+        total += !seen[x];
+        seen[x] = 1;
+        if (i == NVALUES / 2 - 1)
+        {
+            half = total;
+        }
+    }
+
+    siridb_sketch_add(a, points, NVALUES / 2, TP_INT);
+    siridb_sketch_add(b, points + NVALUES / 2, NVALUES / 2, TP_INT);
+
+    err = fabs(siridb_sketch_distinct(a) - (double) half) / half;
+    _assert (err < 0.05);
+
+    siridb_sketch_merge(a, b);
+    err = fabs(siridb_sketch_distinct(a) - (double) total) / total;
+    _assert (err < 0.05);
+    _assert (a->n == NVALUES);
+
+    unpacked = siridb_sketch_unpack(
+            (const unsigned char *) a,
+            siridb_sketch_size(a),
+            &consumed);
+    _assert (unpacked != NULL);
+    _assert (siridb_sketch_distinct(unpacked) == siridb_sketch_distinct(a));
+
+    /* equal integer and float values are one distinct value */
+    siridb_sketch_init(b, SIRIDB_SKETCH_HLL);
+    data[0].val.int64 = 5;
+    data[1].val.int64 = -2;
+    siridb_sketch_add(b, data, 2, TP_INT);
+    data[0].val.real = 5.0;
+    data[1].val.real = 5.5;
+    data[2].val.real = -0.0;
+    siridb_sketch_add(b, data, 3, TP_DOUBLE);
+    _assert (siridb_sketch_distinct(b) == 4);
+
+    siridb_sketch_init(b, SIRIDB_SKETCH_HLL);
+    data[0].val.str = "one";
+    data[1].val.str = "two";
+    data[2].val.str = "one";
+    siridb_sketch_add(b, data, 3, TP_STRING);
+    _assert (siridb_sketch_distinct(b) == 2);
+
+    size = siridb_sketch_size(a);
+
+    siridb_sketch_free(unpacked);
+    siridb_sketch_free(a);
+    siridb_sketch_free(b);
+    test_end();
+
+    printf("    %zu bytes, error %.4f\n", size, err);
+
+    return status;
+}
+
+int main()
+{
+    return (
+        test_tdigest() ||
+        test_tdigest_small() ||
+        test_hll() ||
+        0
+    );
+}
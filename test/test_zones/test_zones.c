@@ -0,0 +1,193 @@
+#include "../test.h"
+#include <siri/db/zones.h>
+#include <siri/grammar/grammar.h>
+
+#define NSERIES 20000
+#define NOW 1579521271
+#define STALE_FIRST 3000
+#define STALE_LAST 3100
+
+/* see cexpr.c */
+#define VIA_NULL 0
+#define VIA_COND 2
+
+static siridb_series_t series[NSERIES + 1];
+
+static cexpr_t * single(cexpr_t * cexpr, cexpr_condition_t * cond)
+{
+    cexpr->operator = CEXPR_AND;
+    cexpr->tp_a = VIA_COND;
+    cexpr->via_a.cond = cond;
+    cexpr->tp_b = VIA_NULL;
+    return cexpr;
+}
+
+static size_t count_matches(siridb_zones_t * zones, cexpr_t * where_expr)
+{
+    size_t i, n = 0;
+    for (i = 0; i < zones->len; i++)
+    {
+        n += siridb_zones_match(zones->zone + i, where_expr);
+    }
+    return n;
+}
+
+int main()
+{
+    test_start("zones");
+
+    siridb_t siridb;
+    siridb_zones_t * zones;
+    cexpr_t stale, or_name, by_pool, short_len, late_start;
+    cexpr_condition_t c_end, c_name, c_pool, c_len, c_start;
+    vec_t * vec;
+    uint32_t id;
+    size_t i, nstale, found;
+
+    memset(&siridb, 0, sizeof(siridb_t));
+    siridb.dbname = "dbtest";
+    siridb.series_map = imap_new();
+    siridb.max_series_id = NSERIES;
+
+    /* series ids start at 1, zone 7 is left empty */
+    for (id = 1; id <= NSERIES; id++)
+    {
+        if ((id >> SIRIDB_ZONES_BITS) == 7)
+        {
+            continue;
+        }
+        series[id].id = id;
+        series[id].ref = 1;
+        series[id].tp = id % 3;
+        series[id].pool = id % 4;
+        series[id].length = 100 + id;
+        series[id].start = NOW - 86400 - id;
+        series[id].end = (id >= STALE_FIRST && id <= STALE_LAST) ?
+                NOW - 8 * 86400 : NOW - id % 60;
+        imap_add(siridb.series_map, id, &series[id]);
+    }
+
+    zones = siridb_zones_new(siridb.series_map, siridb.max_series_id);
+    _assert (zones != NULL);
+    _assert (zones->len == (NSERIES >> SIRIDB_ZONES_BITS) + 1);
+
+    /* end < now - 7d */
+    c_end.prop = CLERI_GID_K_END;
+    c_end.operator = CEXPR_LT;
+    c_end.int64 = NOW - 7 * 86400;
+    single(&stale, &c_end);
+
+    _assert (count_matches(zones, &stale) == 2);
+
+    /* a name cannot be answered by the zones, only the empty zone fails */
+    c_name.prop = CLERI_GID_K_NAME;
+    c_name.operator = CEXPR_EQ;
+    c_name.str = "series";
+    or_name.operator = CEXPR_OR;
+    or_name.tp_a = VIA_COND;
+    or_name.via_a.cond = &c_end;
+    or_name.tp_b = VIA_COND;
+    or_name.via_b.cond = &c_name;
+
+    _assert (count_matches(zones, &or_name) == zones->len - 1);
+
+    /* all zones contain each pool, except the empty one */
+    c_pool.prop = CLERI_GID_K_POOL;
+    c_pool.operator = CEXPR_NE;
+    c_pool.int64 = 2;
+    single(&by_pool, &c_pool);
+    _assert (count_matches(zones, &by_pool) == zones->len - 1);
+    c_pool.operator = CEXPR_GT;
+    c_pool.int64 = 3;
+    _assert (count_matches(zones, &by_pool) == 0);
+
+    /* the vector contains at least all stale series */
+    siridb.zones = zones;
+    vec = siridb_zones_series(&siridb, &stale);
+    _assert (vec != NULL);
+    _assert (vec->len == 2 * SIRIDB_ZONES_SZ);
+
+    for (nstale = 0, i = 0; i < vec->len; i++)
+    {
+        siridb_series_t * s = vec->data[i];
+        nstale += s->end < NOW - 7 * 86400;
+        _assert (s->ref == 2);
+        s->ref--;
+    }
+    _assert (nstale == STALE_LAST - STALE_FIRST + 1);
+    vec_free(vec);
+
+    /* too many zones might match, all series are returned */
+    vec = siridb_zones_series(&siridb, &or_name);
+    _assert (vec != NULL && vec->len == siridb.series_map->len);
+    for (i = 0; i < vec->len; i++)
+    {
+        ((siridb_series_t *) vec->data[i])->ref--;
+    }
+    vec_free(vec);
+
+    /* an update only widens the zone */
+    series[15000].end = NOW - 30 * 86400;
+    siridb_zones_update(&siridb, &series[15000]);
+    _assert (count_matches(zones, &stale) == 3);
+
+    series[15000].end = NOW;
+    siridb_zones_update(&siridb, &series[15000]);
+    _assert (count_matches(zones, &stale) == 3);
+
+    /* a new zone is created for new series */
+    id = NSERIES + SIRIDB_ZONES_SZ;
+    series[0] = series[1];
+    series[0].id = id;
+    series[0].end = NOW - 9 * 86400;
+    siridb_zones_update(&siridb, &series[0]);
+    _assert (zones->len == (id >> SIRIDB_ZONES_BITS) + 1);
+    _assert (count_matches(zones, &stale) == 4);
+
+    /* length < 100, no series matches until a length shrinks */
+    c_len.prop = CLERI_GID_K_LENGTH;
+    c_len.operator = CEXPR_LT;
+    c_len.int64 = 100;
+    single(&short_len, &c_len);
+    _assert (count_matches(zones, &short_len) == 0);
+
+    series[5000].length = 40;   /* for example after dropping a shard */
+    siridb_zones_update(&siridb, &series[5000]);
+    _assert (count_matches(zones, &short_len) == 1);
+
+    vec = siridb_zones_series(&siridb, &short_len);
+    _assert (vec != NULL && vec->len == SIRIDB_ZONES_SZ);
+    for (found = 0, i = 0; i < vec->len; i++)
+    {
+        found += vec->data[i] == &series[5000];
+        ((siridb_series_t *) vec->data[i])->ref--;
+    }
+    _assert (found == 1);
+    vec_free(vec);
+
+    /* start > now, no series matches until a start is raised */
+    c_start.prop = CLERI_GID_K_START;
+    c_start.operator = CEXPR_GT;
+    c_start.int64 = NOW;
+    single(&late_start, &c_start);
+    _assert (count_matches(zones, &late_start) == 0);
+
+    series[9000].start = NOW + 60;
+    siridb_zones_update(&siridb, &series[9000]);
+    _assert (count_matches(zones, &late_start) == 1);
+
+    vec = siridb_zones_series(&siridb, &late_start);
+    _assert (vec != NULL && vec->len == SIRIDB_ZONES_SZ);
+    for (found = 0, i = 0; i < vec->len; i++)
+    {
+        found += vec->data[i] == &series[9000];
+        ((siridb_series_t *) vec->data[i])->ref--;
+    }
+    _assert (found == 1);
+    vec_free(vec);
+
+    siridb_zones_free(zones);
+    imap_free(siridb.series_map, NULL);
+
+    return test_end();
+}